@@ -0,0 +1,266 @@
+/*! @file Main procedure of the WinNFSdpp load generator
+ *
+ * Mounts an export through portmap and MOUNT and runs one workload with concurrent
+ * connections against the NFSv3 server on loopback. Prints throughput and latencies.
+ * */
+
+#include "workload.h"
+#include "container/latency_histogram.h"
+
+#include "network/wsa_session.h"
+
+#include "fs/memory_backend.h"
+#include "server/portmap_server.h"
+#include "server/mount_server.h"
+#include "server/nfs3_server.h"
+#include "server/worker_pool.h"
+#include "container/string_convert.h"
+#include "logging/logger.h"
+
+#include <gflags/gflags.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+DEFINE_int32(portmapPort, portmap::PORT, "Port of the portmapper");
+DEFINE_string(export, "/bench", "Mounted export path");
+DEFINE_string(protocol, "tcp", "Protocol of the workload calls: tcp or udp");
+DEFINE_string(workload, "getattr", "read, write, create, readdirplus, getattr or lookup");
+DEFINE_int32(connections, 4, "Concurrent connections, each on its own thread");
+DEFINE_int32(outstanding, 8, "Outstanding requests per connection");
+DEFINE_int32(seconds, 10, "Duration of the run");
+DEFINE_int32(rsize, 0x10000, "Bytes per READ and READDIRPLUS");
+DEFINE_int32(wsize, 0x10000, "Bytes per WRITE");
+DEFINE_int32(fileMb, 64, "Megabytes of the files that are read and written");
+DEFINE_int32(files, 1000, "Files in the directory that is listed, looked up and stat'ed");
+DEFINE_bool(stable, false, "FILE_SYNC writes instead of UNSTABLE");
+DEFINE_bool(serve, false, "Runs the servers on an in-memory filesystem in this process");
+DEFINE_int32(mountPort, mount::PORT, "Port of the mount server with --serve");
+DEFINE_int32(nfsPort, nfs3::PORT, "Port of the nfs server with --serve");
+DEFINE_int32(workerThreads, 4, "Threads that execute nfs calls with --serve, 0 executes them on the socket thread");
+DEFINE_int32(socketThreads, 1, "Threads that receive nfs calls with --serve");
+DEFINE_string(logLevel, "warning", "Level of the server log with --serve: trace, info, warning, failure or off");
+
+namespace {
+  using clock_t = std::chrono::steady_clock;
+
+  struct server_t {
+    server_t()
+      : workers_m(worker_config())
+      , portmap_server_m(FLAGS_portmapPort)
+      , mount_server_m(backend_m, FLAGS_mountPort)
+      , nfs3_server_m(mount_server_m.cache(), {}, FLAGS_nfsPort, FLAGS_workerThreads > 0 ? &workers_m : nullptr,
+                      static_cast<size_t>(std::max(1, FLAGS_socketThreads)))
+    {
+      auto path = convert::to_wstring(FLAGS_export);
+      backend_m.make_directories(path);
+      auto& aliases = mount_server_m.aliases();
+      aliases.add(aliases.create_source(), path, FLAGS_export);
+
+      portmap_server_m.add(mount::PROGRAM, mount::VERSION, FLAGS_mountPort);
+      portmap_server_m.add(nfs3::PROGRAM, nfs3::VERSION, FLAGS_nfsPort);
+      if (FLAGS_workerThreads > 0) workers_m.start();
+      portmap_server_m.start();
+      mount_server_m.start();
+      nfs3_server_m.start();
+    }
+
+    static worker_pool_t::config_t worker_config() {
+      worker_pool_t::config_t config;
+      config.threads = static_cast<size_t>(std::max(0, FLAGS_workerThreads));
+      return config;
+    }
+
+  private:
+    fs::memory_backend_t backend_m;
+    worker_pool_t workers_m;
+    portmap_server_t portmap_server_m;
+    mount_server_t mount_server_m;
+    nfs3_server_t nfs3_server_m;
+  };
+
+  struct connection_result_t {
+    latency_histogram_t latencies;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+  };
+
+  /*
+   * Keeps the outstanding slots of one connection busy until the deadline.
+   * Every reply sends the next call of its slot, so each slot is a closed loop.
+   */
+  void run_connection(bench::workload_t& workload, size_t connection, rpc_client_t::protocol_t protocol,
+                      const inet_addr_t& server, clock_t::time_point deadline, connection_result_t& result) {
+    rpc_client_t client;
+    if ( !client.connect(protocol, server)) {
+        ++result.errors;
+        return;
+      }
+
+    struct pending_t {
+      size_t slot;
+      bench::nfs_call_t call;
+      clock_t::time_point sent;
+    };
+    std::vector<bench::stream_ptr_t> streams;
+    std::unordered_map<uint32_t, pending_t> pending;
+
+    auto issue = [&](size_t slot) {
+      auto call = streams[slot]->next();
+      auto xid = client.next_xid();
+      auto sent = clock_t::now();
+      if ( !client.send(xid, nfs3::PROGRAM, nfs3::VERSION, call.procedure, call.parameters)) {
+          ++result.errors;
+          return;
+        }
+      pending.emplace(xid, pending_t { slot, std::move(call), sent });
+    };
+
+    for (auto slot = 0; slot < FLAGS_outstanding; ++slot) {
+        streams.push_back(workload.stream(connection));
+        issue(slot);
+      }
+
+    binary_t reply;
+    while ( !pending.empty()) {
+        if ( !client.receive(reply)) {
+            // lost calls - datagrams are sent again, a stalled stream ends the connection
+            result.errors += pending.size();
+            if (rpc_client_t::TCP == protocol) return;
+            std::vector<size_t> slots;
+            for (auto& entry : pending) slots.push_back(entry.second.slot);
+            pending.clear();
+            if (clock_t::now() < deadline) {
+                for (auto slot : slots) issue(slot);
+              }
+            continue;
+          }
+        auto received = clock_t::now();
+        auto found = pending.find(rpc_client_t::reply_xid(reply));
+        if (pending.end() == found) continue; // a late reply of a lost call
+
+        auto& call = found->second;
+        binary_reader_t results;
+        if (rpc_client_t::results(reply, results) && streams[call.slot]->complete(call.call, results)) {
+            result.latencies.record(received - call.sent);
+            result.bytes += call.call.bytes;
+          }
+        else ++result.errors;
+
+        auto slot = call.slot;
+        pending.erase(found);
+        if (received < deadline) issue(slot);
+      }
+  }
+
+  double microseconds(latency_histogram_t::duration_t duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  }
+
+  int run(std::ostream& out) {
+    auto protocol = "udp" == FLAGS_protocol ? rpc_client_t::UDP : rpc_client_t::TCP;
+
+    bench::config_t config;
+    config.name = FLAGS_workload;
+    config.connections = static_cast<size_t>(std::max(1, FLAGS_connections));
+    config.rsize = static_cast<uint32_t>(std::max(1, FLAGS_rsize));
+    config.wsize = static_cast<uint32_t>(std::max(1, FLAGS_wsize));
+    config.file_size = static_cast<uint64_t>(std::max(1, FLAGS_fileMb)) << 20;
+    config.files = static_cast<size_t>(std::max(1, FLAGS_files));
+    config.stable = FLAGS_stable;
+    config.run_id = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    auto workload = bench::make_workload(config);
+    if ( !workload) {
+        out << "unknown workload: " << FLAGS_workload << std::endl;
+        return 1;
+      }
+
+    // setup runs over tcp - files are filled with large writes
+    rpc_client_t portmap_client;
+    if ( !portmap_client.connect(rpc_client_t::TCP, inet_addr_t::loopback(FLAGS_portmapPort))) {
+        out << "portmapper not reachable on port " << FLAGS_portmapPort << std::endl;
+        return 1;
+      }
+    auto mount_port = bench::get_port(portmap_client, mount::PROGRAM, mount::VERSION);
+    auto nfs_port = bench::get_port(portmap_client, nfs3::PROGRAM, nfs3::VERSION);
+    if (0 == mount_port || 0 == nfs_port) {
+        out << "mount or nfs program not registered" << std::endl;
+        return 1;
+      }
+
+    rpc_client_t mount_client;
+    nfs3::filehandle_t root;
+    if ( !mount_client.connect(rpc_client_t::TCP, inet_addr_t::loopback(mount_port))
+         || !bench::mount(mount_client, FLAGS_export, root)) {
+        out << "mounting " << FLAGS_export << " failed" << std::endl;
+        return 1;
+      }
+
+    auto server = inet_addr_t::loopback(nfs_port);
+    rpc_client_t setup_client;
+    if ( !setup_client.connect(rpc_client_t::TCP, server)) {
+        out << "nfs server not reachable on port " << nfs_port << std::endl;
+        return 1;
+      }
+    bench::nfs_session_t session(setup_client);
+    out << "setting up " << FLAGS_workload << std::endl;
+    if ( !workload->setup(session, root)) {
+        out << "setup failed" << std::endl;
+        return 1;
+      }
+
+    std::vector<connection_result_t> results(config.connections);
+    std::vector<std::thread> threads;
+    auto start = clock_t::now();
+    auto deadline = start + std::chrono::seconds(std::max(1, FLAGS_seconds));
+    for (size_t connection = 0; connection < config.connections; ++connection) {
+        threads.emplace_back([&, connection] {
+            run_connection(*workload, connection, protocol, server, deadline, results[connection]);
+          });
+      }
+    for (auto& thread : threads) thread.join();
+    auto elapsed = std::chrono::duration<double>(clock_t::now() - start).count();
+
+    connection_result_t total;
+    for (auto& result : results) {
+        total.latencies.merge(result.latencies);
+        total.bytes += result.bytes;
+        total.errors += result.errors;
+      }
+    auto ops = total.latencies.count();
+    out << std::fixed << std::setprecision(1)
+        << "workload: " << FLAGS_workload << " protocol: " << FLAGS_protocol
+        << " connections: " << config.connections << " outstanding: " << FLAGS_outstanding << std::endl
+        << "ops: " << ops << " ops/s: " << ops / elapsed
+        << " MB/s: " << total.bytes / elapsed / (1 << 20)
+        << " errors: " << total.errors << std::endl
+        << "latency us p50: " << microseconds(total.latencies.percentile(50))
+        << " p99: " << microseconds(total.latencies.percentile(99))
+        << " p999: " << microseconds(total.latencies.percentile(99.9))
+        << " max: " << microseconds(total.latencies.max()) << std::endl;
+    return 0 == ops ? 1 : 0;
+  }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  gflags::SetUsageMessage("<flags>");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  wsa_session_t wsa_session(2, 2);
+  if ( !FLAGS_serve) return run(std::cout);
+
+  logging::level_t level;
+  if ( !logging::parse_level(FLAGS_logLevel, level)) {
+      std::cerr << "unknown log level: " << FLAGS_logLevel << std::endl;
+      return 1;
+    }
+  logging::set_level(level);
+  server_t server;
+  return run(std::cout);
+}
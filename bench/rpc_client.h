@@ -0,0 +1,125 @@
+/*! @file Blocking rpc client over udp or tcp for the load generator
+ * */
+#pragma once
+
+#include "network/inet.h"
+#include "network/tcp.h"
+#include "network/udp.h"
+
+#include "rpc/record_marking.h"
+#include "rpc/rpc.h"
+
+#include "binary/binary_builder.h"
+
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief one connection to an rpc server
+ *
+ * Calls are sent and replies received independently, so several calls can be outstanding.
+ * Replies are matched by the caller with their xid. Over udp the "connection" is a socket
+ * that only talks to the server address.
+ */
+struct rpc_client_t {
+  enum protocol_t { UDP, TCP };
+  enum : int {
+    UDP_TIMEOUT_MS = 1000, // lost datagrams are sent again
+    TCP_TIMEOUT_MS = 30000, // the server is gone
+  };
+
+  rpc_client_t() = default;
+  rpc_client_t(rpc_client_t&&) = default;
+  rpc_client_t& operator= (rpc_client_t&&) = default;
+
+  bool connect(protocol_t protocol, const inet_addr_t& server) {
+    protocol_m = protocol;
+    server_m = server;
+    if (UDP == protocol) {
+        udp_m = udp_socket_t::create();
+        return udp_m.valid() && socket_set_receive_timeout(udp_m.handle(), UDP_TIMEOUT_MS);
+      }
+    tcp_m = tcp_socket_t::create();
+    return tcp_m.valid()
+        && SOCKET_ERROR != tcp_m.connect(server)
+        && tcp_m.set_no_delay()
+        && socket_set_receive_timeout(tcp_m.handle(), TCP_TIMEOUT_MS);
+  }
+
+  protocol_t protocol() const { return protocol_m; }
+  uint32_t next_xid() { return ++xid_m; }
+
+  bool send(uint32_t xid, uint32_t program, uint32_t version, uint32_t procedure, const binary_t& parameters) {
+    auto message = rpc::message_builder().call(xid).null_auth(program, version, procedure, parameters);
+    if (UDP == protocol_m) return static_cast<int>(message.size()) == udp_m.send_to(message, server_m);
+
+    binary_builder_t builder;
+    builder.append32(record_marking::single_fragment_header(message.size()));
+    segmented_binary_t record(builder.release());
+    record.append(std::move(message));
+    for (size_t offset = 0; offset < record.size();) {
+        auto sent = tcp_m.send(record, offset);
+        if (0 > sent) return false;
+        offset += sent;
+      }
+    return true;
+  }
+
+  // the next complete reply - false on errors and timeouts
+  bool receive(binary_t& reply) {
+    if (UDP == protocol_m) {
+        reply.resize(0x10000);
+        inet_addr_t sender;
+        return 0 < udp_m.receive_from(reply, sender);
+      }
+    while (true) {
+        binary_reader_t record;
+        switch (reassembler_m.next(record)) {
+          case record_marking::reassembler_t::RECORD:
+            reply.assign(record.data(), record.data() + record.size());
+            return true;
+          case record_marking::reassembler_t::INVALID: return false;
+          case record_marking::reassembler_t::NEED_MORE: break;
+          }
+        auto bytes = tcp_m.receive(reassembler_m.prepare(0x10000), 0x10000);
+        if (0 >= bytes) return false;
+        reassembler_m.commit(bytes);
+      }
+  }
+
+  // one call at a time - for setup
+  bool call(uint32_t program, uint32_t version, uint32_t procedure, const binary_t& parameters, binary_t& reply) {
+    auto xid = next_xid();
+    if ( !send(xid, program, version, procedure, parameters)) return false;
+    while (receive(reply)) {
+        if (xid == reply_xid(reply)) return true;
+      }
+    return false;
+  }
+
+  static uint32_t reply_xid(const binary_t& reply) {
+    return reply.size() < 4 ? 0 : binary_reader_t::binary(reply).get32(0);
+  }
+
+  // the results of an accepted and successful call
+  static bool results(const binary_t& reply, binary_reader_t& results) {
+    auto reader = binary_reader_t::binary(reply);
+    if ( !reader.has_size(20)) return false;
+    if (rpc::msg_type_t::REPLY != static_cast<rpc::msg_type_t>(reader.get32(4))) return false;
+    if (rpc::reply_stat_t::ACCEPTED != static_cast<rpc::reply_stat_t>(reader.get32(8))) return false;
+    auto verifier_size = (reader.get32(16) + 3) & ~3u;
+    auto offset = 20 + verifier_size;
+    if ( !reader.has_size(offset + 4)) return false;
+    if (rpc::accept_stat_t::SUCCESS != static_cast<rpc::accept_stat_t>(reader.get32(offset))) return false;
+    results = reader.get_reader(offset + 4);
+    return true;
+  }
+
+private:
+  protocol_t protocol_m = TCP;
+  inet_addr_t server_m;
+  udp_socket_t udp_m;
+  tcp_socket_t tcp_m;
+  record_marking::reassembler_t reassembler_m {0x200000};
+  uint32_t xid_m = 0;
+};
@@ -0,0 +1,291 @@
+#include "workload.h"
+
+#include <algorithm>
+
+namespace bench {
+
+  namespace {
+    // the position of the next call shared by the streams of a connection
+    struct cursor_t {
+      uint64_t next = 0;
+    };
+    using cursor_ptr_t = std::shared_ptr<cursor_t>;
+
+    struct connection_files_t {
+      std::vector<nfs3::filehandle_t> handles; // one per connection
+      std::vector<cursor_ptr_t> cursors;
+
+      bool setup(nfs_session_t& session, const nfs3::filehandle_t& root, const config_t& config, const char* prefix, bool fill) {
+        for (size_t connection = 0; connection < config.connections; ++connection) {
+            nfs3::filehandle_t handle;
+            auto name = prefix + std::to_string(connection);
+            if ( !session.ensure_file(root, name, handle)) return false;
+            if (fill && !session.fill(handle, config.file_size, std::min<uint32_t>(config.wsize, 0x10000))) return false;
+            handles.push_back(handle);
+            cursors.push_back(std::make_shared<cursor_t>());
+          }
+        return true;
+      }
+    };
+
+    // sequential reads of rsize through a file per connection
+    struct read_workload_t : workload_t {
+      explicit read_workload_t(const config_t& config) : config_m(config) {}
+
+      bool setup(nfs_session_t& session, const nfs3::filehandle_t& root) override {
+        return files_m.setup(session, root, config_m, "read", true);
+      }
+
+      struct read_stream_t : stream_t {
+        nfs_call_t next() override {
+          nfs3::read_args_t args;
+          args.filehandle = file;
+          args.offset = cursor->next;
+          args.count = count;
+          cursor->next += count;
+          if (cursor->next >= size) cursor->next = 0;
+          nfs_call_t result;
+          result.procedure = READ;
+          result.parameters = xdr::to_binary(args);
+          result.bytes = count;
+          return result;
+        }
+
+        nfs3::filehandle_t file;
+        cursor_ptr_t cursor;
+        uint32_t count;
+        uint64_t size;
+      };
+
+      stream_ptr_t stream(size_t connection) override {
+        std::unique_ptr<read_stream_t> result(new read_stream_t());
+        result->file = files_m.handles[connection];
+        result->cursor = files_m.cursors[connection];
+        result->count = config_m.rsize;
+        result->size = config_m.file_size;
+        return result;
+      }
+
+    private:
+      config_t config_m;
+      connection_files_t files_m;
+    };
+
+    // sequential writes of wsize through a file per connection
+    struct write_workload_t : workload_t {
+      explicit write_workload_t(const config_t& config) : config_m(config) {}
+
+      bool setup(nfs_session_t& session, const nfs3::filehandle_t& root) override {
+        return files_m.setup(session, root, config_m, "write", false);
+      }
+
+      struct write_stream_t : stream_t {
+        nfs_call_t next() override {
+          args.offset = cursor->next;
+          cursor->next += args.count;
+          if (cursor->next >= size) cursor->next = 0;
+          nfs_call_t result;
+          result.procedure = WRITE;
+          result.parameters = xdr::to_binary(args, args.data.size() + 128);
+          result.bytes = args.count;
+          return result;
+        }
+
+        nfs3::write_args_t args;
+        cursor_ptr_t cursor;
+        uint64_t size;
+      };
+
+      stream_ptr_t stream(size_t connection) override {
+        std::unique_ptr<write_stream_t> result(new write_stream_t());
+        result->args.filehandle = files_m.handles[connection];
+        result->args.count = config_m.wsize;
+        result->args.stable = config_m.stable ? nfs3::stable_how_t::FILE_SYNC : nfs3::stable_how_t::UNSTABLE;
+        result->args.data.assign(config_m.wsize, static_cast<uint8_t>(connection));
+        result->cursor = files_m.cursors[connection];
+        result->size = config_m.file_size;
+        return result;
+      }
+
+    private:
+      config_t config_m;
+      connection_files_t files_m;
+    };
+
+    // empty files with new names in a directory per connection
+    struct create_workload_t : workload_t {
+      explicit create_workload_t(const config_t& config) : config_m(config) {}
+
+      bool setup(nfs_session_t& session, const nfs3::filehandle_t& root) override {
+        for (size_t connection = 0; connection < config_m.connections; ++connection) {
+            nfs3::filehandle_t directory;
+            if ( !session.ensure_directory(root, "create" + std::to_string(connection), directory)) return false;
+            directories_m.push_back(directory);
+            cursors_m.push_back(std::make_shared<cursor_t>());
+          }
+        return true;
+      }
+
+      struct create_stream_t : stream_t {
+        nfs_call_t next() override {
+          args.where.name = prefix + std::to_string(cursor->next++);
+          nfs_call_t result;
+          result.procedure = CREATE;
+          result.parameters = xdr::to_binary(args);
+          return result;
+        }
+
+        nfs3::create_args_t args;
+        std::string prefix;
+        cursor_ptr_t cursor;
+      };
+
+      stream_ptr_t stream(size_t connection) override {
+        std::unique_ptr<create_stream_t> result(new create_stream_t());
+        result->args.where.directory = directories_m[connection];
+        result->args.how = nfs3::create_how_t::GUARDED;
+        result->args.obj_attributes.set(nfs3::set_attr_t());
+        result->prefix = "f" + std::to_string(config_m.run_id) + "_";
+        result->cursor = cursors_m[connection];
+        return result;
+      }
+
+    private:
+      config_t config_m;
+      std::vector<nfs3::filehandle_t> directories_m;
+      std::vector<cursor_ptr_t> cursors_m;
+    };
+
+    // the directory with the files that are listed, looked up and stat'ed
+    struct tree_t {
+      nfs3::filehandle_t directory;
+      std::vector<std::string> names;
+      std::vector<nfs3::filehandle_t> handles;
+
+      bool setup(nfs_session_t& session, const nfs3::filehandle_t& root, const config_t& config) {
+        if ( !session.ensure_directory(root, "tree" + std::to_string(config.files), directory)) return false;
+        for (size_t i = 0; i < config.files; ++i) {
+            nfs3::filehandle_t handle;
+            names.push_back("f" + std::to_string(i));
+            if ( !session.ensure_file(directory, names.back(), handle)) return false;
+            handles.push_back(handle);
+          }
+        return !names.empty();
+      }
+    };
+
+    // complete listings of the tree - continued with the cookies of the replies
+    struct read_dir_plus_workload_t : workload_t {
+      explicit read_dir_plus_workload_t(const config_t& config) : config_m(config) {}
+
+      bool setup(nfs_session_t& session, const nfs3::filehandle_t& root) override {
+        return tree_m.setup(session, root, config_m);
+      }
+
+      struct read_dir_plus_stream_t : stream_t {
+        nfs_call_t next() override {
+          nfs_call_t result;
+          result.procedure = READDIRPLUS;
+          result.parameters = xdr::to_binary(args);
+          return result;
+        }
+
+        bool complete(const nfs_call_t&, const binary_reader_t& results) override {
+          nfs3::read_dir_plus_result_t result;
+          if ( !xdr::decode(results, result) || nfs3::status_t::OK != result.status) {
+              args.cookie = 0;
+              args.cookie_verifier = {};
+              return false;
+            }
+          if (result.is_finished || result.reply.empty()) {
+              args.cookie = 0;
+              args.cookie_verifier = {};
+            }
+          else {
+              args.cookie = result.reply.back().cookie;
+              args.cookie_verifier = result.cookie_verifier;
+            }
+          return true;
+        }
+
+        nfs3::read_dir_plus_args_t args;
+      };
+
+      stream_ptr_t stream(size_t) override {
+        std::unique_ptr<read_dir_plus_stream_t> result(new read_dir_plus_stream_t());
+        result->args.directory = tree_m.directory;
+        result->args.cookie = 0;
+        result->args.cookie_verifier = {};
+        result->args.dircount = config_m.rsize / 4;
+        result->args.maxcount = config_m.rsize;
+        return result;
+      }
+
+    private:
+      config_t config_m;
+      tree_t tree_m;
+    };
+
+    // GETATTR or LOOKUP of the files of the tree in turn
+    struct attribute_workload_t : workload_t {
+      attribute_workload_t(const config_t& config, procedure_t procedure)
+        : config_m(config), procedure_m(procedure)
+      {}
+
+      bool setup(nfs_session_t& session, const nfs3::filehandle_t& root) override {
+        if ( !tree_m.setup(session, root, config_m)) return false;
+        for (size_t i = 0; i < tree_m.names.size(); ++i) {
+            parameters_m.push_back(LOOKUP == procedure_m
+                                   ? xdr::to_binary(nfs3::dir_op_args_t { tree_m.directory, tree_m.names[i] })
+                                   : xdr::to_binary_with<xdr::filehandle_codec_t>(tree_m.handles[i]));
+          }
+        for (size_t connection = 0; connection < config_m.connections; ++connection) {
+            auto cursor = std::make_shared<cursor_t>();
+            cursor->next = connection * parameters_m.size() / config_m.connections; // spread the connections
+            cursors_m.push_back(cursor);
+          }
+        return true;
+      }
+
+      struct attribute_stream_t : stream_t {
+        nfs_call_t next() override {
+          nfs_call_t result;
+          result.procedure = procedure;
+          result.parameters = (*parameters)[cursor->next++ % parameters->size()];
+          return result;
+        }
+
+        uint32_t procedure;
+        const std::vector<binary_t>* parameters;
+        cursor_ptr_t cursor;
+      };
+
+      stream_ptr_t stream(size_t connection) override {
+        std::unique_ptr<attribute_stream_t> result(new attribute_stream_t());
+        result->procedure = procedure_m;
+        result->parameters = &parameters_m;
+        result->cursor = cursors_m[connection];
+        return result;
+      }
+
+    private:
+      config_t config_m;
+      procedure_t procedure_m;
+      tree_t tree_m;
+      std::vector<binary_t> parameters_m;
+      std::vector<cursor_ptr_t> cursors_m;
+    };
+  } // namespace
+
+  workload_ptr_t make_workload(const config_t& config)
+  {
+    if ("read" == config.name) return workload_ptr_t(new read_workload_t(config));
+    if ("write" == config.name) return workload_ptr_t(new write_workload_t(config));
+    if ("create" == config.name) return workload_ptr_t(new create_workload_t(config));
+    if ("readdirplus" == config.name) return workload_ptr_t(new read_dir_plus_workload_t(config));
+    if ("getattr" == config.name) return workload_ptr_t(new attribute_workload_t(config, GETATTR));
+    if ("lookup" == config.name) return workload_ptr_t(new attribute_workload_t(config, LOOKUP));
+    return {};
+  }
+
+} // namespace bench
@@ -0,0 +1,169 @@
+/*! @file Workloads of the load generator
+ * */
+#pragma once
+
+#include "rpc_client.h"
+
+#include "nfs/mount_types.h"
+#include "nfs/mount_xdr.h"
+#include "nfs/nfs3_types.h"
+#include "nfs/nfs3_xdr.h"
+#include "rpc/portmap.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace bench {
+
+  enum procedure_t : uint32_t {
+    GETATTR = 1,
+    LOOKUP = 3,
+    READ = 6,
+    WRITE = 7,
+    CREATE = 8,
+    MKDIR = 9,
+    READDIRPLUS = 17,
+  };
+
+  struct nfs_call_t {
+    uint32_t procedure = 0;
+    binary_t parameters;
+    uint64_t bytes = 0; // file data moved by the call
+  };
+
+  // the nfs status leads all results
+  inline bool ok(const binary_reader_t& results) {
+    return results.has_size(4) && nfs3::status_t::OK == results.get32<nfs3::status_t>(0);
+  }
+
+  inline uint32_t get_port(rpc_client_t& portmap, uint32_t program, uint32_t version) {
+    binary_builder_t builder;
+    builder.append32(program);
+    builder.append32(version);
+    builder.append32(rpc_client_t::UDP == portmap.protocol() ? portmap::UDP : portmap::TCP);
+    builder.append32(0);
+    binary_t reply;
+    binary_reader_t results;
+    if ( !portmap.call(portmap::PROGRAM, portmap::VERSION, 3, builder.release(), reply)
+         || !rpc_client_t::results(reply, results)
+         || !results.has_size(4)) return 0;
+    return results.get32(0);
+  }
+
+  inline bool mount(rpc_client_t& client, const std::string& path, nfs3::filehandle_t& root) {
+    binary_t reply;
+    binary_reader_t results;
+    mount::mount_result_t mounted;
+    if ( !client.call(mount::PROGRAM, mount::VERSION, 1, xdr::to_binary_with<xdr::directory_path_codec_t>(path), reply)
+         || !rpc_client_t::results(reply, results)
+         || !xdr::decode(results, mounted)
+         || mount::OK != mounted.status) return false;
+    root = mounted.filehandle;
+    return true;
+  }
+
+  /**
+   * @brief synchronous nfs calls to prepare the files of a workload
+   *
+   * Existing files and directories are reused, so a workload can run again on a server.
+   */
+  struct nfs_session_t {
+    explicit nfs_session_t(rpc_client_t& client)
+      : client_m(client)
+    {}
+
+    template<typename result_t>
+    bool call(uint32_t procedure, const binary_t& parameters, result_t& result) {
+      binary_t reply;
+      binary_reader_t results;
+      return client_m.call(nfs3::PROGRAM, nfs3::VERSION, procedure, parameters, reply)
+          && rpc_client_t::results(reply, results)
+          && xdr::decode(results, result)
+          && nfs3::status_t::OK == result.status;
+    }
+
+    bool lookup(const nfs3::filehandle_t& directory, const std::string& name, nfs3::filehandle_t& handle) {
+      nfs3::lookup_result_t result;
+      if ( !call(LOOKUP, xdr::to_binary(nfs3::dir_op_args_t { directory, name }), result)) return false;
+      handle = result.object_handle;
+      return true;
+    }
+
+    bool ensure_file(const nfs3::filehandle_t& directory, const std::string& name, nfs3::filehandle_t& handle) {
+      if (lookup(directory, name, handle)) return true;
+      nfs3::create_args_t args;
+      args.where = { directory, name };
+      args.how = nfs3::create_how_t::UNCHECKED;
+      args.obj_attributes.set(nfs3::set_attr_t());
+      nfs3::create_result_t result;
+      if ( !call(CREATE, xdr::to_binary(args), result) || !result.object.is<nfs3::filehandle_t>()) return false;
+      handle = result.object.get<nfs3::filehandle_t>();
+      return true;
+    }
+
+    bool ensure_directory(const nfs3::filehandle_t& directory, const std::string& name, nfs3::filehandle_t& handle) {
+      if (lookup(directory, name, handle)) return true;
+      nfs3::mkdir_args_t args;
+      args.where = { directory, name };
+      nfs3::mkdir_result_t result;
+      if ( !call(MKDIR, xdr::to_binary(args), result) || !result.object.is<nfs3::filehandle_t>()) return false;
+      handle = result.object.get<nfs3::filehandle_t>();
+      return true;
+    }
+
+    // fills the file with a pattern in stable writes of chunk bytes
+    bool fill(const nfs3::filehandle_t& file, uint64_t size, uint32_t chunk) {
+      nfs3::write_args_t args;
+      args.filehandle = file;
+      args.stable = nfs3::stable_how_t::FILE_SYNC;
+      for (uint64_t offset = 0; offset < size; offset += chunk) {
+          args.offset = offset;
+          args.count = static_cast<nfs3::count_t>(std::min<uint64_t>(chunk, size - offset));
+          args.data.assign(args.count, static_cast<uint8_t>(offset / chunk));
+          nfs3::write_result_t result;
+          if ( !call(WRITE, xdr::to_binary(args), result)) return false;
+        }
+      return true;
+    }
+
+  private:
+    rpc_client_t& client_m;
+  };
+
+  struct config_t {
+    std::string name; // of the workload
+    size_t connections = 1;
+    uint32_t rsize = 0x10000;
+    uint32_t wsize = 0x10000;
+    uint64_t file_size = 64 << 20;
+    size_t files = 1000; // in directories that are listed or looked up
+    bool stable = false; // FILE_SYNC writes instead of UNSTABLE
+    uint64_t run_id = 0; // keeps the names of created files unique
+  };
+
+  // the calls of one outstanding request slot - used by a single thread
+  struct stream_t {
+    virtual ~stream_t() = default;
+
+    virtual nfs_call_t next() = 0;
+    // false counts the call as failed
+    virtual bool complete(const nfs_call_t&, const binary_reader_t& results) { return ok(results); }
+  };
+  using stream_ptr_t = std::unique_ptr<stream_t>;
+
+  struct workload_t {
+    virtual ~workload_t() = default;
+
+    // creates the files on the server
+    virtual bool setup(nfs_session_t& session, const nfs3::filehandle_t& root) = 0;
+    // all streams of a connection run on one thread
+    virtual stream_ptr_t stream(size_t connection) = 0;
+  };
+  using workload_ptr_t = std::unique_ptr<workload_t>;
+
+  // read, write, create, readdirplus, getattr or lookup - nullptr for other names
+  workload_ptr_t make_workload(const config_t&);
+
+} // namespace bench
@@ -10,6 +10,8 @@
 #include "server/portmap_server.h"
 #include "server/mount_server.h"
 #include "server/nfs3_server.h"
+#include "server/worker_pool.h"
+#include "binary/buffer_pool.h"
 
 #include <iostream>
 #include <iterator>
@@ -21,6 +23,19 @@
 #include "winfs/winfs_directory.h"
 #include "container/string_convert.h"
 #include "winfs/file_change_notifier.h"
+#include "logging/logger.h"
+
+
+/*! @brief Writes the records of the server logger to glog
+ * */
+struct glog_sink_t : logging::sink_t {
+    void write(const logging::record_t& record) override {
+        auto severity = google::GLOG_INFO;
+        if (record.level == logging::level_t::WARNING) severity = google::GLOG_WARNING;
+        if (record.level == logging::level_t::FAILURE) severity = google::GLOG_ERROR;
+        google::LogMessage(record.component, 0, severity).stream() << record.message;
+    }
+};
 
 
 /*! @brief Reads and watches a path configuration file
@@ -73,23 +88,38 @@ private:
 
 struct program_t {
     program_t()
-        : nfs3_server_m(mount_server_m.cache())
+        : workers_m(worker_config())
+        , nfs3_server_m(mount_server_m.cache(), nfs3_config(), nfs3::PORT, FLAGS_workerThreads > 0 ? &workers_m : nullptr,
+                         static_cast<size_t>(std::max(1, FLAGS_socketThreads)))
     {}
 
+    static worker_pool_t::config_t worker_config() {
+        worker_pool_t::config_t config;
+        config.threads = static_cast<size_t>(std::max(0, FLAGS_workerThreads));
+        config.queue_depth = static_cast<size_t>(std::max(0, FLAGS_workerQueueDepth));
+        return config;
+    }
+
+    static nfs3::rpc_program::config_t nfs3_config() {
+        nfs3::rpc_program::config_t config;
+        config.attribute_cache.time_to_live = std::chrono::milliseconds(std::max(0, FLAGS_attributeCacheMs));
+        config.watch_changes = FLAGS_watchChanges;
+        config.write_buffer.memory_limit = static_cast<size_t>(std::max(0, FLAGS_writeBufferMb)) << 20;
+        config.read_max_size = config.write_max_size = static_cast<uint32_t>(std::max(0, FLAGS_transferKb)) << 10;
+        return config;
+    }
+
     void restore_cache() {
-        std::ifstream ifs(FLAGS_cachePath, std::ios_base::binary);
-        binary_t binary;
-        binary.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
-        if (!binary.empty()) {
-            mount_server_m.restore(binary);
+        mount_journal_t::config_t config;
+        config.path = FLAGS_cachePath;
+        config.checkpoint_interval = std::chrono::seconds(std::max(1, FLAGS_cacheCheckpointS));
+        if (!mount_server_m.persist(config)) {
+            LOG(WARNING) << "Mount cache \"" << FLAGS_cachePath << "\" was corrupt, clients have to mount again";
         }
     }
 
     void store_cache() {
-        binary_t binary = mount_server_m.cache().save();
-        std::ofstream ofs(FLAGS_cachePath, std::ios_base::binary);
-        ofs.write((char*)&binary[0], binary.size());
-        ofs.flush();
+        mount_server_m.checkpoint();
     }
 
     void run() {
@@ -102,6 +132,8 @@ struct program_t {
 
         restore_cache();
 
+        if (FLAGS_workerThreads > 0) workers_m.start();
+        nfs3_server_m.set_idle_timeout(std::chrono::seconds(std::max(0, FLAGS_idleConnectionS)));
         portmap_server_m.start();
         mount_server_m.start();
         nfs3_server_m.start();
@@ -114,10 +146,64 @@ struct program_t {
         std::string line;
         while (std::getline(std::cin, line)) {
             if (line == "quit" || line == "q") return;
+            if (line == "stats") print_stats(std::cout);
+            if (line.compare(0, 6, "stats ") == 0) write_stats(line.substr(6));
         }
     }
 
+    void write_stats(const std::string& file_path) {
+        std::ofstream ofs(file_path);
+        print_stats(ofs);
+        if (!ofs) std::cout << "failed to write stats to \"" << file_path << "\"" << std::endl;
+    }
+
+    void print_stats(std::ostream& out) {
+        auto objects = nfs3_server_m.object_cache_stats();
+        out << "open handles: " << objects.size
+            << " hits: " << objects.hits << " misses: " << objects.misses
+            << " hit rate: " << objects.hit_rate()
+            << " evictions: " << objects.evictions
+            << " invalidations: " << objects.invalidations << std::endl;
+        auto attributes = nfs3_server_m.attribute_cache_stats();
+        out << "cached attributes: " << attributes.size
+            << " hits: " << attributes.hits << " misses: " << attributes.misses
+            << " hit rate: " << attributes.hit_rate()
+            << " invalidations: " << attributes.invalidations << std::endl;
+        auto listings = nfs3_server_m.directory_listings_stats();
+        out << "directory listings: " << listings.listings << " entries: " << listings.size
+            << " continued: " << listings.hits << " restarted: " << listings.misses
+            << " evictions: " << listings.evictions << std::endl;
+        auto writes = nfs3_server_m.write_buffer_stats();
+        out << "buffered writes: " << writes.writes << " dirty bytes: " << writes.dirty_bytes
+            << " dirty files: " << writes.dirty_files << " written bytes: " << writes.written_bytes
+            << " forced flushes: " << writes.forced_flushes << " failures: " << writes.failures << std::endl;
+        auto duplicates = nfs3_server_m.duplicate_cache_stats();
+        out << "cached replies: " << duplicates.size << " bytes: " << duplicates.bytes
+            << " retransmissions answered: " << duplicates.hits << " dropped in progress: " << duplicates.in_progress
+            << " misses: " << duplicates.misses << " evictions: " << duplicates.evictions << std::endl;
+        auto connections = nfs3_server_m.connection_stats();
+        out << "nfs connections: " << connections.connections << " hosts: " << connections.hosts
+            << " max per host: " << connections.max_per_host
+            << " buffered bytes: " << connections.memory << " max per connection: " << connections.max_memory
+            << " accepted: " << connections.accepted << " replaced: " << connections.replaced
+            << " closed idle: " << connections.reaped << std::endl;
+        auto workers = workers_m.stats();
+        out << "worker calls: " << workers.executed << " stolen: " << workers.stolen
+            << " queued: " << workers.queued << " run on socket threads: " << workers.rejected << std::endl;
+        auto journal = mount_server_m.cache().journal_stats();
+        out << "mount journal generation: " << journal.generation << " records: " << journal.records
+            << " replayed: " << journal.replayed << " torn: " << journal.torn
+            << " checkpoints: " << journal.checkpoints << " failures: " << journal.failures << std::endl;
+        auto buffers = buffer_pool_t::shared().stats();
+        out << "pooled buffers: " << buffers.buffers << " bytes: " << buffers.bytes
+            << " reused: " << buffers.hits << " allocated: " << buffers.misses << std::endl;
+        rpc_stats_t::write(out, portmap_server_m.rpc_stats());
+        rpc_stats_t::write(out, mount_server_m.rpc_stats());
+        rpc_stats_t::write(out, nfs3_server_m.rpc_stats());
+    }
+
 private:
+    worker_pool_t workers_m; // outlives the servers
     portmap_server_t portmap_server_m;
     mount_server_t mount_server_m;
     nfs3_server_t nfs3_server_m;
@@ -13,6 +13,16 @@ DEFINE_string(user_id,"0", "User ID");
 DEFINE_string(group_id,"0", "Group ID");
 DEFINE_string(pathFile,"", "File with local export Paths");
 DEFINE_string(cachePath,"./mount_cache", "Mount cache path");
+DEFINE_int32(cacheCheckpointS, 60, "Seconds between snapshots of the mount cache, changes are journaled in between");
+DEFINE_int32(attributeCacheMs, 1000, "Milliseconds file attributes are cached, 0 disables the cache");
+DEFINE_bool(watchChanges, true, "Watches exported directories to invalidate cached attributes");
+DEFINE_string(logLevel, "info", "Level of the server log: trace, info, warning, failure or off");
+DEFINE_int32(workerThreads, 4, "Threads that execute nfs calls, 0 executes them on the socket threads");
+DEFINE_int32(socketThreads, 1, "Threads that receive nfs calls, each with its own udp socket where supported");
+DEFINE_int32(workerQueueDepth, 1024, "Nfs calls queued for the workers before the socket threads execute them");
+DEFINE_int32(idleConnectionS, 300, "Seconds without calls before a tcp connection is closed, 0 keeps idle connections");
+DEFINE_int32(transferKb, 1024, "Kilobytes of the largest READ and WRITE offered to clients, 4 to 1024");
+DEFINE_int32(writeBufferMb, 64, "Megabytes of UNSTABLE writes buffered before they are written, 0 writes before replying");
 
 #include "cli.h"
 
@@ -27,9 +37,18 @@ int main(int argc, char *argv[])
     google::InitGoogleLogging(argv[0]);
     LOG(INFO) << "WINNFSDPP Version: " << version;
 
+    logging::level_t level;
+    if (!logging::parse_level(FLAGS_logLevel, level)) {
+        LOG(ERROR) << "Unknown log level \"" << FLAGS_logLevel << "\"";
+        return 1;
+    }
+    logging::set_level(level);
+    logging::set_sink(std::make_shared<glog_sink_t>());
+
     LOG(INFO) << "Starting windows socket sesstion";
     wsa_session_t wsa_session(2, 2);
     program_t program;
     program.run();
+    logging::flush();
     LOG(INFO) << "Returned from CLI loop, exiting";
 }
@@ -2,5 +2,6 @@
 
 #include <vector>
 #include <cstdint>
+#include <stddef.h>
 
 typedef std::vector<uint8_t> binary_t;
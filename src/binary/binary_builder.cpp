@@ -1,57 +1,44 @@
 #include "binary_builder.h"
 
+#include <utility>
+#include <algorithm>
+#include <cstring>
+
 void binary_builder_t::clear()
 {
-  binary_m.clear();
-  offset_m = 0;
+  offset_m = size_m = 0;
 }
 
-void binary_builder_t::seek_end()
+binary_t binary_builder_t::release()
 {
-  offset_m = binary_m.size();
+  binary_m.resize(size_m);
+  offset_m = size_m = 0;
+  return std::move(binary_m);
 }
 
-void binary_builder_t::seek_to(size_t offset)
+void binary_builder_t::reserve(size_t size)
 {
-  offset_m = offset;
+  if (binary_m.size() - size_m < size) binary_m.resize(size_m + size);
 }
 
-void binary_builder_t::append8(uint8_t value)
-{
-  if (offset_m >= size()) {
-      binary_m.push_back(value);
-    }
-  else {
-      binary_m[offset_m] = value;
-    }
-  ++offset_m;
-}
-
-void binary_builder_t::append32(uint32_t value)
+void binary_builder_t::seek_end()
 {
-  for (auto n = sizeof(value); n--;) {
-      append8((value >> (n*8)) & 255);
-    }
+  offset_m = size_m;
 }
 
-void binary_builder_t::append64(uint64_t value)
+void binary_builder_t::seek_to(size_t offset)
 {
-  for (auto n = sizeof(value); n--;) {
-      append8((value >> (n*8)) & 255);
-    }
+  offset_m = offset;
 }
 
-void binary_builder_t::append_binary(const uint8_t* binary, size_t size)
+void binary_builder_t::append_binary_slow(const uint8_t* binary, size_t size)
 {
-  auto binary_size = binary_m.size();
-  while (offset_m < binary_size && size > 0) {
-      binary_m[offset_m] = *binary;
-      ++offset_m;
-      ++binary;
-      --size;
-    }
-  if (size > 0) {
-      binary_m.insert(binary_m.end(), binary, binary + size);
-      offset_m += size;
+  auto end = std::max(offset_m, size_m);
+  if (binary_m.size() - end < size) {
+      binary_m.resize(std::max<size_t>(std::max<size_t>(64, 2 * binary_m.size()), end + size));
     }
+  if (offset_m > size_m) std::memset(&binary_m[size_m], 0, offset_m - size_m); // seeked past the end
+  if (size > 0) std::memcpy(&binary_m[offset_m], binary, size);
+  offset_m += size;
+  size_m = std::max(size_m, offset_m);
 }
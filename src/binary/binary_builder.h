@@ -1,27 +1,46 @@
 #pragma once
 
 #include "binary.h"
+#include "byte_order.h"
 
 #include <vector>
 #include <array>
 #include <cstdint>
+#include <cstring>
 
 struct binary_builder_t {
-	size_t size() const { return binary_m.size(); }
+	size_t size() const { return size_m; }
 	size_t offset() const { return offset_m; }
 
-	binary_t build() const { return binary_m; }
+	binary_t build() const { return binary_t(binary_m.begin(), binary_m.begin() + size_m); }
+	// moves the built binary out and leaves the builder empty
+	binary_t release();
 
 	void clear();
+	// reserves room for size more bytes after the current end
+	void reserve(size_t size);
 
 	void seek_end();
 	void seek_to(size_t offset);
 
-	void append8(uint8_t value);
-	void append32(uint32_t value);
-	void append64(uint64_t value);
+	void append8(uint8_t value) { append_binary(&value, sizeof(value)); }
+	// whole words are written in network byte order at once
+	void append32(uint32_t value) {
+		value = byte_order::big32(value);
+		append_binary(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+	}
+	void append64(uint64_t value) {
+		value = byte_order::big64(value);
+		append_binary(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+	}
 
-	void append_binary(const uint8_t* binary, size_t);
+	void append_binary(const uint8_t* binary, size_t size) {
+		if (offset_m == size_m && size <= binary_m.size() - size_m) { // common case - room at the end
+			if (size > 0) std::memcpy(&binary_m[offset_m], binary, size);
+			offset_m = size_m += size;
+		}
+		else append_binary_slow(binary, size);
+	}
 
 	// these allow to write enum classes
 	template<typename type>
@@ -48,7 +67,11 @@ struct binary_builder_t {
 	    }
 	}
 
+private:
+	void append_binary_slow(const uint8_t* binary, size_t size);
+
 private:
 	size_t offset_m = 0;
+	size_t size_m = 0; // binary_m grows ahead in zero filled doubling steps - most appends are one memcpy
 	binary_t binary_m;
 };
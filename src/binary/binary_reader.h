@@ -1,12 +1,14 @@
 #pragma once
 
 #include "binary.h"
+#include "byte_order.h"
 
 #include <vector>
 #include <array>
 #include <string>
 #include <cstdint>
 #include <cassert>
+#include <cstring>
 
 struct binary_reader_t
 {
@@ -23,6 +25,7 @@ struct binary_reader_t
     return binary_reader_t(begin, end);
   }
 
+  const uint8_t* data() const { return begin_m; }
   size_t size() const { return end_m - begin_m; }
   bool empty() const { return end_m == begin_m; }
 
@@ -34,8 +37,20 @@ struct binary_reader_t
     return begin_m[offset];
   }
 
-  uint32_t get32(size_t offset) const;
-  uint64_t get64(size_t offset) const;
+  // whole words are read in network byte order at once
+  uint32_t get32(size_t offset) const {
+    assert(has_size(offset + sizeof(uint32_t)));
+    uint32_t result;
+    std::memcpy(&result, begin_m + offset, sizeof(result));
+    return byte_order::big32(result);
+  }
+
+  uint64_t get64(size_t offset) const {
+    assert(has_size(offset + sizeof(uint64_t)));
+    uint64_t result;
+    std::memcpy(&result, begin_m + offset, sizeof(result));
+    return byte_order::big64(result);
+  }
 
   template<typename value_t>
   value_t get32(size_t offset) const { return static_cast<value_t>(get32(offset)); }
@@ -48,7 +63,10 @@ struct binary_reader_t
     return { begin_m + offset, begin_m + offset + size };
   }
 
-  void get_binary(size_t offset, uint8_t* data, size_t size) const;
+  void get_binary(size_t offset, uint8_t* data, size_t size) const {
+    assert(has_size(offset + size));
+    if (size > 0) std::memcpy(data, begin_m + offset, size);
+  }
 
   template<size_t size>
   void get_binary(size_t offset, const uint8_t (&data)[size]) const {
@@ -82,6 +100,86 @@ struct binary_reader_t
   }
 
 private:
-  it begin_m;
-  it end_m;
+  it begin_m = nullptr;
+  it end_m = nullptr;
+};
+
+/**
+ * @brief bounds checked sequential reads from a binary_reader_t
+ *
+ * Reading past the end yields zeros and invalidates the cursor,
+ * so a whole structure can be read before checking valid() once.
+ */
+struct binary_cursor_t
+{
+  binary_cursor_t() = default;
+  explicit binary_cursor_t(const binary_reader_t& reader, size_t offset = 0)
+    : reader_m(reader), offset_m(offset), valid_m(offset <= reader.size())
+  {}
+
+  bool valid() const { return valid_m; }
+  size_t offset() const { return offset_m; }
+  size_t remaining() const { return valid_m ? reader_m.size() - offset_m : 0; }
+
+  uint32_t get32() {
+    if ( !take(sizeof(uint32_t))) return 0;
+    return reader_m.get32(offset_m - sizeof(uint32_t));
+  }
+
+  uint64_t get64() {
+    if ( !take(sizeof(uint64_t))) return 0;
+    return reader_m.get64(offset_m - sizeof(uint64_t));
+  }
+
+  template<typename value_t>
+  value_t get32() { return static_cast<value_t>(get32()); }
+
+  bool get_binary(uint8_t* data, size_t size) {
+    if ( !take(size)) return false;
+    reader_m.get_binary(offset_m - size, data, size);
+    return true;
+  }
+
+  template<size_t size>
+  bool get_binary(std::array<uint8_t, size>& data) { return get_binary(&data[0], size); }
+
+  // size characters - empty if out of bounds
+  std::string get_string(size_t size) {
+    if ( !take(size)) return {};
+    return reader_m.get_string(offset_m - size, size);
+  }
+
+  std::wstring get_wstring(size_t size) {
+    if (size > remaining() / sizeof(wchar_t) || !take(sizeof(wchar_t) * size)) {
+        valid_m = false;
+        return {};
+      }
+    return reader_m.get_wstring(offset_m - sizeof(wchar_t) * size, size);
+  }
+
+  // the next size bytes as reader - empty if out of bounds
+  binary_reader_t get_reader(size_t size) {
+    if ( !take(size)) return {};
+    return reader_m.get_reader(offset_m - size, size);
+  }
+
+  bool skip(size_t size) { return take(size); }
+
+  // skips xdr padding up to the next multiple of 4 bytes
+  bool align4() { return take((4 - (offset_m & 3)) & 3); }
+
+private:
+  bool take(size_t size) {
+    if ( !valid_m || reader_m.size() - offset_m < size) {
+        valid_m = false;
+        return false;
+      }
+    offset_m += size;
+    return true;
+  }
+
+private:
+  binary_reader_t reader_m;
+  size_t offset_m = 0;
+  bool valid_m = false;
 };
@@ -0,0 +1,71 @@
+#include "buffer_pool.h"
+
+buffer_pool_t::buffer_pool_t()
+  : buffer_pool_t(config_t())
+{}
+
+buffer_pool_t::buffer_pool_t(const config_t& config)
+  : config_m(config)
+  , classes_m(MAX_BUFFER / GRANULE + 1)
+{}
+
+buffer_pool_t& buffer_pool_t::shared()
+{
+  static buffer_pool_t pool;
+  return pool;
+}
+
+binary_t buffer_pool_t::acquire(size_t capacity)
+{
+  binary_t result;
+  if (capacity < GRANULE || capacity > MAX_BUFFER) {
+      result.reserve(capacity);
+      return result;
+    }
+  auto index = (capacity + GRANULE - 1) / GRANULE;
+  {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    auto& buffers = classes_m[index];
+    if ( !buffers.empty()) {
+        result = std::move(buffers.back());
+        buffers.pop_back();
+        bytes_m -= result.capacity();
+      }
+  }
+  if (result.capacity() >= capacity) {
+      hits_m.fetch_add(1, std::memory_order_relaxed);
+      return result;
+    }
+  misses_m.fetch_add(1, std::memory_order_relaxed);
+  result.reserve(index * GRANULE); // the whole class - fits every later acquire of it
+  return result;
+}
+
+void buffer_pool_t::release(binary_t&& binary)
+{
+  auto capacity = binary.capacity();
+  if (capacity < GRANULE || capacity > MAX_BUFFER) return;
+  binary.clear();
+  std::lock_guard<std::mutex> lock(mutex_m);
+  if (bytes_m + capacity > config_m.budget) return;
+  bytes_m += capacity;
+  classes_m[capacity / GRANULE].push_back(std::move(binary));
+}
+
+void buffer_pool_t::release(segmented_binary_t&& segments)
+{
+  for (auto& segment : segments.release()) {
+      if ( !segment.borrowed) release(std::move(segment.owned));
+    }
+}
+
+buffer_pool_t::stats_t buffer_pool_t::stats() const
+{
+  stats_t result;
+  result.hits = hits_m.load(std::memory_order_relaxed);
+  result.misses = misses_m.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_m);
+  for (auto& buffers : classes_m) result.buffers += buffers.size();
+  result.bytes = bytes_m;
+  return result;
+}
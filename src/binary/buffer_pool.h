@@ -0,0 +1,62 @@
+#pragma once
+
+#include "binary.h"
+#include "segmented_binary.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief reuses the large buffers of requests and replies
+ *
+ * Buffers are kept in classes of GRANULE bytes. acquire() rounds the size up to the
+ * next class, release() rounds the capacity down, so every pooled buffer of a class
+ * fits the acquired size. Buffers below GRANULE are left to the allocator, released
+ * buffers above the budget are freed.
+ *
+ * All methods are thread safe.
+ */
+struct buffer_pool_t {
+  enum : size_t {
+    GRANULE = 0x10000,
+    MAX_BUFFER = 0x200000, // larger buffers are never pooled
+  };
+
+  struct config_t {
+    size_t budget = 64 << 20; // bytes of idle buffers
+  };
+
+  struct stats_t {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t buffers = 0; // idle
+    size_t bytes = 0; // idle
+  };
+
+  buffer_pool_t();
+  explicit buffer_pool_t(const config_t&);
+
+  buffer_pool_t(const buffer_pool_t&) = delete;
+  buffer_pool_t& operator= (const buffer_pool_t&) = delete;
+
+  // pool of the whole process - shared by the servers and the nfs procedures
+  static buffer_pool_t& shared();
+
+  // empty binary with at least capacity bytes reserved
+  binary_t acquire(size_t capacity);
+  void release(binary_t&&);
+  // releases the owned segments
+  void release(segmented_binary_t&&);
+
+  stats_t stats() const;
+
+private:
+  config_t config_m;
+  mutable std::mutex mutex_m;
+  std::vector<std::vector<binary_t>> classes_m;
+  size_t bytes_m = 0;
+  std::atomic<uint64_t> hits_m {0};
+  std::atomic<uint64_t> misses_m {0};
+};
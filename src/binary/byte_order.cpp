@@ -0,0 +1 @@
+#include "byte_order.h"
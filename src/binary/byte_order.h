@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
+
+/**
+ * @brief conversion between host and network (big endian) byte order
+ */
+namespace byte_order {
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  inline uint32_t big32(uint32_t value) { return value; }
+  inline uint64_t big64(uint64_t value) { return value; }
+#elif defined(_MSC_VER)
+  inline uint32_t big32(uint32_t value) { return _byteswap_ulong(value); }
+  inline uint64_t big64(uint64_t value) { return _byteswap_uint64(value); }
+#else
+  inline uint32_t big32(uint32_t value) { return __builtin_bswap32(value); }
+  inline uint64_t big64(uint64_t value) { return __builtin_bswap64(value); }
+#endif
+
+} // namespace byte_order
@@ -0,0 +1,24 @@
+#include "crc32.h"
+
+#include <array>
+
+namespace {
+  using table_t = std::array<uint32_t, 256>;
+
+  table_t make_table() {
+    table_t result;
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (auto bit = 0; bit < 8; ++bit) crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        result[i] = crc;
+      }
+    return result;
+  }
+} // namespace
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc) {
+  static const table_t table = make_table();
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief CRC-32 (IEEE 802.3, as zlib) of persisted data
+ *
+ * Pass the previous result as crc to continue a checksum over several parts.
+ */
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
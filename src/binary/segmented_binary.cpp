@@ -0,0 +1,69 @@
+#include "segmented_binary.h"
+
+#include <algorithm>
+
+void segmented_binary_t::append(binary_t&& binary)
+{
+  if (binary.empty()) return;
+  size_m += binary.size();
+  segments_m.emplace_back();
+  segments_m.back().owned = std::move(binary);
+}
+
+void segmented_binary_t::append(segmented_binary_t&& other)
+{
+  size_m += other.size_m;
+  for (auto& segment : other.segments_m) {
+      segments_m.push_back(std::move(segment));
+    }
+  other.segments_m.clear();
+  other.size_m = 0;
+}
+
+void segmented_binary_t::append_borrowed(const uint8_t* data, size_t size)
+{
+  if (0 == size) return;
+  size_m += size;
+  segments_m.emplace_back();
+  segments_m.back().borrowed = data;
+  segments_m.back().borrowed_size = size;
+}
+
+void segmented_binary_t::prepend(binary_t&& binary)
+{
+  if (binary.empty()) return;
+  size_m += binary.size();
+  segments_m.emplace(segments_m.begin());
+  segments_m.front().owned = std::move(binary);
+}
+
+void segmented_binary_t::copy_to(binary_t& binary, size_t offset) const
+{
+  // grows geometrically - appending to a pending send buffer stays linear
+  auto needed = binary.size() + size_m - std::min(offset, size_m);
+  if (needed > binary.capacity()) binary.reserve(std::max(2 * binary.capacity(), needed));
+  for (const auto& segment : segments_m) {
+      auto size = segment.size();
+      if (offset >= size) {
+          offset -= size;
+          continue;
+        }
+      binary.insert(binary.end(), segment.data() + offset, segment.data() + size);
+      offset = 0;
+    }
+}
+
+binary_t segmented_binary_t::flatten() const
+{
+  binary_t result;
+  copy_to(result);
+  return result;
+}
+
+segmented_binary_t::segments_t segmented_binary_t::release()
+{
+  segments_t result;
+  result.swap(segments_m);
+  size_m = 0;
+  return result;
+}
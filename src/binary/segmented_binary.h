@@ -0,0 +1,49 @@
+#pragma once
+
+#include "binary.h"
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief binary made of several segments that are sent with one gather operation
+ *
+ * Owned segments hold their bytes, so large payloads can be moved in without a copy.
+ * Borrowed segments only point to memory that has to outlive the segmented binary.
+ */
+struct segmented_binary_t
+{
+  struct segment_t {
+    binary_t owned;
+    const uint8_t* borrowed = nullptr;
+    size_t borrowed_size = 0;
+
+    const uint8_t* data() const { return borrowed ? borrowed : owned.data(); }
+    size_t size() const { return borrowed ? borrowed_size : owned.size(); }
+  };
+  using segments_t = std::vector<segment_t>;
+
+  segmented_binary_t() = default;
+  segmented_binary_t(binary_t&& binary) { append(std::move(binary)); }
+
+  size_t size() const { return size_m; }
+  bool empty() const { return 0 == size_m; }
+
+  const segments_t& segments() const { return segments_m; }
+
+  void append(binary_t&& binary);
+  void append(segmented_binary_t&& other);
+  void append_borrowed(const uint8_t* data, size_t size);
+  void prepend(binary_t&& binary);
+
+  // copies all bytes starting at offset to the end of binary
+  void copy_to(binary_t& binary, size_t offset = 0) const;
+  binary_t flatten() const;
+
+  // moves the segments out and leaves the binary empty
+  segments_t release();
+
+private:
+  segments_t segments_m;
+  size_t size_m = 0;
+};
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief bounded cache of open handles shared between concurrent users
+ *
+ * The keys are spread over shards, each with its own lock and least recently used list.
+ * get() returns a reference counted handle. A handle that is evicted or invalidated
+ * is closed when its last user releases it.
+ *
+ * Handles that were not used for idle_timeout are dropped by a sweep. The sweep runs
+ * at most twice per idle_timeout during get(), or when evict_idle() is called.
+ *
+ * handle_t needs a valid() member. Invalid handles are returned but never cached.
+ */
+template<typename key_t, typename handle_t, typename hash_t = std::hash<key_t>, typename clock_source_t = std::chrono::steady_clock>
+struct handle_cache_t {
+  using handle_ptr_t = std::shared_ptr<handle_t>;
+  using time_point_t = typename clock_source_t::time_point;
+  using duration_t = typename clock_source_t::duration;
+
+  struct config_t {
+    size_t capacity = 1024; // open handles kept by the cache
+    size_t shards = 16;
+    duration_t idle_timeout = std::chrono::seconds(10);
+  };
+
+  struct stats_t {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0; // by capacity or idle timeout
+    uint64_t invalidations = 0;
+    size_t size = 0;
+
+    double hit_rate() const {
+      auto total = hits + misses;
+      return 0 == total ? 0.0 : static_cast<double>(hits) / total;
+    }
+  };
+
+  explicit handle_cache_t(const config_t& config = config_t())
+    : config_m(config)
+    , shards_m(std::max<size_t>(1, config.shards))
+    , shard_capacity_m(std::max<size_t>(1, (config.capacity + shards_m.size() - 1) / shards_m.size()))
+    , next_sweep_m(clock_source_t::now().time_since_epoch().count())
+  {}
+
+  handle_cache_t(const handle_cache_t&) = delete;
+  handle_cache_t& operator= (const handle_cache_t&) = delete;
+
+  const config_t& config() const { return config_m; }
+
+  // returns the cached handle or stores the result of open() - open is called without a lock
+  template<typename open_t> // handle_t ()
+  handle_ptr_t get(const key_t& key, const open_t& open) {
+    auto now = clock_source_t::now();
+    maybe_sweep(now);
+    auto& shard = shard_for(key);
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.index.find(key);
+      if (it != shard.index.end()) {
+          touch(shard, it->second, now);
+          hits_m.fetch_add(1, std::memory_order_relaxed);
+          return it->second->handle;
+        }
+    }
+    misses_m.fetch_add(1, std::memory_order_relaxed);
+    auto handle = std::make_shared<handle_t>(open());
+    if ( !handle->valid()) return handle;
+
+    std::vector<handle_ptr_t> released; // closed after the lock is released
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // opened concurrently - share the first one
+        released.push_back(std::move(handle));
+        touch(shard, it->second, now);
+        return it->second->handle;
+      }
+    shard.lru.push_front({ key, handle, now });
+    shard.index.emplace(key, shard.lru.begin());
+    while (shard.lru.size() > shard_capacity_m) {
+        released.push_back(std::move(shard.lru.back().handle));
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+        evictions_m.fetch_add(1, std::memory_order_relaxed);
+      }
+    return handle;
+  }
+
+  // drops the handle - users that still hold it keep it open
+  bool invalidate(const key_t& key) {
+    handle_ptr_t released;
+    auto& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) return false;
+    released = std::move(it->second->handle);
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+    invalidations_m.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // drops all handles with a matching key (e.g. every access mode of one file)
+  template<typename predicate_t> // bool (const key_t&)
+  size_t invalidate_if(const predicate_t& predicate) {
+    size_t count = 0;
+    for (auto& shard : shards_m) {
+        std::vector<handle_ptr_t> released;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.lru.begin(); it != shard.lru.end();) {
+            if ( !predicate(it->key)) {
+                ++it;
+                continue;
+              }
+            released.push_back(std::move(it->handle));
+            shard.index.erase(it->key);
+            it = shard.lru.erase(it);
+            ++count;
+          }
+      }
+    invalidations_m.fetch_add(count, std::memory_order_relaxed);
+    return count;
+  }
+
+  // drops handles that are not in use and were idle for idle_timeout
+  size_t evict_idle(time_point_t now = clock_source_t::now()) {
+    size_t count = 0;
+    auto limit = now - config_m.idle_timeout;
+    for (auto& shard : shards_m) {
+        std::vector<handle_ptr_t> released;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        // the list is ordered by last use - stop at the first recent entry
+        for (auto it = shard.lru.end(); it != shard.lru.begin();) {
+            --it;
+            if (it->last_used > limit) break;
+            if (1 < it->handle.use_count()) continue;
+            released.push_back(std::move(it->handle));
+            shard.index.erase(it->key);
+            it = shard.lru.erase(it);
+            ++count;
+          }
+      }
+    evictions_m.fetch_add(count, std::memory_order_relaxed);
+    return count;
+  }
+
+  void clear() {
+    for (auto& shard : shards_m) {
+        std::list<entry_t> released;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.index.clear();
+        released.swap(shard.lru);
+      }
+  }
+
+  size_t size() const {
+    size_t result = 0;
+    for (auto& shard : shards_m) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        result += shard.lru.size();
+      }
+    return result;
+  }
+
+  stats_t stats() const {
+    stats_t result;
+    result.hits = hits_m.load(std::memory_order_relaxed);
+    result.misses = misses_m.load(std::memory_order_relaxed);
+    result.evictions = evictions_m.load(std::memory_order_relaxed);
+    result.invalidations = invalidations_m.load(std::memory_order_relaxed);
+    result.size = size();
+    return result;
+  }
+
+private:
+  struct entry_t {
+    key_t key;
+    handle_ptr_t handle;
+    time_point_t last_used;
+  };
+  using lru_t = std::list<entry_t>;
+  using lru_it = typename lru_t::iterator;
+
+  struct shard_t {
+    mutable std::mutex mutex;
+    lru_t lru; // most recently used first
+    std::unordered_map<key_t, lru_it, hash_t> index;
+  };
+
+  shard_t& shard_for(const key_t& key) {
+    // spread the bits - hashes of integers are often the identity
+    uint64_t hash = hash_t()(key) * 0x9E3779B97F4A7C15ull;
+    return shards_m[(hash >> 32) % shards_m.size()];
+  }
+
+  static void touch(shard_t& shard, lru_it it, time_point_t now) {
+    it->last_used = now;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it);
+  }
+
+  void maybe_sweep(time_point_t now) {
+    auto next = next_sweep_m.load(std::memory_order_relaxed);
+    auto count = now.time_since_epoch().count();
+    if (count < next) return;
+    auto following = count + (config_m.idle_timeout / 2).count();
+    if ( !next_sweep_m.compare_exchange_strong(next, following)) return; // another thread sweeps
+    evict_idle(now);
+  }
+
+private:
+  config_t config_m;
+  std::vector<shard_t> shards_m;
+  size_t shard_capacity_m;
+  std::atomic<typename duration_t::rep> next_sweep_m;
+  std::atomic<uint64_t> hits_m {0};
+  std::atomic<uint64_t> misses_m {0};
+  std::atomic<uint64_t> evictions_m {0};
+  std::atomic<uint64_t> invalidations_m {0};
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief grow only map of ids to values that readers find without locks
+ *
+ * The table stores pointers to values owned by the caller and never removes them.
+ * Lookups probe an open addressed array with atomic loads only - no lock, no
+ * reference count and no allocation - so any number of readers never contend with
+ * each other or with the writer.
+ *
+ * Only one writer at a time - the caller serializes inserts. A full table is copied
+ * into one of twice the size that is published afterwards. Readers might still probe
+ * the former one, so it is kept until the table is destroyed - all of them together
+ * are smaller than the current one.
+ */
+template<typename value_t>
+struct id_table_t {
+  using id_t = uint64_t;
+
+  explicit id_table_t(size_t capacity = 64) {
+    size_t size = 16;
+    while (size < capacity * 2) size *= 2;
+    publish(std::unique_ptr<table_t>(new table_t(size)));
+  }
+
+  id_table_t(const id_table_t&) = delete;
+  id_table_t& operator= (const id_table_t&) = delete;
+
+  size_t size() const { return size_m; }
+
+  // nullptr if the id is not stored
+  const value_t* find(id_t id) const {
+    auto table = current_m.load(std::memory_order_acquire);
+    for (auto index = table->index(id);; index = table->next(index)) {
+        auto& slot = table->slots[index];
+        auto value = slot.value.load(std::memory_order_acquire);
+        if ( !value) return nullptr; // ids are never removed - the probe ends at a free slot
+        if (id == slot.id.load(std::memory_order_relaxed)) return value;
+      }
+  }
+
+  // stores the value - false if the id is stored already
+  bool insert(id_t id, const value_t* value) {
+    if ( !value || find(id)) return false;
+    if ((size_m + 1) * 2 > current()->size()) grow();
+    current()->put(id, value);
+    ++size_m;
+    return true;
+  }
+
+  // tables grow on insert otherwise
+  void reserve(size_t count) {
+    if (count * 2 > current()->size()) grow(count);
+  }
+
+private:
+  struct slot_t {
+    std::atomic<id_t> id {0};
+    std::atomic<const value_t*> value {nullptr}; // set last - a value marks the slot used
+  };
+
+  struct table_t {
+    explicit table_t(size_t size)
+      : mask(size - 1)
+      , shift(64 - bits(size))
+      , slots(new slot_t[size])
+    {}
+
+    size_t size() const { return mask + 1; }
+
+    // fibonacci hashing spreads sequential ids
+    size_t index(id_t id) const { return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> shift); }
+    size_t next(size_t index) const { return (index + 1) & mask; }
+
+    void put(id_t id, const value_t* value) {
+      auto index = this->index(id);
+      while (slots[index].value.load(std::memory_order_relaxed)) index = next(index);
+      slots[index].id.store(id, std::memory_order_relaxed);
+      slots[index].value.store(value, std::memory_order_release);
+    }
+
+    static unsigned bits(size_t size) {
+      unsigned result = 0;
+      while (size > 1) {
+          size >>= 1;
+          ++result;
+        }
+      return result;
+    }
+
+    const size_t mask;
+    const unsigned shift;
+    const std::unique_ptr<slot_t[]> slots;
+  };
+
+  table_t* current() const { return current_m.load(std::memory_order_relaxed); }
+
+  void grow(size_t count = 0) {
+    auto size = current()->size() * 2;
+    while (size < count * 2) size *= 2;
+    std::unique_ptr<table_t> table(new table_t(size));
+    auto former = current();
+    for (size_t index = 0; index < former->size(); ++index) {
+        auto value = former->slots[index].value.load(std::memory_order_relaxed);
+        if (value) table->put(former->slots[index].id.load(std::memory_order_relaxed), value);
+      }
+    publish(std::move(table));
+  }
+
+  void publish(std::unique_ptr<table_t>&& table) {
+    current_m.store(table.get(), std::memory_order_release);
+    tables_m.push_back(std::move(table));
+  }
+
+private:
+  std::atomic<table_t*> current_m {nullptr};
+  std::vector<std::unique_ptr<table_t>> tables_m; // the current one and all readers might probe
+  size_t size_m = 0;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @brief counts latencies in log-linear buckets of nanoseconds
+ *
+ * Every power of two range is split into SUB_BUCKETS buckets, so a percentile is off by
+ * less than 1/SUB_BUCKETS of its value. Values above 2^VALUE_BITS ns (18 minutes) are
+ * counted in the last bucket. Recording is a few shifts and one increment.
+ *
+ * Concurrent recorders keep their own bucket counters and add them with add_bucket().
+ */
+struct latency_histogram_t {
+  using duration_t = std::chrono::nanoseconds;
+
+  enum : uint32_t {
+    SUB_BUCKET_BITS = 4,
+    SUB_BUCKETS = 1u << SUB_BUCKET_BITS,
+    VALUE_BITS = 40,
+    RANGES = VALUE_BITS - SUB_BUCKET_BITS,
+    BUCKETS = (RANGES + 1) * SUB_BUCKETS,
+  };
+
+  static uint64_t value(duration_t latency) {
+    auto value = static_cast<uint64_t>(std::max<duration_t::rep>(0, latency.count()));
+    return std::min(value, (uint64_t(1) << VALUE_BITS) - 1);
+  }
+
+  // values below SUB_BUCKETS have their own bucket, above the leading bits select one
+  static size_t bucket(uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+    auto range = 63 - leading_zeros(value) - SUB_BUCKET_BITS + 1;
+    auto sub_bucket = (value >> (range - 1)) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>(range) * SUB_BUCKETS + static_cast<size_t>(sub_bucket);
+  }
+
+  // largest value counted in the bucket
+  static uint64_t upper_bound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    auto range = bucket / SUB_BUCKETS;
+    auto sub_bucket = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub_bucket + 1) << (range - 1)) - 1;
+  }
+
+  void record(duration_t latency) {
+    auto v = value(latency);
+    ++buckets_m[bucket(v)];
+    ++count_m;
+    max_m = std::max(max_m, v);
+  }
+
+  void add_bucket(size_t bucket, uint64_t count) {
+    if (0 == count) return;
+    buckets_m[bucket] += count;
+    count_m += count;
+  }
+  void add_max(duration_t latency) { max_m = std::max(max_m, value(latency)); }
+
+  void merge(const latency_histogram_t& other) {
+    for (size_t i = 0; i < buckets_m.size(); ++i) buckets_m[i] += other.buckets_m[i];
+    count_m += other.count_m;
+    max_m = std::max(max_m, other.max_m);
+  }
+
+  uint64_t count() const { return count_m; }
+  duration_t max() const { return duration_t(max_m); }
+
+  // upper bound of the bucket that holds the percentile (0..100)
+  duration_t percentile(double percent) const {
+    if (0 == count_m) return duration_t(0);
+    auto rank = static_cast<uint64_t>(percent / 100.0 * count_m + 0.5);
+    rank = std::max<uint64_t>(1, std::min(rank, count_m));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_m.size(); ++i) {
+        seen += buckets_m[i];
+        if (seen >= rank) return duration_t(std::min(upper_bound(i), max_m));
+      }
+    return duration_t(max_m);
+  }
+
+private:
+  static int leading_zeros(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(value);
+#endif
+  }
+
+private:
+  std::array<uint64_t, BUCKETS> buckets_m = {};
+  uint64_t count_m = 0;
+  uint64_t max_m = 0;
+};
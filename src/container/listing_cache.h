@@ -0,0 +1,149 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief bounded cache of directory listings to continue an enumeration where it stopped
+ *
+ * A listing is a snapshot of all entries of a directory together with the version of the
+ * directory it was taken from. Continuations index into the snapshot instead of enumerating
+ * the directory again. A listing of another version is never returned.
+ *
+ * The listings are bounded by the total number of entries. The least recently used listings
+ * are dropped first. A listing with more entries than the capacity is returned but not kept.
+ */
+template<typename key_t, typename entry_t, typename hash_t = std::hash<key_t>>
+struct listing_cache_t {
+  using version_t = uint64_t;
+
+  struct listing_t {
+    version_t version;
+    std::vector<entry_t> entries;
+  };
+  using listing_ptr_t = std::shared_ptr<const listing_t>;
+
+  struct config_t {
+    size_t capacity = 0x80000; // entries of all kept listings
+    size_t listings = 64;
+  };
+
+  struct stats_t {
+    uint64_t hits = 0;
+    uint64_t misses = 0; // includes listings of another version
+    uint64_t evictions = 0;
+    size_t size = 0; // kept entries
+    size_t listings = 0;
+
+    double hit_rate() const {
+      auto total = hits + misses;
+      return 0 == total ? 0.0 : static_cast<double>(hits) / total;
+    }
+  };
+
+  explicit listing_cache_t(const config_t& config = config_t())
+    : config_m(config)
+  {}
+
+  listing_cache_t(const listing_cache_t&) = delete;
+  listing_cache_t& operator= (const listing_cache_t&) = delete;
+
+  const config_t& config() const { return config_m; }
+
+  // returns the listing of the version or nullptr
+  listing_ptr_t get(const key_t& key, version_t version) {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    auto it = index_m.find(key);
+    if (it == index_m.end() || it->second->listing->version != version) {
+        ++misses_m;
+        return {};
+      }
+    lru_m.splice(lru_m.begin(), lru_m, it->second);
+    ++hits_m;
+    return it->second->listing;
+  }
+
+  // stores the listing - replaces any other version of the key
+  listing_ptr_t put(const key_t& key, version_t version, std::vector<entry_t>&& entries) {
+    auto listing = std::make_shared<listing_t>();
+    listing->version = version;
+    listing->entries = std::move(entries);
+    listing_ptr_t result = listing;
+
+    std::vector<listing_ptr_t> released; // freed after the lock is released
+    std::lock_guard<std::mutex> lock(mutex_m);
+    auto it = index_m.find(key);
+    if (it != index_m.end()) {
+        size_m -= it->second->listing->entries.size();
+        released.push_back(std::move(it->second->listing));
+        lru_m.erase(it->second);
+        index_m.erase(it);
+      }
+    if (result->entries.size() > config_m.capacity) return result;
+
+    lru_m.push_front({ key, result });
+    index_m.emplace(key, lru_m.begin());
+    size_m += result->entries.size();
+    while (size_m > config_m.capacity || lru_m.size() > config_m.listings) {
+        size_m -= lru_m.back().listing->entries.size();
+        released.push_back(std::move(lru_m.back().listing));
+        index_m.erase(lru_m.back().key);
+        lru_m.pop_back();
+        ++evictions_m;
+      }
+    return result;
+  }
+
+  bool invalidate(const key_t& key) {
+    listing_ptr_t released;
+    std::lock_guard<std::mutex> lock(mutex_m);
+    auto it = index_m.find(key);
+    if (it == index_m.end()) return false;
+    size_m -= it->second->listing->entries.size();
+    released = std::move(it->second->listing);
+    lru_m.erase(it->second);
+    index_m.erase(it);
+    return true;
+  }
+
+  void clear() {
+    lru_t released;
+    std::lock_guard<std::mutex> lock(mutex_m);
+    index_m.clear();
+    released.swap(lru_m);
+    size_m = 0;
+  }
+
+  stats_t stats() const {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    stats_t result;
+    result.hits = hits_m;
+    result.misses = misses_m;
+    result.evictions = evictions_m;
+    result.size = size_m;
+    result.listings = lru_m.size();
+    return result;
+  }
+
+private:
+  struct node_t {
+    key_t key;
+    listing_ptr_t listing;
+  };
+  using lru_t = std::list<node_t>;
+
+private:
+  config_t config_m;
+  mutable std::mutex mutex_m;
+  lru_t lru_m; // most recently used first
+  std::unordered_map<key_t, typename lru_t::iterator, hash_t> index_m;
+  size_t size_m = 0;
+  uint64_t hits_m = 0;
+  uint64_t misses_m = 0;
+  uint64_t evictions_m = 0;
+};
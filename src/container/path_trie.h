@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief map of '/' separated paths with a longest prefix lookup
+ *
+ * Every node is a path component, so lookups cost the length of the path - independent
+ * of the number of stored paths. Paths have to start with '/'.
+ *
+ * Copies share all nodes. A modification copies the nodes on its path that are still
+ * shared and changes only the nodes owned by this trie, so copies handed out before
+ * never change. A published copy can be read by many threads while a writer modifies
+ * its own copy.
+ */
+template<typename value_t>
+struct path_trie_t {
+  using value_ptr_t = std::shared_ptr<const value_t>;
+
+  struct match_t {
+    value_ptr_t value; // nullptr if nothing matched
+    size_t length = 0; // of the matched prefix of the path
+  };
+
+  size_t size() const { return size_m; }
+  bool empty() const { return 0 == size_m; }
+
+  // value stored at exactly this path
+  value_ptr_t find(const std::string& path) const {
+    const node_t* node = root_m.get();
+    for_each_component(path, [&](const char* name, size_t size, size_t) {
+        if (node) node = node->child(name, size);
+        return nullptr != node;
+      });
+    return node ? node->value : nullptr;
+  }
+
+  // value of the longest stored path that is the path or a prefix ending before a '/'
+  match_t longest_prefix(const std::string& path) const {
+    match_t result;
+    const node_t* node = root_m.get();
+    for_each_component(path, [&](const char* name, size_t size, size_t end) {
+        if (node) node = node->child(name, size);
+        if ( !node) return false;
+        if (node->value) {
+            result.value = node->value;
+            result.length = end;
+          }
+        return true;
+      });
+    return result;
+  }
+
+  // stores or replaces the value - false for paths without leading '/'
+  bool insert(const std::string& path, value_ptr_t value) {
+    if (path.empty() || path[0] != '/') return false;
+    node_ptr_t* node = &root_m;
+    for_each_component(path, [&](const char* name, size_t size, size_t) {
+        node = &own(*node).child_slot(name, size);
+        return true;
+      });
+    auto& target = own(*node);
+    if ( !target.value) ++size_m;
+    target.value = std::move(value);
+    return true;
+  }
+
+  // removes the value at exactly this path
+  bool erase(const std::string& path) {
+    if ( !find(path)) return false;
+    erase_at(root_m, path, 1);
+    --size_m;
+    return true;
+  }
+
+  // removes all values the predicate selects
+  template<typename predicate_t>
+  size_t erase_if(predicate_t predicate) {
+    std::vector<std::string> paths;
+    for_each([&](const std::string& path, const value_t& value) {
+        if (predicate(value)) paths.push_back(path);
+      });
+    for (const auto& path : paths) erase(path);
+    return paths.size();
+  }
+
+  // calls callback(path, value) for all values in order of the paths
+  template<typename callback_t>
+  void for_each(callback_t callback) const {
+    if ( !root_m) return;
+    std::string path;
+    visit(*root_m, path, callback);
+  }
+
+private:
+  struct node_t;
+  using node_ptr_t = std::shared_ptr<node_t>;
+  using child_t = std::pair<std::string, node_ptr_t>;
+  using name_t = std::pair<const char*, size_t>;
+
+  struct node_t {
+    std::vector<child_t> children; // sorted by name
+    value_ptr_t value;
+
+    template<typename iterator_t>
+    static iterator_t lower_bound(iterator_t begin, iterator_t end, const char* name, size_t size) {
+      return std::lower_bound(begin, end, name_t(name, size), [](const child_t& child, const name_t& name) {
+          return child.first.compare(0, std::string::npos, name.first, name.second) < 0;
+        });
+    }
+
+    static bool equal(const child_t& child, const char* name, size_t size) {
+      return 0 == child.first.compare(0, std::string::npos, name, size);
+    }
+
+    const node_t* child(const char* name, size_t size) const {
+      auto it = lower_bound(children.begin(), children.end(), name, size);
+      if (it == children.end() || !equal(*it, name, size)) return nullptr;
+      return it->second.get();
+    }
+
+    node_ptr_t& child_slot(const char* name, size_t size) {
+      auto it = lower_bound(children.begin(), children.end(), name, size);
+      if (it == children.end() || !equal(*it, name, size)) {
+          it = children.emplace(it, std::string(name, size), nullptr);
+        }
+      return it->second;
+    }
+  };
+
+  // splits "/a/b" into "a" and "b" - callback(name, size, end of the component) returns false to stop
+  template<typename callback_t>
+  static void for_each_component(const std::string& path, callback_t callback) {
+    if (path.empty() || path[0] != '/') return;
+    size_t start = 1;
+    while (true) {
+        auto end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        if ( !callback(path.data() + start, end - start, end)) return;
+        if (end == path.size()) return;
+        start = end + 1;
+      }
+  }
+
+  // the node is owned by this trie afterwards - shared nodes are copied
+  static node_t& own(node_ptr_t& node) {
+    if ( !node) node = std::make_shared<node_t>();
+    else if (node.use_count() > 1) node = std::make_shared<node_t>(*node);
+    return *node;
+  }
+
+  // the path exists - returns true if the node became empty
+  static bool erase_at(node_ptr_t& node_ptr, const std::string& path, size_t start) {
+    auto& node = own(node_ptr);
+    auto end = std::min(path.find('/', start), path.size());
+    auto it = node_t::lower_bound(node.children.begin(), node.children.end(), path.data() + start, end - start);
+    bool empty = false;
+    if (end == path.size()) {
+        own(it->second).value = nullptr;
+        empty = it->second->children.empty();
+      }
+    else
+      empty = erase_at(it->second, path, end + 1);
+    if (empty) node.children.erase(it);
+    return node.children.empty() && !node.value;
+  }
+
+  template<typename callback_t>
+  static void visit(const node_t& node, std::string& path, callback_t& callback) {
+    for (const auto& child : node.children) {
+        auto size = path.size();
+        path += '/';
+        path += child.first;
+        if (child.second->value) callback(static_cast<const std::string&>(path), *child.second->value);
+        visit(*child.second, path, callback);
+        path.resize(size);
+      }
+  }
+
+private:
+  node_ptr_t root_m;
+  size_t size_m = 0;
+};
@@ -1,59 +1,30 @@
 #pragma once
 
+#include "utf.h"
+
 #include <string>
-#include <cstring>
-#include <wchar.h>
 
+/**
+ * @brief conversion between utf8 and the wide strings of the platform
+ *
+ * wchar_t strings are utf16 on windows and utf32 elsewhere - independent of the locale.
+ * Invalid input converts to an empty string.
+ */
 struct convert {
-  struct state_t {
-    state_t() {
-      ::memset(&state_m, 0, sizeof state_m);
-    }
-
-    operator mbstate_t& () {
-      return state_m;
-    }
-
-  private:
-    mbstate_t state_m;
-  };
-
   // ---- to_wstring ----
   static inline std::wstring to_wstring(const std::string& src) {
     return to_wstring_with_offset(src, 0);
   }
 
   static inline std::wstring to_wstring_with_offset(const std::string& src, size_t offset) {
-    state_t state;
-    return to_wstring_with_offset(src, offset, state);
-  }
-
-  static inline std::wstring to_wstring_with_offset(const std::string& src, size_t offset, state_t &state) {
-    auto wstring_length = to_wstring_length_with_offset(src, offset, state);
-    return to_wstring_with_offset_and_length(src, offset, wstring_length, state);
-  }
-
-  static inline size_t to_wstring_length_with_offset(const std::string& src, size_t offset, mbstate_t &state) {
-    size_t result;
-    auto cstr = src.c_str() + offset;
-    auto clen = src.length() - offset;
-    mbsrtowcs_s(&result,
-                nullptr, 0,
-                &cstr, clen, &state);;
+    std::wstring result;
+    utf::append_from_utf8(result, src.data() + offset, src.size() - offset);
     return result;
   }
 
-  static inline std::wstring to_wstring_with_offset_and_length(const std::string& src, size_t offset, size_t wstring_length, mbstate_t &state) {
-    std::wstring result;
-    auto cstr = src.c_str() + offset;
-    auto clen = src.length() - offset;
-    result.reserve(wstring_length);
-    result.resize(wstring_length - 1);
-    size_t converted;
-    mbsrtowcs_s(&converted,
-                &result[0], wstring_length,
-                &cstr, clen, &state);
-    return result;
+  // appends src to dst - false and dst unchanged for invalid input
+  static inline bool append_wstring(std::wstring& dst, const std::string& src) {
+    return utf::append_from_utf8(dst, src.data(), src.size());
   }
 
   // ---- to_string ----
@@ -61,46 +32,18 @@ struct convert {
     return to_string_with_offset(src, 0);
   }
 
-  static inline std::string to_string_with_offset(const std::wstring& src, size_t offset) {
-    state_t state;
-    return to_string_with_offset(src, offset, state);
-  }
-
-  static inline std::string to_string_with_offset(const std::wstring& src, size_t offset, state_t &state) {
-    auto string_length = to_string_length_with_offset(src, offset, state);
-    return to_string_with_offset_and_length(src, offset, string_length, state);
-  }
-
-  static inline size_t to_string_length(const std::wstring& src, state_t &state) {
-    return to_string_length_with_offset(src, 0, state);
-  }
-
-  static inline size_t to_string_length_with_offset(const std::wstring& src, size_t offset, mbstate_t &state) {
-    size_t result;
-    auto cstr = src.c_str() + offset;
-    auto clen = src.length() - offset;
-    wcsrtombs_s(&result,
-                nullptr, 0,
-                &cstr, clen, &state);;
+  static inline std::string to_string(const wchar_t* src, size_t size) {
+    std::string result;
+    utf::append_utf8(result, src, size);
     return result;
   }
 
-  static inline std::string to_string_with_length(const std::wstring& src, size_t string_length, state_t &state) {
-    return to_string_with_offset_and_length(src, 0, string_length, state);
+  static inline std::string to_string_with_offset(const std::wstring& src, size_t offset) {
+    return to_string(src.data() + offset, src.size() - offset);
   }
 
-  static inline std::string to_string_with_offset_and_length(const std::wstring& src, size_t offset, size_t string_length, mbstate_t &state) {
-    std::string result;
-    auto cstr = src.c_str() + offset;
-    auto clen = src.length() - offset;
-    result.reserve(string_length);
-    result.resize(string_length - 1);
-    size_t converted;
-    wcsrtombs_s(&converted,
-                &result[0], string_length,
-                &cstr, clen, &state);
-    return result;
+  // appends src to dst - false and dst unchanged for invalid input
+  static inline bool append_string(std::string& dst, const std::wstring& src) {
+    return utf::append_utf8(dst, src.data(), src.size());
   }
-
-
 };
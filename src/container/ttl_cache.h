@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief bounded cache of values that expire a fixed time after they were stored
+ *
+ * The keys are spread over shards with their own lock. Every shard keeps its entries
+ * in the order they were stored. With a single time to live this is also the order of
+ * expiry, so expired and surplus entries are always dropped from the front.
+ *
+ * A time to live of zero disables the cache.
+ */
+template<typename key_t, typename value_t,
+         typename hash_t = std::hash<key_t>, typename key_equal_t = std::equal_to<key_t>,
+         typename clock_source_t = std::chrono::steady_clock>
+struct ttl_cache_t {
+  using time_point_t = typename clock_source_t::time_point;
+  using duration_t = typename clock_source_t::duration;
+
+  struct config_t {
+    size_t capacity = 0x10000;
+    size_t shards = 16;
+    duration_t time_to_live = std::chrono::seconds(1);
+  };
+
+  struct stats_t {
+    uint64_t hits = 0;
+    uint64_t misses = 0; // includes expired entries
+    uint64_t invalidations = 0;
+    size_t size = 0;
+
+    double hit_rate() const {
+      auto total = hits + misses;
+      return 0 == total ? 0.0 : static_cast<double>(hits) / total;
+    }
+  };
+
+  explicit ttl_cache_t(const config_t& config = config_t())
+    : config_m(config)
+    , shards_m(std::max<size_t>(1, config.shards))
+    , shard_capacity_m(std::max<size_t>(1, (config.capacity + shards_m.size() - 1) / shards_m.size()))
+  {}
+
+  ttl_cache_t(const ttl_cache_t&) = delete;
+  ttl_cache_t& operator= (const ttl_cache_t&) = delete;
+
+  const config_t& config() const { return config_m; }
+  bool enabled() const { return config_m.time_to_live > duration_t::zero(); }
+
+  // copies the value if it is stored and not expired
+  bool get(const key_t& key, value_t& value) {
+    if ( !enabled()) return false;
+    auto& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end() || it->second->expires <= clock_source_t::now()) {
+        misses_m.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    value = it->second->value;
+    hits_m.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // stores or replaces the value - it expires after time_to_live
+  void put(const key_t& key, const value_t& value) {
+    if ( !enabled()) return;
+    auto now = clock_source_t::now();
+    auto& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        it->second->value = value;
+        it->second->expires = now + config_m.time_to_live;
+        shard.entries.splice(shard.entries.end(), shard.entries, it->second);
+      }
+    else {
+        shard.entries.push_back({ key, value, now + config_m.time_to_live });
+        shard.index.emplace(key, std::prev(shard.entries.end()));
+      }
+    while ( !shard.entries.empty()
+            && (shard.entries.size() > shard_capacity_m || shard.entries.front().expires <= now)) {
+        shard.index.erase(shard.entries.front().key);
+        shard.entries.pop_front();
+      }
+  }
+
+  bool invalidate(const key_t& key) {
+    auto& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) return false;
+    shard.entries.erase(it->second);
+    shard.index.erase(it);
+    invalidations_m.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  void clear() {
+    uint64_t count = 0;
+    for (auto& shard : shards_m) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.entries.size();
+        shard.index.clear();
+        shard.entries.clear();
+      }
+    invalidations_m.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  size_t size() const {
+    size_t result = 0;
+    for (auto& shard : shards_m) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        result += shard.entries.size();
+      }
+    return result;
+  }
+
+  stats_t stats() const {
+    stats_t result;
+    result.hits = hits_m.load(std::memory_order_relaxed);
+    result.misses = misses_m.load(std::memory_order_relaxed);
+    result.invalidations = invalidations_m.load(std::memory_order_relaxed);
+    result.size = size();
+    return result;
+  }
+
+private:
+  struct entry_t {
+    key_t key;
+    value_t value;
+    time_point_t expires;
+  };
+  using entries_t = std::list<entry_t>;
+
+  struct shard_t {
+    mutable std::mutex mutex;
+    entries_t entries; // oldest first
+    std::unordered_map<key_t, typename entries_t::iterator, hash_t, key_equal_t> index;
+  };
+
+  shard_t& shard_for(const key_t& key) {
+    // spread the bits - hashes of integers are often the identity
+    uint64_t hash = hash_t()(key) * 0x9E3779B97F4A7C15ull;
+    return shards_m[(hash >> 32) % shards_m.size()];
+  }
+
+private:
+  config_t config_m;
+  std::vector<shard_t> shards_m;
+  size_t shard_capacity_m;
+  std::atomic<uint64_t> hits_m {0};
+  std::atomic<uint64_t> misses_m {0};
+  std::atomic<uint64_t> invalidations_m {0};
+};
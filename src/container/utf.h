@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define UTF_AVX2 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief locale independent conversion between utf8 and utf16 or utf32
+ *
+ * The unit type selects the encoding by its size: char16_t and the wchar_t of windows
+ * are utf16, char32_t and the wchar_t of other systems are utf32.
+ *
+ * Every conversion is a single pass into a buffer of the worst case size. Runs of
+ * ascii are converted a vector at a time with SSE2 or AVX2 when the build targets
+ * them, everything else character by character. Unpaired surrogates, overlong
+ * sequences and code points above U+10FFFF are invalid.
+ */
+namespace utf {
+
+  enum : size_t { INVALID = ~size_t(0) };
+
+  // utf8 bytes of size units at most
+  template<typename unit_t>
+  constexpr size_t max_utf8_size(size_t size) {
+    return (2 == sizeof(unit_t) ? 3 : 4) * size;
+  }
+
+  namespace detail {
+    enum : size_t { BLOCK = 16 }; // units converted by character before the next vector attempt
+    enum : uint32_t { BAD_CODE = 0xFFFFFFFF };
+
+    using utf16_t = std::integral_constant<size_t, 2>;
+    using utf32_t = std::integral_constant<size_t, 4>;
+
+    // ---- ascii runs - return the count of leading units converted ----
+
+    template<typename unit_t>
+    size_t widen_ascii(const uint8_t* src, size_t size, unit_t* dst, utf16_t) {
+      size_t done = 0;
+#ifdef UTF_AVX2
+      for (; done + 32 <= size; done += 32) {
+          auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done));
+          if (0 != _mm256_movemask_epi8(bytes)) break;
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+        }
+#endif
+#ifdef UTF_SSE2
+      const auto zero = _mm_setzero_si128();
+      for (; done + 16 <= size; done += 16) {
+          auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+          if (0 != _mm_movemask_epi8(bytes)) break;
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done), _mm_unpacklo_epi8(bytes, zero));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done + 8), _mm_unpackhi_epi8(bytes, zero));
+        }
+#endif
+      return done;
+    }
+
+    template<typename unit_t>
+    size_t widen_ascii(const uint8_t* src, size_t size, unit_t* dst, utf32_t) {
+      size_t done = 0;
+#ifdef UTF_AVX2
+      for (; done + 32 <= size; done += 32) {
+          auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done));
+          if (0 != _mm256_movemask_epi8(bytes)) break;
+          auto low = _mm256_castsi256_si128(bytes);
+          auto high = _mm256_extracti128_si256(bytes, 1);
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done), _mm256_cvtepu8_epi32(low));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8)));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done + 16), _mm256_cvtepu8_epi32(high));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8)));
+        }
+#endif
+#ifdef UTF_SSE2
+      const auto zero = _mm_setzero_si128();
+      for (; done + 16 <= size; done += 16) {
+          auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+          if (0 != _mm_movemask_epi8(bytes)) break;
+          auto low = _mm_unpacklo_epi8(bytes, zero);
+          auto high = _mm_unpackhi_epi8(bytes, zero);
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done), _mm_unpacklo_epi16(low, zero));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done + 4), _mm_unpackhi_epi16(low, zero));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done + 8), _mm_unpacklo_epi16(high, zero));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done + 12), _mm_unpackhi_epi16(high, zero));
+        }
+#endif
+      return done;
+    }
+
+    template<typename unit_t>
+    size_t narrow_ascii(const unit_t* src, size_t size, uint8_t* dst, utf16_t) {
+      size_t done = 0;
+#ifdef UTF_AVX2
+      const auto high_bits256 = _mm256_set1_epi16(static_cast<short>(0xFF80));
+      for (; done + 32 <= size; done += 32) {
+          auto first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done));
+          auto second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done + 16));
+          if ( !_mm256_testz_si256(_mm256_or_si256(first, second), high_bits256)) break;
+          // the pack works per lane - the permute restores the order
+          auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xD8);
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done), packed);
+        }
+#endif
+#ifdef UTF_SSE2
+      const auto zero = _mm_setzero_si128();
+      const auto high_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+      for (; done + 16 <= size; done += 16) {
+          auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+          auto second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done + 8));
+          auto high = _mm_and_si128(_mm_or_si128(first, second), high_bits);
+          if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi16(high, zero))) break;
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done), _mm_packus_epi16(first, second));
+        }
+#endif
+      return done;
+    }
+
+    template<typename unit_t>
+    size_t narrow_ascii(const unit_t* src, size_t size, uint8_t* dst, utf32_t) {
+      size_t done = 0;
+#ifdef UTF_SSE2
+      const auto zero = _mm_setzero_si128();
+      const auto high_bits = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+      for (; done + 16 <= size; done += 16) {
+          auto units = reinterpret_cast<const __m128i*>(src + done);
+          auto first = _mm_loadu_si128(units);
+          auto second = _mm_loadu_si128(units + 1);
+          auto third = _mm_loadu_si128(units + 2);
+          auto fourth = _mm_loadu_si128(units + 3);
+          auto high = _mm_and_si128(_mm_or_si128(_mm_or_si128(first, second), _mm_or_si128(third, fourth)), high_bits);
+          if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi32(high, zero))) break;
+          auto words = _mm_packus_epi16(_mm_packs_epi32(first, second), _mm_packs_epi32(third, fourth));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done), words);
+        }
+#endif
+      return done;
+    }
+
+    // ---- single characters ----
+
+    // the code point starting at src[index] - BAD_CODE for unpaired surrogates
+    template<typename unit_t>
+    uint32_t decode(const unit_t* src, size_t size, size_t& index, utf16_t) {
+      uint32_t code = static_cast<uint16_t>(src[index++]);
+      if (code < 0xD800 || code > 0xDFFF) return code;
+      if (code > 0xDBFF || index == size) return BAD_CODE;
+      uint32_t low = static_cast<uint16_t>(src[index]);
+      if (low < 0xDC00 || low > 0xDFFF) return BAD_CODE;
+      ++index;
+      return 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+    }
+
+    template<typename unit_t>
+    uint32_t decode(const unit_t* src, size_t, size_t& index, utf32_t) {
+      auto code = static_cast<uint32_t>(src[index++]);
+      if (code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) return BAD_CODE;
+      return code;
+    }
+
+    template<typename unit_t>
+    size_t encode(uint32_t code, unit_t* dst, utf16_t) {
+      if (code < 0x10000) {
+          dst[0] = static_cast<unit_t>(code);
+          return 1;
+        }
+      code -= 0x10000;
+      dst[0] = static_cast<unit_t>(0xD800 + (code >> 10));
+      dst[1] = static_cast<unit_t>(0xDC00 + (code & 0x3FF));
+      return 2;
+    }
+
+    template<typename unit_t>
+    size_t encode(uint32_t code, unit_t* dst, utf32_t) {
+      dst[0] = static_cast<unit_t>(code);
+      return 1;
+    }
+
+    inline size_t encode_utf8(uint32_t code, uint8_t* dst) {
+      if (code < 0x80) {
+          dst[0] = static_cast<uint8_t>(code);
+          return 1;
+        }
+      if (code < 0x800) {
+          dst[0] = static_cast<uint8_t>(0xC0 | (code >> 6));
+          dst[1] = static_cast<uint8_t>(0x80 | (code & 0x3F));
+          return 2;
+        }
+      if (code < 0x10000) {
+          dst[0] = static_cast<uint8_t>(0xE0 | (code >> 12));
+          dst[1] = static_cast<uint8_t>(0x80 | ((code >> 6) & 0x3F));
+          dst[2] = static_cast<uint8_t>(0x80 | (code & 0x3F));
+          return 3;
+        }
+      dst[0] = static_cast<uint8_t>(0xF0 | (code >> 18));
+      dst[1] = static_cast<uint8_t>(0x80 | ((code >> 12) & 0x3F));
+      dst[2] = static_cast<uint8_t>(0x80 | ((code >> 6) & 0x3F));
+      dst[3] = static_cast<uint8_t>(0x80 | (code & 0x3F));
+      return 4;
+    }
+
+    // the code point of the sequence starting at src[index] - BAD_CODE for malformed sequences
+    inline uint32_t decode_utf8(const uint8_t* src, size_t size, size_t& index) {
+      uint32_t lead = src[index];
+      if (lead < 0x80) {
+          ++index;
+          return lead;
+        }
+      size_t follow;
+      uint32_t code, minimum;
+      if ((lead & 0xE0) == 0xC0) { follow = 1; code = lead & 0x1F; minimum = 0x80; }
+      else if ((lead & 0xF0) == 0xE0) { follow = 2; code = lead & 0x0F; minimum = 0x800; }
+      else if ((lead & 0xF8) == 0xF0) { follow = 3; code = lead & 0x07; minimum = 0x10000; }
+      else return BAD_CODE;
+      if (size - index <= follow) return BAD_CODE; // truncated
+      for (size_t i = 1; i <= follow; ++i) {
+          uint32_t next = src[index + i];
+          if ((next & 0xC0) != 0x80) return BAD_CODE;
+          code = (code << 6) | (next & 0x3F);
+        }
+      if (code < minimum || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) return BAD_CODE;
+      index += follow + 1;
+      return code;
+    }
+  } // namespace detail
+
+  /**
+   * @brief converts size units to utf8
+   *
+   * dst has room for max_utf8_size(size) bytes. Returns the bytes written or INVALID.
+   */
+  template<typename unit_t>
+  size_t to_utf8(const unit_t* src, size_t size, char* dst) {
+    using width_t = std::integral_constant<size_t, sizeof(unit_t)>;
+    auto out = reinterpret_cast<uint8_t*>(dst);
+    size_t index = 0, written = 0;
+    while (index < size) {
+        auto ascii = detail::narrow_ascii(src + index, size - index, out + written, width_t());
+        index += ascii;
+        written += ascii;
+        auto end = std::min<size_t>(size, index + detail::BLOCK);
+        while (index < end) {
+            auto code = detail::decode(src, size, index, width_t());
+            if (detail::BAD_CODE == code) return INVALID;
+            written += detail::encode_utf8(code, out + written);
+          }
+      }
+    return written;
+  }
+
+  /**
+   * @brief converts size bytes of utf8 to units
+   *
+   * dst has room for size units. Returns the units written or INVALID.
+   */
+  template<typename unit_t>
+  size_t from_utf8(const char* src, size_t size, unit_t* dst) {
+    using width_t = std::integral_constant<size_t, sizeof(unit_t)>;
+    auto in = reinterpret_cast<const uint8_t*>(src);
+    size_t index = 0, written = 0;
+    while (index < size) {
+        auto ascii = detail::widen_ascii(in + index, size - index, dst + written, width_t());
+        index += ascii;
+        written += ascii;
+        auto end = std::min<size_t>(size, index + detail::BLOCK);
+        while (index < end) {
+            auto code = detail::decode_utf8(in, size, index);
+            if (detail::BAD_CODE == code) return INVALID;
+            written += detail::encode(code, dst + written, width_t());
+          }
+      }
+    return written;
+  }
+
+  // appends the converted units - false and dst unchanged for invalid input
+  template<typename unit_t>
+  bool append_utf8(std::string& dst, const unit_t* src, size_t size) {
+    auto offset = dst.size();
+    dst.resize(offset + max_utf8_size<unit_t>(size));
+    auto written = to_utf8(src, size, &dst[0] + offset);
+    dst.resize(INVALID == written ? offset : offset + written);
+    return INVALID != written;
+  }
+
+  template<typename unit_t>
+  bool append_from_utf8(std::basic_string<unit_t>& dst, const char* src, size_t size) {
+    auto offset = dst.size();
+    dst.resize(offset + size);
+    auto written = from_utf8(src, size, &dst[0] + offset);
+    dst.resize(INVALID == written ? offset : offset + written);
+    return INVALID != written;
+  }
+
+} // namespace utf
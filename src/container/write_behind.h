@@ -0,0 +1,337 @@
+#pragma once
+
+#include "binary/binary.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief buffers writes of files in memory and writes them later in the background
+ *
+ * Every file keeps its dirty ranges ordered by offset. The data of a write is moved into
+ * its range without a copy. Only overlapping writes are merged.
+ *
+ * A background thread writes files that were idle for flush_delay, or all files when half
+ * of the memory limit is buffered. A write that exceeds the memory limit writes the oldest
+ * files before it returns.
+ *
+ * A failed write is remembered for the file. flush() reports it until commit() did.
+ */
+template<typename key_t, typename hash_t = std::hash<key_t>, typename key_equal_t = std::equal_to<key_t>,
+         typename clock_source_t = std::chrono::steady_clock>
+struct write_behind_t {
+  using time_point_t = typename clock_source_t::time_point;
+  using duration_t = typename clock_source_t::duration;
+
+  // writes data at the offset - called without a lock and never concurrently for one file
+  using writer_t = std::function<bool (uint64_t offset, const binary_t& data)>;
+
+  struct config_t {
+    size_t memory_limit = 64 << 20; // buffered bytes of all files
+    duration_t flush_delay = std::chrono::milliseconds(100);
+  };
+
+  struct stats_t {
+    uint64_t writes = 0;
+    uint64_t written_bytes = 0; // by the writers
+    uint64_t flushes = 0; // writer calls
+    uint64_t forced_flushes = 0; // by the memory limit
+    uint64_t failures = 0;
+    size_t dirty_bytes = 0;
+    size_t dirty_files = 0;
+  };
+
+  explicit write_behind_t(const config_t& config = config_t())
+    : config_m(config)
+    , flusher_m([this] { flusher(); })
+  {}
+
+  write_behind_t(const write_behind_t&) = delete;
+  write_behind_t& operator= (const write_behind_t&) = delete;
+
+  ~write_behind_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      stop_m = true;
+    }
+    wake_m.notify_all();
+    flusher_m.join();
+    flush_all();
+  }
+
+  const config_t& config() const { return config_m; }
+
+  // buffers the data - the writer is kept for the file until all its data is written
+  bool write(const key_t& key, uint64_t offset, binary_t&& data, const writer_t& writer) {
+    bool full;
+    {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      auto& file = files_m[key];
+      if ( !file) {
+          file = std::make_shared<file_t>();
+          file->writer = writer;
+        }
+      if (file->failed) return false;
+      insert(file->ranges, offset, std::move(data));
+      file->last_write = clock_source_t::now();
+      ++writes_m;
+      full = dirty_m > config_m.memory_limit;
+      if (dirty_m > config_m.memory_limit / 2) wake_m.notify_one();
+    }
+    while (full) {
+        ++forced_flushes_m;
+        full = flush_oldest();
+      }
+    return true;
+  }
+
+  // writes the buffered data that overlaps the range (count 0 is up to the end)
+  bool flush(const key_t& key, uint64_t offset = 0, uint64_t count = 0) {
+    auto file = find(key);
+    if ( !file) return true;
+    return flush_file(key, file, offset, count);
+  }
+
+  // flushes the range and reports a failed write only once
+  bool commit(const key_t& key, uint64_t offset = 0, uint64_t count = 0) {
+    auto file = find(key);
+    if ( !file) return true;
+    auto success = flush_file(key, file, offset, count);
+    std::lock_guard<std::mutex> lock(mutex_m);
+    file->failed = false;
+    release_if_clean(key, file);
+    return success;
+  }
+
+  // also while buffered data is being written - the file is not complete before
+  bool dirty(const key_t& key) const {
+    uint64_t end;
+    return buffered_end(key, end);
+  }
+
+  // end of the buffered data of the file - false if nothing is buffered or being written
+  bool buffered_end(const key_t& key, uint64_t& end) const {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    auto it = files_m.find(key);
+    if (it == files_m.end()) return false;
+    const file_t& file = *it->second;
+    if (file.ranges.empty() && !file.flushing) return false;
+    end = file.flushing ? file.flushing_end : 0;
+    if ( !file.ranges.empty()) {
+        auto& last = *file.ranges.rbegin();
+        end = std::max<uint64_t>(end, last.first + last.second.size());
+      }
+    return true;
+  }
+
+  void flush_all() {
+    for (auto& entry : snapshot([](const file_t&) { return true; })) {
+        flush_file(entry.first, entry.second, 0, 0);
+      }
+  }
+
+  // drops the buffered data of the file
+  void discard(const key_t& key) {
+    auto file = find(key);
+    if ( !file) return;
+    std::lock_guard<std::mutex> flush_lock(file->flush_mutex);
+    std::lock_guard<std::mutex> lock(mutex_m);
+    for (auto& range : file->ranges) dirty_m -= range.second.size();
+    file->ranges.clear();
+    file->failed = false;
+    release_if_clean(key, file);
+  }
+
+  stats_t stats() const {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    stats_t result;
+    result.writes = writes_m;
+    result.written_bytes = written_bytes_m;
+    result.flushes = flushes_m;
+    result.forced_flushes = forced_flushes_m;
+    result.failures = failures_m;
+    result.dirty_bytes = dirty_m;
+    result.dirty_files = files_m.size();
+    return result;
+  }
+
+private:
+  using ranges_t = std::map<uint64_t, binary_t>;
+
+  struct file_t {
+    std::mutex flush_mutex; // orders the writes of the file
+    writer_t writer;
+    ranges_t ranges; // guarded by mutex_m
+    bool flushing = false; // ranges are taken out and written - guarded by mutex_m
+    uint64_t flushing_end = 0; // of the taken ranges
+    time_point_t last_write;
+    bool failed = false;
+  };
+  using file_ptr_t = std::shared_ptr<file_t>;
+  using files_t = std::vector<std::pair<key_t, file_ptr_t>>;
+
+  file_ptr_t find(const key_t& key) const {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    auto it = files_m.find(key);
+    return it == files_m.end() ? file_ptr_t() : it->second;
+  }
+
+  template<typename predicate_t> // bool (const file_t&)
+  files_t snapshot(const predicate_t& predicate) const {
+    files_t result;
+    std::lock_guard<std::mutex> lock(mutex_m);
+    for (auto& entry : files_m) {
+        if ( !entry.second->ranges.empty() && predicate(*entry.second)) result.push_back(entry);
+      }
+    return result;
+  }
+
+  // call with mutex_m - the writer is released with the file
+  void release_if_clean(const key_t& key, const file_ptr_t& file) {
+    if ( !file->ranges.empty() || file->flushing || file->failed) return;
+    auto it = files_m.find(key);
+    if (it != files_m.end() && it->second == file) files_m.erase(it);
+  }
+
+  // call with mutex_m
+  void insert(ranges_t& ranges, uint64_t offset, binary_t&& data) {
+    if (data.empty()) return;
+    auto end = offset + data.size();
+    auto it = ranges.upper_bound(offset);
+    if (it != ranges.begin()) {
+        auto previous = std::prev(it);
+        if (previous->first + previous->second.size() > offset) it = previous;
+      }
+    if (it == ranges.end() || it->first >= end) {
+        dirty_m += data.size();
+        ranges.emplace_hint(it, offset, std::move(data));
+        return;
+      }
+
+    // merge all overlapping ranges - the new data wins
+    auto start = std::min(it->first, offset);
+    auto merged_end = end;
+    auto last = it;
+    for (; last != ranges.end() && last->first < end; ++last) {
+        merged_end = std::max<uint64_t>(merged_end, last->first + last->second.size());
+      }
+    binary_t merged(merged_end - start);
+    for (auto range = it; range != last; ++range) {
+        memcpy(&merged[range->first - start], range->second.data(), range->second.size());
+        dirty_m -= range->second.size();
+      }
+    memcpy(&merged[offset - start], data.data(), data.size());
+    ranges.erase(it, last);
+    dirty_m += merged.size();
+    ranges.emplace(start, std::move(merged));
+  }
+
+  bool flush_file(const key_t& key, const file_ptr_t& file, uint64_t offset, uint64_t count) {
+    std::lock_guard<std::mutex> flush_lock(file->flush_mutex);
+    ranges_t taken;
+    {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      auto& ranges = file->ranges;
+      auto begin = ranges.lower_bound(offset);
+      if (begin != ranges.begin()) {
+          auto previous = std::prev(begin);
+          if (previous->first + previous->second.size() > offset) begin = previous;
+        }
+      auto end = 0 == count ? ranges.end() : ranges.lower_bound(offset + count);
+      for (auto it = begin; it != end; it = ranges.erase(it)) {
+          taken.emplace(it->first, std::move(it->second));
+        }
+      if (taken.empty()) return !file->failed;
+      auto& last = *taken.rbegin();
+      file->flushing = true;
+      file->flushing_end = last.first + last.second.size();
+    }
+
+    bool success = true;
+    size_t bytes = 0;
+    size_t written = 0;
+    uint64_t calls = 0;
+    for (auto& range : taken) {
+        bytes += range.second.size();
+        if ( !success) continue;
+        ++calls;
+        success = file->writer(range.first, range.second);
+        if (success) written += range.second.size();
+      }
+
+    std::lock_guard<std::mutex> lock(mutex_m);
+    file->flushing = false;
+    dirty_m -= bytes;
+    written_bytes_m += written;
+    flushes_m += calls;
+    if ( !success) {
+        file->failed = true;
+        ++failures_m;
+      }
+    release_if_clean(key, file);
+    return !file->failed;
+  }
+
+  // returns whether the memory limit is still exceeded
+  bool flush_oldest() {
+    key_t key;
+    file_ptr_t oldest;
+    {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      if (dirty_m <= config_m.memory_limit) return false;
+      for (auto& entry : files_m) {
+          if (entry.second->ranges.empty()) continue;
+          if ( !oldest || entry.second->last_write < oldest->last_write) {
+              key = entry.first;
+              oldest = entry.second;
+            }
+        }
+      if ( !oldest) return false;
+    }
+    flush_file(key, oldest, 0, 0);
+    std::lock_guard<std::mutex> lock(mutex_m);
+    return dirty_m > config_m.memory_limit;
+  }
+
+  void flusher() {
+    auto interval = std::max<duration_t>(config_m.flush_delay / 2, std::chrono::milliseconds(1));
+    while (true) {
+        bool all;
+        {
+          std::unique_lock<std::mutex> lock(mutex_m);
+          wake_m.wait_for(lock, interval, [this] { return stop_m || dirty_m > config_m.memory_limit / 2; });
+          if (stop_m) return;
+          all = dirty_m > config_m.memory_limit / 2;
+        }
+        auto limit = clock_source_t::now() - config_m.flush_delay;
+        auto files = snapshot([&](const file_t& file) { return all || file.last_write <= limit; });
+        for (auto& entry : files) flush_file(entry.first, entry.second, 0, 0);
+      }
+  }
+
+private:
+  config_t config_m;
+  mutable std::mutex mutex_m;
+  std::condition_variable wake_m;
+  std::unordered_map<key_t, file_ptr_t, hash_t, key_equal_t> files_m;
+  size_t dirty_m = 0;
+  uint64_t writes_m = 0;
+  uint64_t written_bytes_m = 0;
+  uint64_t flushes_m = 0;
+  std::atomic<uint64_t> forced_flushes_m {0};
+  uint64_t failures_m = 0;
+  bool stop_m = false;
+  std::thread flusher_m; // last - started after all members
+};
@@ -0,0 +1,30 @@
+#include "fs.h"
+
+#include <cstring>
+
+namespace fs {
+
+  bool operator== (const volume_file_id_t& a, const volume_file_id_t& b) {
+    return a.volume == b.volume
+        && 0 == memcmp(a.file, b.file, sizeof(a.file));
+  }
+
+  size_t volume_file_id_hash_t::operator() (const volume_file_id_t& id) const {
+    uint64_t file[2];
+    memcpy(file, id.file, sizeof(file));
+    return static_cast<size_t>(file[0] ^ (file[1] * 0x9E3779B97F4A7C15ull) ^ id.volume);
+  }
+
+  uint64_t short_file_id(const volume_file_id_t& id) {
+    uint64_t result;
+    memcpy(&result, id.file, sizeof(result));
+    return result;
+  }
+
+  path_t parent_path(const path_t& path) {
+    auto position = path.find_last_of(L"\\/");
+    if (path_t::npos == position) return {};
+    return path.substr(0, position);
+  }
+
+} // namespace fs
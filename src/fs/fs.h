@@ -0,0 +1,150 @@
+#pragma once
+
+#include "binary/binary.h"
+#include "wintime/unix_time.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief filesystem backends used by the mount and nfs3 programs
+ *
+ * A backend opens objects by path or by id. Objects are files, directories or symlinks.
+ * Directories create, remove and rename their entries by name, so no full paths are built
+ * by the programs.
+ *
+ * backends: winfs (windows) in winfs_backend.cpp, posix (linux) in posix_backend.cpp,
+ * memory (benchmarks) in memory_backend.cpp
+ */
+namespace fs {
+
+  using path_t = std::wstring; // host paths as configured for the mounts
+  using name_t = std::string; // utf8 names of directory entries
+  using time_t = wintime::unix_time_t;
+
+  // 24 bytes with the layout of the windows FILE_ID_INFO - file handles stay valid
+  struct volume_file_id_t {
+    uint64_t volume;
+    uint8_t file[16];
+  };
+  bool operator== (const volume_file_id_t&, const volume_file_id_t&);
+  inline bool operator!= (const volume_file_id_t& a, const volume_file_id_t& b) { return !(a == b); }
+
+  struct volume_file_id_hash_t {
+    size_t operator() (const volume_file_id_t&) const;
+  };
+
+  // the leading 8 bytes of the file id are unique on the volume (nfs fileid)
+  uint64_t short_file_id(const volume_file_id_t&);
+
+  enum class type_t : uint32_t {
+    REGULAR_FILE,
+    DIRECTORY,
+    SYMLINK,
+  };
+
+  struct attributes_t {
+    type_t type = type_t::REGULAR_FILE;
+    uint32_t mode = 0; // permission bits - 0 allows nothing
+    uint32_t nlink = 1;
+    uint64_t size = 0;
+    uint64_t allocated_size = 0;
+    time_t atime = {};
+    time_t mtime = {};
+    time_t ctime = {};
+  };
+
+  struct entry_t {
+    name_t name;
+    uint8_t file[16]; // on the volume of the directory
+    attributes_t attributes; // nlink is 1 if the backend does not list it
+  };
+
+  struct space_t {
+    uint64_t total_bytes = 0;
+    uint64_t free_bytes = 0;
+    uint64_t available_bytes = 0; // for the user of the server
+  };
+
+  // the backends pick their open modes from these
+  enum access_t : uint32_t {
+    READ_ATTRIBUTES = 1,
+    WRITE_ATTRIBUTES = 2, // includes the size
+    READ_DATA = 4,
+    WRITE_DATA = 8,
+    LIST_DIRECTORY = 16,
+  };
+
+  struct object_t;
+  using object_ptr_t = std::unique_ptr<object_t>;
+
+  // all calls are thread safe unless noted
+  struct object_t {
+    virtual ~object_t() = default;
+
+    virtual path_t path() const = 0;
+    virtual bool id(volume_file_id_t&) const = 0;
+    virtual bool stat(attributes_t&) const = 0;
+    virtual bool space(space_t&) const = 0;
+
+    // files - positional I/O does not use a shared file pointer
+    virtual bool read_at(uint64_t offset, binary_t& binary) const = 0; // shortened at the end of file
+    virtual bool write_at(uint64_t offset, const binary_t& binary) const = 0;
+    virtual bool sync() const = 0; // makes the written data durable
+    virtual bool set_size(uint64_t size) const = 0;
+    virtual bool touch(bool access_time, bool modify_time) const = 0; // sets the times to now
+    virtual bool read_link(name_t& target) const = 0;
+
+    // directories - not concurrently for one object
+    virtual bool enumerate(const std::function<bool (const entry_t&)>& callback) const = 0;
+
+    // directories - names are single components
+    virtual object_ptr_t lookup(const name_t& name, uint32_t access = READ_ATTRIBUTES) const = 0;
+    virtual object_ptr_t create_file(const name_t& name) const = 0; // fails for existing names
+    virtual object_ptr_t create_directory(const name_t& name) const = 0;
+    virtual bool remove(const name_t& name) const = 0;
+    virtual bool remove_directory(const name_t& name) const = 0;
+    virtual bool rename(const name_t& from, const object_t& to_directory, const name_t& to) const = 0;
+  };
+
+  // shareable in a handle_cache_t
+  struct handle_t {
+    handle_t() = default;
+    handle_t(object_ptr_t&& object) : object(std::move(object)) {}
+
+    bool valid() const { return bool(object); }
+
+    object_ptr_t object;
+  };
+
+  // stops watching when destroyed
+  struct watcher_t {
+    virtual ~watcher_t() = default;
+  };
+  using watcher_ptr_t = std::unique_ptr<watcher_t>;
+
+  struct backend_t {
+    using change_callback_t = std::function<void (const path_t&)>;
+
+    virtual ~backend_t() = default;
+
+    virtual const char* name() const = 0;
+
+    virtual object_ptr_t open_path(const path_t& path, uint32_t access = READ_ATTRIBUTES) = 0;
+    // the mount directory selects the volume
+    virtual object_ptr_t open_by_id(const object_t& mount_directory, const volume_file_id_t& id, uint32_t access = READ_ATTRIBUTES) = 0;
+
+    // reports changed paths below the directory, or the directory itself if changes were lost
+    // returns nullptr if watching is not possible
+    virtual watcher_ptr_t watch(const object_t& directory, change_callback_t&& callback) = 0;
+  };
+
+  // path without the last component - for both separators
+  path_t parent_path(const path_t&);
+
+  // the backend of the platform
+  backend_t& default_backend();
+
+} // namespace fs
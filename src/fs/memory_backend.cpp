@@ -0,0 +1,491 @@
+#include "memory_backend.h"
+
+#include "container/string_convert.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <cstring>
+
+namespace fs {
+
+  using page_t = std::array<uint8_t, memory_backend_t::PAGE_SIZE>;
+
+  struct memory_backend_t::inode_t {
+    inode_t(std::atomic<size_t>& page_count) : page_count(page_count) {}
+    ~inode_t() { page_count -= pages.size(); }
+
+    uint64_t id = 0;
+    type_t type = type_t::REGULAR_FILE;
+
+    // guarded by the mutex of the backend
+    std::weak_ptr<inode_t> parent; // empty for the root and removed inodes
+    name_t name;
+    std::map<name_t, inode_ptr_t> children;
+
+    mutable std::shared_timed_mutex mutex; // after the mutex of the backend
+    uint32_t mode = 0;
+    time_t atime = {};
+    time_t mtime = {};
+    time_t ctime = {};
+    uint64_t size = 0;
+    std::map<uint64_t, std::unique_ptr<page_t>> pages; // by index - missing pages are zeros
+    std::atomic<size_t>& page_count;
+  };
+
+  namespace {
+    using inode_t = memory_backend_t::inode_t;
+    using inode_ptr_t = memory_backend_t::inode_ptr_t;
+    using read_lock_t = std::shared_lock<std::shared_timed_mutex>;
+    using write_lock_t = std::unique_lock<std::shared_timed_mutex>;
+
+    time_t now() {
+      auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+      auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count();
+      time_t result;
+      result.seconds = static_cast<uint64_t>(nanoseconds / 1000000000);
+      result.nanoseconds = static_cast<uint32_t>(nanoseconds % 1000000000);
+      return result;
+    }
+
+    // the modify time is the version of a directory listing - it never repeats
+    void changed(inode_t& inode) {
+      auto time = now();
+      if (time.seconds < inode.mtime.seconds
+          || (time.seconds == inode.mtime.seconds && time.nanoseconds <= inode.mtime.nanoseconds)) {
+          time = inode.mtime;
+          if (++time.nanoseconds == 1000000000) {
+              time.nanoseconds = 0;
+              ++time.seconds;
+            }
+        }
+      inode.mtime = time;
+      inode.ctime = time;
+    }
+
+    bool is_special(const name_t& name) {
+      return name.empty() || "." == name || ".." == name
+          || name.find_first_of("/\\") != name_t::npos;
+    }
+
+    // call with the lock of the inode
+    void truncate(inode_t& inode, uint64_t size) {
+      if (size < inode.size) {
+          auto first_dropped = (size + memory_backend_t::PAGE_SIZE - 1) / memory_backend_t::PAGE_SIZE;
+          auto it = inode.pages.lower_bound(first_dropped);
+          inode.page_count -= static_cast<size_t>(std::distance(it, inode.pages.end()));
+          inode.pages.erase(it, inode.pages.end());
+          auto tail = size % memory_backend_t::PAGE_SIZE;
+          if (0 != tail) {
+              auto last = inode.pages.find(size / memory_backend_t::PAGE_SIZE);
+              if (last != inode.pages.end()) memset(last->second->data() + tail, 0, memory_backend_t::PAGE_SIZE - tail);
+            }
+        }
+      inode.size = size;
+    }
+
+    struct memory_object_t : object_t {
+      memory_object_t(memory_backend_t& backend, inode_ptr_t inode)
+        : backend_m(backend), inode_m(std::move(inode))
+      {}
+
+      path_t path() const override {
+        return backend_m.path(inode_m);
+      }
+
+      bool id(volume_file_id_t& id) const override {
+        id = {};
+        id.volume = backend_m.config().volume;
+        memcpy(id.file, &inode_m->id, sizeof(inode_m->id));
+        return true;
+      }
+
+      bool stat(attributes_t& attributes) const override {
+        backend_m.delay();
+        fill(attributes);
+        return true;
+      }
+
+      void fill(attributes_t& attributes) const {
+        attributes.nlink = backend_m.nlink(inode_m);
+        read_lock_t lock(inode_m->mutex);
+        attributes.type = inode_m->type;
+        attributes.mode = inode_m->mode;
+        attributes.size = inode_m->size;
+        attributes.allocated_size = inode_m->pages.size() * memory_backend_t::PAGE_SIZE;
+        attributes.atime = inode_m->atime;
+        attributes.mtime = inode_m->mtime;
+        attributes.ctime = inode_m->ctime;
+      }
+
+      bool space(space_t& space) const override {
+        auto used = backend_m.stats().pages * memory_backend_t::PAGE_SIZE;
+        space.total_bytes = backend_m.config().capacity;
+        space.free_bytes = used < space.total_bytes ? space.total_bytes - used : 0;
+        space.available_bytes = space.free_bytes;
+        return true;
+      }
+
+      bool read_at(uint64_t offset, binary_t& binary) const override {
+        backend_m.delay();
+        if (inode_m->type != type_t::REGULAR_FILE) return false;
+        read_lock_t lock(inode_m->mutex);
+        auto size = offset < inode_m->size ? std::min<uint64_t>(binary.size(), inode_m->size - offset) : 0;
+        binary.resize(static_cast<size_t>(size));
+        for (size_t done = 0; done < binary.size();) {
+            auto position = offset + done;
+            auto page_offset = static_cast<size_t>(position % memory_backend_t::PAGE_SIZE);
+            auto count = std::min(binary.size() - done, memory_backend_t::PAGE_SIZE - page_offset);
+            auto it = inode_m->pages.find(position / memory_backend_t::PAGE_SIZE);
+            if (it == inode_m->pages.end()) memset(&binary[done], 0, count);
+            else memcpy(&binary[done], it->second->data() + page_offset, count);
+            done += count;
+          }
+        return true;
+      }
+
+      bool write_at(uint64_t offset, const binary_t& binary) const override {
+        backend_m.delay();
+        if (inode_m->type != type_t::REGULAR_FILE) return false;
+        write_lock_t lock(inode_m->mutex);
+        for (size_t done = 0; done < binary.size();) {
+            auto position = offset + done;
+            auto page_offset = static_cast<size_t>(position % memory_backend_t::PAGE_SIZE);
+            auto count = std::min(binary.size() - done, memory_backend_t::PAGE_SIZE - page_offset);
+            auto& page = inode_m->pages[position / memory_backend_t::PAGE_SIZE];
+            if ( !page) {
+                page.reset(new page_t());
+                ++inode_m->page_count;
+              }
+            memcpy(page->data() + page_offset, &binary[done], count);
+            done += count;
+          }
+        inode_m->size = std::max<uint64_t>(inode_m->size, offset + binary.size());
+        changed(*inode_m);
+        return true;
+      }
+
+      bool sync() const override {
+        backend_m.delay();
+        return true; // memory is as durable as it gets
+      }
+
+      bool set_size(uint64_t size) const override {
+        backend_m.delay();
+        if (inode_m->type != type_t::REGULAR_FILE) return false;
+        write_lock_t lock(inode_m->mutex);
+        truncate(*inode_m, size);
+        changed(*inode_m);
+        return true;
+      }
+
+      bool touch(bool access_time, bool modify_time) const override {
+        backend_m.delay();
+        write_lock_t lock(inode_m->mutex);
+        if (access_time) inode_m->atime = now();
+        if (modify_time) changed(*inode_m);
+        return true;
+      }
+
+      bool read_link(name_t&) const override {
+        return false; // no symlinks are created
+      }
+
+      bool enumerate(const std::function<bool (const entry_t&)>& callback) const override {
+        backend_m.delay();
+        if (inode_m->type != type_t::DIRECTORY) return false;
+        for (auto& child : backend_m.children(inode_m)) {
+            entry_t entry;
+            entry.name = child.first;
+            memcpy(entry.file, &child.second->id, sizeof(child.second->id));
+            memset(entry.file + sizeof(child.second->id), 0, sizeof(entry.file) - sizeof(child.second->id));
+            memory_object_t(backend_m, child.second).fill(entry.attributes);
+            if ( !callback(entry)) return true;
+          }
+        return true;
+      }
+
+      object_ptr_t lookup(const name_t& name, uint32_t) const override {
+        backend_m.delay();
+        auto child = backend_m.child(inode_m, name);
+        if ( !child) return {};
+        return object_ptr_t(new memory_object_t(backend_m, std::move(child)));
+      }
+
+      object_ptr_t create_file(const name_t& name) const override {
+        backend_m.delay();
+        auto child = backend_m.create(inode_m, name, type_t::REGULAR_FILE);
+        if ( !child) return {};
+        return object_ptr_t(new memory_object_t(backend_m, std::move(child)));
+      }
+
+      object_ptr_t create_directory(const name_t& name) const override {
+        backend_m.delay();
+        auto child = backend_m.create(inode_m, name, type_t::DIRECTORY);
+        if ( !child) return {};
+        return object_ptr_t(new memory_object_t(backend_m, std::move(child)));
+      }
+
+      bool remove(const name_t& name) const override {
+        backend_m.delay();
+        return backend_m.unlink(inode_m, name, type_t::REGULAR_FILE);
+      }
+
+      bool remove_directory(const name_t& name) const override {
+        backend_m.delay();
+        return backend_m.unlink(inode_m, name, type_t::DIRECTORY);
+      }
+
+      bool rename(const name_t& from, const object_t& to_directory, const name_t& to) const override {
+        backend_m.delay();
+        auto target = dynamic_cast<const memory_object_t*>(&to_directory);
+        if ( !target) return false; // another backend
+        return backend_m.rename(inode_m, from, target->inode_m, to);
+      }
+
+    private:
+      memory_backend_t& backend_m;
+      inode_ptr_t inode_m;
+    };
+  } // namespace
+
+  memory_backend_t::memory_backend_t()
+    : memory_backend_t(config_t())
+  {}
+
+  memory_backend_t::memory_backend_t(const config_t& config)
+    : config_m(config)
+  {
+    write_lock_t lock(mutex_m);
+    root_m = make_inode(type_t::DIRECTORY);
+  }
+
+  memory_backend_t::~memory_backend_t() = default;
+
+  object_ptr_t memory_backend_t::open_path(const path_t& path, uint32_t)
+  {
+    auto inode = resolve(path, false);
+    if ( !inode) return {};
+    return object_ptr_t(new memory_object_t(*this, std::move(inode)));
+  }
+
+  object_ptr_t memory_backend_t::open_by_id(const object_t& mount_directory, const volume_file_id_t& id, uint32_t)
+  {
+    if ( !dynamic_cast<const memory_object_t*>(&mount_directory)) return {}; // another backend
+    if (id.volume != config_m.volume) return {};
+    inode_ptr_t inode;
+    {
+      read_lock_t lock(mutex_m);
+      auto it = inodes_m.find(short_file_id(id));
+      if (it == inodes_m.end()) return {}; // removed
+      inode = it->second;
+    }
+    return object_ptr_t(new memory_object_t(*this, std::move(inode)));
+  }
+
+  watcher_ptr_t memory_backend_t::watch(const object_t&, change_callback_t&&)
+  {
+    return {}; // all changes are made by the server
+  }
+
+  object_ptr_t memory_backend_t::make_directories(const path_t& path)
+  {
+    auto inode = resolve(path, true);
+    if ( !inode) return {};
+    return object_ptr_t(new memory_object_t(*this, std::move(inode)));
+  }
+
+  memory_backend_t::stats_t memory_backend_t::stats() const
+  {
+    stats_t result;
+    result.pages = pages_m.load(std::memory_order_relaxed);
+    read_lock_t lock(mutex_m);
+    result.inodes = inodes_m.size();
+    return result;
+  }
+
+  void memory_backend_t::delay() const
+  {
+    if (config_m.latency.count() > 0) std::this_thread::sleep_for(config_m.latency);
+  }
+
+  path_t memory_backend_t::path(const inode_ptr_t& inode) const
+  {
+    std::vector<const name_t*> names;
+    read_lock_t lock(mutex_m);
+    for (auto current = inode; current && current != root_m; current = current->parent.lock()) {
+        names.push_back(&current->name);
+      }
+    if (names.empty()) return L"/";
+    name_t result;
+    for (auto it = names.rbegin(); it != names.rend(); ++it) result += '/' + **it;
+    return convert::to_wstring(result);
+  }
+
+  uint32_t memory_backend_t::nlink(const inode_ptr_t& inode) const
+  {
+    read_lock_t lock(mutex_m);
+    if (inode != root_m && inode->parent.expired()) return 0; // removed
+    if (inode->type != type_t::DIRECTORY) return 1;
+    auto directories = std::count_if(inode->children.begin(), inode->children.end(), [](const auto& child) {
+        return child.second->type == type_t::DIRECTORY;
+      });
+    return static_cast<uint32_t>(2 + directories);
+  }
+
+  memory_backend_t::inode_ptr_t memory_backend_t::child(const inode_ptr_t& directory, const name_t& name) const
+  {
+    read_lock_t lock(mutex_m);
+    if ("." == name) return directory;
+    if (".." == name) {
+        auto parent = directory->parent.lock();
+        return parent ? parent : directory;
+      }
+    auto it = directory->children.find(name);
+    if (it == directory->children.end()) return {};
+    return it->second;
+  }
+
+  memory_backend_t::children_t memory_backend_t::children(const inode_ptr_t& directory) const
+  {
+    children_t result;
+    read_lock_t lock(mutex_m);
+    result.reserve(2 + directory->children.size());
+    auto parent = directory->parent.lock();
+    result.emplace_back(".", directory);
+    result.emplace_back("..", parent ? parent : directory);
+    for (auto& child : directory->children) result.push_back(child);
+    return result;
+  }
+
+  memory_backend_t::inode_ptr_t memory_backend_t::create(const inode_ptr_t& directory, const name_t& name, type_t type)
+  {
+    if (is_special(name)) return {};
+    write_lock_t lock(mutex_m);
+    if (directory->type != type_t::DIRECTORY) return {};
+    if (directory != root_m && directory->parent.expired()) return {}; // removed
+    auto& child = directory->children[name];
+    if (child) return {}; // exists
+    child = make_inode(type);
+    child->parent = directory;
+    child->name = name;
+    write_lock_t directory_lock(directory->mutex);
+    changed(*directory);
+    return child;
+  }
+
+  bool memory_backend_t::unlink(const inode_ptr_t& directory, const name_t& name, type_t type)
+  {
+    inode_ptr_t released; // freed after the lock is released
+    write_lock_t lock(mutex_m);
+    auto it = directory->children.find(name);
+    if (it == directory->children.end()) return false;
+    auto& child = it->second;
+    if (child->type != type) return false;
+    if ( !child->children.empty()) return false; // not empty
+    released = std::move(child);
+    directory->children.erase(it);
+    released->parent.reset();
+    inodes_m.erase(released->id);
+    write_lock_t directory_lock(directory->mutex);
+    changed(*directory);
+    return true;
+  }
+
+  bool memory_backend_t::rename(const inode_ptr_t& from_directory, const name_t& from, const inode_ptr_t& to_directory, const name_t& to)
+  {
+    if (is_special(to)) return false;
+    inode_ptr_t released; // freed after the lock is released
+    write_lock_t lock(mutex_m);
+    if (to_directory->type != type_t::DIRECTORY) return false;
+    auto from_it = from_directory->children.find(from);
+    if (from_it == from_directory->children.end()) return false;
+    auto moved = from_it->second;
+    if (from_directory == to_directory && from == to) return true;
+
+    // a directory cannot move below itself
+    for (auto current = to_directory; current; current = current->parent.lock()) {
+        if (current == moved) return false;
+      }
+
+    auto to_it = to_directory->children.find(to);
+    if (to_it != to_directory->children.end()) {
+        auto& replaced = to_it->second;
+        if (replaced->type != moved->type || !replaced->children.empty()) return false;
+        released = std::move(replaced);
+        released->parent.reset();
+        inodes_m.erase(released->id);
+        to_directory->children.erase(to_it);
+      }
+    from_directory->children.erase(from_it);
+    moved->parent = to_directory;
+    moved->name = to;
+    to_directory->children.emplace(to, moved);
+    {
+      write_lock_t directory_lock(from_directory->mutex);
+      changed(*from_directory);
+    }
+    if (to_directory != from_directory) {
+        write_lock_t directory_lock(to_directory->mutex);
+        changed(*to_directory);
+      }
+    return true;
+  }
+
+  memory_backend_t::inode_ptr_t memory_backend_t::make_inode(type_t type)
+  {
+    auto inode = std::make_shared<inode_t>(pages_m);
+    inode->id = next_id_m++;
+    inode->type = type;
+    inode->mode = type == type_t::DIRECTORY ? 0755 : 0644;
+    changed(*inode);
+    inode->atime = inode->mtime;
+    inodes_m.emplace(inode->id, inode);
+    return inode;
+  }
+
+  memory_backend_t::inode_ptr_t memory_backend_t::resolve(const path_t& path, bool create_directories)
+  {
+    std::vector<name_t> names;
+    size_t start = 0;
+    while (start <= path.size()) {
+        auto end = path.find_first_of(L"\\/", start);
+        if (path_t::npos == end) end = path.size();
+        auto name = convert::to_string(path.data() + start, end - start);
+        if ( !name.empty() && "." != name) names.push_back(std::move(name));
+        start = end + 1;
+      }
+
+    write_lock_t write_lock(mutex_m, std::defer_lock);
+    read_lock_t read_lock(mutex_m, std::defer_lock);
+    if (create_directories) write_lock.lock();
+    else read_lock.lock();
+
+    auto current = root_m;
+    for (auto& name : names) {
+        if (current->type != type_t::DIRECTORY) return {};
+        if (".." == name) {
+            auto parent = current->parent.lock();
+            if (parent) current = parent;
+            continue;
+          }
+        auto it = current->children.find(name);
+        if (it != current->children.end()) {
+            current = it->second;
+            continue;
+          }
+        if ( !create_directories) return {};
+        auto child = make_inode(type_t::DIRECTORY);
+        child->parent = current;
+        child->name = name;
+        current->children.emplace(name, child);
+        write_lock_t directory_lock(current->mutex);
+        changed(*current);
+        current = child;
+      }
+    return current;
+  }
+
+} // namespace fs
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "fs.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fs {
+
+  /**
+   * @brief backend with a tree of inodes in memory - measures the server without storage
+   *
+   * File data is kept in pages of PAGE_SIZE bytes. Pages that were never written read as
+   * zeros. Ids count up and are never reused, so file handles stay valid for the lifetime
+   * of the backend.
+   *
+   * Every call of an object waits for the configured latency to imitate a device.
+   * Paths may use both separators and always start at the root of the tree.
+   *
+   * Changes are not watched - all changes are made through the backend.
+   */
+  struct memory_backend_t : backend_t {
+    static constexpr size_t PAGE_SIZE = 4096;
+
+    struct config_t {
+      std::chrono::microseconds latency = std::chrono::microseconds(0); // per call of an object
+      uint64_t volume = 0x6D656D; // "mem"
+      uint64_t capacity = uint64_t(1) << 40; // reported as total space
+    };
+
+    struct stats_t {
+      size_t inodes = 0; // including the root
+      size_t pages = 0;
+    };
+
+    struct inode_t;
+    using inode_ptr_t = std::shared_ptr<inode_t>;
+
+    memory_backend_t();
+    explicit memory_backend_t(const config_t& config);
+    ~memory_backend_t() override;
+
+    memory_backend_t(const memory_backend_t&) = delete;
+    memory_backend_t& operator= (const memory_backend_t&) = delete;
+
+    const config_t& config() const { return config_m; }
+    const char* name() const override { return "memory"; }
+
+    object_ptr_t open_path(const path_t& path, uint32_t access = READ_ATTRIBUTES) override;
+    object_ptr_t open_by_id(const object_t& mount_directory, const volume_file_id_t& id, uint32_t access = READ_ATTRIBUTES) override;
+    watcher_ptr_t watch(const object_t& directory, change_callback_t&& callback) override;
+
+    // creates the missing directories of the path - to prepare a tree
+    object_ptr_t make_directories(const path_t& path);
+
+    stats_t stats() const;
+
+  public: // used by the objects
+    using children_t = std::vector<std::pair<name_t, inode_ptr_t>>;
+
+    void delay() const;
+    path_t path(const inode_ptr_t&) const;
+    uint32_t nlink(const inode_ptr_t&) const;
+    inode_ptr_t child(const inode_ptr_t& directory, const name_t& name) const;
+    children_t children(const inode_ptr_t& directory) const; // with . and ..
+    inode_ptr_t create(const inode_ptr_t& directory, const name_t& name, type_t type);
+    bool unlink(const inode_ptr_t& directory, const name_t& name, type_t type);
+    bool rename(const inode_ptr_t& from_directory, const name_t& from, const inode_ptr_t& to_directory, const name_t& to);
+
+  private:
+    inode_ptr_t make_inode(type_t type); // call with mutex_m
+    inode_ptr_t resolve(const path_t& path, bool create_directories);
+
+  private:
+    config_t config_m;
+    std::atomic<size_t> pages_m {0}; // outlives the inodes
+    mutable std::shared_timed_mutex mutex_m; // the tree and the inode map
+    std::unordered_map<uint64_t, inode_ptr_t> inodes_m; // by id - removed when unlinked
+    uint64_t next_id_m = 1;
+    inode_ptr_t root_m;
+  };
+
+} // namespace fs
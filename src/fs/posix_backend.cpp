@@ -0,0 +1,319 @@
+#include "posix_backend.h"
+
+#include "posixfs/posix_file.h"
+
+#include "container/string_convert.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace fs {
+
+  namespace {
+    // getdents64 has no glibc wrapper before 2.30
+    struct linux_dirent64_t {
+      uint64_t d_ino;
+      int64_t d_off;
+      unsigned short d_reclen;
+      unsigned char d_type;
+      char d_name[1];
+    };
+
+    struct handle_buffer_t {
+      struct file_handle header;
+      uint8_t bytes[MAX_HANDLE_SZ];
+    };
+
+    time_t unix_time(const timespec& time) {
+      time_t result;
+      result.seconds = static_cast<uint64_t>(time.tv_sec);
+      result.nanoseconds = static_cast<uint32_t>(time.tv_nsec);
+      return result;
+    }
+
+    attributes_t attributes_from_stat(const struct ::stat& st) {
+      attributes_t result;
+      if (S_ISDIR(st.st_mode)) result.type = type_t::DIRECTORY;
+      else if (S_ISLNK(st.st_mode)) result.type = type_t::SYMLINK;
+      else result.type = type_t::REGULAR_FILE;
+      result.mode = st.st_mode & 0777;
+      result.nlink = static_cast<uint32_t>(st.st_nlink);
+      result.size = static_cast<uint64_t>(st.st_size);
+      result.allocated_size = static_cast<uint64_t>(st.st_blocks) * 512;
+      result.atime = unix_time(st.st_atim);
+      result.mtime = unix_time(st.st_mtim);
+      result.ctime = unix_time(st.st_ctim);
+      return result;
+    }
+
+    volume_file_id_t id_from_stat(const struct ::stat& st) {
+      volume_file_id_t result = {};
+      result.volume = static_cast<uint64_t>(st.st_dev);
+      uint64_t inode = static_cast<uint64_t>(st.st_ino);
+      memcpy(result.file, &inode, sizeof(inode));
+      return result;
+    }
+
+    // data needs a readable or writable descriptor, everything else works with O_PATH
+    template<typename open_t> // int (int flags)
+    int open_for(uint32_t access, const open_t& open) {
+      int flags = O_PATH;
+      if (access & (WRITE_DATA | WRITE_ATTRIBUTES)) flags = O_RDWR;
+      else if (access & (READ_DATA | LIST_DIRECTORY)) flags = O_RDONLY;
+      auto fd = open(flags | O_CLOEXEC);
+      if (fd < 0 && EISDIR == errno && O_RDWR == flags) fd = open(O_RDONLY | O_CLOEXEC); // attributes of directories
+      if (fd < 0 && ELOOP == errno && 0 == (access & (READ_DATA | WRITE_DATA | LIST_DIRECTORY))) {
+          fd = open(O_PATH | O_CLOEXEC); // symlinks themselves
+        }
+      return fd;
+    }
+
+    std::string fd_path(int fd) {
+      char link[32];
+      snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+      char buffer[PATH_MAX];
+      auto size = ::readlink(link, buffer, sizeof(buffer));
+      if (size <= 0) return {};
+      return std::string(buffer, static_cast<size_t>(size));
+    }
+
+    struct posix_object_t : object_t {
+      posix_object_t(posix_backend_t& backend, int fd, std::string path)
+        : backend_m(backend), fd_m(fd), path_m(std::move(path))
+      {}
+      ~posix_object_t() override { ::close(fd_m); }
+
+      int fd() const { return fd_m; }
+      std::string child_path(const name_t& name) const { return path_m + '/' + name; }
+
+      path_t path() const override {
+        return convert::to_wstring(path_m);
+      }
+
+      bool id(volume_file_id_t& id) const override {
+        struct ::stat st;
+        if (0 != ::fstat(fd_m, &st)) return false;
+        id = id_from_stat(st);
+        backend_m.remember(id, path_m);
+        return true;
+      }
+
+      bool stat(attributes_t& attributes) const override {
+        struct ::stat st;
+        if (0 != ::fstat(fd_m, &st)) return false;
+        attributes = attributes_from_stat(st);
+        return true;
+      }
+
+      bool space(space_t& space) const override {
+        struct ::statvfs st;
+        if (0 != ::fstatvfs(fd_m, &st)) return false;
+        space.total_bytes = static_cast<uint64_t>(st.f_blocks) * st.f_frsize;
+        space.free_bytes = static_cast<uint64_t>(st.f_bfree) * st.f_frsize;
+        space.available_bytes = static_cast<uint64_t>(st.f_bavail) * st.f_frsize;
+        return true;
+      }
+
+      bool read_at(uint64_t offset, binary_t& binary) const override {
+        return posixfs::file_t(fd_m).read_at(offset, binary);
+      }
+
+      bool write_at(uint64_t offset, const binary_t& binary) const override {
+        return posixfs::file_t(fd_m).write_at(offset, binary);
+      }
+
+      bool sync() const override {
+        return posixfs::file_t(fd_m).sync();
+      }
+
+      bool set_size(uint64_t size) const override {
+        return 0 == ::ftruncate(fd_m, static_cast<off_t>(size));
+      }
+
+      bool touch(bool access_time, bool modify_time) const override {
+        struct timespec times[2];
+        times[0].tv_nsec = access_time ? UTIME_NOW : UTIME_OMIT;
+        times[1].tv_nsec = modify_time ? UTIME_NOW : UTIME_OMIT;
+        // futimens needs a file opened for writing, the path works for all
+        return 0 == ::utimensat(AT_FDCWD, path_m.c_str(), times, AT_SYMLINK_NOFOLLOW);
+      }
+
+      bool read_link(name_t& target) const override {
+        char buffer[PATH_MAX];
+        auto size = ::readlinkat(fd_m, "", buffer, sizeof(buffer));
+        if (size < 0) return false;
+        target.assign(buffer, static_cast<size_t>(size));
+        return true;
+      }
+
+      bool enumerate(const std::function<bool (const entry_t&)>& callback) const override {
+        if (::lseek(fd_m, 0, SEEK_SET) < 0) return false;
+        alignas(8) char buffer[0x10000];
+        while (true) {
+            auto size = ::syscall(SYS_getdents64, fd_m, buffer, sizeof(buffer));
+            if (size < 0) return false;
+            if (0 == size) return true;
+            for (long offset = 0; offset < size;) {
+                auto dirent = reinterpret_cast<const linux_dirent64_t*>(buffer + offset);
+                offset += dirent->d_reclen;
+
+                struct ::stat st;
+                if (0 != ::fstatat(fd_m, dirent->d_name, &st, AT_SYMLINK_NOFOLLOW)) continue; // removed meanwhile
+
+                entry_t entry;
+                entry.name = dirent->d_name;
+                auto id = id_from_stat(st);
+                memcpy(entry.file, id.file, sizeof(entry.file));
+                entry.attributes = attributes_from_stat(st);
+                if (entry.name != "." && entry.name != "..") backend_m.remember(id, child_path(entry.name));
+                if ( !callback(entry)) return true;
+              }
+          }
+      }
+
+      object_ptr_t lookup(const name_t& name, uint32_t access) const override {
+        auto fd = open_for(access, [&](int flags) {
+            return ::openat(fd_m, name.c_str(), flags | O_NOFOLLOW);
+          });
+        if (fd < 0) return {};
+        return object_ptr_t(new posix_object_t(backend_m, fd, child_path(name)));
+      }
+
+      object_ptr_t create_file(const name_t& name) const override {
+        auto fd = ::openat(fd_m, name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC | O_NOFOLLOW, 0666);
+        if (fd < 0) return {};
+        return object_ptr_t(new posix_object_t(backend_m, fd, child_path(name)));
+      }
+
+      object_ptr_t create_directory(const name_t& name) const override {
+        if (0 != ::mkdirat(fd_m, name.c_str(), 0777)) return {};
+        return lookup(name, READ_ATTRIBUTES);
+      }
+
+      bool remove(const name_t& name) const override {
+        return 0 == ::unlinkat(fd_m, name.c_str(), 0);
+      }
+
+      bool remove_directory(const name_t& name) const override {
+        return 0 == ::unlinkat(fd_m, name.c_str(), AT_REMOVEDIR);
+      }
+
+      bool rename(const name_t& from, const object_t& to_directory, const name_t& to) const override {
+        auto target = dynamic_cast<const posix_object_t*>(&to_directory);
+        if ( !target) return false; // another backend
+        if (0 != ::renameat(fd_m, from.c_str(), target->fd_m, to.c_str())) return false;
+        backend_m.renamed(child_path(from), target->child_path(to));
+        return true;
+      }
+
+    private:
+      posix_backend_t& backend_m;
+      int fd_m;
+      std::string path_m;
+    };
+  } // namespace
+
+  object_ptr_t posix_backend_t::open_path(const path_t& path, uint32_t access)
+  {
+    // mount paths may contain symlinks - the objects know the resolved path
+    auto narrow_path = convert::to_string(path);
+    char resolved[PATH_MAX];
+    if ( !::realpath(narrow_path.c_str(), resolved)) return {};
+    auto fd = open_for(access, [&](int flags) {
+        return ::open(resolved, flags);
+      });
+    if (fd < 0) return {};
+    return object_ptr_t(new posix_object_t(*this, fd, resolved));
+  }
+
+  object_ptr_t posix_backend_t::open_by_id(const object_t& mount_directory, const volume_file_id_t& id, uint32_t access)
+  {
+    known_t known;
+    {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      auto it = known_m.find(id);
+      if (it == known_m.end()) return {}; // never handed out
+      known = it->second;
+    }
+
+    auto mount = dynamic_cast<const posix_object_t*>(&mount_directory);
+    if (mount && !known.handle.empty() && by_handle_m.load(std::memory_order_relaxed)) {
+        handle_buffer_t buffer;
+        buffer.header.handle_bytes = static_cast<unsigned>(known.handle.size());
+        buffer.header.handle_type = known.handle_type;
+        memcpy(buffer.header.f_handle, known.handle.data(), known.handle.size());
+        auto fd = open_for(access, [&](int flags) {
+            return ::open_by_handle_at(mount->fd(), &buffer.header, flags);
+          });
+        if (0 <= fd) return object_ptr_t(new posix_object_t(*this, fd, fd_path(fd))); // also after foreign renames
+        if (EPERM == errno) by_handle_m = false;
+      }
+
+    auto fd = open_for(access, [&](int flags) {
+        return ::open(known.path.c_str(), flags | O_NOFOLLOW);
+      });
+    if (fd < 0) return {};
+    struct ::stat st;
+    if (0 != ::fstat(fd, &st) || id_from_stat(st) != id) {
+        ::close(fd); // replaced by another file
+        return {};
+      }
+
+    if (known.handle.empty() && by_handle_m.load(std::memory_order_relaxed)) {
+        handle_buffer_t buffer;
+        buffer.header.handle_bytes = MAX_HANDLE_SZ;
+        int mount_id;
+        if (0 == ::name_to_handle_at(fd, "", &buffer.header, &mount_id, AT_EMPTY_PATH)) {
+            std::lock_guard<std::mutex> lock(mutex_m);
+            auto& stored = known_m[id];
+            stored.handle_type = buffer.header.handle_type;
+            stored.handle.assign(buffer.header.f_handle, buffer.header.f_handle + buffer.header.handle_bytes);
+          }
+      }
+    return object_ptr_t(new posix_object_t(*this, fd, known.path));
+  }
+
+  watcher_ptr_t posix_backend_t::watch(const object_t&, change_callback_t&&)
+  {
+    return {}; // inotify does not watch subtrees
+  }
+
+  size_t posix_backend_t::known_ids() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    return known_m.size();
+  }
+
+  void posix_backend_t::remember(const volume_file_id_t& id, const std::string& path)
+  {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    auto& known = known_m[id];
+    if (known.path != path) known.path = path; // the latest of several links
+  }
+
+  void posix_backend_t::renamed(const std::string& from, const std::string& to)
+  {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    for (auto& entry : known_m) {
+        auto& path = entry.second.path;
+        if (0 != path.compare(0, from.size(), from)) continue;
+        if (path.size() == from.size()) path = to;
+        else if ('/' == path[from.size()]) path = to + path.substr(from.size());
+      }
+  }
+
+  backend_t& default_backend()
+  {
+    static posix_backend_t backend;
+    return backend;
+  }
+
+} // namespace fs
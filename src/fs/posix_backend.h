@@ -0,0 +1,55 @@
+#pragma once
+
+#include "fs.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace fs {
+
+  /**
+   * @brief backend for linux with openat, fstatat, getdents64 and name_to_handle_at
+   *
+   * Ids are the device and inode number. The backend remembers the path of every id it
+   * handed out. Renames through the backend move the remembered paths.
+   *
+   * open_by_id uses the file handle of name_to_handle_at if the process may call
+   * open_by_handle_at (CAP_DAC_READ_SEARCH). Otherwise it opens the remembered path
+   * and verifies the inode.
+   *
+   * Changes are not watched - cached attributes only expire.
+   */
+  struct posix_backend_t : backend_t {
+    posix_backend_t() = default;
+
+    posix_backend_t(const posix_backend_t&) = delete;
+    posix_backend_t& operator= (const posix_backend_t&) = delete;
+
+    const char* name() const override { return "posix"; }
+
+    object_ptr_t open_path(const path_t& path, uint32_t access = READ_ATTRIBUTES) override;
+    object_ptr_t open_by_id(const object_t& mount_directory, const volume_file_id_t& id, uint32_t access = READ_ATTRIBUTES) override;
+    watcher_ptr_t watch(const object_t& directory, change_callback_t&& callback) override;
+
+    size_t known_ids() const;
+
+  public: // used by the objects
+    void remember(const volume_file_id_t& id, const std::string& path);
+    void renamed(const std::string& from, const std::string& to);
+
+  private:
+    struct known_t {
+      std::string path;
+      int handle_type = 0;
+      std::vector<uint8_t> handle; // empty until the id was opened by path
+    };
+
+  private:
+    mutable std::mutex mutex_m;
+    std::unordered_map<volume_file_id_t, known_t, volume_file_id_hash_t> known_m;
+    std::atomic<bool> by_handle_m {true}; // cleared when open_by_handle_at is not permitted
+  };
+
+} // namespace fs
@@ -0,0 +1,250 @@
+#include "winfs_backend.h"
+
+#include "winfs/winfs_object.h"
+#include "winfs/file_change_notifier.h"
+#include "wintime/wintime_convert.h"
+
+#include "container/string_convert.h"
+#include "logging/logger.h"
+
+#include <cstring>
+
+namespace fs {
+
+  static_assert(sizeof(volume_file_id_t) == sizeof(winfs::volume_file_id_t), "file handles keep their layout");
+
+  namespace {
+    const uint32_t object_flags = FILE_FLAG_OPEN_REPARSE_POINT | FILE_FLAG_BACKUP_SEMANTICS;
+
+    uint32_t desired_access(uint32_t access) {
+      uint32_t result = 0;
+      if (access & READ_ATTRIBUTES) result |= FILE_READ_ATTRIBUTES;
+      if (access & WRITE_ATTRIBUTES) result |= FILE_WRITE_ATTRIBUTES | FILE_APPEND_DATA;
+      if (access & READ_DATA) result |= FILE_READ_DATA;
+      if (access & WRITE_DATA) result |= FILE_GENERIC_WRITE;
+      if (access & LIST_DIRECTORY) result |= FILE_LIST_DIRECTORY;
+      return result;
+    }
+
+    // positional I/O of an overlapped handle runs in parallel, a synchronous handle serializes it
+    uint32_t open_flags(uint32_t access) {
+      if (access & (READ_DATA | WRITE_DATA)) return object_flags | FILE_FLAG_OVERLAPPED;
+      return object_flags;
+    }
+
+    type_t type_from_FileAttributes(DWORD FileAttributes) {
+      if (FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) return type_t::SYMLINK;
+      if (FileAttributes & FILE_ATTRIBUTE_DIRECTORY) return type_t::DIRECTORY;
+      return type_t::REGULAR_FILE;
+    }
+
+    uint32_t mode_from_FileAttributes(DWORD FileAttributes) {
+      if (FileAttributes & FILE_ATTRIBUTE_SYSTEM) return 0; // nothing allowed
+      if (FileAttributes & FILE_ATTRIBUTE_READONLY) return 0555;
+      return 0777;
+    }
+
+    winfs::file_id_t windows_file_id(const uint8_t (&file)[16]) {
+      winfs::file_id_t result;
+      memcpy(&result, file, sizeof(result));
+      return result;
+    }
+
+    struct winfs_object_t : object_t {
+      explicit winfs_object_t(winfs::unique_object_t&& object)
+        : object_m(std::move(object))
+      {}
+
+      const winfs::unique_object_t& object() const { return object_m; }
+      // false for names that are empty or not utf8 - the path would be the directory itself
+      bool child_path(const name_t& name, std::wstring& path) const {
+        if (name.empty()) return false;
+        path = object_m.fullpath();
+        path += L'\\';
+        return convert::append_wstring(path, name);
+      }
+
+      path_t path() const override {
+        return object_m.fullpath();
+      }
+
+      bool id(volume_file_id_t& id) const override {
+        winfs::volume_file_id_t windows_id;
+        if ( !object_m.id(windows_id)) return false;
+        memcpy(&id, &windows_id, sizeof(id));
+        return true;
+      }
+
+      bool stat(attributes_t& attributes) const override {
+        FILE_BASIC_INFO basic_info;
+        FILE_STANDARD_INFO standard_info;
+        if ( !object_m.basic_info(basic_info) || !object_m.standard_info(standard_info)) return false;
+        attributes.type = type_from_FileAttributes(basic_info.FileAttributes);
+        attributes.mode = mode_from_FileAttributes(basic_info.FileAttributes);
+        attributes.nlink = standard_info.NumberOfLinks;
+        attributes.size = standard_info.EndOfFile.QuadPart;
+        attributes.allocated_size = standard_info.AllocationSize.QuadPart;
+        attributes.atime = wintime::convert_LARGE_INTEGER_to_unix_time(basic_info.LastAccessTime);
+        attributes.mtime = wintime::convert_LARGE_INTEGER_to_unix_time(basic_info.LastWriteTime);
+        attributes.ctime = wintime::convert_LARGE_INTEGER_to_unix_time(basic_info.ChangeTime);
+        return true;
+      }
+
+      bool space(space_t& space) const override {
+        ULARGE_INTEGER available_bytes, total_bytes, free_bytes;
+        auto fullpath = object_m.fullpath();
+        if ( !::GetDiskFreeSpaceExW(fullpath.c_str(), &available_bytes, &total_bytes, &free_bytes)) return false;
+        space.total_bytes = total_bytes.QuadPart;
+        space.free_bytes = free_bytes.QuadPart;
+        space.available_bytes = available_bytes.QuadPart;
+        return true;
+      }
+
+      bool read_at(uint64_t offset, binary_t& binary) const override {
+        return object_m.as_file().read_at(offset, binary);
+      }
+
+      bool write_at(uint64_t offset, const binary_t& binary) const override {
+        return object_m.as_file().write_at(offset, binary);
+      }
+
+      bool sync() const override {
+        return object_m.as_file().sync();
+      }
+
+      bool set_size(uint64_t size) const override {
+        return const_cast<winfs::unique_object_t&>(object_m).set_size(size);
+      }
+
+      bool touch(bool access_time, bool modify_time) const override {
+        FILETIME filetime;
+        ::GetSystemTimeAsFileTime(&filetime);
+        LARGE_INTEGER now;
+        now.HighPart = filetime.dwHighDateTime;
+        now.LowPart = filetime.dwLowDateTime;
+
+        FILE_BASIC_INFO basic_info = {}; // zero times are not changed
+        if (access_time) basic_info.LastAccessTime = now;
+        if (modify_time) basic_info.LastWriteTime = now;
+        return object_m.set_basic_info(basic_info);
+      }
+
+      bool read_link(name_t& target) const override {
+        target.clear(); // TODO: translate the reparse point target
+        return true;
+      }
+
+      bool enumerate(const std::function<bool (const entry_t&)>& callback) const override {
+        return object_m.as_directory().enumerate([&](const winfs::directory_entry_t& directory_entry) {
+            entry_t entry;
+            entry.name = convert::to_string(directory_entry.filename_data(), directory_entry.filename_size());
+            if (entry.name.empty()) return true; // unpaired surrogates have no utf8 name - not listed
+            auto file_id = directory_entry.id();
+            memcpy(entry.file, &file_id, sizeof(entry.file));
+            auto file_attributes = directory_entry.attributes();
+            entry.attributes.type = type_from_FileAttributes(file_attributes);
+            entry.attributes.mode = mode_from_FileAttributes(file_attributes);
+            entry.attributes.nlink = 1; // not listed
+            entry.attributes.size = directory_entry.size();
+            entry.attributes.allocated_size = directory_entry.allocated_size();
+            entry.attributes.atime = wintime::convert_LARGE_INTEGER_to_unix_time(directory_entry.lastAccessTime());
+            entry.attributes.mtime = wintime::convert_LARGE_INTEGER_to_unix_time(directory_entry.lastWriteTime());
+            entry.attributes.ctime = wintime::convert_LARGE_INTEGER_to_unix_time(directory_entry.changeTime());
+            return callback(entry);
+          });
+      }
+
+      object_ptr_t lookup(const name_t& name, uint32_t access) const override {
+        std::wstring path;
+        if ( !child_path(name, path)) return {};
+        auto object = winfs::open_path(path, desired_access(access), open_flags(access));
+        if ( !object.valid()) return {};
+        return object_ptr_t(new winfs_object_t(std::move(object)));
+      }
+
+      object_ptr_t create_file(const name_t& name) const override {
+        std::wstring path;
+        if ( !child_path(name, path)) return {};
+        auto object = winfs::create_file<FILE_READ_ATTRIBUTES | FILE_WRITE_ATTRIBUTES>(path);
+        if ( !object.valid()) return {};
+        return object_ptr_t(new winfs_object_t(std::move(object)));
+      }
+
+      object_ptr_t create_directory(const name_t& name) const override {
+        std::wstring path;
+        if ( !child_path(name, path) || !winfs::directory_t::create(path)) return {};
+        auto object = winfs::open_path<FILE_READ_ATTRIBUTES>(path);
+        if ( !object.valid()) return {};
+        return object_ptr_t(new winfs_object_t(std::move(object)));
+      }
+
+      bool remove(const name_t& name) const override {
+        std::wstring path;
+        return child_path(name, path) && winfs::file_t::remove(path);
+      }
+
+      bool remove_directory(const name_t& name) const override {
+        std::wstring path;
+        return child_path(name, path) && winfs::directory_t::remove(path);
+      }
+
+      bool rename(const name_t& from, const object_t& to_directory, const name_t& to) const override {
+        auto target = dynamic_cast<const winfs_object_t*>(&to_directory);
+        if ( !target) return false; // another backend
+        std::wstring from_path, to_path;
+        if ( !child_path(from, from_path) || !target->child_path(to, to_path)) return false;
+        return winfs::file_t::move(from_path, to_path);
+      }
+
+    private:
+      winfs::unique_object_t object_m;
+    };
+
+    struct winfs_watcher_t : watcher_t {
+      winfs_watcher_t(const path_t& path, backend_t::change_callback_t&& callback)
+        : notifier_m(path, file_change_notifier::subtree, [callback](file_change_notifier::full_path_t path) {
+            callback(path);
+          })
+      {
+        notifier_m.start_watching();
+      }
+
+    private:
+      file_change_notifier notifier_m;
+    };
+  } // namespace
+
+  object_ptr_t winfs_backend_t::open_path(const path_t& path, uint32_t access)
+  {
+    auto object = winfs::open_path(path, desired_access(access), open_flags(access));
+    if ( !object.valid()) return {};
+    return object_ptr_t(new winfs_object_t(std::move(object)));
+  }
+
+  object_ptr_t winfs_backend_t::open_by_id(const object_t& mount_directory, const volume_file_id_t& id, uint32_t access)
+  {
+    auto mount = dynamic_cast<const winfs_object_t*>(&mount_directory);
+    if ( !mount) return {};
+    auto object = mount->object().by_id(windows_file_id(id.file), desired_access(access), open_flags(access));
+    if ( !object.valid()) return {};
+    return object_ptr_t(new winfs_object_t(std::move(object)));
+  }
+
+  watcher_ptr_t winfs_backend_t::watch(const object_t& directory, change_callback_t&& callback)
+  {
+    try {
+      return watcher_ptr_t(new winfs_watcher_t(directory.path(), std::move(callback)));
+    }
+    catch (const std::exception& e) {
+      LOG_AT(WARNING, "winfs") << "Watching failed: " << e.what();
+      return {};
+    }
+  }
+
+  backend_t& default_backend()
+  {
+    static winfs_backend_t backend;
+    return backend;
+  }
+
+} // namespace fs
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "fs.h"
+
+namespace fs {
+
+  /**
+   * @brief backend for windows with OpenFileById and the extended directory information
+   *
+   * Ids are the FILE_ID_INFO of the volume. Data is accessed through overlapped handles,
+   * so concurrent positional reads and writes of one handle run in parallel.
+   * Changes below a watched directory are reported by ReadDirectoryChangesW.
+   */
+  struct winfs_backend_t : backend_t {
+    const char* name() const override { return "winfs"; }
+
+    object_ptr_t open_path(const path_t& path, uint32_t access = READ_ATTRIBUTES) override;
+    object_ptr_t open_by_id(const object_t& mount_directory, const volume_file_id_t& id, uint32_t access = READ_ATTRIBUTES) override;
+    watcher_ptr_t watch(const object_t& directory, change_callback_t&& callback) override;
+  };
+
+} // namespace fs
@@ -0,0 +1,265 @@
+#include "logger.h"
+
+#include "container/string_convert.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <condition_variable>
+#include <ctime>
+#include <cwchar>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace logging {
+
+  std::atomic<level_t> minimum_level {level_t::INFO};
+
+  namespace {
+    /**
+     * @brief records of one thread on their way to the writer
+     *
+     * Single producer - the owning thread, single consumer - whoever holds the drain lock.
+     */
+    struct ring_t {
+      enum : size_t { CAPACITY = 1024 };
+
+      bool push(record_t&& record) {
+        auto tail = tail_m.load(std::memory_order_relaxed);
+        if (tail - head_m.load(std::memory_order_acquire) == CAPACITY) return false;
+        slots_m[tail % CAPACITY] = std::move(record);
+        tail_m.store(tail + 1, std::memory_order_release);
+        return true;
+      }
+
+      template<typename callback_t>
+      void drain(callback_t&& callback) {
+        auto head = head_m.load(std::memory_order_relaxed);
+        auto tail = tail_m.load(std::memory_order_acquire);
+        for (; head != tail; ++head) callback(std::move(slots_m[head % CAPACITY]));
+        head_m.store(head, std::memory_order_release);
+      }
+
+      bool empty() const {
+        return head_m.load(std::memory_order_acquire) == tail_m.load(std::memory_order_acquire);
+      }
+
+    private:
+      std::array<record_t, CAPACITY> slots_m;
+      std::atomic<size_t> head_m {0};
+      std::atomic<size_t> tail_m {0};
+    };
+    using ring_ptr_t = std::shared_ptr<ring_t>;
+
+    struct logger_t {
+      enum : int { WRITE_INTERVAL_MS = 20 };
+
+      logger_t()
+        : sink_m(std::make_shared<stream_sink_t>(std::clog))
+        , writer_m([this] { run(); })
+      {}
+
+      ~logger_t() {
+        {
+          std::lock_guard<std::mutex> lock(wake_mutex_m);
+          stopping_m = true;
+        }
+        wake_m.notify_one();
+        writer_m.join();
+        write_all();
+      }
+
+      ring_t& ring() {
+        thread_local ring_ptr_t ring = add_ring();
+        return *ring;
+      }
+
+      void push(record_t&& record) {
+        if (ring().push(std::move(record))) records_m.fetch_add(1, std::memory_order_relaxed);
+        else dropped_m.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      void set_sink(sink_ptr_t sink) {
+        std::lock_guard<std::mutex> lock(drain_mutex_m);
+        sink_m = std::move(sink);
+      }
+
+      // drains all rings and writes their records in time order
+      void write_all() {
+        std::lock_guard<std::mutex> lock(drain_mutex_m);
+        std::vector<ring_ptr_t> rings;
+        {
+          std::lock_guard<std::mutex> rings_lock(rings_mutex_m);
+          // rings of finished threads are dropped once they are empty
+          rings_m.erase(std::remove_if(rings_m.begin(), rings_m.end(), [](const ring_ptr_t& ring) {
+              return 1 == ring.use_count() && ring->empty();
+            }), rings_m.end());
+          rings = rings_m;
+        }
+        batch_m.clear();
+        for (auto& ring : rings) ring->drain([&](record_t&& record) { batch_m.push_back(std::move(record)); });
+        if (batch_m.empty() && dropped_m.load(std::memory_order_relaxed) == reported_dropped_m) return;
+        std::stable_sort(batch_m.begin(), batch_m.end(), [](const record_t& a, const record_t& b) {
+            return a.time < b.time;
+          });
+        if ( !sink_m) return;
+        for (const auto& record : batch_m) sink_m->write(record);
+        report_dropped();
+        sink_m->flush();
+      }
+
+      stats_t stats() const {
+        stats_t result;
+        result.records = records_m.load(std::memory_order_relaxed);
+        result.dropped = dropped_m.load(std::memory_order_relaxed);
+        return result;
+      }
+
+    private:
+      ring_ptr_t add_ring() {
+        auto ring = std::make_shared<ring_t>();
+        std::lock_guard<std::mutex> lock(rings_mutex_m);
+        rings_m.push_back(ring);
+        return ring;
+      }
+
+      void report_dropped() {
+        auto dropped = dropped_m.load(std::memory_order_relaxed);
+        if (dropped == reported_dropped_m) return;
+        record_t record;
+        record.level = level_t::WARNING;
+        record.time = record_t::clock_t::now();
+        record.thread = std::this_thread::get_id();
+        record.component = "logging";
+        record.message = std::to_string(dropped - reported_dropped_m) + " records dropped";
+        sink_m->write(record);
+        reported_dropped_m = dropped;
+      }
+
+      void run() {
+        std::unique_lock<std::mutex> lock(wake_mutex_m);
+        while ( !stopping_m) {
+            wake_m.wait_for(lock, std::chrono::milliseconds(WRITE_INTERVAL_MS));
+            lock.unlock();
+            write_all();
+            lock.lock();
+          }
+      }
+
+    private:
+      std::mutex rings_mutex_m;
+      std::vector<ring_ptr_t> rings_m;
+
+      std::mutex drain_mutex_m; // one consumer of the rings at a time
+      sink_ptr_t sink_m;
+      std::vector<record_t> batch_m;
+      uint64_t reported_dropped_m = 0;
+
+      std::atomic<uint64_t> records_m {0};
+      std::atomic<uint64_t> dropped_m {0};
+
+      std::mutex wake_mutex_m;
+      std::condition_variable wake_m;
+      bool stopping_m = false;
+      std::thread writer_m; // last - starts after all members
+    };
+
+    logger_t& logger() {
+      static logger_t result;
+      return result;
+    }
+
+    std::ostringstream& thread_stream() {
+      thread_local std::ostringstream stream;
+      return stream;
+    }
+  } // namespace
+
+  const char* level_name(level_t level) {
+    switch (level) {
+      case level_t::TRACE: return "trace";
+      case level_t::INFO: return "info";
+      case level_t::WARNING: return "warning";
+      case level_t::FAILURE: return "failure";
+      case level_t::OFF: return "off";
+      }
+    return "";
+  }
+
+  bool parse_level(const std::string& name, level_t& level) {
+    for (auto candidate : { level_t::TRACE, level_t::INFO, level_t::WARNING, level_t::FAILURE, level_t::OFF }) {
+        if (name == level_name(candidate)) {
+            level = candidate;
+            return true;
+          }
+      }
+    return false;
+  }
+
+  void stream_sink_t::write(const record_t& record) {
+    auto time = record_t::clock_t::to_time_t(record.time);
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(record.time.time_since_epoch()).count() % 1000000;
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &local);
+    out_m << static_cast<char>(std::toupper(level_name(record.level)[0])) << " " << date
+          << "." << std::setfill('0') << std::setw(6) << microseconds << std::setfill(' ')
+          << " " << record.component << "] " << record.message << '\n';
+  }
+
+  void stream_sink_t::flush() {
+    out_m.flush();
+  }
+
+  void set_sink(sink_ptr_t sink) {
+    logger().set_sink(std::move(sink));
+  }
+
+  void flush() {
+    logger().write_all();
+  }
+
+  stats_t stats() {
+    return logger().stats();
+  }
+
+  line_t::line_t(level_t level, const char* component)
+    : level_m(level)
+    , component_m(component)
+    , stream_m(thread_stream())
+  {
+    stream_m.str(std::string());
+    stream_m.clear();
+    stream_m.flags(std::ios_base::skipws | std::ios_base::dec);
+    stream_m.precision(6);
+    stream_m.fill(' ');
+  }
+
+  line_t::~line_t() {
+    record_t record;
+    record.level = level_m;
+    record.time = record_t::clock_t::now();
+    record.thread = std::this_thread::get_id();
+    record.component = component_m;
+    record.message = stream_m.str();
+    logger().push(std::move(record));
+  }
+
+  line_t& line_t::operator<< (const std::wstring& value) {
+    stream_m << convert::to_string(value);
+    return *this;
+  }
+
+  line_t& line_t::operator<< (const wchar_t* value) {
+    if (value) stream_m << convert::to_string(value, std::wcslen(value));
+    return *this;
+  }
+
+} // namespace logging
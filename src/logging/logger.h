@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+/**
+ * Asynchronous leveled logging
+ *
+ * LOG_AT(INFO, "mount") << "Mount: " << path;
+ *
+ * The arguments are only evaluated if the level is enabled. The line is formatted on the
+ * calling thread into a reused buffer and pushed to a ring buffer of that thread without
+ * locks. A background writer drains all rings in time order and hands the records to the
+ * sink. If a ring is full the record is dropped and counted.
+ */
+namespace logging {
+
+  enum class level_t : uint8_t { TRACE, INFO, WARNING, FAILURE, OFF };
+
+  const char* level_name(level_t);
+  bool parse_level(const std::string&, level_t&); // trace, info, warning, failure or off
+
+  struct record_t {
+    using clock_t = std::chrono::system_clock;
+
+    level_t level = level_t::INFO;
+    clock_t::time_point time;
+    std::thread::id thread;
+    const char* component = ""; // string literal of the logging module
+    std::string message;
+  };
+
+  struct sink_t {
+    virtual ~sink_t() = default;
+    // called from the writer thread only
+    virtual void write(const record_t&) = 0;
+    virtual void flush() {}
+  };
+  using sink_ptr_t = std::shared_ptr<sink_t>;
+
+  // one line per record: "I 2024-01-31 12:34:56.789012 component] message"
+  struct stream_sink_t : sink_t {
+    explicit stream_sink_t(std::ostream& out) : out_m(out) {}
+
+    void write(const record_t&) override;
+    void flush() override;
+
+  private:
+    std::ostream& out_m;
+  };
+
+  struct stats_t {
+    uint64_t records = 0;
+    uint64_t dropped = 0; // rings were full
+  };
+
+  extern std::atomic<level_t> minimum_level;
+
+  inline bool enabled(level_t level) {
+    return level >= minimum_level.load(std::memory_order_relaxed) && level != level_t::OFF;
+  }
+  inline void set_level(level_t level) { minimum_level.store(level, std::memory_order_relaxed); }
+  inline level_t level() { return minimum_level.load(std::memory_order_relaxed); }
+
+  // changes the minimum level until destroyed
+  struct scoped_level_t {
+    explicit scoped_level_t(level_t level) : previous_m(minimum_level.exchange(level)) {}
+    ~scoped_level_t() { set_level(previous_m); }
+
+    scoped_level_t(const scoped_level_t&) = delete;
+    scoped_level_t& operator= (const scoped_level_t&) = delete;
+
+  private:
+    level_t previous_m;
+  };
+
+  // the default sink writes to std::clog
+  void set_sink(sink_ptr_t);
+  // writes all records pushed so far
+  void flush();
+  stats_t stats();
+
+  /**
+   * @brief formats one record and pushes it when destroyed
+   *
+   * Wide strings are converted to the narrow encoding.
+   */
+  struct line_t {
+    line_t(level_t level, const char* component);
+    ~line_t();
+
+    line_t(const line_t&) = delete;
+    line_t& operator= (const line_t&) = delete;
+
+    template<typename value_t>
+    line_t& operator<< (const value_t& value) {
+      stream_m << value;
+      return *this;
+    }
+    line_t& operator<< (const std::wstring&);
+    line_t& operator<< (const wchar_t*);
+
+  private:
+    level_t level_m;
+    const char* component_m;
+    std::ostringstream& stream_m;
+  };
+
+  // turns the line into void for the conditional of LOG_AT
+  struct voidify_t {
+    void operator& (const line_t&) {}
+  };
+
+} // namespace logging
+
+#define LOG_AT(level, component) \
+  !logging::enabled(logging::level_t::level) ? (void)0 \
+  : logging::voidify_t() & logging::line_t(logging::level_t::level, component)
@@ -0,0 +1,47 @@
+#include "event_loop.h"
+
+#include <algorithm>
+
+event_loop_t::event_loop_t(size_t thread_count)
+{
+  thread_count = std::max<size_t>(1, thread_count);
+  loops_m.reserve(thread_count);
+  for (auto i = 0u; i < thread_count; ++i) {
+      loops_m.emplace_back(new loop_t());
+    }
+}
+
+event_loop_t::~event_loop_t()
+{
+  stop();
+}
+
+reactor_t& event_loop_t::next_reactor()
+{
+  auto index = next_m.fetch_add(1, std::memory_order_relaxed) % loops_m.size();
+  return loops_m[index]->reactor;
+}
+
+void event_loop_t::start()
+{
+  if (running_m.exchange(true)) return; // already running
+  for (auto& loop : loops_m) {
+      auto loop_ptr = loop.get();
+      loop->thread = std::thread([=] {
+          while (running_m) {
+              if ( !loop_ptr->reactor.run_once(1000)) break;
+            }
+        });
+    }
+}
+
+void event_loop_t::stop()
+{
+  if ( !running_m.exchange(false)) return; // not running
+  for (auto& loop : loops_m) {
+      loop->reactor.wakeup();
+    }
+  for (auto& loop : loops_m) {
+      if (loop->thread.joinable()) loop->thread.join();
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "reactor.h"
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+
+/**
+ * @brief fixed set of threads each running a reactor
+ *
+ * sockets are spread round robin over the reactors, so the number of threads
+ * stays constant regardless of the number of connections
+ */
+struct event_loop_t {
+  explicit event_loop_t(size_t thread_count = 1);
+  ~event_loop_t();
+
+  event_loop_t(const event_loop_t&) = delete;
+  event_loop_t& operator= (const event_loop_t&) = delete;
+
+  size_t size() const { return loops_m.size(); }
+  bool running() const { return running_m; }
+
+  reactor_t& reactor(size_t index) { return loops_m[index]->reactor; }
+  reactor_t& next_reactor();
+
+  void start();
+  void stop();
+
+private:
+  struct loop_t {
+    reactor_t reactor;
+    std::thread thread;
+  };
+  using loop_ptr = std::unique_ptr<loop_t>;
+
+  std::vector<loop_ptr> loops_m;
+  std::atomic<bool> running_m {false};
+  std::atomic<size_t> next_m {0};
+};
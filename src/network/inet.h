@@ -1,7 +1,9 @@
 #pragma once
 
-#include <winsock2.h>
+#include "socket.h"
+
 #include <string>
+#include <cstring>
 
 struct inet_addr_t : sockaddr_in {
   inet_addr_t() {
@@ -21,4 +23,11 @@ struct inet_addr_t : sockaddr_in {
     result.sin_addr.s_addr = INADDR_ANY;
     return result;
   }
+
+  static inet_addr_t loopback(int port) {
+    inet_addr_t result;
+    result.sin_port = htons(port);
+    result.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return result;
+  }
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "socket.h"
+
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @brief readiness based socket multiplexer
+ *
+ * Sockets are registered with an interest mask and a callback.
+ * run_once() waits for readiness and invokes the callbacks on the calling thread.
+ * All calls except run_once() are thread safe.
+ *
+ * backends: epoll (linux) in reactor_epoll.cpp, WSAPoll (windows) in reactor_wsapoll.cpp
+ */
+struct reactor_t {
+  enum event_t : uint32_t {
+    READABLE = 1,
+    WRITABLE = 2,
+    CLOSED   = 4, // hangup or error - always reported
+  };
+  using callback_t = std::function<void (uint32_t events)>;
+
+  reactor_t();
+  ~reactor_t();
+
+  reactor_t(const reactor_t&) = delete;
+  reactor_t& operator= (const reactor_t&) = delete;
+
+  bool add(socket_handle_t, uint32_t interest, callback_t&&);
+  bool modify(socket_handle_t, uint32_t interest);
+  void remove(socket_handle_t);
+
+  // wait at most timeout_ms for events and dispatch them - returns false on fatal errors
+  bool run_once(int timeout_ms);
+
+  // interrupt a blocked run_once from another thread
+  void wakeup();
+
+private:
+  struct impl;
+  std::unique_ptr<impl> p;
+};
@@ -0,0 +1,121 @@
+#include "reactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <unordered_map>
+#include <mutex>
+#include <array>
+
+namespace {
+  uint32_t epoll_events_from_interest(uint32_t interest) {
+    uint32_t result = EPOLLRDHUP;
+    if (interest & reactor_t::READABLE) result |= EPOLLIN;
+    if (interest & reactor_t::WRITABLE) result |= EPOLLOUT;
+    return result;
+  }
+
+  uint32_t events_from_epoll(uint32_t epoll_events) {
+    uint32_t result = 0;
+    if (epoll_events & EPOLLIN) result |= reactor_t::READABLE;
+    if (epoll_events & EPOLLOUT) result |= reactor_t::WRITABLE;
+    if (epoll_events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) result |= reactor_t::CLOSED;
+    return result;
+  }
+} // namespace
+
+struct reactor_t::impl {
+  using callback_ptr = std::shared_ptr<callback_t>;
+  using handler_map_t = std::unordered_map<socket_handle_t, callback_ptr>;
+
+  int epoll_m = -1;
+  int wakeup_m = -1;
+
+  std::mutex handler_mutex_m;
+  handler_map_t handler_map_m;
+
+  impl() {
+    epoll_m = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeup_m = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = wakeup_m;
+    ::epoll_ctl(epoll_m, EPOLL_CTL_ADD, wakeup_m, &event);
+  }
+
+  ~impl() {
+    if (wakeup_m >= 0) ::close(wakeup_m);
+    if (epoll_m >= 0) ::close(epoll_m);
+  }
+
+  callback_ptr find(socket_handle_t handle) {
+    std::lock_guard<std::mutex> lock(handler_mutex_m);
+    auto it = handler_map_m.find(handle);
+    if (it == handler_map_m.end()) return {};
+    return it->second;
+  }
+};
+
+reactor_t::reactor_t()
+  : p(new impl())
+{}
+
+reactor_t::~reactor_t()
+{}
+
+bool reactor_t::add(socket_handle_t handle, uint32_t interest, callback_t&& callback)
+{
+  {
+    std::lock_guard<std::mutex> lock(p->handler_mutex_m);
+    p->handler_map_m[handle] = std::make_shared<callback_t>(std::move(callback));
+  }
+  epoll_event event = {};
+  event.events = epoll_events_from_interest(interest);
+  event.data.fd = handle;
+  if (0 == ::epoll_ctl(p->epoll_m, EPOLL_CTL_ADD, handle, &event)) return true;
+
+  std::lock_guard<std::mutex> lock(p->handler_mutex_m);
+  p->handler_map_m.erase(handle);
+  return false;
+}
+
+bool reactor_t::modify(socket_handle_t handle, uint32_t interest)
+{
+  epoll_event event = {};
+  event.events = epoll_events_from_interest(interest);
+  event.data.fd = handle;
+  return 0 == ::epoll_ctl(p->epoll_m, EPOLL_CTL_MOD, handle, &event);
+}
+
+void reactor_t::remove(socket_handle_t handle)
+{
+  ::epoll_ctl(p->epoll_m, EPOLL_CTL_DEL, handle, nullptr);
+  std::lock_guard<std::mutex> lock(p->handler_mutex_m);
+  p->handler_map_m.erase(handle);
+}
+
+bool reactor_t::run_once(int timeout_ms)
+{
+  std::array<epoll_event, 64> events;
+  auto count = ::epoll_wait(p->epoll_m, events.data(), events.size(), timeout_ms);
+  if (count < 0) return errno == EINTR;
+  for (auto i = 0; i < count; ++i) {
+      const auto& event = events[i];
+      if (event.data.fd == p->wakeup_m) {
+          uint64_t value;
+          while (sizeof(value) == ::read(p->wakeup_m, &value, sizeof(value))) {}
+          continue;
+        }
+      // lookup each time - an earlier callback might have removed this handle
+      auto callback = p->find(event.data.fd);
+      if (callback) (*callback)(events_from_epoll(event.events));
+    }
+  return true;
+}
+
+void reactor_t::wakeup()
+{
+  uint64_t value = 1;
+  auto written = ::write(p->wakeup_m, &value, sizeof(value));
+  (void)written; // counter overflow means a wakeup is pending anyway
+}
@@ -0,0 +1,134 @@
+#include "reactor.h"
+
+#include "inet.h"
+
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+namespace {
+  SHORT poll_events_from_interest(uint32_t interest) {
+    SHORT result = 0;
+    if (interest & reactor_t::READABLE) result |= POLLRDNORM;
+    if (interest & reactor_t::WRITABLE) result |= POLLWRNORM;
+    return result;
+  }
+
+  uint32_t events_from_poll(SHORT poll_events) {
+    uint32_t result = 0;
+    if (poll_events & POLLRDNORM) result |= reactor_t::READABLE;
+    if (poll_events & POLLWRNORM) result |= reactor_t::WRITABLE;
+    if (poll_events & (POLLHUP | POLLERR | POLLNVAL)) result |= reactor_t::CLOSED;
+    return result;
+  }
+} // namespace
+
+struct reactor_t::impl {
+  using callback_ptr = std::shared_ptr<callback_t>;
+  struct handler_t {
+    uint32_t interest;
+    callback_ptr callback;
+  };
+  using handler_map_t = std::unordered_map<socket_handle_t, handler_t>;
+
+  // WSAPoll has no native wakeup - a datagram sent to ourselves does the job
+  socket_handle_t wakeup_m = INVALID_SOCKET;
+  inet_addr_t wakeup_addr_m;
+
+  std::mutex handler_mutex_m;
+  handler_map_t handler_map_m;
+
+  impl() {
+    wakeup_m = ::socket(AF_INET, SOCK_DGRAM, 0);
+    auto addr = inet_addr_t::loopback(0);
+    ::bind(wakeup_m, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    socket_length_t addrlen = sizeof(wakeup_addr_m);
+    ::getsockname(wakeup_m, reinterpret_cast<sockaddr*>(&wakeup_addr_m), &addrlen);
+    socket_set_non_blocking(wakeup_m);
+  }
+
+  ~impl() {
+    if (wakeup_m != INVALID_SOCKET) closesocket(wakeup_m);
+  }
+
+  std::vector<WSAPOLLFD> poll_fds() {
+    std::vector<WSAPOLLFD> result;
+    std::lock_guard<std::mutex> lock(handler_mutex_m);
+    result.reserve(1 + handler_map_m.size());
+    result.push_back({ wakeup_m, POLLRDNORM, 0 });
+    for (const auto& pair : handler_map_m) {
+        result.push_back({ pair.first, poll_events_from_interest(pair.second.interest), 0 });
+      }
+    return result;
+  }
+
+  callback_ptr find(socket_handle_t handle) {
+    std::lock_guard<std::mutex> lock(handler_mutex_m);
+    auto it = handler_map_m.find(handle);
+    if (it == handler_map_m.end()) return {};
+    return it->second.callback;
+  }
+};
+
+reactor_t::reactor_t()
+  : p(new impl())
+{}
+
+reactor_t::~reactor_t()
+{}
+
+bool reactor_t::add(socket_handle_t handle, uint32_t interest, callback_t&& callback)
+{
+  {
+    std::lock_guard<std::mutex> lock(p->handler_mutex_m);
+    auto& handler = p->handler_map_m[handle];
+    handler.interest = interest;
+    handler.callback = std::make_shared<callback_t>(std::move(callback));
+  }
+  wakeup(); // poll set changed
+  return true;
+}
+
+bool reactor_t::modify(socket_handle_t handle, uint32_t interest)
+{
+  {
+    std::lock_guard<std::mutex> lock(p->handler_mutex_m);
+    auto it = p->handler_map_m.find(handle);
+    if (it == p->handler_map_m.end()) return false;
+    it->second.interest = interest;
+  }
+  wakeup();
+  return true;
+}
+
+void reactor_t::remove(socket_handle_t handle)
+{
+  std::lock_guard<std::mutex> lock(p->handler_mutex_m);
+  p->handler_map_m.erase(handle);
+}
+
+bool reactor_t::run_once(int timeout_ms)
+{
+  auto fds = p->poll_fds();
+  auto count = ::WSAPoll(fds.data(), fds.size(), timeout_ms);
+  if (count == SOCKET_ERROR) return false;
+  for (const auto& fd : fds) {
+      if (0 == fd.revents) continue;
+      if (fd.fd == p->wakeup_m) {
+          char buffer[16];
+          while (0 < ::recv(p->wakeup_m, buffer, sizeof(buffer), 0)) {}
+          continue;
+        }
+      // lookup each time - an earlier callback might have removed this handle
+      auto callback = p->find(fd.fd);
+      if (callback) (*callback)(events_from_poll(fd.revents));
+    }
+  return true;
+}
+
+void reactor_t::wakeup()
+{
+  char signal = 1;
+  ::sendto(p->wakeup_m, &signal, 1, 0, reinterpret_cast<const sockaddr*>(&p->wakeup_addr_m), sizeof(p->wakeup_addr_m));
+}
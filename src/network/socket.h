@@ -0,0 +1,137 @@
+#pragma once
+
+#include "binary/segmented_binary.h"
+
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#undef max
+#undef min
+
+using socket_handle_t = SOCKET;
+using socket_length_t = int;
+using socket_buffer_t = WSABUF;
+
+const int SOCKET_SEND_FLAGS = 0;
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+using socket_handle_t = int;
+using socket_length_t = socklen_t;
+using socket_buffer_t = iovec;
+
+const socket_handle_t INVALID_SOCKET = -1;
+const int SOCKET_ERROR = -1;
+// a peer that closed its end fails the send instead of raising SIGPIPE
+const int SOCKET_SEND_FLAGS = MSG_NOSIGNAL;
+
+inline int closesocket(socket_handle_t handle) { return ::close(handle); }
+#endif
+
+inline int socket_last_error() {
+#ifdef _WIN32
+  return ::WSAGetLastError();
+#else
+  return errno;
+#endif
+}
+
+// true if the last operation failed only because a non-blocking socket was not ready
+inline bool socket_would_block(int error = socket_last_error()) {
+#ifdef _WIN32
+  return error == WSAEWOULDBLOCK;
+#else
+  return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+#endif
+}
+
+inline bool socket_set_non_blocking(socket_handle_t handle) {
+#ifdef _WIN32
+  u_long mode = 1;
+  return 0 == ::ioctlsocket(handle, FIONBIO, &mode);
+#else
+  auto flags = ::fcntl(handle, F_GETFL, 0);
+  if (flags < 0) return false;
+  return 0 == ::fcntl(handle, F_SETFL, flags | O_NONBLOCK);
+#endif
+}
+
+inline bool socket_set_reuse_address(socket_handle_t handle) {
+  int enable = 1;
+  return 0 == ::setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&enable, sizeof(enable));
+}
+
+// several sockets bind the same port and the kernel spreads the datagrams over them - false if not supported
+inline bool socket_set_reuse_port(socket_handle_t handle) {
+#ifdef SO_REUSEPORT
+  int enable = 1;
+  return 0 == ::setsockopt(handle, SOL_SOCKET, SO_REUSEPORT, (const char*)&enable, sizeof(enable));
+#else
+  (void)handle;
+  return false;
+#endif
+}
+
+// blocking receives fail with a would block error after the timeout
+inline bool socket_set_receive_timeout(socket_handle_t handle, int milliseconds) {
+#ifdef _WIN32
+  DWORD timeout = static_cast<DWORD>(milliseconds);
+#else
+  timeval timeout;
+  timeout.tv_sec = milliseconds / 1000;
+  timeout.tv_usec = (milliseconds % 1000) * 1000;
+#endif
+  return 0 == ::setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+// gather list for all bytes of the segments starting at offset
+inline std::vector<socket_buffer_t> socket_buffers(const segmented_binary_t& segments, size_t offset = 0) {
+  std::vector<socket_buffer_t> result;
+  result.reserve(segments.segments().size());
+  for (const auto& segment : segments.segments()) {
+      auto size = segment.size();
+      if (offset >= size) {
+          offset -= size;
+          continue;
+        }
+      socket_buffer_t buffer;
+#ifdef _WIN32
+      buffer.buf = (CHAR*)(segment.data() + offset);
+      buffer.len = static_cast<ULONG>(size - offset);
+#else
+      buffer.iov_base = (void*)(segment.data() + offset);
+      buffer.iov_len = size - offset;
+#endif
+      result.push_back(buffer);
+      offset = 0;
+    }
+  return result;
+}
+
+// gather send - returns the bytes sent or SOCKET_ERROR
+inline int socket_send_buffers(socket_handle_t handle, std::vector<socket_buffer_t>& buffers, const sockaddr* to = nullptr, socket_length_t to_length = 0) {
+  if (buffers.empty()) return 0;
+#ifdef _WIN32
+  DWORD sent = 0;
+  auto result = ::WSASendTo(handle, buffers.data(), static_cast<DWORD>(buffers.size()), &sent, 0, to, to_length, nullptr, nullptr);
+  return result == SOCKET_ERROR ? SOCKET_ERROR : static_cast<int>(sent);
+#else
+  msghdr message = {};
+  message.msg_name = const_cast<sockaddr*>(to);
+  message.msg_namelen = to_length;
+  message.msg_iov = buffers.data();
+  message.msg_iovlen = buffers.size();
+  return static_cast<int>(::sendmsg(handle, &message, SOCKET_SEND_FLAGS));
+#endif
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "socket.h"
 #include "inet.h"
 #include "binary/binary.h"
 
@@ -7,9 +8,6 @@
 #include <utility>
 #include <algorithm>
 
-#include <winsock2.h>
-#undef max
-
 struct tcp_socket_t
 {
   tcp_socket_t() = default;
@@ -43,7 +41,33 @@ struct tcp_socket_t
     handle_m = INVALID_SOCKET;
   }
 
+  // stop both directions - the owning thread sees the socket as closed
+  void shutdown() const {
+#ifdef _WIN32
+    ::shutdown(handle_m, SD_BOTH);
+#else
+    ::shutdown(handle_m, SHUT_RDWR);
+#endif
+  }
+
   bool valid() const { return handle_m != INVALID_SOCKET; }
+  socket_handle_t handle() const { return handle_m; }
+
+  bool set_non_blocking() const {
+    assert(valid());
+    return socket_set_non_blocking(handle_m);
+  }
+
+  bool set_no_delay() const {
+    assert(valid());
+    int enable = 1;
+    return 0 == ::setsockopt(handle_m, IPPROTO_TCP, TCP_NODELAY, (const char*)&enable, sizeof(enable));
+  }
+
+  int connect(const inet_addr_t& remote_addr) const {
+    assert(valid());
+    return ::connect(handle_m, reinterpret_cast<const sockaddr*>(&remote_addr), sizeof(remote_addr));
+  }
 
   int bind_all(int port) const {
     assert(valid());
@@ -59,27 +83,57 @@ struct tcp_socket_t
   tcp_socket_t accept(sockaddr_in& remoteaddr) const {
     assert(valid());
     tcp_socket_t result;
-    int addrlen = sizeof(remoteaddr);
+    socket_length_t addrlen = sizeof(remoteaddr);
     result.handle_m = ::accept(handle_m, reinterpret_cast<sockaddr*>(&remoteaddr), &addrlen);
     return result;
   }
 
   int send(const binary_t& buffer) const {
     assert(valid());
-    return ::send(handle_m, (char*)&buffer[0], buffer.size(), 0);
+    return ::send(handle_m, (char*)&buffer[0], buffer.size(), SOCKET_SEND_FLAGS);
+  }
+
+  int send(const uint8_t* data, size_t size) const {
+    assert(valid());
+    return ::send(handle_m, (const char*)data, size, SOCKET_SEND_FLAGS);
+  }
+
+  // gather send of all segments starting at offset
+  int send(const segmented_binary_t& segments, size_t offset = 0) const {
+    assert(valid());
+    auto buffers = socket_buffers(segments, offset);
+    return socket_send_buffers(handle_m, buffers);
+  }
+
+  int receive(uint8_t* data, size_t size) const {
+    assert(valid());
+    return ::recv(handle_m, (char*)data, size, 0);
+  }
+
+  // bytes that can be received without blocking
+  size_t available() const {
+    assert(valid());
+#ifdef _WIN32
+    u_long result = 0;
+    if (SOCKET_ERROR == ::ioctlsocket(handle_m, FIONREAD, &result)) return 0;
+#else
+    int result = 0;
+    if (SOCKET_ERROR == ::ioctl(handle_m, FIONREAD, &result)) return 0;
+#endif
+    return static_cast<size_t>(result);
   }
 
   int receive(binary_t& buffer) const {
     assert(valid());
     auto offset = buffer.size();
     buffer.resize(buffer.size() + 1500);
-    auto result = ::recv(handle_m, (char*)&buffer[offset], buffer.size() - offset, 0);
+    int result = ::recv(handle_m, (char*)&buffer[offset], buffer.size() - offset, 0);
     buffer.resize(offset + std::max(0, result));
     return result;
   }
 
 private:
-  SOCKET handle_m = INVALID_SOCKET;
+  socket_handle_t handle_m = INVALID_SOCKET;
 };
 
 struct tcp_accept
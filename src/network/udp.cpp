@@ -1 +1,106 @@
 #include "udp.h"
+
+udp_batch_t::udp_batch_t(size_t capacity)
+  : buffers_m(std::max<size_t>(1, capacity), binary_t(MAX_DATAGRAM))
+  , sizes_m(buffers_m.size())
+  , senders_m(buffers_m.size())
+#ifdef __linux__
+  , receive_vectors_m(buffers_m.size())
+  , receive_messages_m(buffers_m.size())
+#endif
+{
+#ifdef __linux__
+  for (size_t i = 0; i < buffers_m.size(); ++i) {
+      receive_vectors_m[i].iov_base = buffers_m[i].data();
+      receive_vectors_m[i].iov_len = buffers_m[i].size();
+      auto& header = receive_messages_m[i].msg_hdr;
+      header = {};
+      header.msg_name = &senders_m[i];
+      header.msg_iov = &receive_vectors_m[i];
+      header.msg_iovlen = 1;
+    }
+#endif
+}
+
+void udp_batch_t::queue_reply(segmented_binary_t&& data, const inet_addr_t& to)
+{
+  replies_m.push_back({ std::move(data), to });
+}
+
+void udp_batch_t::queue_replies(std::vector<reply_t>& replies)
+{
+  for (auto& reply : replies) replies_m.push_back(std::move(reply));
+  replies.clear();
+}
+
+#ifdef __linux__
+size_t udp_batch_t::receive(const udp_socket_t& socket)
+{
+  received_m = 0;
+  for (auto& message : receive_messages_m) message.msg_hdr.msg_namelen = sizeof(inet_addr_t);
+  auto count = ::recvmmsg(socket.handle(), receive_messages_m.data(), static_cast<unsigned>(capacity()), MSG_DONTWAIT, nullptr);
+  if (0 >= count) return 0; // would block or error
+  for (int i = 0; i < count; ++i) sizes_m[i] = receive_messages_m[i].msg_len;
+  received_m = static_cast<size_t>(count);
+  return received_m;
+}
+
+size_t udp_batch_t::send(const udp_socket_t& socket)
+{
+  // the gather lists of all replies first - the messages point into them
+  send_vectors_m.clear();
+  send_messages_m.resize(replies_m.size());
+  for (size_t i = 0; i < replies_m.size(); ++i) {
+      auto& header = send_messages_m[i].msg_hdr;
+      header = {};
+      header.msg_name = &replies_m[i].to;
+      header.msg_namelen = sizeof(inet_addr_t);
+      header.msg_iovlen = replies_m[i].data.segments().size();
+      for (const auto& segment : replies_m[i].data.segments()) {
+          send_vectors_m.push_back({ (void*)segment.data(), segment.size() });
+        }
+    }
+  size_t offset = 0;
+  for (auto& message : send_messages_m) {
+      message.msg_hdr.msg_iov = send_vectors_m.data() + offset;
+      offset += message.msg_hdr.msg_iovlen;
+    }
+
+  size_t sent = 0;
+  for (size_t next = 0; next < send_messages_m.size();) {
+      auto count = ::sendmmsg(socket.handle(), send_messages_m.data() + next, static_cast<unsigned>(send_messages_m.size() - next), SOCKET_SEND_FLAGS);
+      if (count > 0) {
+          sent += count;
+          next += count;
+        }
+      else if (EINTR == socket_last_error()) continue;
+      else if (socket_would_block()) break; // the clients retransmit
+      else ++next; // only this reply failed - e.g. its client is unreachable
+    }
+  replies_m.clear();
+  return sent;
+}
+#else
+size_t udp_batch_t::receive(const udp_socket_t& socket)
+{
+  received_m = 0;
+  while (received_m < capacity()) {
+      auto& buffer = buffers_m[received_m];
+      auto bytes = socket.receive_from(buffer, senders_m[received_m]);
+      buffer.resize(MAX_DATAGRAM);
+      if (0 > bytes) break; // would block or error
+      sizes_m[received_m++] = static_cast<size_t>(bytes);
+    }
+  return received_m;
+}
+
+size_t udp_batch_t::send(const udp_socket_t& socket)
+{
+  size_t sent = 0;
+  for (const auto& reply : replies_m) {
+      if (SOCKET_ERROR != socket.send_to(reply.data, reply.to)) ++sent;
+    }
+  replies_m.clear();
+  return sent;
+}
+#endif
@@ -1,13 +1,14 @@
 #pragma once
 
+#include "socket.h"
 #include "inet.h"
 #include "binary/binary.h"
+#include "binary/binary_reader.h"
+#include "binary/segmented_binary.h"
 
 #include <cassert>
 #include <algorithm>
-
-#include <winsock2.h>
-#undef max
+#include <vector>
 
 struct udp_socket_t
 {
@@ -43,6 +44,12 @@ struct udp_socket_t
   }
 
   bool valid() const { return handle_m != INVALID_SOCKET; }
+  socket_handle_t handle() const { return handle_m; }
+
+  bool set_non_blocking() const {
+    assert(valid());
+    return socket_set_non_blocking(handle_m);
+  }
 
   int bind_all(int port) const {
     assert(valid());
@@ -55,17 +62,83 @@ struct udp_socket_t
     return ::sendto(handle_m, (char*)&buffer[0], buffer.size(), 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
   }
 
+  // gather send of all segments as one datagram
+  int send_to(const segmented_binary_t& segments, const inet_addr_t& addr) const {
+    assert(valid());
+    auto buffers = socket_buffers(segments);
+    return socket_send_buffers(handle_m, buffers, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+  }
+
   int receive_from(binary_t& buffer, inet_addr_t& remoteaddr) const {
     assert(valid());
-    int addrlen = sizeof(remoteaddr);
+    socket_length_t addrlen = sizeof(remoteaddr);
     buffer.resize(buffer.capacity());
-    auto result = ::recvfrom(handle_m, (char*)&buffer[0], buffer.size(), 0, reinterpret_cast<sockaddr*>(&remoteaddr), &addrlen);
+    int result = ::recvfrom(handle_m, (char*)&buffer[0], buffer.size(), 0, reinterpret_cast<sockaddr*>(&remoteaddr), &addrlen);
     buffer.resize(std::max(0, result));
     return result;
   }
 
 private:
-  SOCKET handle_m = INVALID_SOCKET;
+  socket_handle_t handle_m = INVALID_SOCKET;
+};
+
+/**
+ * @brief datagrams received and replies sent a batch at a time
+ *
+ * Linux moves a whole batch with one recvmmsg or sendmmsg call, elsewhere every
+ * datagram takes its own call. Each buffer holds the largest possible datagram and
+ * replies are sent from their segments without copying them.
+ */
+struct udp_batch_t
+{
+  struct reply_t {
+    segmented_binary_t data;
+    inet_addr_t to;
+  };
+
+  enum : size_t {
+    MAX_DATAGRAM = 0x10000,
+    MAX_REPLY = 65507, // largest udp payload over ipv4
+    CAPACITY = 32, // datagrams per call
+  };
+
+  explicit udp_batch_t(size_t capacity = CAPACITY);
+
+  // the messages point into the buffers
+  udp_batch_t(const udp_batch_t&) = delete;
+  udp_batch_t& operator= (const udp_batch_t&) = delete;
+
+  size_t capacity() const { return buffers_m.size(); }
+
+  // datagrams of the last receive() - valid until the next one
+  size_t size() const { return received_m; }
+  binary_reader_t datagram(size_t index) const {
+    return binary_reader_t(buffers_m[index].data(), buffers_m[index].data() + sizes_m[index]);
+  }
+  const inet_addr_t& sender(size_t index) const { return senders_m[index]; }
+
+  // receives the available datagrams up to the capacity - zero if none or on errors
+  size_t receive(const udp_socket_t&);
+
+  // replies are kept until send()
+  void queue_reply(segmented_binary_t&&, const inet_addr_t&);
+  // moves the replies behind the queued ones - e.g. those other threads collected
+  void queue_replies(std::vector<reply_t>&);
+  // sends and drops all queued replies - returns the count that was sent
+  size_t send(const udp_socket_t&);
+
+private:
+  std::vector<binary_t> buffers_m;
+  std::vector<size_t> sizes_m;
+  std::vector<inet_addr_t> senders_m;
+  size_t received_m = 0;
+  std::vector<reply_t> replies_m;
+#ifdef __linux__
+  std::vector<iovec> receive_vectors_m;
+  std::vector<mmsghdr> receive_messages_m;
+  std::vector<iovec> send_vectors_m;
+  std::vector<mmsghdr> send_messages_m;
+#endif
 };
 
 struct udp_receive {
@@ -80,7 +153,7 @@ struct udp_receive {
     const auto bind_result = socket.bind_all(config.port);
     if (bind_result == SOCKET_ERROR) return false;
     binary_t buffer;
-    buffer.resize(2000);
+    buffer.resize(udp_batch_t::MAX_DATAGRAM);
     while (socket.valid()) {
         inet_addr_t remote_addr;
         int bytes = socket.receive_from(buffer, remote_addr);
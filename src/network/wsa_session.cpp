@@ -1,6 +1,8 @@
 #include "wsa_session.h"
 
+#ifdef _WIN32
 #include <WinSock2.h>
+#endif
 
 /*
 #pragma comment(lib, "ws2_32.lib")
@@ -10,13 +12,19 @@
 wsa_session_t::wsa_session_t(int major, int minor)
   : activated_m(true)
 {
+#ifdef _WIN32
   WSAData wsaData; // move out if needed
   WSAStartup(MAKEWORD(major, minor), &wsaData);
+#else
+  (void)major; (void)minor; // berkeley sockets need no session
+#endif
 }
 
 wsa_session_t::~wsa_session_t()
 {
+#ifdef _WIN32
   if (activated_m) {
       WSACleanup();
     }
+#endif
 }
@@ -1,42 +1,15 @@
 #include "mount.h"
 
-#include "rpc/rpc.h"
+#include "mount_xdr.h"
 
-#define DEBUG_NFS_MOUNT_RPC
+#include "rpc/rpc.h"
 
-#ifdef DEBUG_NFS_MOUNT_RPC
-#include <iostream>
-#endif
+#include "logging/logger.h"
 
 namespace mount {
-  namespace {
-    struct directory_path_reader_t {
-      directory_path_reader_t(const binary_reader_t& reader)
-        : directory_path_m(xdr::opaque_reader<DIRECTORY_PATH_LEN>(reader, 0))
-      {}
-
-      size_t size() const { return 4 + directory_path_m.read_size(); }
-      bool valid() const { return directory_path_m.valid(); }
-      directory_path_t directory_path() const { return directory_path_m.to_string(); }
-
-    private:
-      xdr::opaque_reader_t directory_path_m;
-    };
-
-    binary_t write_mount_result(const mount_result_t& mount_result) {
-      binary_builder_t builder;
-      builder.append32(mount_result.status);
-      if (mount_result.status == status_t::OK) {
-          xdr::write_opaque_binary<FILEHANDLE_SIZE>(builder, mount_result.filehandle);
-          xdr::write_opaque_binary<>(builder, mount_result.auth_flavors);
-        }
-      return builder.build();
-    }
-
-  } // namespace
 
   mount_result_t rpc_program::mount(const hostname_t& sender, const directory_path_t& directory_path) {
-    std::cout << "Mount: " << directory_path << " for " << sender << std::endl;
+    LOG_AT(INFO, "mount") << "Mount: " << directory_path << " for " << sender;
     mount_result_t result;
 
     mount_cache_m.mount_session([&](const auto& session) {
@@ -57,7 +30,7 @@ namespace mount {
           }
 
         if (mount_it != session.end()) {
-            std::cout << "Mount success!" << std::endl;
+            LOG_AT(INFO, "mount") << "Mount success!";
             result.status = status_t::OK;
             result.filehandle = mount_it->second.filehandle;
             // result.auth_flavors = ??
@@ -69,13 +42,13 @@ namespace mount {
 
   void rpc_program::unmount(const hostname_t& sender, const directory_path_t& directory_path)
   {
-    std::cout << "Unmount: " << directory_path << " for " << sender << std::endl;
+    LOG_AT(INFO, "mount") << "Unmount: " << directory_path << " for " << sender;
     mount_cache_m.unmount(sender, directory_path);
   }
 
   void rpc_program::unmount_all(const hostname_t& sender)
   {
-    std::cout << "Unmount All: " << sender << std::endl;
+    LOG_AT(INFO, "mount") << "Unmount All: " << sender;
     mount_cache_m.unmount_client(sender);
   }
 
@@ -93,10 +66,12 @@ namespace mount {
         return result_t::respond({});
       };
     auto mount_rpc = [=](const args_t& args)->result_t {
-        directory_path_reader_t reader(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto mount_result = mount(args.sender, reader.directory_path());
-        return result_t::respond(write_mount_result(mount_result));
+        directory_path_t directory_path;
+        if (!xdr::decode_with<xdr::directory_path_codec_t>(args.parameter_reader, directory_path)) return {};
+        args.decoded();
+        auto mount_result = mount(args.sender, directory_path);
+        args.executed();
+        return result_t::respond(xdr::to_binary(mount_result));
       };
     //    auto dump_rpc = [=](const args_t& args)->result_t {
     //        if (0 != args.parameter_reader.size()) return {};
@@ -104,14 +79,17 @@ namespace mount {
     //        return result_t::respond(write_dump_result(dump_result));
     //      };
     auto unmount_rpc = [=](const args_t& args)->result_t {
-        directory_path_reader_t reader(args.parameter_reader);
-        if (!reader.valid()) return {};
-        unmount(args.sender, reader.directory_path());
+        directory_path_t directory_path;
+        if (!xdr::decode_with<xdr::directory_path_codec_t>(args.parameter_reader, directory_path)) return {};
+        args.decoded();
+        unmount(args.sender, directory_path);
+        args.executed();
         return result_t::respond({});
       };
     auto unmountall_rpc = [=](const args_t& args)->result_t {
         if (0 != args.parameter_reader.size()) return {};
         unmount_all(args.sender);
+        args.executed();
         return result_t::respond({});
       };
     //    auto export_rpc = [=](const args_t& args)->result_t {
@@ -121,11 +99,11 @@ namespace mount {
     //      };
 
     auto& calls = result.procedures;
-    calls.set(0, { "NULL", null_rpc });
-    calls.set(1, { "MNT", mount_rpc });
+    calls.set(0, { "NULL", null_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(1, { "MNT", mount_rpc, rpc_program_t::NO_REPLY_CACHE });
     //calls.set(2, { "DUMP", dump_rpc });
-    calls.set(3, { "UMNT", unmount_rpc });
-    calls.set(4, { "UMNTALL", unmountall_rpc });
+    calls.set(3, { "UMNT", unmount_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(4, { "UMNTALL", unmountall_rpc, rpc_program_t::NO_REPLY_CACHE });
     //calls.set(5, { "EXPORT", export_rpc });
 
     return result;
@@ -1,9 +1,10 @@
 #include "mount_aliases.h"
 
 #include "container/string_convert.h"
-#include "winfs/winfs_object.h"
 
-#include <iostream>
+#include "logging/logger.h"
+
+#include <algorithm>
 
 mount_aliases_t::windows_path_t
 mount_aliases_t::alias_subpath_to_windows(const alias_path_t& alias_path) {
@@ -53,71 +54,40 @@ mount_aliases_t::windows_to_alias_path(const windows_path_t &windows_path)
 }
 
 mount_aliases_t::windows_path_t
-mount_aliases_t::by_alias_path_safe(const alias_path_t& alias_path) const {
-  auto alias_path_length = alias_path.length();
-  auto end_it = store_m.end();
-  auto best_it = end_it;
-  auto best_length = 0u;
-
-  for (auto it = store_m.begin(); it != end_it; ++it) {
-      const entry_t& entry = *it;
-      auto entry_length = entry.alias_path.length();
-
-      if (entry_length > alias_path_length) continue; // entry path is longer
-      if (entry_length < best_length) continue; // not better
-      if (entry_length == alias_path_length) {
-          if (entry.alias_path != alias_path) continue; // not equal match
-        }
-      else {
-          assert(entry_length < alias_path_length);
-          if (0 != alias_path.compare(0, entry_length, entry.alias_path)) continue; // does not start with entry
-          if (alias_path[entry_length] != '/') continue; // not a full folder
-        }
-      best_it = it;
-      best_length = entry_length;
-    }
-
-  if (best_it == end_it) {
+mount_aliases_t::by_alias_path(const store_t& store, const alias_path_t& alias_path) {
+  auto match = store.longest_prefix(alias_path);
+  if ( !match.value) {
       return {}; // not found
     }
-  const entry_t& best_entry = *best_it;
-  auto subpath = alias_subpath_to_windows(alias_path.substr(best_length));
-  return best_entry.windows_path + subpath;
+  auto subpath = alias_subpath_to_windows(alias_path.substr(match.length));
+  return match.value->windows_path + subpath;
 }
 
 bool
-mount_aliases_t::add_safe(source_t source, const windows_path_t& windows_path, const alias_path_t& alias_path) {
-  if (std::any_of(store_m.begin(), store_m.end(), [&](const entry_t& entry) {
-                  return entry.alias_path == alias_path;
-})) return false;
-
-  auto directory = winfs::open_path<0, FILE_FLAG_BACKUP_SEMANTICS>(windows_path);
-  if ( !directory.valid()) return false;
-
-  entry_t entry;
-  entry.windows_path = directory.fullpath();
-  entry.alias_path = alias_path.empty() ? windows_to_alias_path(windows_path) : alias_path;
-  entry.source = source;
-  store_m.push_back(entry);
-  std::wcout << "Alias by " << entry.source << " for " << entry.windows_path;
-  std::cout << " at " << entry.alias_path << std::endl;
+mount_aliases_t::add_safe(store_t& store, source_t source, const windows_path_t& windows_path, const alias_path_t& alias_path) {
+  auto entry = std::make_shared<entry_t>();
+  entry->alias_path = alias_path.empty() ? windows_to_alias_path(windows_path) : alias_path;
+  if (store.find(entry->alias_path)) return false;
+
+  auto directory = backend_m.open_path(windows_path);
+  if ( !directory) return false;
+
+  entry->windows_path = directory->path();
+  entry->source = source;
+  if ( !store.insert(entry->alias_path, entry)) return false;
+  LOG_AT(INFO, "mount") << "Alias by " << entry->source << " for " << entry->windows_path << " at " << entry->alias_path;
   return true;
 }
 
 void
-mount_aliases_t::set_aliases_safe(source_t source, const alias_vector_t& alias_vector) {
+mount_aliases_t::set_aliases_safe(store_t& store, source_t source, const alias_vector_t& alias_vector) {
   // remove old mounts
-  for (auto it = store_m.begin(); it != store_m.end();) {
-      const entry_t& entry = *it;
-      if (entry.source == source) {
-          it = store_m.erase(it);
-        }
-      else
-        ++it;
-    }
+  store.erase_if([&](const entry_t& entry) {
+      return entry.source == source;
+    });
 
   // add new mounts
   for (const auto& pair : alias_vector) {
-      add_safe(source, pair.first, pair.second);
+      add_safe(store, source, pair.first, pair.second);
     }
 }
@@ -1,11 +1,22 @@
 #pragma once
 
+#include "fs/fs.h"
+
+#include "container/path_trie.h"
+
 #include <atomic>
-#include <shared_mutex>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <algorithm>
 #include <cassert>
 
+/**
+ * @brief the windows directories exported under alias paths
+ *
+ * The aliases are an immutable trie. Writers build a new version and publish it,
+ * so resolving takes no lock and costs the length of the path.
+ */
 struct mount_aliases_t {
   using source_t = uint32_t;
   using mount_id_t = uint32_t;
@@ -15,9 +26,18 @@ struct mount_aliases_t {
   using alias_vector_t = std::vector<windows_alias_path_pair_t>;
 
 public:
+  explicit mount_aliases_t(fs::backend_t& backend = fs::default_backend())
+    : backend_m(backend)
+    , store_m(std::make_shared<const store_t>())
+  {}
+
+  // windows path of the longest alias that is a prefix of full folders - empty if none
   windows_path_t resolve(const alias_path_t& alias_path) const {
-    std::shared_lock<std::shared_timed_mutex> lock(store_mutex_m);
-    return by_alias_path_safe(alias_path);
+    return by_alias_path(*std::atomic_load(&store_m), alias_path);
+  }
+
+  size_t size() const {
+    return std::atomic_load(&store_m)->size();
   }
 
   static bool check_alias_path(const alias_path_t& alias_path) {
@@ -39,38 +59,45 @@ public:
 
   bool add(source_t source, const windows_path_t& windows_path, const alias_path_t& alias_path = {}) {
     assert(alias_path.empty() || check_alias_path(alias_path));
-    std::unique_lock<std::shared_timed_mutex> lock(store_mutex_m);
-    return add_safe(source, windows_path, alias_path);
+    std::lock_guard<std::mutex> lock(writer_mutex_m);
+    auto store = *store_m;
+    if ( !add_safe(store, source, windows_path, alias_path)) return false;
+    std::atomic_store(&store_m, std::make_shared<const store_t>(std::move(store)));
+    return true;
   }
 
   void set(source_t source, const alias_vector_t& alias_vector) {
     assert(std::all_of(alias_vector.begin(), alias_vector.end(), [] (const windows_alias_path_pair_t& pair) {
         return pair.second.empty() || check_alias_path(pair.second);
       }));
-    std::unique_lock<std::shared_timed_mutex> lock(store_mutex_m);
-    set_aliases_safe(source, alias_vector);
+    std::lock_guard<std::mutex> lock(writer_mutex_m);
+    auto store = *store_m;
+    set_aliases_safe(store, source, alias_vector);
+    std::atomic_store(&store_m, std::make_shared<const store_t>(std::move(store)));
   }
 
   void clear(source_t source) {
     set(source, {});
   }
 
-private:
-  windows_path_t by_alias_path_safe(const alias_path_t&) const;
-
-  bool add_safe(source_t, const windows_path_t&, const alias_path_t&);
-  void set_aliases_safe(source_t, const alias_vector_t&);
-
 private:
   struct entry_t {
     source_t source;
     alias_path_t alias_path; // path used by NFS to mount this
     windows_path_t windows_path; // base path for windows
   };
-  using store_t = std::vector<entry_t>;
+  using store_t = path_trie_t<entry_t>; // by alias path
 
+  static windows_path_t by_alias_path(const store_t&, const alias_path_t&);
+
+  // the writers change their copy of the store
+  bool add_safe(store_t&, source_t, const windows_path_t&, const alias_path_t&);
+  void set_aliases_safe(store_t&, source_t, const alias_vector_t&);
+
+private:
+  fs::backend_t& backend_m;
   std::atomic<source_t> next_source_m {1};
 
-  mutable std::shared_timed_mutex store_mutex_m;
-  store_t store_m;
+  std::mutex writer_mutex_m;
+  std::shared_ptr<const store_t> store_m; // published with atomic_load and atomic_store
 };
@@ -3,7 +3,87 @@
 #include "binary/binary_builder.h"
 #include "binary/binary_reader.h"
 
+#include "logging/logger.h"
+
 #include <algorithm>
+#include <iterator>
+
+namespace {
+  // changes appended to the journal
+  enum class record_t : uint32_t {
+    MOUNT = 1, // mount id, windows path, volume file id (since version 2)
+    QUERY = 2, // query path, mount id
+    CLIENT = 3, // client, mount id
+  };
+
+  void append_volume_file_id(binary_builder_t& builder, const fs::volume_file_id_t& id) {
+    builder.append64(id.volume);
+    builder.append_binary(id.file);
+  }
+
+  fs::volume_file_id_t get_volume_file_id(binary_cursor_t& cursor) {
+    fs::volume_file_id_t result;
+    result.volume = cursor.get64();
+    if ( !cursor.get_binary(result.file, sizeof(result.file))) std::fill(std::begin(result.file), std::end(result.file), 0);
+    return result;
+  }
+
+  const fs::volume_file_id_t& volume_file_id(const binary_t& filehandle) {
+    return mount_filehandle_t::view_binary(filehandle).volume_file_id;
+  }
+
+  binary_t mount_record(uint64_t mount_id, const std::wstring& windows_path, const fs::volume_file_id_t& id) {
+    binary_builder_t builder;
+    builder.append32(record_t::MOUNT);
+    builder.append64(mount_id);
+    builder.append32(windows_path.length());
+    builder.append_binary(windows_path);
+    append_volume_file_id(builder, id);
+    return builder.release();
+  }
+
+  binary_t mount_id_record(record_t type, const std::string& text, uint64_t mount_id) {
+    binary_builder_t builder;
+    builder.append32(type);
+    builder.append32(text.length());
+    builder.append_binary(text);
+    builder.append64(mount_id);
+    return builder.release();
+  }
+} // namespace
+
+constexpr std::chrono::seconds mount_directory_t::RETRY_DELAY;
+
+const fs::object_t*
+mount_directory_t::open(fs::backend_t& backend) const
+{
+  std::lock_guard<std::mutex> lock(mutex_m);
+  auto directory = directory_m.load(std::memory_order_acquire);
+  if (directory) return directory; // opened while waiting
+  auto now = clock_source_t::now();
+  if (now < retry_m) return nullptr; // failed while waiting or recently
+
+  auto object = backend.open_path(windows_path_m);
+  fs::volume_file_id_t id;
+  if ( !object || !object->id(id) || id != volume_file_id_m) {
+      LOG_AT(WARNING, "mount") << "Restored mount of " << windows_path_m << " is not available"
+                               << (object ? " - the directory was replaced" : "");
+      retry_m = now + RETRY_DELAY;
+      return nullptr;
+    }
+  owned_m = std::move(object);
+  directory_m.store(owned_m.get(), std::memory_order_release);
+  return owned_m.get();
+}
+
+size_t
+mount_cache_t::unopened() const
+{
+  std::shared_lock<std::shared_timed_mutex> lock(mutex_m);
+  return std::count_if(mount_map_m.begin(), mount_map_m.end(), [](const mount_map_t::value_type& mount) {
+      return !mount.second.directory->opened();
+    });
+}
 
 binary_t
 mount_cache_t::safe_save() const
@@ -17,6 +97,7 @@ mount_cache_t::safe_save() const
       auto& entry = it->second;
       builder.append32(entry.windows_path.length());
       builder.append_binary(entry.windows_path);
+      append_volume_file_id(builder, volume_file_id(entry.filehandle));
     }
 
   builder.append32(query_map_m.size());
@@ -43,30 +124,34 @@ mount_cache_t::safe_save() const
   return builder.build();
 }
 
-void
-mount_cache_t::safe_restore(const binary_t & binary)
+bool
+mount_cache_t::safe_restore(const binary_reader_t& reader, uint32_t version)
 {
-  auto reader = binary_reader_t::binary(binary);
-  auto offset = 0u;
-
-  auto windows_path_count = reader.get32(offset); offset += 4;
-  for (auto i = 0u; i < windows_path_count; ++i) {
-      auto mount_id = reader.get64(offset); offset += 8;
-      auto windows_path_length = reader.get32(offset); offset += 4;
-      auto windows_path = reader.get_wstring(offset, windows_path_length);
-      offset += windows_path_length * sizeof(wchar_t);
+  // every count is bounded by the data - each item takes at least four bytes
+  binary_cursor_t cursor(reader);
 
-      safe_mount_windows_path(mount_id, windows_path);
+  auto windows_path_count = cursor.get32();
+  for (auto i = 0u; i < windows_path_count && cursor.valid(); ++i) {
+      auto mount_id = cursor.get64();
+      auto windows_path = cursor.get_wstring(cursor.get32());
+      if (version >= 2) {
+          auto id = get_volume_file_id(cursor);
+          if ( !cursor.valid()) break;
+          safe_restore_mount(mount_id, windows_path, id);
+        }
+      else {
+          if ( !cursor.valid()) break;
+          safe_mount_windows_path(mount_id, windows_path); // the id is not known
+        }
 
       next_mount_m = std::max(mount_id + 1, next_mount_m);
     }
 
-  auto query_path_count = reader.get32(offset); offset += 4;
-  for (auto i = 0u; i < query_path_count; ++i) {
-      auto query_path_length = reader.get32(offset); offset += 4;
-      auto query_path = reader.get_string(offset, query_path_length);
-      offset += query_path_length;
-      auto mount_id = reader.get64(offset); offset += 8;
+  auto query_path_count = cursor.get32();
+  for (auto i = 0u; i < query_path_count && cursor.valid(); ++i) {
+      auto query_path = cursor.get_string(cursor.get32());
+      auto mount_id = cursor.get64();
+      if ( !cursor.valid()) break;
 
       auto mount_it = mount_map_m.find(mount_id);
       if (mount_it == mount_map_m.end()) continue;
@@ -74,15 +159,14 @@ mount_cache_t::safe_restore(const binary_t & binary)
       query_map_m[query_path] = mount_it;
     }
 
-  auto client_count = reader.get32(offset); offset += 4;
-  for (auto i = 0u; i < client_count; ++i) {
-      auto client_length = reader.get32(offset); offset += 4;
-      auto client = reader.get_string(offset, client_length);
-      offset += client_length;
+  auto client_count = cursor.get32();
+  for (auto i = 0u; i < client_count && cursor.valid(); ++i) {
+      auto client = cursor.get_string(cursor.get32());
 
-      auto client_mount_count = reader.get32(offset); offset += 4;
-      for (auto j = 0u; j < client_mount_count; ++j) {
-          auto mount_id = reader.get64(offset); offset += 8;
+      auto client_mount_count = cursor.get32();
+      for (auto j = 0u; j < client_mount_count && cursor.valid(); ++j) {
+          auto mount_id = cursor.get64();
+          if ( !cursor.valid()) break;
 
           auto mount_it = mount_map_m.find(mount_id);
           if (mount_it == mount_map_m.end()) continue;
@@ -90,6 +174,89 @@ mount_cache_t::safe_restore(const binary_t & binary)
           safe_mount_sender(client, mount_it);
         }
     }
+  return cursor.valid();
+}
+
+bool
+mount_cache_t::safe_replay(const binary_reader_t& reader, uint32_t version)
+{
+  binary_cursor_t cursor(reader);
+  auto type = cursor.get32<record_t>();
+  switch (type) {
+    case record_t::MOUNT: {
+        auto mount_id = cursor.get64();
+        auto windows_path = cursor.get_wstring(cursor.get32());
+        if (version >= 2) {
+            auto id = get_volume_file_id(cursor);
+            if ( !cursor.valid()) return false;
+            safe_restore_mount(mount_id, windows_path, id);
+          }
+        else {
+            if ( !cursor.valid()) return false;
+            safe_mount_windows_path(mount_id, windows_path);
+          }
+        next_mount_m = std::max(mount_id + 1, next_mount_m);
+        return true;
+      }
+    case record_t::QUERY:
+    case record_t::CLIENT: {
+        auto text = cursor.get_string(cursor.get32());
+        auto mount_id = cursor.get64();
+        if ( !cursor.valid()) return false;
+        auto mount_it = mount_map_m.find(mount_id);
+        if (mount_it == mount_map_m.end()) return false;
+        if (type == record_t::QUERY) query_map_m[text] = mount_it;
+        else safe_mount_sender(text, mount_it);
+        return true;
+      }
+    }
+  return false; // unknown record
+}
+
+void
+mount_cache_t::safe_journal(const binary_t& record)
+{
+  if (journal_m) journal_m->append(record);
+}
+
+bool
+mount_cache_t::persist(const mount_journal_t::config_t& config)
+{
+  auto journal = std::unique_ptr<mount_journal_t>(new mount_journal_t(config));
+  std::unique_lock<std::shared_timed_mutex> lock(mutex_m);
+  if (journal_m) return false; // persisted already
+  auto valid = journal->load(
+    [this](const binary_reader_t& snapshot, uint32_t version) { return safe_restore(snapshot, version); },
+    [this](const binary_reader_t& record, uint32_t version) { return safe_replay(record, version); });
+  auto stats = journal->stats();
+  LOG_AT(INFO, "mount") << "Restored " << mount_map_m.size() << " mounts with " << stats.replayed << " journal records";
+  journal_m = std::move(journal);
+  lock.unlock();
+
+  journal_m->start([this] { checkpoint(); });
+  return valid;
+}
+
+bool
+mount_cache_t::checkpoint()
+{
+  if ( !journal_m) return false;
+  binary_t snapshot;
+  mount_journal_t::generation_t generation;
+  {
+    // writers journal with the exclusive lock - no record is missed
+    std::shared_lock<std::shared_timed_mutex> lock(mutex_m);
+    snapshot = safe_save();
+    generation = journal_m->rotate();
+  }
+  return journal_m->write_snapshot(generation, snapshot);
+}
+
+mount_journal_t::stats_t
+mount_cache_t::journal_stats() const
+{
+  if ( !journal_m) return {};
+  return journal_m->stats();
 }
 
 void
@@ -106,11 +273,16 @@ mount_cache_t::safe_mount_sender(const client_t& client, mount_map_it mount_it)
   mounts_set_t& client_mounts = client_it->second;
   client_mounts.insert(mount_it);
   entry.clients.insert(client_view_t(client_it->first));
+  safe_journal(mount_id_record(record_t::CLIENT, client, mount_it->first));
 }
 
 void
 mount_cache_t::safe_mount_sender_query(const client_t& client, mount_map_it mount_it, const query_path_t& query_path) {
-  query_map_m[query_path] = mount_it;
+  auto query_it = query_map_m.find(query_path);
+  if (query_it == query_map_m.end() || query_it->second != mount_it) {
+      query_map_m[query_path] = mount_it;
+      safe_journal(mount_id_record(record_t::QUERY, query_path, mount_it->first));
+    }
   safe_mount_sender(client, mount_it);
 }
 
@@ -120,6 +292,8 @@ mount_cache_t::safe_mount(const client_t& client, const query_path_t& query_path
   auto mount_it = safe_mount_windows_path(mount_id, windows_path);
 
   if (mount_it != mount_map_m.end()) {
+      auto& entry = mount_it->second;
+      safe_journal(mount_record(mount_id, entry.windows_path, volume_file_id(entry.filehandle)));
       safe_mount_sender_query(client, mount_it, query_path);
     }
   return mount_it;
@@ -137,20 +311,39 @@ mount_cache_t::safe_unmount_client(const client_t& client) {
 
 mount_cache_t::mount_map_it
 mount_cache_t::safe_mount_windows_path(mount_id_t mount_id, const windows_path_t& windows_path)
+{
+  auto directory = backend_m.open_path(windows_path);
+  if (!directory) return mount_map_m.end();
+  entry_t entry;
+  entry.windows_path = directory->path();
+  auto& filehandle = mount_filehandle_t::create_in_binary(entry.filehandle);
+  filehandle.mount_id = mount_id;
+  directory->id(filehandle.volume_file_id);
+  entry.directory.reset(new mount_directory_t(std::move(directory)));
+  return safe_insert(mount_id, std::move(entry));
+}
+
+mount_cache_t::mount_map_it
+mount_cache_t::safe_restore_mount(mount_id_t mount_id, const windows_path_t& windows_path, const fs::volume_file_id_t& volume_file_id)
 {
   entry_t entry;
-  entry.directory = winfs::open_path(windows_path);
-  if (!entry.directory.valid()) return mount_map_m.end();
-  entry.windows_path = entry.directory.fullpath();
+  entry.windows_path = windows_path;
   auto& filehandle = mount_filehandle_t::create_in_binary(entry.filehandle);
   filehandle.mount_id = mount_id;
-  entry.directory.id(filehandle.volume_file_id);
+  filehandle.volume_file_id = volume_file_id;
+  entry.directory.reset(new mount_directory_t(windows_path, volume_file_id));
+  return safe_insert(mount_id, std::move(entry));
+}
 
+mount_cache_t::mount_map_it
+mount_cache_t::safe_insert(mount_id_t mount_id, entry_t&& entry)
+{
   auto tmp = mount_map_m.insert(std::make_pair(mount_id, std::move(entry)));
   if (tmp.second) {
       auto mount_it = tmp.first;
       entry_t& entry_ref = mount_it->second;
       windows_map_m.insert(std::make_pair(windows_path_view_t(entry_ref.windows_path), mount_it));
+      index_m.insert(mount_id, &entry_ref); // readers find the complete entry
 
       return tmp.first;
     }
@@ -1,9 +1,18 @@
 #pragma once
 
-#include "winfs/winfs_object.h"
+#include "mount_journal.h"
+
+#include "container/id_table.h"
+
+#include "fs/fs.h"
 
 #include "binary/binary.h"
+#include "binary/binary_reader.h"
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <map>
 #include <unordered_map>
@@ -30,7 +39,7 @@ struct assoc_iterator_less {
 
 struct mount_filehandle_t {
   uint64_t mount_id;
-  winfs::volume_file_id_t volume_file_id;
+  fs::volume_file_id_t volume_file_id;
 
 public:
   static bool is_valid(const binary_t& data) {
@@ -45,6 +54,59 @@ public:
   }
 };
 
+/**
+ * @brief the root directory of a mount
+ *
+ * Restored mounts open it on first use - concurrent callers wait for one open. The
+ * opened directory has to be the one of the filehandles, otherwise the mount stays
+ * unavailable. Failed opens are retried after RETRY_DELAY.
+ */
+struct mount_directory_t {
+  using windows_path_t = std::wstring;
+  using clock_source_t = std::chrono::steady_clock;
+  static constexpr std::chrono::seconds RETRY_DELAY{1};
+
+  explicit mount_directory_t(fs::object_ptr_t&& directory)
+    : directory_m(directory.get())
+    , owned_m(std::move(directory))
+  {}
+
+  mount_directory_t(const windows_path_t& windows_path, const fs::volume_file_id_t& volume_file_id)
+    : windows_path_m(windows_path)
+    , volume_file_id_m(volume_file_id)
+  {}
+
+  mount_directory_t(const mount_directory_t&) = delete;
+  mount_directory_t& operator= (const mount_directory_t&) = delete;
+
+  bool opened() const { return nullptr != directory_m.load(std::memory_order_acquire); }
+
+  // nullptr while the directory is not available
+  const fs::object_t* get(fs::backend_t& backend) const {
+    auto directory = directory_m.load(std::memory_order_acquire);
+    return directory ? directory : open(backend);
+  }
+
+private:
+  const fs::object_t* open(fs::backend_t&) const;
+
+private:
+  mutable std::atomic<const fs::object_t*> directory_m {nullptr};
+  mutable std::mutex mutex_m; // the open
+  mutable fs::object_ptr_t owned_m;
+  mutable clock_source_t::time_point retry_m {}; // no open before
+  windows_path_t windows_path_m;
+  fs::volume_file_id_t volume_file_id_m {};
+};
+
+// what a request needs of its mount - valid as long as the cache
+struct mount_view_t {
+  const fs::object_t* directory = nullptr; // nullptr while the mount is not available
+  const mount_filehandle_t* filehandle = nullptr; // of the directory
+
+  explicit operator bool() const { return nullptr != directory; }
+};
+
 struct mount_cache_t {
   using mount_id_t = uint64_t;
   using client_t = std::string;
@@ -54,7 +116,7 @@ struct mount_cache_t {
   using windows_path_t = std::wstring;
   using windows_path_view_t = gsl::cwstring_span<>;
   struct entry_t {
-    winfs::unique_object_t directory;
+    std::unique_ptr<mount_directory_t> directory;
     binary_t filehandle;
     windows_path_t windows_path;
     client_view_set_t clients;
@@ -108,27 +170,42 @@ struct mount_cache_t {
   };
 
 public:
-  std::pair<winfs::shared_object_t, binary_t> get(const mount_id_t& mount_id) const {
-    std::pair<winfs::shared_object_t, binary_t> result;
-    std::shared_lock<std::shared_timed_mutex> lock(mutex_m);
-    auto it = mount_map_m.find(mount_id);
-    if (it != mount_map_m.end()) {
-        const entry_t& entry = it->second;
-        result.first.share(entry.directory);
-        result.second = entry.filehandle;
-      }
+  explicit mount_cache_t(fs::backend_t& backend = fs::default_backend())
+    : backend_m(backend)
+  {}
+
+  fs::backend_t& backend() const { return backend_m; }
+
+  // the directory lives as long as the cache - mounts are never removed
+  // takes no lock - restored mounts are opened here on first use
+  mount_view_t get(const mount_id_t& mount_id) const {
+    mount_view_t result;
+    auto entry = index_m.find(mount_id);
+    if ( !entry) return result;
+    result.directory = entry->directory->get(backend_m);
+    if (result.directory) result.filehandle = &mount_filehandle_t::view_binary(entry->filehandle);
     return result;
   }
 
+  // mounts restored but not used yet
+  size_t unopened() const;
+
   binary_t save() const {
     std::shared_lock<std::shared_timed_mutex> lock(mutex_m);
     return safe_save();
   }
-  void restore(const binary_t& binary) {
+  bool restore(const binary_t& binary) {
+    if (binary.empty()) return true;
     std::unique_lock<std::shared_timed_mutex> lock(mutex_m);
-    safe_restore(binary);
+    return safe_restore(binary_reader_t::binary(binary), mount_journal_t::VERSION);
   }
 
+  // restores the persisted mounts and journals all changes from now on
+  bool persist(const mount_journal_t::config_t&);
+  // writes the mounts as snapshot and starts a new journal
+  bool checkpoint();
+  mount_journal_t::stats_t journal_stats() const;
+
   template<typename callback_t>
   void mount_session(const callback_t& callback) {
     std::unique_lock<std::shared_timed_mutex> lock(mutex_m);
@@ -147,7 +224,9 @@ public:
 
 private:
   binary_t safe_save() const;
-  void safe_restore(const binary_t&);
+  bool safe_restore(const binary_reader_t&, uint32_t version);
+  bool safe_replay(const binary_reader_t&, uint32_t version); // one journal record
+  void safe_journal(const binary_t&); // appends a record if persisted
 
   void safe_mount_sender(const client_t&, mount_map_it mount_it);
   void safe_mount_sender_query(const client_t&, mount_map_it, const query_path_t&);
@@ -156,8 +235,11 @@ private:
   void safe_unmount_client(const client_t&);
 
   mount_map_it safe_mount_windows_path(mount_id_t, const windows_path_t&);
+  mount_map_it safe_restore_mount(mount_id_t, const windows_path_t&, const fs::volume_file_id_t&); // opened on first use
+  mount_map_it safe_insert(mount_id_t, entry_t&&);
 
 private:
+  fs::backend_t& backend_m;
   mount_id_t next_mount_m {1};
   mutable std::shared_timed_mutex mutex_m;
 
@@ -165,4 +247,7 @@ private:
   windows_map_t windows_map_m;
   query_map_t query_map_m;
   client_mounts_t client_mounts_m;
+  id_table_t<entry_t> index_m; // of mount_map_m for get - the directory and filehandle of an entry never change
+
+  std::unique_ptr<mount_journal_t> journal_m; // stops the checkpoints before the members are destroyed
 };
@@ -0,0 +1,280 @@
+#include "mount_journal.h"
+
+#include "binary/binary_builder.h"
+#include "binary/crc32.h"
+
+#include "logging/logger.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+  bool read_file(const std::string& path, binary_t& binary) {
+    std::ifstream ifs(path, std::ios_base::binary | std::ios_base::ate);
+    if ( !ifs) return false;
+    auto size = static_cast<std::streamoff>(ifs.tellg());
+    if (size < 0) return false;
+    binary.resize(static_cast<size_t>(size));
+    ifs.seekg(0);
+    return binary.empty() || ifs.read(reinterpret_cast<char*>(binary.data()), size).gcount() == size;
+  }
+
+  bool write_all(std::FILE* file, const binary_t& binary) {
+    return binary.empty() || binary.size() == std::fwrite(binary.data(), 1, binary.size(), file);
+  }
+
+  // the data is on the disk afterwards
+  bool sync(std::FILE* file) {
+    if (0 != std::fflush(file)) return false;
+#ifdef _WIN32
+    return 0 == ::_commit(::_fileno(file));
+#else
+    return 0 == ::fsync(::fileno(file));
+#endif
+  }
+
+  // replaces the target in one step - readers see the old or the new file
+  bool replace_file(const std::string& source, const std::string& target) {
+#ifdef _WIN32
+    return 0 != ::MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    if (0 != std::rename(source.c_str(), target.c_str())) return false;
+    // the rename is durable with the directory
+    auto slash = target.rfind('/');
+    auto directory = slash == std::string::npos ? std::string(".") : target.substr(0, std::max<size_t>(1, slash));
+    auto handle = ::open(directory.c_str(), O_RDONLY);
+    if (handle >= 0) {
+        ::fsync(handle);
+        ::close(handle);
+      }
+    return true;
+#endif
+  }
+} // namespace
+
+mount_journal_t::mount_journal_t()
+  : mount_journal_t(config_t())
+{}
+
+mount_journal_t::mount_journal_t(const config_t& config)
+  : config_m(config)
+{}
+
+mount_journal_t::~mount_journal_t() {
+  stop();
+  std::lock_guard<std::mutex> lock(mutex_m);
+  close_journal();
+}
+
+std::string
+mount_journal_t::journal_path(generation_t generation) const {
+  return config_m.path + "." + std::to_string(generation);
+}
+
+bool
+mount_journal_t::load(const reader_callback_t& snapshot, const reader_callback_t& record) {
+  generation_t generation = 0;
+  bool valid = true;
+  binary_t file;
+  if (read_file(config_m.path, file) && !file.empty()) {
+      binary_cursor_t cursor(binary_reader_t::binary(file));
+      if (SNAPSHOT_MAGIC != cursor.get32()) {
+          valid = snapshot(binary_reader_t::binary(file), 0);
+        }
+      else {
+          auto version = cursor.get32();
+          generation = cursor.get64();
+          auto size = cursor.get64();
+          auto crc = cursor.get32();
+          auto payload = cursor.get_reader(static_cast<size_t>(size));
+          valid = cursor.valid() && MIN_VERSION <= version && version <= VERSION
+                  && crc == crc32(payload.data(), payload.size())
+                  && snapshot(payload, version);
+        }
+      if ( !valid) {
+          LOG_AT(FAILURE, "mount") << "Mount cache " << config_m.path << " is corrupt - kept as .corrupt";
+          std::rename(config_m.path.c_str(), (config_m.path + ".corrupt").c_str());
+          generation = 0;
+        }
+    }
+  snapshot_generation_m = generation;
+  // journals a crash left behind after the snapshot was written
+  for (auto covered = generation; covered-- > 0 && 0 == std::remove(journal_path(covered).c_str());) {}
+
+  binary_t journal;
+  while (read_file(journal_path(generation), journal)) {
+      replay_journal(generation, journal, record);
+      ++generation;
+    }
+
+  std::lock_guard<std::mutex> lock(mutex_m);
+  stats_m.generation = generation;
+  open_journal();
+  return valid;
+}
+
+void
+mount_journal_t::replay_journal(generation_t generation, const binary_t& journal, const reader_callback_t& record) {
+  if (journal.empty()) {
+      ++stats_m.torn;
+      return;
+    }
+  binary_cursor_t cursor(binary_reader_t::binary(journal));
+  auto magic = cursor.get32();
+  auto version = cursor.get32();
+  if (JOURNAL_MAGIC != magic || version < MIN_VERSION || VERSION < version || generation != cursor.get64()) {
+      ++stats_m.torn;
+      return;
+    }
+  while (cursor.remaining() > 0) {
+      auto size = cursor.get32();
+      auto crc = cursor.get32();
+      auto payload = cursor.get_reader(size);
+      if ( !cursor.valid() || size > MAX_RECORD || crc != crc32(payload.data(), payload.size())) {
+          LOG_AT(WARNING, "mount") << "Mount journal " << journal_path(generation) << " ends in a torn record";
+          ++stats_m.torn;
+          return;
+        }
+      if (record(payload, version)) ++stats_m.replayed;
+    }
+}
+
+bool
+mount_journal_t::append(const binary_t& record) {
+  binary_builder_t builder;
+  builder.reserve(8 + record.size());
+  builder.append32(record.size());
+  builder.append32(crc32(record.data(), record.size()));
+  builder.append_binary(record);
+  auto frame = builder.release();
+
+  std::lock_guard<std::mutex> lock(mutex_m);
+  if ( !journal_m
+      || !write_all(journal_m, frame)
+      || 0 != std::fflush(journal_m)
+      || (config_m.sync_records && !sync(journal_m))) {
+      ++stats_m.failures;
+      return false;
+    }
+  if (++stats_m.records == config_m.checkpoint_records) wake_m.notify_all();
+  return true;
+}
+
+mount_journal_t::generation_t
+mount_journal_t::rotate() {
+  std::lock_guard<std::mutex> lock(mutex_m);
+  close_journal();
+  ++stats_m.generation;
+  stats_m.records = 0;
+  open_journal();
+  return stats_m.generation;
+}
+
+bool
+mount_journal_t::write_snapshot(generation_t generation, const binary_t& payload) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex_m);
+  if (generation <= snapshot_generation_m) return true; // a later snapshot was written
+
+  binary_builder_t builder;
+  builder.append32(SNAPSHOT_MAGIC);
+  builder.append32(VERSION);
+  builder.append64(generation);
+  builder.append64(payload.size());
+  builder.append32(crc32(payload.data(), payload.size()));
+  auto header = builder.release();
+
+  auto temporary = config_m.path + ".tmp";
+  auto file = std::fopen(temporary.c_str(), "wb");
+  bool written = file && write_all(file, header) && write_all(file, payload) && sync(file);
+  if (file) written = 0 == std::fclose(file) && written;
+  written = written && replace_file(temporary, config_m.path);
+  if ( !written) {
+      std::remove(temporary.c_str());
+      LOG_AT(FAILURE, "mount") << "Mount cache " << config_m.path << " was not written";
+      std::lock_guard<std::mutex> lock(mutex_m);
+      ++stats_m.failures;
+      return false;
+    }
+
+  for (auto covered = snapshot_generation_m; covered < generation; ++covered) {
+      std::remove(journal_path(covered).c_str());
+    }
+  snapshot_generation_m = generation;
+  std::lock_guard<std::mutex> lock(mutex_m);
+  ++stats_m.checkpoints;
+  return true;
+}
+
+void
+mount_journal_t::start(checkpoint_callback_t&& checkpoint) {
+  std::lock_guard<std::mutex> lock(mutex_m);
+  if (running_m) return;
+  checkpoint_m = std::move(checkpoint);
+  running_m = true;
+  thread_m = std::thread([this] { run(); });
+}
+
+void
+mount_journal_t::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    running_m = false;
+  }
+  wake_m.notify_all();
+  if (thread_m.joinable()) thread_m.join();
+}
+
+mount_journal_t::stats_t
+mount_journal_t::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_m);
+  return stats_m;
+}
+
+bool
+mount_journal_t::open_journal() {
+  journal_m = std::fopen(journal_path(stats_m.generation).c_str(), "wb");
+  if ( !journal_m) {
+      LOG_AT(FAILURE, "mount") << "Mount journal " << journal_path(stats_m.generation) << " was not created";
+      ++stats_m.failures;
+      return false;
+    }
+  binary_builder_t builder;
+  builder.append32(JOURNAL_MAGIC);
+  builder.append32(VERSION);
+  builder.append64(stats_m.generation);
+  if ( !write_all(journal_m, builder.release()) || !sync(journal_m)) {
+      ++stats_m.failures;
+      return false;
+    }
+  return true;
+}
+
+void
+mount_journal_t::close_journal() {
+  if ( !journal_m) return;
+  std::fclose(journal_m);
+  journal_m = nullptr;
+}
+
+void
+mount_journal_t::run() {
+  std::unique_lock<std::mutex> lock(mutex_m);
+  while (running_m) {
+      wake_m.wait_for(lock, config_m.checkpoint_interval, [this] {
+          return !running_m || stats_m.records >= config_m.checkpoint_records;
+        });
+      if ( !running_m) return;
+      if (0 == stats_m.records) continue;
+      lock.unlock();
+      checkpoint_m();
+      lock.lock();
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "binary/binary.h"
+#include "binary/binary_reader.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+/**
+ * @brief crash safe persistence of the mount cache
+ *
+ * The state is a snapshot and the journals of the changes after it. Every change is
+ * appended to the current journal before the mount is answered. A checkpoint starts
+ * the journal of the next generation, writes the state before it to a temporary file
+ * that is synced and renamed over the snapshot, and deletes the older journals.
+ *
+ *   snapshot <path>:              magic version generation size crc32 payload
+ *   journal <path>.<generation>:  magic version generation, then records of size crc32 payload
+ *
+ * The snapshot of generation g covers all journals before g. Loading replays the
+ * journals from g on - each up to its first torn or corrupt record - and appends to a
+ * new journal after them, so a torn tail is never continued.
+ */
+struct mount_journal_t {
+  using generation_t = uint64_t;
+  using reader_callback_t = std::function<bool(const binary_reader_t&, uint32_t version)>;
+  using checkpoint_callback_t = std::function<void()>;
+
+  enum : uint32_t {
+    SNAPSHOT_MAGIC = 0x574D4353, // "WMCS"
+    JOURNAL_MAGIC = 0x574D434A, // "WMCJ"
+    VERSION = 2, // mounts with the id of their directory
+    MIN_VERSION = 1,
+    MAX_RECORD = 0x10000, // larger records are corrupt
+  };
+
+  struct config_t {
+    std::string path = "./mount_cache"; // of the snapshot
+    std::chrono::milliseconds checkpoint_interval = std::chrono::seconds(60);
+    size_t checkpoint_records = 0x10000; // checkpoint early after as many records
+    bool sync_records = false; // sync every record to survive power loss - not only crashes
+  };
+
+  struct stats_t {
+    generation_t generation = 0; // of the journal appended to
+    uint64_t records = 0; // appended since the last checkpoint
+    uint64_t replayed = 0; // records restored by load
+    uint64_t torn = 0; // journals that ended in a torn or corrupt record
+    uint64_t checkpoints = 0;
+    uint64_t failures = 0; // failed writes
+  };
+
+  mount_journal_t();
+  explicit mount_journal_t(const config_t& config);
+  ~mount_journal_t();
+
+  mount_journal_t(const mount_journal_t&) = delete;
+  mount_journal_t& operator= (const mount_journal_t&) = delete;
+
+  const config_t& config() const { return config_m; }
+  std::string journal_path(generation_t) const;
+
+  // restores the snapshot and the records after it - false if the snapshot is corrupt
+  // the callbacks get the version of the file - 0 for a snapshot without header
+  bool load(const reader_callback_t& snapshot, const reader_callback_t& record);
+
+  // appends a record to the current journal - the caller serializes the changes
+  bool append(const binary_t& record);
+
+  // starts the journal of the next generation - the snapshot of this generation is
+  // the state of all records appended before
+  generation_t rotate();
+  // writes the snapshot and deletes the journals it covers
+  bool write_snapshot(generation_t, const binary_t& payload);
+
+  // calls the checkpoint in the background after the interval or enough records
+  void start(checkpoint_callback_t&&);
+  void stop();
+
+  stats_t stats() const;
+
+private:
+  bool open_journal(); // call with mutex_m
+  void close_journal(); // call with mutex_m
+  void replay_journal(generation_t, const binary_t&, const reader_callback_t&);
+  void run();
+
+private:
+  config_t config_m;
+
+  mutable std::mutex mutex_m; // the journal and the stats
+  std::condition_variable wake_m;
+  std::FILE* journal_m = nullptr;
+  stats_t stats_m;
+  bool running_m = false;
+
+  std::mutex snapshot_mutex_m; // snapshots are written in order
+  generation_t snapshot_generation_m = 0;
+
+  checkpoint_callback_t checkpoint_m;
+  std::thread thread_m;
+};
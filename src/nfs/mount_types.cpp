@@ -0,0 +1 @@
+#include "mount_types.h"
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "binary/binary.h"
+
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief mount protocol version 3 according to RFC1813 appendix I
+ */
+namespace mount {
+
+  enum {
+    PROGRAM = 100005,
+    VERSION = 3,
+    PORT = 1058,
+
+    DIRECTORY_PATH_LEN = 1024, // Maximum bytes in a path name
+    MNTNAMLEN  = 255,  // Maximum bytes in a name
+    FILEHANDLE_SIZE    = 64,   // Maximum bytes in a V3 file handle
+  };
+
+  using filehandle_t = binary_t;
+  using hostname_t = std::string;
+  using directory_path_t = std::string;
+
+  enum status_t {
+    OK = 0,                  /* no error */
+    ERR_PERM = 1,            /* Not owner */
+    ERR_NOENT = 2,           /* No such file or directory */
+    ERR_IO = 5,              /* I/O error */
+    ERR_ACCES = 13,          /* Permission denied */
+    ERR_NOTDIR = 20,         /* Not a directory */
+    ERR_INVAL = 22,          /* Invalid argument */
+    ERR_NAMETOOLONG = 63,    /* Filename too long */
+    ERR_NOTSUPP = 10004,     /* Operation not supported */
+    ERR_SERVERFAULT = 10006  /* A failure on the server */
+  };
+
+  struct mount_result_t {
+    status_t status = ERR_NOENT;
+    filehandle_t filehandle; // only valid for OK
+    binary_t auth_flavors; // only valid for OK
+  };
+
+  struct mount_entry_t {
+    hostname_t hostname;
+    directory_path_t directory;
+  };
+
+} // namespace mount
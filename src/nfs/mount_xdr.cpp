@@ -0,0 +1 @@
+#include "mount_xdr.h"
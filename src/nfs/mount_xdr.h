@@ -0,0 +1,22 @@
+#pragma once
+
+#include "mount_types.h"
+
+#include "rpc/xdr_schema.h"
+
+/**
+ * @brief xdr schema of the mount argument and result types
+ */
+namespace xdr {
+
+  using directory_path_codec_t = opaque_codec_t<mount::directory_path_t, mount::DIRECTORY_PATH_LEN>;
+
+  template<> struct schema_t<mount::mount_result_t> {
+    static auto fields() {
+      using namespace mount;
+      return xdr::fields(discriminated(&mount_result_t::status,
+                                       when(status_t::OK, opaque<FILEHANDLE_SIZE>(&mount_result_t::filehandle), &mount_result_t::auth_flavors)));
+    }
+  };
+
+} // namespace xdr
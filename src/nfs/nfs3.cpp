@@ -1,770 +1,294 @@
 #include "nfs3.h"
 
-#include "winfs/winfs_directory.h"
-#include "wintime/wintime_convert.h"
+#include "nfs3_xdr.h"
 
 #include "rpc/rpc.h"
 
-#include "container/string_convert.h"
+#include "binary/buffer_pool.h"
 
-#define DEBUG_NFS_RPC
+#include "logging/logger.h"
 
-#ifdef DEBUG_NFS_RPC
-#include <iostream>
-#endif
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
 
 namespace nfs3
 {
   namespace {
-    struct filehandle_reader_t {
-      filehandle_reader_t(const binary_reader_t& reader)
-        : filehandle_m(xdr::opaque_reader<FILEHANDLE_SIZE>(reader, 0))
-      {}
-
-      size_t size() const { return filehandle_m.read_size(); }
-      bool valid() const { return filehandle_m.valid(); }
-      filehandle_t read() const { return filehandle_m.to_binary(); }
-
-    private:
-      xdr::opaque_reader_t filehandle_m;
-    };
-
-    struct dir_op_args_reader_t {
-      dir_op_args_reader_t(const binary_reader_t& reader)
-        : dir_m(reader)
-        , name_m(xdr::opaque_reader(reader, dir_m.size()))
-      {}
-      size_t size() const { return dir_m.size() + name_m.read_size(); }
-      bool valid() const { return dir_m.valid() && name_m.valid(); }
-
-      dir_op_args_t read() const {
-        dir_op_args_t result;
-        result.directory = dir_m.read();
-        result.name = name_m.to_string();
-        return result;
-      }
-
-    private:
-      filehandle_reader_t dir_m;
-      xdr::opaque_reader_t name_m;
-    };
-
-    struct set_attr_reader_t {
-      set_attr_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-      {}
-      size_t size() const { return mtime_size(); }
-      bool valid() const { return reader_m.has_size(size()); }
-
-      bool has_mode() const { return reader_m.has_size(4) && reader_m.get32(0); }
-      meta::optional_t<mode_t> mode() const {
-        meta::optional_t<mode_t> result;
-        if (has_mode()) result.set(reader_m.get32<mode_t>(4));
-        return result;
-      }
-      uint32_t mode_size() const { return 4 + (has_mode() ? 4 : 0); }
-
-      bool has_uid() const { return reader_m.has_size(mode_size() + 4) && reader_m.get32(mode_size()); }
-      meta::optional_t<uid_t> uid() const {
-        meta::optional_t<uid_t> result;
-        if (has_mode()) result.set(reader_m.get32<uid_t>(4 + mode_size()));
-        return result;
-      }
-      uint32_t uid_size() const { return mode_size() + 4 + (has_uid() ? 4 : 0); }
-
-      bool has_gid() const { return reader_m.has_size(uid_size() + 4) && reader_m.get32(uid_size()); }
-      meta::optional_t<gid_t> gid() const {
-        meta::optional_t<gid_t> result;
-        if (has_mode()) result.set(reader_m.get32<gid_t>(4 + uid_size()));
-        return result;
-      }
-      uint32_t gid_size() const { return uid_size() + 4 + (has_gid() ? 4 : 0); }
-
-      bool has_fsize() const { return reader_m.has_size(gid_size() + 4) && reader_m.get32(gid_size()); }
-      meta::optional_t<size_t> fsize() const {
-        meta::optional_t<size_t> result;
-        if (has_mode()) result.set(reader_m.get64(4 + gid_size()));
-        return result;
-      }
-      uint32_t fsize_size() const { return gid_size() + 4 + (has_fsize() ? 8 : 0); }
-
-      time_how_t atime_how() const { return reader_m.has_size(fsize_size() + 4) ? reader_m.get32<time_how_t>(fsize_size()) : time_how_t::DONT_CHANGE; }
-      time_t atime() const {
-        time_t result;
-        result.seconds = reader_m.get32(4 + fsize_size());
-        result.nanoseconds = reader_m.get32(8 + fsize_size());
-        return result;
-      }
-      uint32_t atime_size() const { return fsize_size() + 4 + (atime_how() == time_how_t::SET_TO_CLIENT_TIME ? 8 : 0); }
-
-      time_how_t mtime_how() const { return reader_m.has_size(atime_size() + 4) ? reader_m.get32<time_how_t>(atime_size()) : time_how_t::DONT_CHANGE; }
-      time_t mtime() const {
-        time_t result;
-        result.seconds = reader_m.get32(4 + atime_size());
-        result.nanoseconds = reader_m.get32(8 + atime_size());
-        return result;
-      }
-      uint32_t mtime_size() const { return atime_size() + 4 + (mtime_how() == time_how_t::SET_TO_CLIENT_TIME ? 8 : 0); }
-
-      set_attr_t read() const {
-        set_attr_t result;
-        result.mode = mode();
-        result.uid = uid();
-        result.gid = gid();
-        result.size = fsize();
-        result.set_atime = atime_how();
-        if (result.set_atime == time_how_t::SET_TO_CLIENT_TIME) result.atime = atime();
-        result.set_mtime = mtime_how();
-        if (result.set_mtime == time_how_t::SET_TO_CLIENT_TIME) result.mtime = mtime();
-        return result;
-      }
-
-    private:
-      const binary_reader_t reader_m;
-    };
-
-    struct read_dir_args_reader_t {
-      read_dir_args_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-        , directory_handle_m(reader)
-      {}
-      size_t size() const { return 12 + directory_handle_m.size() + sizeof(cookie_verifier_t); }
-      bool valid() const { return directory_handle_m.valid() && reader_m.has_size(size()); }
-
-      read_dir_args_t read() const {
-        read_dir_args_t result;
-        result.directory = directory_handle_m.read();
-        result.cookie = reader_m.get64(directory_handle_m.size());
-        reader_m.get_binary(8 + directory_handle_m.size(), result.cookie_verifier);
-        result.count = reader_m.get32(8 + directory_handle_m.size() + sizeof(cookie_verifier_t));
-        return result;
-      }
-
-    private:
-      binary_reader_t reader_m;
-      filehandle_reader_t directory_handle_m;
-    };
-
-    struct read_dir_plus_args_reader_t {
-      read_dir_plus_args_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-        , directory_handle_m(reader)
-      {}
-      size_t size() const { return 16 + directory_handle_m.size() + sizeof(cookie_verifier_t); }
-      bool valid() const { return directory_handle_m.valid() && reader_m.has_size(size()); }
-
-      read_dir_plus_args_t read() const {
-        read_dir_plus_args_t result;
-        result.directory = directory_handle_m.read();
-        result.cookie = reader_m.get64(directory_handle_m.size());
-        reader_m.get_binary(8 + directory_handle_m.size(), result.cookie_verifier);
-        result.dircount = reader_m.get32(8 + directory_handle_m.size() + sizeof(cookie_verifier_t));
-        result.maxcount = reader_m.get32(12 + directory_handle_m.size() + sizeof(cookie_verifier_t));
-        return result;
-      }
-
-    private:
-      binary_reader_t reader_m;
-      filehandle_reader_t directory_handle_m;
-    };
-
-    struct commit_args_reader_t {
-      commit_args_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-        , file_handle_m(reader)
-      {}
-      size_t size() const { return 12 + file_handle_m.size(); }
-      bool valid() const { return file_handle_m.valid() && reader_m.has_size(size()); }
-
-      commit_args_t read() const {
-        commit_args_t result;
-        result.file = file_handle_m.read();
-        result.offset = reader_m.get64(0 + file_handle_m.size());
-        result.count = reader_m.get32(8 + file_handle_m.size());
-        return result;
-      }
-
-    private:
-      binary_reader_t reader_m;
-      filehandle_reader_t file_handle_m;
-    };
-
-    struct set_attr_args_reader_t {
-      set_attr_args_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-        , directory_handle_m(reader)
-        , set_attr_reader_m(reader.get_reader(directory_handle_m.size()))
-      {}
-      size_t size() const { return directory_handle_m.size() + set_attr_reader_m.size() + 4 + (has_time() ? 8 : 0); }
-      bool valid() const { return directory_handle_m.valid() && set_attr_reader_m.valid() && reader_m.has_size(size()); }
-
-      bool has_time() const {
-        return reader_m.has_size(directory_handle_m.size() + set_attr_reader_m.size() + 4)
-            && reader_m.get32(directory_handle_m.size() + set_attr_reader_m.size());
-      }
-      time_t check_time() const {
-        time_t result;
-        result.seconds = reader_m.get32(directory_handle_m.size() + set_attr_reader_m.size() + 4);
-        result.nanoseconds = reader_m.get32(directory_handle_m.size() + set_attr_reader_m.size() + 8);
-        return result;
-      }
-
-      set_attr_args_t read() const {
-        set_attr_args_t result;
-        result.filehandle = directory_handle_m.read();
-        result.new_attributes = set_attr_reader_m.read();
-        if (has_time()) result.check_time.set(check_time());
-        return result;
-      }
-
-    private:
-      binary_reader_t reader_m;
-      filehandle_reader_t directory_handle_m;
-      set_attr_reader_t set_attr_reader_m;
-    };
-
-    struct access_args_reader_t {
-      access_args_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-        , directory_handle_m(reader)
-      {}
-      size_t size() const { return 4 + directory_handle_m.size(); }
-      bool valid() const { return directory_handle_m.valid() && reader_m.has_size(size()); }
-
-      access_args_t read() const {
-        access_args_t result;
-        result.filehandle = directory_handle_m.read();
-        result.access = reader_m.get32(directory_handle_m.size());
-        return result;
-      }
-
-    private:
-      binary_reader_t reader_m;
-      filehandle_reader_t directory_handle_m;
-    };
-
-    struct read_args_reader_t {
-      read_args_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-        , file_handle_m(reader)
-      {}
-      size_t size() const { return file_handle_m.size() + 8 + 4; }
-      bool valid() const { return file_handle_m.valid() && reader_m.has_size(size()); }
-
-      read_args_t read() const {
-        read_args_t result;
-        result.filehandle = file_handle_m.read();
-        result.offset = reader_m.get64(file_handle_m.size());
-        result.count = reader_m.get32(8 + file_handle_m.size());
-        return result;
-      }
-
-    private:
-      binary_reader_t reader_m;
-      filehandle_reader_t file_handle_m;
-    };
-
-    struct write_args_reader_t {
-      write_args_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-        , file_handle_m(reader)
-        , data_m(xdr::opaque_reader<>(reader, file_handle_m.size() + 8 + 4 + 4))
-      {}
-      size_t size() const { return file_handle_m.size() + 8 + 4 + 4 + data_m.read_size(); }
-      bool valid() const { return file_handle_m.valid() && data_m.valid() && reader_m.has_size(size()); }
-
-      write_args_t read() const {
-        write_args_t result;
-        result.filehandle = file_handle_m.read();
-        result.offset = reader_m.get64(file_handle_m.size());
-        result.count = reader_m.get32(8 + file_handle_m.size());
-        result.stable = reader_m.get32<stable_how_t>(8 + 4 + file_handle_m.size());
-        result.data = data_m.to_binary();
-        return result;
-      }
-
-    private:
-      binary_reader_t reader_m;
-      filehandle_reader_t file_handle_m;
-      xdr::opaque_reader_t data_m;
-    };
-
-    struct create_args_reader_t {
-      create_args_reader_t(const binary_reader_t& reader)
-        : reader_m(reader)
-        , diropargs_m(reader)
-        , set_attr_reader_m(reader.get_reader(diropargs_m.size() + 4))
-      {}
-      size_t size() const { return diropargs_m.size() + 4 + create_how_size(); }
-      bool valid() const {
-        return diropargs_m.valid()
-            && reader_m.has_size(size())
-            && (create_how() == create_how_t::EXCLUSIVE || set_attr_reader_m.valid());
-      }
-
-      create_how_t create_how() const {
-        return reader_m.has_size(diropargs_m.size() + 4) ? reader_m.get32<create_how_t>(diropargs_m.size()) : create_how_t::UNCHECKED;
-      }
-      uint32_t create_how_size() const {
-        return create_how() == create_how_t::EXCLUSIVE ? sizeof(create_verifier_t) : set_attr_reader_m.size();
-      }
-
-      create_args_t read() const {
-        create_args_t result;
-        result.where = diropargs_m.read();
-        result.how = create_how();
-        if (result.how == create_how_t::EXCLUSIVE) {
-            create_verifier_t verifier;
-            reader_m.get_binary(diropargs_m.size() + 4, verifier);
-            result.verifier.set(verifier);
-          }
-        else {
-            result.obj_attributes.set(set_attr_reader_m.read());
-          }
-        return result;
-      }
-
-    private:
-      binary_reader_t reader_m;
-      dir_op_args_reader_t diropargs_m;
-      set_attr_reader_t set_attr_reader_m;
-    };
-
-    struct mkdir_args_reader_t {
-      mkdir_args_reader_t(const binary_reader_t& reader)
-        : diropargs_m(reader)
-        , set_attr_reader_m(reader.get_reader(diropargs_m.size()))
-      {}
-      size_t size() const { return diropargs_m.size() + set_attr_reader_m.size(); }
-      bool valid() const { return diropargs_m.valid() && set_attr_reader_m.valid(); }
-
-      mkdir_args_t read() const {
-        mkdir_args_t result;
-        result.where = diropargs_m.read();
-        result.attributes = set_attr_reader_m.read();
-        return result;
-      }
-
-    private:
-      dir_op_args_reader_t diropargs_m;
-      set_attr_reader_t set_attr_reader_m;
-    };
-
-    struct rename_args_reader_t {
-      rename_args_reader_t(const binary_reader_t& reader)
-        : from_diropargs_m(reader)
-        , to_diropargs_m(reader.get_reader(from_diropargs_m.size()))
-      {}
-      size_t size() const { return from_diropargs_m.size() + to_diropargs_m.size(); }
-      bool valid() const { return from_diropargs_m.valid() && to_diropargs_m.valid(); }
-
-      rename_args_t read() const {
-        rename_args_t result;
-        result.from = from_diropargs_m.read();
-        result.to = to_diropargs_m.read();
-        return result;
-      }
-
-    private:
-      dir_op_args_reader_t from_diropargs_m;
-      dir_op_args_reader_t to_diropargs_m;
-    };
-
-    void write_file_attr(binary_builder_t& builder, const file_attr_t& attr) {
-      builder.append32(attr.type);
-      builder.append32(attr.mode);
-      builder.append32(attr.nlink);
-      builder.append32(attr.uid);
-      builder.append32(attr.gid);
-      builder.append64(attr.size);
-      builder.append64(attr.used);
-      builder.append32(attr.rdev.data1);
-      builder.append32(attr.rdev.data2);
-      builder.append64(attr.fsid);
-      builder.append64(attr.fileid);
-      builder.append32(attr.atime.seconds);
-      builder.append32(attr.atime.nanoseconds);
-      builder.append32(attr.mtime.seconds);
-      builder.append32(attr.mtime.nanoseconds);
-      builder.append32(attr.ctime.seconds);
-      builder.append32(attr.ctime.nanoseconds);
-    }
-
-    void write_wcc_attr(binary_builder_t& builder, const wcc_attr_t& attr) {
-      builder.append64(attr.size);
-      builder.append32(attr.mtime.seconds);
-      builder.append32(attr.mtime.nanoseconds);
-      builder.append32(attr.ctime.seconds);
-      builder.append32(attr.ctime.nanoseconds);
-    }
-
-    void write_pre_op_attr(binary_builder_t& builder, const pre_op_attr_t& attr) {
-      auto active = attr.is<wcc_attr_t>();
-      builder.append32(active);
-      if (active) write_wcc_attr(builder, attr.get<wcc_attr_t>());
-    }
-
-    void write_post_op_attr(binary_builder_t& builder, const post_op_attr_t& attr) {
-      auto active = attr.is<file_attr_t>();
-      builder.append32(active);
-      if (active) write_file_attr(builder, attr.get<file_attr_t>());
-    }
-
-    void write_post_op_handle(binary_builder_t& builder, const post_op_filehandle_t& post_op) {
-      auto active = post_op.is<filehandle_t>();
-      builder.append32(active);
-      if (active) xdr::write_opaque_binary<FILEHANDLE_SIZE>(builder, post_op.get<filehandle_t>());
-    }
-
-    void write_wcc_data(binary_builder_t& builder, const wcc_data_t& wcc_data) {
-      write_pre_op_attr(builder, wcc_data.before);
-      write_post_op_attr(builder, wcc_data.after);
-    }
-
-    binary_t write_get_attr_result(const get_attr_result_t& get_attr) {
-      binary_builder_t builder;
-      builder.append32(get_attr.status);
-      if (get_attr.status == status_t::OK) {
-          write_file_attr(builder, get_attr.attr);
-        }
-      return builder.build();
-    }
-
-    binary_t write_set_attr_result(const set_attr_result_t& set_attr) {
-      binary_builder_t builder;
-      builder.append32(set_attr.status);
-      if (set_attr.status == status_t::OK) {
-          write_wcc_data(builder, set_attr.wcc_data);
-        }
-      else {
-          write_wcc_data(builder, set_attr.wcc_data);
-        }
-      return builder.build();
-    }
-
-    binary_t write_lookup_result(const lookup_result_t& lookup) {
+    // the read data is moved into its own segment
+    segmented_binary_t write_read_result(read_result_t& read) {
+      segmented_binary_t result;
       binary_builder_t builder;
-      builder.append32(lookup.status);
-      if (lookup.status == status_t::OK) {
-          xdr::write_opaque_binary<FILEHANDLE_SIZE>(builder, lookup.object_handle);
-          write_post_op_attr(builder, lookup.object_attributes);
-          write_post_op_attr(builder, lookup.dir_attributes);
+      xdr::encode(builder, read.status);
+      xdr::encode(builder, read.file_attributes);
+      if (read.status == status_t::OK) {
+          xdr::encode(builder, read.count);
+          xdr::encode(builder, read.eof);
+          xdr::write_opaque_segment(result, builder, std::move(read.data));
         }
       else {
-          write_post_op_attr(builder, lookup.dir_attributes);
+          result.append(builder.release());
         }
-
-      return builder.build();
+      return result;
     }
 
-    binary_t write_access_result(const access_result_t& access) {
-      binary_builder_t builder;
-      builder.append32(access.status);
-      if (access.status == status_t::OK) {
-          write_post_op_attr(builder, access.obj_attributes);
-          builder.append32(access.access);
-        }
-      else {
-          write_post_op_attr(builder, access.obj_attributes);
-        }
-
-      return builder.build();
-    }
+    // estimated encoded sizes to reserve directory replies up front (names assumed short)
+    enum : size_t {
+      READ_DIR_RESULT_SIZE = 4 + 88 + COOKIEVERF_SIZE + 8,
+      READ_DIR_ENTRY_SIZE = 4 + 8 + 4 + 32 + 8,
+      READ_DIR_PLUS_ENTRY_SIZE = READ_DIR_ENTRY_SIZE + 88 + 8 + FILEHANDLE_SIZE,
+    };
 
-    binary_t write_readlink_result(const readlink_result_t& readlink) {
-      binary_builder_t builder;
-      builder.append32(readlink.status);
-      if (readlink.status == status_t::OK) {
-          write_post_op_attr(builder, readlink.symlink_attributes);
-          xdr::write_opaque_string(builder, readlink.path);
-        }
-      else {
-          write_post_op_attr(builder, readlink.symlink_attributes);
+    inline filetype_t filetype_from_type(fs::type_t type) {
+      switch (type) {
+        case fs::type_t::DIRECTORY: return filetype_t::DIRECTORY;
+        case fs::type_t::SYMLINK: return filetype_t::SYMLINK;
+        default: return filetype_t::REGULAR_FILE;
         }
-      return builder.build();
     }
 
-    binary_t write_read_result(const read_result_t& read) {
-      binary_builder_t builder;
-      builder.append32(read.status);
-      if (read.status == status_t::OK) {
-          write_post_op_attr(builder, read.file_attributes);
-          builder.append32(read.count);
-          builder.append32(read.eof);
-          xdr::write_opaque_binary(builder, read.data);
-        }
-      else {
-          write_post_op_attr(builder, read.file_attributes);
-        }
-      return builder.build();
+    // the backends report the permission bits of the owner for everyone
+    inline mode_t mode_from_attributes(const fs::attributes_t& attributes) {
+      mode_t result =
+          OWNER_READ | OWNER_WRITE | OWNER_EXECUTE |
+          GROUP_READ | GROUP_WRITE | GROUP_EXECUTE |
+          OTHERS_READ | OTHERS_WRITE | OTHERS_EXECUTE;
+      return result & attributes.mode;
     }
 
-    binary_t write_write_result(const write_result_t& write) {
-      binary_builder_t builder;
-      builder.append32(write.status);
-      if (write.status == status_t::OK) {
-          write_wcc_data(builder, write.file_wcc);
-          builder.append32(write.count);
-          builder.append32(write.committed);
-          builder.append_binary(write.verifier);
-        }
-      else {
-          write_wcc_data(builder, write.file_wcc);
-        }
-      return builder.build();
+    inline bool writable(const file_attr_t& attr) {
+      return 0 != (attr.mode & OWNER_WRITE);
     }
 
-    binary_t write_create_result(const create_result_t& create) {
-      binary_builder_t builder;
-      builder.append32(create.status);
-      if (create.status == status_t::OK) {
-          write_post_op_handle(builder, create.object);
-          write_post_op_attr(builder, create.object_attributes);
-          write_wcc_data(builder, create.directory_wcc);
-        }
-      else {
-          write_wcc_data(builder, create.directory_wcc);
-        }
-      return builder.build();
+    inline wcc_attr_t wcc_attr_from_attributes(const fs::attributes_t& attributes) {
+      wcc_attr_t result;
+      result.size = attributes.size;
+      result.mtime = attributes.mtime;
+      result.ctime = attributes.ctime;
+      return result;
     }
 
-    binary_t write_remove_result(const remove_result_t& remove) {
-      binary_builder_t builder;
-      builder.append32(remove.status);
-      if (remove.status == status_t::OK) {
-          write_wcc_data(builder, remove.directory_wcc);
-        }
-      else {
-          write_wcc_data(builder, remove.directory_wcc);
-        }
-      return builder.build();
+    inline file_attr_t file_attr_from_attributes(const fs::attributes_t& attributes, const fs::volume_file_id_t& id) {
+      file_attr_t result;
+      result.type = filetype_from_type(attributes.type);
+      result.mode = mode_from_attributes(attributes);
+      result.nlink = attributes.nlink;
+      result.uid = 0; // TODO: make this configurable
+      result.gid = 0;
+      result.size = attributes.size;
+      result.used = attributes.allocated_size;
+      result.fsid = 7;
+      result.fileid = fs::short_file_id(id);
+      result.atime = attributes.atime;
+      result.mtime = attributes.mtime;
+      result.ctime = attributes.ctime;
+      return result;
     }
 
-    binary_t write_rename_result(const rename_result_t& rename) {
-      binary_builder_t builder;
-      builder.append32(rename.status);
-      if (rename.status == status_t::OK) {
-          write_wcc_data(builder, rename.from_directory_wcc);
-          write_wcc_data(builder, rename.to_directory_wcc);
-        }
-      else {
-          write_wcc_data(builder, rename.from_directory_wcc);
-          write_wcc_data(builder, rename.to_directory_wcc);
-        }
-      return builder.build();
+    // the cookie verifier changes with every modification of the directory
+    inline uint64_t directory_version(const fs::attributes_t& attributes) {
+      return attributes.mtime.seconds * 1000000000ull + attributes.mtime.nanoseconds;
     }
 
-    binary_t write_read_dir_result(const read_dir_result_t& read_dir) {
-      binary_builder_t builder;
-      builder.append32(read_dir.status);
-      if (read_dir.status == status_t::OK) {
-          write_post_op_attr(builder, read_dir.directory_attributes);
-          builder.append_binary(read_dir.cookie_verifier);
-          xdr::write_list(builder, read_dir.reply, [](binary_builder_t& builder, const read_dir_entry_t& entry){
-            builder.append64(entry.file_id);
-            xdr::write_opaque_string<>(builder, entry.name);
-            builder.append64(entry.cookie);
-          }),
-          builder.append32(read_dir.is_finished);
-        }
-      else {
-          write_post_op_attr(builder, read_dir.directory_attributes);
-        }
-
-      return builder.build();
-    }
+  } // namespace
 
-    binary_t write_read_dir_plus_result(const read_dir_plus_result_t& read_dir_plus) {
-      binary_builder_t builder;
-      builder.append32(read_dir_plus.status);
-      if (read_dir_plus.status == status_t::OK) {
-          write_post_op_attr(builder, read_dir_plus.directory_attributes);
-          builder.append_binary(read_dir_plus.cookie_verifier);
-          xdr::write_list(builder, read_dir_plus.reply, [](binary_builder_t& builder, const read_dir_plus_entry_t& entry){
-            builder.append64(entry.file_id);
-            xdr::write_opaque_string<>(builder, entry.name);
-            builder.append64(entry.cookie);
-            write_post_op_attr(builder, entry.name_attributes);
-            write_post_op_handle(builder, entry.name_handle);
-          }),
-          builder.append32(read_dir_plus.is_finished);
-        }
-      else {
-          write_post_op_attr(builder, read_dir_plus.directory_attributes);
-        }
+  bool operator== (const object_key_t& a, const object_key_t& b) {
+    return a.mount_id == b.mount_id
+        && a.access == b.access
+        && a.id == b.id;
+  }
 
-      return builder.build();
-    }
+  size_t object_key_hash_t::operator() (const object_key_t& key) const {
+    uint64_t result = fs::volume_file_id_hash_t()(key.id);
+    result ^= key.mount_id * 0xC2B2AE3D27D4EB4Full;
+    result ^= static_cast<uint64_t>(key.access) << 32;
+    return static_cast<size_t>(result);
+  }
 
-    binary_t write_fs_stat_result(const fs_stat_result_t& fs_stat) {
-      binary_builder_t builder;
-      builder.append32(fs_stat.status);
-      if (fs_stat.status == status_t::OK) {
-          write_post_op_attr(builder, fs_stat.object_attributes);
-          builder.append64(fs_stat.total_bytes);
-          builder.append64(fs_stat.free_bytes);
-          builder.append64(fs_stat.available_bytes);
-          builder.append64(fs_stat.total_files);
-          builder.append64(fs_stat.free_files);
-          builder.append64(fs_stat.available_files);
-          builder.append32(fs_stat.invar_sec);
-        }
-      else {
-          write_post_op_attr(builder, fs_stat.object_attributes);
-        }
+  rpc_program::rpc_program(const mount_cache_t &mount_cache, const config_t& config)
+    : mount_cache_m(mount_cache)
+    , backend_m(mount_cache.backend())
+    , attribute_cache_m(config.attribute_cache)
+    , directory_listings_m(config.directory_listings)
+    , write_buffer_m(config.write_buffer)
+    , watch_changes_m(config.watch_changes && attribute_cache_m.enabled())
+    , read_max_size_m(std::min<uint32_t>(std::max<uint32_t>(config.read_max_size, MIN_TRANSFER_SIZE), MAX_TRANSFER_SIZE))
+    , write_max_size_m(std::min<uint32_t>(std::max<uint32_t>(config.write_max_size, MIN_TRANSFER_SIZE), MAX_TRANSFER_SIZE))
+  {
+    uint64_t start_time = std::chrono::system_clock::now().time_since_epoch().count();
+    memcpy(cookie_verifier_m.data(), &start_time, sizeof(start_time));
+
+    // the start time alone might repeat after a clock change
+    std::random_device random;
+    uint64_t write_verifier = start_time;
+    write_verifier ^= (static_cast<uint64_t>(random()) << 32) | random();
+    memcpy(write_verifier_m.data(), &write_verifier, sizeof(write_verifier));
+  }
 
-      return builder.build();
-    }
+  uint32_t rpc_program::fitting_transfer_size(uint32_t size, size_t max_reply_size)
+  {
+    if (0 == max_reply_size) return size;
+    auto fitting = max_reply_size > TRANSFER_OVERHEAD ? max_reply_size - TRANSFER_OVERHEAD : 0;
+    fitting -= fitting % MIN_TRANSFER_SIZE;
+    return std::min<uint32_t>(size, static_cast<uint32_t>(std::max<size_t>(fitting, MIN_TRANSFER_SIZE)));
+  }
 
-    binary_t write_fs_info_result(const fs_info_result_t& fs_info) {
-      binary_builder_t builder;
-      builder.append32(fs_info.status);
-      if (fs_info.status == status_t::OK) {
-          write_post_op_attr(builder, fs_info.object_attributes);
-          builder.append32(fs_info.read_max_size);
-          builder.append32(fs_info.read_preferred_size);
-          builder.append32(fs_info.read_suggested_multiple);
-          builder.append32(fs_info.write_max_size);
-          builder.append32(fs_info.write_preferred_size);
-          builder.append32(fs_info.write_suggested_multiple);
-          builder.append32(fs_info.directory_preferred_size);
-          builder.append64(fs_info.file_maximum_size);
-          builder.append32(fs_info.time_delta.seconds);
-          builder.append32(fs_info.time_delta.nanoseconds);
-          builder.append32(fs_info.properties);
-        }
-      else {
-          write_post_op_attr(builder, fs_info.object_attributes);
-        }
+  cached_object_t rpc_program::cached_by_id(const fs::object_t& mount_directory, const mount_filehandle_t& filehandle, uint32_t access)
+  {
+    object_key_t key;
+    key.mount_id = filehandle.mount_id;
+    key.id = filehandle.volume_file_id;
+    key.access = access;
+
+    cached_object_t result;
+    result.lease = object_cache_m.get(key, [&] {
+        return fs::handle_t(backend_m.open_by_id(mount_directory, filehandle.volume_file_id, access));
+      });
+    return result;
+  }
 
-      return builder.build();
-    }
+  void rpc_program::invalidate_objects(const fs::object_t& directory, const fs::name_t& name)
+  {
+    // cached objects stay open - an open handle would keep a removed file pending on windows
+    auto object = directory.lookup(name);
+    fs::volume_file_id_t id;
+    if ( !object || !object->id(id)) return;
+    write_buffer_m.flush(id); // releases the object of the writer
+    object_cache_m.invalidate_if([&](const object_key_t& key) {
+        return key.id == id;
+      });
+    attribute_cache_m.invalidate(id);
+  }
 
-    binary_t write_path_conf_result(const path_conf_result_t& path_conf) {
-      binary_builder_t builder;
-      builder.append32(path_conf.status);
-      if (path_conf.status == status_t::OK) {
-          write_post_op_attr(builder, path_conf.object_attributes);
-          builder.append32(path_conf.link_max);
-          builder.append32(path_conf.name_max);
-          builder.append32(path_conf.no_truncation);
-          builder.append32(path_conf.chown_restricted);
-          builder.append32(path_conf.case_insensitive);
-          builder.append32(path_conf.case_preserving);
-        }
-      else {
-          write_post_op_attr(builder, path_conf.object_attributes);
-        }
+  mount_view_t rpc_program::watched_mount(uint64_t mount_id)
+  {
+    auto mount_view = mount_cache_m.get(mount_id);
+    if ( !watch_changes_m || !mount_view || watched_m.find(mount_id)) return mount_view;
 
-      return builder.build();
-    }
+    std::lock_guard<std::mutex> lock(watchers_mutex_m);
+    if (watchers_m.count(mount_id)) return mount_view; // also when watching failed
 
-    binary_t write_commit_result(const commit_result_t& commit) {
-      binary_builder_t builder;
-      builder.append32(commit.status);
-      if (commit.status == status_t::OK) {
-          write_wcc_data(builder, commit.file_wcc);
-          builder.append_binary(commit.verifier);
-        }
-      else {
-          write_wcc_data(builder, commit.file_wcc);
-        }
+    auto mount_path = mount_view.directory->path();
+    auto watcher = backend_m.watch(*mount_view.directory, [this, mount_path](const fs::path_t& path) {
+        invalidate_changed(mount_path, path);
+      });
+    if ( !watcher) LOG_AT(WARNING, "nfs3") << "Changes of the mount are not watched - attributes will only expire";
+    auto it = watchers_m.emplace(mount_id, std::move(watcher)).first;
+    watched_m.insert(mount_id, &it->second);
+    return mount_view;
+  }
 
-      return builder.build();
-    }
+  void rpc_program::invalidate_changed(const fs::path_t& mount_path, const fs::path_t& path)
+  {
+    if (path == mount_path) {
+        attribute_cache_m.clear(); // changes were lost
+        return;
+      }
+    fs::volume_file_id_t id;
+    auto object = backend_m.open_path(path);
+    if (object && object->id(id)) attribute_cache_m.invalidate(id);
 
-    inline filetype_t filetype_from_FileAttributes(DWORD FileAttributes) {
-      if (FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) return filetype_t::SYMLINK;
-      if (FileAttributes & FILE_ATTRIBUTE_DIRECTORY) return filetype_t::DIRECTORY;
-      //if (FileAttributes & FILE_ATTRIBUTE_NORMAL) {
-      return filetype_t::REGULAR_FILE;
-    }
+    // a change of the entries changes the directory times
+    auto directory = backend_m.open_path(fs::parent_path(path));
+    if (directory && directory->id(id)) attribute_cache_m.invalidate(id);
+  }
 
-    inline mode_t mode_from_FileAttributes(DWORD FileAttributes) {
-      if (FileAttributes & FILE_ATTRIBUTE_SYSTEM) return 0; // nothing allowed
-      //if (FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) return 0; // nothing allowed
-      mode_t result =
-          OWNER_READ | OWNER_WRITE | OWNER_EXECUTE |
-          GROUP_READ | GROUP_WRITE | GROUP_EXECUTE |
-          OTHERS_READ | OTHERS_WRITE | OTHERS_EXECUTE;
-      if (FileAttributes & FILE_ATTRIBUTE_READONLY) {
-          result &= ~(OWNER_WRITE | GROUP_WRITE | OTHERS_WRITE);
-        }
-      return result;
-    }
+  file_attr_t rpc_program::remember_attributes(const fs::attributes_t& attributes, const fs::volume_file_id_t& id)
+  {
+    auto attr = file_attr_from_attributes(attributes, id);
+    if ( !buffered_size(attr, id)) cache_attributes(id, attr);
+    return attr;
+  }
 
-    inline wcc_attr_t wcc_attr_from_BASIC_and_STANDARD_INFO(const FILE_BASIC_INFO& basic_info, const FILE_STANDARD_INFO& standard_info) {
-      wcc_attr_t result;
-      result.size = standard_info.EndOfFile.QuadPart;
-      std::cout << "FROM size: " << result.size << std::endl;
-      result.mtime = wintime::convert_LARGE_INTEGER_to_unix_time(basic_info.LastWriteTime);
-      result.ctime = wintime::convert_LARGE_INTEGER_to_unix_time(basic_info.ChangeTime);
-      return result;
-    }
+  bool rpc_program::buffered_size(file_attr_t& attr, const fs::volume_file_id_t& id) const
+  {
+    uint64_t end;
+    if ( !write_buffer_m.buffered_end(id, end)) return false;
+    attr.size = std::max<uint64_t>(attr.size, end);
+    return true;
+  }
 
-    inline file_attr_t file_attr_from_BASIC_and_STANDARD_INFO(const FILE_BASIC_INFO& basic_info, const FILE_STANDARD_INFO& standard_info, const winfs::volume_file_id_t& id) {
-      file_attr_t result;
-      result.type = filetype_from_FileAttributes(basic_info.FileAttributes);
-      result.mode = mode_from_FileAttributes(basic_info.FileAttributes);
-      result.nlink = standard_info.NumberOfLinks;
-      result.uid = 0; // TODO: make this configurable
-      result.gid = 0;
-      result.size = standard_info.EndOfFile.QuadPart;
-      result.used = standard_info.AllocationSize.QuadPart;
-      std::cout << "TO size: " << result.size << " used: " << result.used << std::endl;
-      result.fsid = 7;
-      result.fileid = *reinterpret_cast<const uint64_t*>(&id.FileId); // filehandle_view.volume_file_id.FileId; - too large
-      result.atime = wintime::convert_LARGE_INTEGER_to_unix_time(basic_info.LastAccessTime);
-      result.mtime = wintime::convert_LARGE_INTEGER_to_unix_time(basic_info.LastWriteTime);
-      result.ctime = wintime::convert_LARGE_INTEGER_to_unix_time(basic_info.ChangeTime);
-      return result;
-    }
+  void rpc_program::cache_attributes(const fs::volume_file_id_t& id, const file_attr_t& attr)
+  {
+    attribute_cache_m.put(id, attr);
+    // a write buffered since the stat invalidated before the put - checked after it
+    if (write_buffer_m.dirty(id)) attribute_cache_m.invalidate(id);
+  }
 
-    inline meta::optional_t<file_attr_t> file_attr_from_object(const winfs::unique_object_t& file, const winfs::volume_file_id_t& id) {
-      FILE_BASIC_INFO basic_info;
-      bool success = file.basic_info(basic_info);
-      if (!success) return {};
+  meta::optional_t<file_attr_t> rpc_program::fresh_attributes(const fs::object_t& object, const fs::volume_file_id_t& id)
+  {
+    fs::attributes_t attributes;
+    bool success = object.stat(attributes);
+    if (!success) return {};
 
-      FILE_STANDARD_INFO standard_info;
-      success = file.standard_info(standard_info);
-      if (!success) return {};
+    return remember_attributes(attributes, id);
+  }
 
-      return file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, id);
-    }
+  directory_listings_t::listing_ptr_t rpc_program::directory_listing(const mount_filehandle_t& filehandle, const fs::object_t& directory, uint64_t verifier, uint64_t cookie, bool* enumerated)
+  {
+    if (enumerated) *enumerated = false;
+    object_key_t key;
+    key.mount_id = filehandle.mount_id;
+    key.id = filehandle.volume_file_id;
+    key.access = fs::LIST_DIRECTORY;
 
-  } // namespace
+    // a listing from the start takes a new snapshot
+    if (0 != cookie) {
+        auto listing = directory_listings_m.get(key, verifier);
+        if (listing) return listing;
+      }
 
-  rpc_program::rpc_program(const mount_cache_t &mount_cache)
-    : mount_cache_m(mount_cache)
-  {
-    ::GetSystemTimeAsFileTime(reinterpret_cast<FILETIME*>(&cookie_verifier_m));
+    std::vector<fs::entry_t> entries;
+    bool success = directory.enumerate([&](const fs::entry_t& entry) {
+        entries.push_back(entry);
+        return true;
+      });
+    if (!success) return {};
+    if (enumerated) *enumerated = true;
+    return directory_listings_m.put(key, verifier, std::move(entries));
   }
 
   get_attr_result_t rpc_program::get_attr(const filehandle_t& filehandle)
   {
-    std::cout << "Get Attr..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Get Attr...";
     get_attr_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(filehandle);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if (!mount_pair.first.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto file = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
+    // cached attributes never include buffered writes
+    file_attr_t cached;
+    if ( !write_buffer_m.dirty(filehandle_view.volume_file_id) && attribute_cache_m.get(filehandle_view.volume_file_id, cached)) {
+        result.attr = cached;
+        result.status = status_t::OK;
+        LOG_AT(TRACE, "nfs3") << "...success (cached)";
+        return result;
+      }
+
+    // the size includes buffered writes
+    if (!write_buffer_m.flush(filehandle_view.volume_file_id)) {
+        result.status = status_t::ERR_IO;
+        return result;
+      }
+
+    auto file = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
     if (!file.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    auto attr = file_attr_from_object(file, filehandle_view.volume_file_id);
+    auto attr = fresh_attributes(*file, filehandle_view.volume_file_id);
     if (attr.empty()) {
         result.status = status_t::ERR_IO;
         return result;
@@ -772,141 +296,120 @@ namespace nfs3
 
     result.attr = attr.get<file_attr_t>();
     result.status = status_t::OK;
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
     return result;
   }
 
   set_attr_result_t rpc_program::set_attr(const set_attr_args_t& args)
   {
-    std::cout << "Set Attr..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Set Attr...";
     set_attr_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.filehandle);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if (!mount_pair.first.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto file = mount_directory.by_id<FILE_READ_ATTRIBUTES | FILE_WRITE_ATTRIBUTES | FILE_APPEND_DATA>(filehandle_view.volume_file_id.FileId);
+    auto file = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES | fs::WRITE_ATTRIBUTES);
     if (!file.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = file.basic_info(basic_info);
-    if (!success) {
+    // a buffered write must not extend the file after a new size was set
+    if (!write_buffer_m.flush(filehandle_view.volume_file_id)) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    FILE_STANDARD_INFO standard_info;
-    success = file.standard_info(standard_info);
+    fs::attributes_t attributes;
+    bool success = file->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    auto attr = wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info);
+    auto attr = wcc_attr_from_attributes(attributes);
     result.wcc_data.before.set(attr);
 
     if (args.check_time.is<time_t>()) {
         if (attr.ctime != args.check_time.get<time_t>()) {
             result.status = status_t::ERR_NOT_SYNC;
-            result.wcc_data.after = file_attr_from_object(file, filehandle_view.volume_file_id);
+            result.wcc_data.after = fresh_attributes(*file, filehandle_view.volume_file_id);
             return result;
           }
       }
 
-    if (args.new_attributes.size.is<size_t>() && !standard_info.Directory) {
-        success = file.set_size(args.new_attributes.size.get<size_t>());
+    if (args.new_attributes.size.is<size_t>() && attributes.type != fs::type_t::DIRECTORY) {
+        success = file->set_size(args.new_attributes.size.get<size_t>());
         if (!success) {
             result.status = status_t::ERR_INVAL;
-            result.wcc_data.after = file_attr_from_object(file, filehandle_view.volume_file_id);
+            result.wcc_data.after = fresh_attributes(*file, filehandle_view.volume_file_id);
             return result;
           }
       }
 
-    bool set_basic_info = false;
-    if (args.new_attributes.set_atime == time_how_t::SET_TO_SERVER_TIME) {
-        FILETIME filetime;
-        ::GetSystemTimeAsFileTime(&filetime);
-        basic_info.LastAccessTime.HighPart = filetime.dwHighDateTime;
-        basic_info.LastAccessTime.LowPart = filetime.dwLowDateTime;
-        set_basic_info = true;
-      }
-    if (args.new_attributes.set_mtime == time_how_t::SET_TO_SERVER_TIME) {
-        FILETIME filetime;
-        ::GetSystemTimeAsFileTime(&filetime);
-        basic_info.LastWriteTime.HighPart = filetime.dwHighDateTime;
-        basic_info.LastWriteTime.LowPart = filetime.dwLowDateTime;
-        set_basic_info = true;
-      }
-    if (set_basic_info) {
-        success = file.set_basic_info(basic_info);
+    auto set_atime = args.new_attributes.set_atime == time_how_t::SET_TO_SERVER_TIME;
+    auto set_mtime = args.new_attributes.set_mtime == time_how_t::SET_TO_SERVER_TIME;
+    if (set_atime || set_mtime) {
+        success = file->touch(set_atime, set_mtime);
         if (!success) {
             result.status = status_t::ERR_INVAL;
-            result.wcc_data.after = file_attr_from_object(file, filehandle_view.volume_file_id);
+            result.wcc_data.after = fresh_attributes(*file, filehandle_view.volume_file_id);
             return result;
           }
       }
 
-    result.wcc_data.after = file_attr_from_object(file, filehandle_view.volume_file_id);
+    result.wcc_data.after = fresh_attributes(*file, filehandle_view.volume_file_id);
 
     result.status = status_t::OK;
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
     return result;
 
   }
 
   lookup_result_t rpc_program::lookup(const dir_op_args_t& args)
   {
-    std::cout << "Lookup... " << args.name << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Lookup... " << args.name;
     lookup_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.directory);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if (!mount_pair.first.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto file = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
+    auto file = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
     if (!file.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = file.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-
-    FILE_STANDARD_INFO standard_info;
-    success = file.standard_info(standard_info);
+    fs::attributes_t attributes;
+    bool success = file->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.dir_attributes.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+    result.dir_attributes.set(remember_attributes(attributes, filehandle_view.volume_file_id));
 
-    if (0 == (basic_info.FileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+    if (attributes.type != fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_NOTDIR;
         return result;
       }
@@ -922,21 +425,20 @@ namespace nfs3
         return result;
       }
 
-    auto filename = convert::to_wstring(args.name);
-    auto lookup_file = file.lookup<FILE_READ_ATTRIBUTES>(filename);
-    if (!lookup_file.valid()) {
+    auto lookup_file = file->lookup(args.name);
+    if (!lookup_file) {
         result.status = status_t::ERR_NO_ENTRY;
         return result;
       }
 
-    winfs::volume_file_id_t lookup_id;
-    success = lookup_file.id(lookup_id);
+    fs::volume_file_id_t lookup_id;
+    success = lookup_file->id(lookup_id);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    auto lookup_attr = file_attr_from_object(lookup_file, lookup_id);
+    auto lookup_attr = fresh_attributes(*lookup_file, lookup_id);
     if (lookup_attr.empty()) {
         result.status = status_t::ERR_IO;
         return result;
@@ -949,275 +451,265 @@ namespace nfs3
     lookup_filehandle.volume_file_id = lookup_id;
 
     result.status = status_t::OK;
-    std::wcout << "...success " << lookup_file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << lookup_file->path();
     return result;
   }
 
   access_result_t rpc_program::access(const access_args_t& args)
   {
-    std::cout << "Access..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Access...";
     access_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.filehandle);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if (!mount_pair.first.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto file = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
-    if (!file.valid()) {
-        result.status = status_t::ERR_ACCESS;
-        return result;
-      }
+    file_attr_t cached;
+    if ( !attribute_cache_m.get(filehandle_view.volume_file_id, cached)) {
+        auto file = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
+        if (!file.valid()) {
+            result.status = status_t::ERR_ACCESS;
+            return result;
+          }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = file.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    FILE_STANDARD_INFO standard_info;
-    success = file.standard_info(standard_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
+        auto attr = fresh_attributes(*file, filehandle_view.volume_file_id);
+        if (attr.empty()) {
+            result.status = status_t::ERR_IO;
+            return result;
+          }
+        cached = attr.get<file_attr_t>();
       }
 
-    result.obj_attributes.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+    result.obj_attributes.set(cached);
 
-    if (basic_info.FileAttributes & (FILE_ATTRIBUTE_SYSTEM)) {
-        result.access = 0; // do not allow anything with reparse points
+    if (0 == cached.mode) {
+        result.access = 0; // do not allow anything with system files
       }
     else {
         result.access = args.access;
-        if (basic_info.FileAttributes & FILE_ATTRIBUTE_READONLY) {
+        if ( !writable(cached)) {
             result.access &= ~(ACCESS_MODIFY | ACCESS_EXTEND);
           }
-        if (basic_info.FileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+        if (cached.type == filetype_t::DIRECTORY) {
             result.access &= ~(ACCESS_EXECUTE);
           }
         else result.access &= ~(ACCESS_LOOKUP | ACCESS_DELETE);
       }
 
     result.status = status_t::OK;
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success";
     return result;
   }
 
   readlink_result_t rpc_program::readlink(const filehandle_t& filehandle)
   {
-    std::cout << "Readlink..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Readlink...";
     readlink_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(filehandle);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if (!mount_pair.first.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto file = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
+    auto file = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
     if (!file.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    result.symlink_attributes = file_attr_from_object(file, filehandle_view.volume_file_id);
+    result.symlink_attributes = fresh_attributes(*file, filehandle_view.volume_file_id);
     if (result.symlink_attributes.empty()) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    auto symlink_path = std::wstring(); //TODO: file.target_path();
-    result.path = convert::to_string(symlink_path);
+    if ( !file->read_link(result.path)) {
+        result.status = status_t::ERR_IO;
+        return result;
+      }
     std::transform(result.path.begin(), result.path.end(), result.path.begin(), [](char chr) {
         if (chr == '\\') return '/';
         return chr;
       });
 
     result.status = status_t::OK;
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
     return result;
   }
 
-  read_result_t rpc_program::read(const read_args_t& args)
+  read_result_t rpc_program::read(const read_args_t& args, size_t max_reply_size)
   {
-    std::cout << "Read..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Read...";
     read_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.filehandle);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if (!mount_pair.first.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto object = mount_directory.by_id<FILE_READ_ATTRIBUTES|FILE_READ_DATA>(filehandle_view.volume_file_id.FileId);
+    auto object = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES | fs::READ_DATA);
     if (!object.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = object.basic_info(basic_info);
-    if (!success) {
+    // buffered writes reach the file first - also for the size
+    if (!write_buffer_m.flush(filehandle_view.volume_file_id)) {
         result.status = status_t::ERR_IO;
         return result;
       }
-    FILE_STANDARD_INFO standard_info;
-    success = object.standard_info(standard_info);
+
+    fs::attributes_t attributes;
+    bool success = object->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.file_attributes.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+    result.file_attributes.set(remember_attributes(attributes, filehandle_view.volume_file_id));
 
-    if (basic_info.FileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+    if (attributes.type == fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_ISDIR;
         return result;
       }
 
-    auto file = object.as_file();
-    success = file.seek(args.offset);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-
-    result.data.resize(args.count);
-    success = file.read(result.data);
+    // shorter reads than asked for are allowed - the client continues after them
+    auto count = std::min(args.count, fitting_transfer_size(read_max_size_m, max_reply_size));
+    result.data = buffer_pool_t::shared().acquire(count);
+    result.data.resize(count);
+    success = object->read_at(args.offset, result.data);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
     result.count = result.data.size();
-    result.eof = (args.count != 0 && result.data.empty())
-        || (args.offset + result.data.size() == (uint64_t)standard_info.EndOfFile.QuadPart);
+    result.eof = (count != 0 && result.data.empty())
+        || (args.offset + result.data.size() == attributes.size);
 
     result.status = status_t::OK;
-    std::wcout << "...success " << object.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << object->path();
     return result;
   }
 
-  write_result_t rpc_program::write(const write_args_t& args)
+  write_result_t rpc_program::write(write_args_t&& args)
   {
-    std::cout << "Write..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Write...";
     write_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.filehandle);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if (!mount_pair.first.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto object = /*args.stable != stable_how_t::UNSTABLE
-        ? mount_directory.by_id<FILE_READ_ATTRIBUTES | FILE_GENERIC_WRITE, FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, 0>(filehandle_view.volume_file_id.FileId)
-        :*/ mount_directory.by_id<FILE_READ_ATTRIBUTES | FILE_GENERIC_WRITE, 0, 0>(filehandle_view.volume_file_id.FileId);
+    auto object = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES | fs::WRITE_DATA);
     if (!object.valid()) {
-        std::wcout << "Failed Open: " << GetLastError() << std::endl;
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = object.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    FILE_STANDARD_INFO standard_info;
-    success = object.standard_info(standard_info);
+    fs::attributes_t attributes;
+    bool success = object->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.file_wcc.before.set(wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info));
+    result.file_wcc.before.set(wcc_attr_from_attributes(attributes));
 
-    if (basic_info.FileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+    if (attributes.type == fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_INVAL;
         return result;
       }
 
-    auto file = object.as_file();
-    if (0 == args.offset) {
-        success = file.truncate();
+    // like a short read - the client sends the rest again
+    if (args.data.size() > write_max_size_m) args.data.resize(write_max_size_m);
+    args.count = std::min(args.count, write_max_size_m);
+
+    auto write_end = args.offset + args.data.size();
+    if (args.stable == stable_how_t::UNSTABLE) {
+        // answered before the data reaches the file - COMMIT makes it durable
+        auto writer = [object](uint64_t offset, const binary_t& data) {
+            return object->write_at(offset, data);
+          };
+        success = write_buffer_m.write(filehandle_view.volume_file_id, args.offset, std::move(args.data), writer);
       }
     else {
-        success = file.seek(args.offset);
+        // earlier unstable writes must not overwrite this one later
+        success = write_buffer_m.flush(filehandle_view.volume_file_id)
+            && object->write_at(args.offset, args.data)
+            && object->sync();
       }
+    // after the data is buffered - attributes cached until then are stale
+    attribute_cache_m.invalidate(filehandle_view.volume_file_id);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    //auto count = std::min(args.count, args.data.size());
-    //if (count < args.data.size()) args.data.resize(args.count);
-
-    success = file.write(args.data);
-    if (!success) {
-        std::wcout << "Failed Write: " << GetLastError() << std::endl;
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-
     // file is modified - no fail allowed
-    success = object.basic_info(basic_info);
-    success &= object.standard_info(standard_info);
+    success = object->stat(attributes);
     if (success) {
-        result.file_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        auto attr = file_attr_from_attributes(attributes, filehandle_view.volume_file_id);
+        attr.size = std::max<uint64_t>(attr.size, write_end); // includes the buffered data
+        result.file_wcc.after.set(attr);
       }
 
     result.count = args.count;
     result.committed = args.stable != stable_how_t::UNSTABLE ? stable_how_t::FILE_SYNC : stable_how_t::UNSTABLE;
-    result.verifier = cookie_verifier_m;
+    result.verifier = write_verifier_m;
 
     result.status = status_t::OK;
-    std::wcout << "...success " << object.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << object->path();
     return result;
   }
 
   create_result_t rpc_program::create(const create_args_t& args)
   {
-    std::cout << "Create..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Create...";
     create_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.where.directory);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
@@ -1228,201 +720,170 @@ namespace nfs3
         return result;
       }
 
-    auto object = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
+    auto object = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
     if (!object.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = object.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    FILE_STANDARD_INFO standard_info;
-    success = object.standard_info(standard_info);
+    fs::attributes_t attributes;
+    bool success = object->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.directory_wcc.before.set(wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info));
+    result.directory_wcc.before.set(wcc_attr_from_attributes(attributes));
 
-    if (!standard_info.Directory) {
+    if (attributes.type != fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_NOTDIR;
-        result.directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        result.directory_wcc.after.set(remember_attributes(attributes, filehandle_view.volume_file_id));
         return result;
       }
-    if (basic_info.FileAttributes & (FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_SYSTEM)) {
+    if (0 == (attributes.mode & OWNER_WRITE)) {
         result.status = status_t::ERR_ACCESS;
-        result.directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        result.directory_wcc.after.set(remember_attributes(attributes, filehandle_view.volume_file_id));
         return result;
       }
 
-    auto dirpath = object.fullpath();
-    auto filepath = dirpath + L'\\' + convert::to_wstring(args.where.name);
-
-    auto file = winfs::create_file<FILE_READ_ATTRIBUTES | FILE_WRITE_ATTRIBUTES>(filepath);
-    if (!file.valid()) {
+    auto file = object->create_file(args.where.name);
+    if (!file) {
         result.status = status_t::ERR_IO;
-        result.directory_wcc.after = file_attr_from_object(object, filehandle_view.volume_file_id);
+        result.directory_wcc.after = fresh_attributes(*object, filehandle_view.volume_file_id);
         return result;
       }
 
-    result.directory_wcc.after = file_attr_from_object(object, filehandle_view.volume_file_id);
+    result.directory_wcc.after = fresh_attributes(*object, filehandle_view.volume_file_id);
 
     filehandle_t created_filehandle;
     auto& created_filehandle_view = mount_filehandle_t::create_in_binary(created_filehandle);
     created_filehandle_view.mount_id = filehandle_view.mount_id;
-    file.id(created_filehandle_view.volume_file_id);
+    file->id(created_filehandle_view.volume_file_id);
 
-    result.object_attributes = file_attr_from_object(file, created_filehandle_view.volume_file_id);
+    result.object_attributes = fresh_attributes(*file, created_filehandle_view.volume_file_id);
     result.object.set(created_filehandle);
 
     result.status = status_t::OK;
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
     return result;
   }
 
   mkdir_result_t rpc_program::mkdir(const mkdir_args_t& args)
   {
-    std::cout << "MkDir..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "MkDir...";
     mkdir_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.where.directory);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto object = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
+    auto object = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
     if (!object.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = object.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    FILE_STANDARD_INFO standard_info;
-    success = object.standard_info(standard_info);
+    fs::attributes_t attributes;
+    bool success = object->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.directory_wcc.before.set(wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info));
+    result.directory_wcc.before.set(wcc_attr_from_attributes(attributes));
 
-    if (!standard_info.Directory) {
+    if (attributes.type != fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_NOTDIR;
-        result.directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        result.directory_wcc.after.set(remember_attributes(attributes, filehandle_view.volume_file_id));
         return result;
       }
-    if (basic_info.FileAttributes & (FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_SYSTEM)) {
+    if (0 == (attributes.mode & OWNER_WRITE)) {
         result.status = status_t::ERR_ACCESS;
-        result.directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        result.directory_wcc.after.set(remember_attributes(attributes, filehandle_view.volume_file_id));
         return result;
       }
 
-    auto dirpath = object.fullpath();
-    auto filepath = dirpath + L'\\' + convert::to_wstring(args.where.name);
-
-    success = winfs::directory_t::create(filepath);
+    auto target = object->create_directory(args.where.name);
 
-    result.directory_wcc.after = file_attr_from_object(object, filehandle_view.volume_file_id);
+    result.directory_wcc.after = fresh_attributes(*object, filehandle_view.volume_file_id);
 
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    auto target = winfs::open_path<FILE_READ_ATTRIBUTES>(filepath);
-    if (!target.valid()) {
+    if (!target) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.directory_wcc.after = file_attr_from_object(object, filehandle_view.volume_file_id);
+    result.directory_wcc.after = fresh_attributes(*object, filehandle_view.volume_file_id);
 
     filehandle_t created_filehandle;
     auto& created_filehandle_view = mount_filehandle_t::create_in_binary(created_filehandle);
     created_filehandle_view.mount_id = filehandle_view.mount_id;
-    target.id(created_filehandle_view.volume_file_id);
+    target->id(created_filehandle_view.volume_file_id);
 
-    result.object_attributes = file_attr_from_object(target, created_filehandle_view.volume_file_id);
+    result.object_attributes = fresh_attributes(*target, created_filehandle_view.volume_file_id);
     result.object.set(created_filehandle);
 
     result.status = status_t::OK;
-    std::wcout << "...success " << object.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << object->path();
     return result;
   }
 
   remove_result_t rpc_program::remove(const dir_op_args_t& args)
   {
-    std::cout << "Remove..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Remove...";
     remove_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.directory);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto object = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
+    auto object = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
     if (!object.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = object.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    FILE_STANDARD_INFO standard_info;
-    success = object.standard_info(standard_info);
+    fs::attributes_t attributes;
+    bool success = object->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.directory_wcc.before.set(wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info));
+    result.directory_wcc.before.set(wcc_attr_from_attributes(attributes));
 
-    if (!standard_info.Directory) {
+    if (attributes.type != fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_NOTDIR;
-        result.directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        result.directory_wcc.after.set(remember_attributes(attributes, filehandle_view.volume_file_id));
         return result;
       }
-    if (basic_info.FileAttributes & (FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_SYSTEM)) {
+    if (0 == (attributes.mode & OWNER_WRITE)) {
         result.status = status_t::ERR_ACCESS;
-        result.directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        result.directory_wcc.after.set(remember_attributes(attributes, filehandle_view.volume_file_id));
         return result;
       }
 
-    auto dirpath = object.fullpath();
-    auto filepath = dirpath + L'\\' + convert::to_wstring(args.name);
-
-    success = winfs::file_t::remove(filepath);
+    invalidate_objects(*object, args.name);
+    success = object->remove(args.name);
 
-    result.directory_wcc.after = file_attr_from_object(object, filehandle_view.volume_file_id);
+    result.directory_wcc.after = fresh_attributes(*object, filehandle_view.volume_file_id);
 
     if (!success) {
         result.status = status_t::ERR_IO;
@@ -1430,66 +891,58 @@ namespace nfs3
       }
 
     result.status = status_t::OK;
-    std::wcout << "...success " << object.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << object->path();
     return result;
   }
 
   rmdir_result_t rpc_program::rmdir(const dir_op_args_t& args)
   {
-    std::cout << "RmDir..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "RmDir...";
     rmdir_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.directory);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto object = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
+    auto object = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
     if (!object.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = object.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    FILE_STANDARD_INFO standard_info;
-    success = object.standard_info(standard_info);
+    fs::attributes_t attributes;
+    bool success = object->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.directory_wcc.before.set(wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info));
+    result.directory_wcc.before.set(wcc_attr_from_attributes(attributes));
 
-    if (!standard_info.Directory) {
+    if (attributes.type != fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_NOTDIR;
-        result.directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        result.directory_wcc.after.set(remember_attributes(attributes, filehandle_view.volume_file_id));
         return result;
       }
-    if (basic_info.FileAttributes & (FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_SYSTEM)) {
+    if (0 == (attributes.mode & OWNER_WRITE)) {
         result.status = status_t::ERR_ACCESS;
-        result.directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
+        result.directory_wcc.after.set(remember_attributes(attributes, filehandle_view.volume_file_id));
         return result;
       }
 
-    auto dirpath = object.fullpath();
-    auto filepath = dirpath + L'\\' + convert::to_wstring(args.name);
-
-    success = winfs::directory_t::remove(filepath);
+    invalidate_objects(*object, args.name);
+    success = object->remove_directory(args.name);
 
-    result.directory_wcc.after = file_attr_from_object(object, filehandle_view.volume_file_id);
+    result.directory_wcc.after = fresh_attributes(*object, filehandle_view.volume_file_id);
 
     if (!success) {
         result.status = status_t::ERR_IO;
@@ -1497,115 +950,100 @@ namespace nfs3
       }
 
     result.status = status_t::OK;
-    std::wcout << "...success " << object.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << object->path();
     return result;
   }
 
   rename_result_t rpc_program::rename(const rename_args_t& args)
   {
-    std::cout << "Rename... " << args.from.name << " to " << args.to.name << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Rename... " << args.from.name << " to " << args.to.name;
     rename_result_t result;
 
     // build from data
     const auto& from_filehandle_view = mount_filehandle_t::view_binary(args.from.directory);
-    auto from_mount_pair = mount_cache_m.get(from_filehandle_view.mount_id);
-    auto from_mount_directory = from_mount_pair.first;
-    if ( !from_mount_directory.valid()) {
+    auto from_mount_view = watched_mount(from_filehandle_view.mount_id);
+    auto from_mount_directory = from_mount_view.directory;
+    if ( !from_mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto from_mount_filehandle = mount_filehandle_t::view_binary(from_mount_pair.second);
-    if ( from_mount_filehandle.volume_file_id.VolumeSerialNumber != from_filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& from_mount_filehandle = *from_mount_view.filehandle;
+    if ( from_mount_filehandle.volume_file_id.volume != from_filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto from_object = from_mount_directory.by_id<FILE_READ_ATTRIBUTES>(from_filehandle_view.volume_file_id.FileId);
+    auto from_object = cached_by_id(*from_mount_directory, from_filehandle_view, fs::READ_ATTRIBUTES);
     if (!from_object.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = from_object.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    FILE_STANDARD_INFO standard_info;
-    success = from_object.standard_info(standard_info);
+    fs::attributes_t attributes;
+    bool success = from_object->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.from_directory_wcc.before.set(wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info));
+    result.from_directory_wcc.before.set(wcc_attr_from_attributes(attributes));
 
-    if (!standard_info.Directory) {
+    if (attributes.type != fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_NOTDIR;
-        result.from_directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, from_filehandle_view.volume_file_id));
+        result.from_directory_wcc.after.set(remember_attributes(attributes, from_filehandle_view.volume_file_id));
         return result;
       }
-    if (basic_info.FileAttributes & (FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_SYSTEM)) {
+    if (0 == (attributes.mode & OWNER_WRITE)) {
         result.status = status_t::ERR_ACCESS;
-        result.from_directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, from_filehandle_view.volume_file_id));
+        result.from_directory_wcc.after.set(remember_attributes(attributes, from_filehandle_view.volume_file_id));
         return result;
       }
 
-    auto from_dirpath = from_object.fullpath();
-    auto from_filepath = from_dirpath + L'\\' + convert::to_wstring(args.from.name);
-
     // build to data
     const auto& to_filehandle_view = mount_filehandle_t::view_binary(args.to.directory);
-    auto to_mount_pair = mount_cache_m.get(to_filehandle_view.mount_id);
-    auto to_mount_directory = to_mount_pair.first;
-    if ( !to_mount_directory.valid()) {
+    auto to_mount_view = watched_mount(to_filehandle_view.mount_id);
+    auto to_mount_directory = to_mount_view.directory;
+    if ( !to_mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto to_mount_filehandle = mount_filehandle_t::view_binary(to_mount_pair.second);
-    if ( to_mount_filehandle.volume_file_id.VolumeSerialNumber != to_filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& to_mount_filehandle = *to_mount_view.filehandle;
+    if ( to_mount_filehandle.volume_file_id.volume != to_filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto to_object = to_mount_directory.by_id<FILE_READ_ATTRIBUTES>(to_filehandle_view.volume_file_id.FileId);
+    auto to_object = cached_by_id(*to_mount_directory, to_filehandle_view, fs::READ_ATTRIBUTES);
     if (!to_object.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    success = to_object.basic_info(basic_info);
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
-      }
-    success = to_object.standard_info(standard_info);
+    success = to_object->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.to_directory_wcc.before.set(wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info));
+    result.to_directory_wcc.before.set(wcc_attr_from_attributes(attributes));
 
-    if (!standard_info.Directory) {
+    if (attributes.type != fs::type_t::DIRECTORY) {
         result.status = status_t::ERR_NOTDIR;
-        result.to_directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, to_filehandle_view.volume_file_id));
+        result.to_directory_wcc.after.set(remember_attributes(attributes, to_filehandle_view.volume_file_id));
         return result;
       }
-    if (basic_info.FileAttributes & (FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_SYSTEM)) {
+    if (0 == (attributes.mode & OWNER_WRITE)) {
         result.status = status_t::ERR_ACCESS;
-        result.to_directory_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, to_filehandle_view.volume_file_id));
+        result.to_directory_wcc.after.set(remember_attributes(attributes, to_filehandle_view.volume_file_id));
         return result;
       }
 
-    auto to_dirpath = to_object.fullpath();
-    auto to_filepath = to_dirpath + L'\\' + convert::to_wstring(args.to.name);
-
-    success = winfs::file_t::move(from_filepath, to_filepath);
+    invalidate_objects(*from_object, args.from.name);
+    invalidate_objects(*to_object, args.to.name); // replaced by the move
+    success = from_object->rename(args.from.name, *to_object, args.to.name);
 
-    result.from_directory_wcc.after = file_attr_from_object(from_object, from_filehandle_view.volume_file_id);
-    result.to_directory_wcc.after = file_attr_from_object(to_object, to_filehandle_view.volume_file_id);
+    result.from_directory_wcc.after = fresh_attributes(*from_object, from_filehandle_view.volume_file_id);
+    result.to_directory_wcc.after = fresh_attributes(*to_object, to_filehandle_view.volume_file_id);
 
     if (!success) {
         result.status = status_t::ERR_IO;
@@ -1613,135 +1051,135 @@ namespace nfs3
       }
 
     result.status = status_t::OK;
-    std::wcout << "...success " << from_object.fullpath() << " to " << to_object.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << from_object->path() << " to " << to_object->path();
     return result;
   }
 
   read_dir_result_t rpc_program::read_dir(const read_dir_args_t& args)
   {
-    std::cout << "Read Dir..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Read Dir...";
     read_dir_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.directory);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto file = mount_directory.by_id<FILE_LIST_DIRECTORY | FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
-    if (!file.valid()) {
+    // enumerations are not shared - the object is not cached
+    auto file = backend_m.open_by_id(*mount_directory, filehandle_view.volume_file_id, fs::READ_ATTRIBUTES | fs::LIST_DIRECTORY);
+    if (!file) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
     // take care of verifier cookie
-    FILE_BASIC_INFO basic_info;
-    bool success = file.basic_info(basic_info);
+    fs::attributes_t attributes;
+    bool success = file->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
-    const int64_t& args_verifier = *reinterpret_cast<const int64_t*>(&args.cookie_verifier[0]);
-    if (0 != args_verifier && args_verifier != basic_info.LastWriteTime.QuadPart) {
+    auto version = directory_version(attributes);
+    const uint64_t& args_verifier = *reinterpret_cast<const uint64_t*>(&args.cookie_verifier[0]);
+    if (0 != args_verifier && args_verifier != version) {
         result.status = status_t::ERR_BAD_COOKIE;
         return result;
       }
-    *reinterpret_cast<int64_t*>(&result.cookie_verifier[0]) = basic_info.LastWriteTime.QuadPart;
+    *reinterpret_cast<uint64_t*>(&result.cookie_verifier[0]) = version;
 
-    // setup
-    uint64_t fileCookie = 0;
-    convert::state_t mbstate;
+    auto listing = directory_listing(filehandle_view, *file, version, args.cookie);
+    if (!listing) {
+        result.status = status_t::ERR_IO;
+        return result;
+      }
 
     size_t totalcount = 4 + // dir_attributes
         sizeof(cookie_verifier_t) +
         4 + // reply terminator
         4; // eof
 
+    // the cookie is the index of the next entry
+    const auto& entries = listing->entries;
     result.is_finished = true;
-    success = file.as_directory().enumerate([&](const winfs::directory_entry_t& entry) {
-        ++fileCookie;
-        if (fileCookie <= args.cookie) return true; // skip already read parts
-
-        auto entry_filename = entry.filename();
-        auto entry_filename_mbslen = convert::to_string_length(entry_filename, mbstate);
-
+    for (auto index = args.cookie; index < entries.size(); ++index) {
+        const auto& entry = entries[index];
         totalcount +=
             4 + // marker
             8 + // file_id
-            4 + entry_filename_mbslen + // filename
+            4 + entry.name.size() + // filename
             8; // cookie
         if (totalcount > args.count) {
             result.is_finished = false;
-            return false;
+            break;
           }
-        std::wcout << entry_filename << std::endl;
 
         read_dir_entry_t result_entry;
         result_entry.file_id = 1;
-        result_entry.name = convert::to_string_with_length(entry_filename, entry_filename_mbslen, mbstate);
-        result_entry.cookie = fileCookie;
+        result_entry.name = entry.name;
+        result_entry.cookie = index + 1;
 
         result.reply.push_back(result_entry);
-        return true;
-      });
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
       }
-    else
-      std::wcout << "...success " << file.fullpath() << std::endl;
 
+    result.status = status_t::OK;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
     return result;
   }
 
   read_dir_plus_result_t rpc_program::read_dir_plus(const read_dir_plus_args_t& args)
   {
-    std::cout << "Read Dir Plus..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Read Dir Plus...";
     read_dir_plus_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(args.directory);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if ( mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
-    auto file = mount_directory.by_id<FILE_LIST_DIRECTORY | FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
-    if (!file.valid()) {
+    // enumerations are not shared - the object is not cached
+    auto file = backend_m.open_by_id(*mount_directory, filehandle_view.volume_file_id, fs::READ_ATTRIBUTES | fs::LIST_DIRECTORY);
+    if (!file) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
     // take care of verifier cookie
-    FILE_BASIC_INFO basic_info;
-    bool success = file.basic_info(basic_info);
+    fs::attributes_t attributes;
+    bool success = file->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
-    const int64_t& args_verifier = *reinterpret_cast<const int64_t*>(&args.cookie_verifier[0]);
-    if (0 != args_verifier && args_verifier != basic_info.LastWriteTime.QuadPart) {
+    auto version = directory_version(attributes);
+    const uint64_t& args_verifier = *reinterpret_cast<const uint64_t*>(&args.cookie_verifier[0]);
+    if (0 != args_verifier && args_verifier != version) {
         result.status = status_t::ERR_BAD_COOKIE;
         return result;
       }
-    *reinterpret_cast<int64_t*>(&result.cookie_verifier[0]) = basic_info.LastWriteTime.QuadPart;
+    *reinterpret_cast<uint64_t*>(&result.cookie_verifier[0]) = version;
 
-    // setup
-    uint64_t fileCookie = 0;
-    convert::state_t mbstate;
+    bool enumerated = false;
+    auto listing = directory_listing(filehandle_view, *file, version, args.cookie, &enumerated);
+    if (!listing) {
+        result.status = status_t::ERR_IO;
+        return result;
+      }
 
     size_t dircount = 0;
     size_t totalcount = 4 + // dir_attributes
@@ -1749,186 +1187,165 @@ namespace nfs3
         4 + // reply terminator
         4; // eof
 
+    // the cookie is the index of the next entry
+    const auto& entries = listing->entries;
     result.is_finished = true;
-    success = file.as_directory().enumerate([&](const winfs::directory_entry_t& entry) {
-        ++fileCookie;
-        if (fileCookie <= args.cookie) return true; // skip already read parts
-
-        auto entry_filename = entry.filename();
-        auto entry_filename_mbslen = convert::to_string_length(entry_filename, mbstate);
-
+    for (auto index = args.cookie; index < entries.size(); ++index) {
+        const auto& entry = entries[index];
         dircount +=
             8 + // file_id
-            4 + entry_filename_mbslen + // filename
+            4 + entry.name.size() + // filename
             8; // cookie
         if (dircount > args.dircount) {
             result.is_finished = false;
-            return false;
+            break;
           }
 
         totalcount +=
             4 + // marker
             8 + // file_id
-            4 + entry_filename_mbslen + // filename
+            4 + entry.name.size() + // filename
             8 + // cookie
             4 + sizeof(file_attr_t) + // name_attributes
-            4 + sizeof(winfs::file_id_t); // name_handle
+            4 + sizeof(mount_filehandle_t); // name_handle
         if (totalcount > args.maxcount) {
             result.is_finished = false;
-            return false;
+            break;
           }
-        std::wcout << entry_filename << std::endl;
 
         read_dir_plus_entry_t result_entry;
-        auto entry_id = entry.id();
-        result_entry.file_id = *reinterpret_cast<const uint64_t*>(&entry_id);
-        result_entry.name = convert::to_string_with_length(entry_filename, entry_filename_mbslen, mbstate);
-        result_entry.cookie = fileCookie;
-
-        file_attr_t entry_attr;
-        entry_attr.type = filetype_from_FileAttributes(entry.attributes());
-        entry_attr.mode = mode_from_FileAttributes(entry.attributes());
-        entry_attr.nlink = 1;
-        entry_attr.uid = 0; // TODO: make this configurable
-        entry_attr.gid = 0;
-        entry_attr.size = entry.size();
-        entry_attr.used = entry.allocated_size();
-        entry_attr.fsid = filehandle_view.volume_file_id.VolumeSerialNumber;
-        entry_attr.fileid = *reinterpret_cast<const uint64_t*>(&entry_id);
-        entry_attr.atime = wintime::convert_LARGE_INTEGER_to_unix_time(entry.lastAccessTime());
-        entry_attr.mtime = wintime::convert_LARGE_INTEGER_to_unix_time(entry.lastWriteTime());
-        entry_attr.ctime = wintime::convert_LARGE_INTEGER_to_unix_time(entry.changeTime());
-        result_entry.name_attributes.set(entry_attr);
-
         filehandle_t entry_handle;
         auto& entry_filehandle_view = mount_filehandle_t::create_in_binary(entry_handle);
         entry_filehandle_view.mount_id = filehandle_view.mount_id;
-        entry_filehandle_view.volume_file_id.VolumeSerialNumber = filehandle_view.volume_file_id.VolumeSerialNumber;
-        entry_filehandle_view.volume_file_id.FileId = entry.id();
+        entry_filehandle_view.volume_file_id.volume = filehandle_view.volume_file_id.volume;
+        memcpy(entry_filehandle_view.volume_file_id.file, entry.file, sizeof(entry.file));
         result_entry.name_handle.set(entry_handle);
 
+        // same fsid as get_attr - clients compare it to detect mount points
+        auto entry_attr = file_attr_from_attributes(entry.attributes, entry_filehandle_view.volume_file_id);
+        auto buffered = buffered_size(entry_attr, entry_filehandle_view.volume_file_id);
+        result_entry.file_id = entry_attr.fileid;
+        result_entry.name = entry.name;
+        result_entry.cookie = index + 1;
+        result_entry.name_attributes.set(entry_attr);
+
+        // a listing without link counts reports a single link as above
+        // the snapshot of continuations keeps sizes and times of its enumeration - not cached
+        if (enumerated && !buffered) cache_attributes(entry_filehandle_view.volume_file_id, entry_attr);
+
         result.reply.push_back(result_entry);
-        return true;
-      });
-    if (!success) {
-        result.status = status_t::ERR_IO;
-        return result;
       }
-    else
-      std::wcout << "...success " << file.fullpath() << std::endl;
 
     result.status = status_t::OK;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
     return result;
   }
 
   fs_stat_result_t rpc_program::fs_stat(const filehandle_t &root)
   {
-    std::cout << "FS stat..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "FS stat...";
     fs_stat_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(root);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber
-         || 0 != memcpy_s(&mount_filehandle.volume_file_id.FileId, sizeof(mount_filehandle.volume_file_id.FileId),
-                          &filehandle_view.volume_file_id.FileId, sizeof(filehandle_view.volume_file_id.FileId))) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if (mount_filehandle.volume_file_id != filehandle_view.volume_file_id) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // wrong volume
       }
 
     //result.directory_attributes.file_attr.set();
 
-    auto file = mount_directory.by_id<>(filehandle_view.volume_file_id.FileId);
+    auto file = cached_by_id(*mount_directory, filehandle_view);
     if (!file.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
-    auto fullpath = file.fullpath();
-
-    ULARGE_INTEGER available_bytes, total_bytes, free_bytes;
-    bool success = ::GetDiskFreeSpaceEx(fullpath.c_str(), &available_bytes, &total_bytes, &free_bytes);
+    fs::space_t space;
+    bool success = file->space(space);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
     result.status = status_t::OK;
-    result.total_bytes = total_bytes.QuadPart;
-    result.free_bytes = free_bytes.QuadPart;
-    result.available_bytes = available_bytes.QuadPart;
+    result.total_bytes = space.total_bytes;
+    result.free_bytes = space.free_bytes;
+    result.available_bytes = space.available_bytes;
     result.total_files = 1ull << (32 + 1);
     result.free_files = 1ull << 32;
     result.available_files = 1ull << 32;
     result.invar_sec = 0;
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
     return result;
   }
 
-  fs_info_result_t rpc_program::fs_info(const filehandle_t& root)
+  fs_info_result_t rpc_program::fs_info(const filehandle_t& root, size_t max_reply_size)
   {
-    std::cout << "FS info..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "FS info...";
     fs_info_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(root);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if ( mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber
-         || 0 != memcpy_s(&mount_filehandle.volume_file_id.FileId, sizeof(mount_filehandle.volume_file_id.FileId),
-                          &filehandle_view.volume_file_id.FileId, sizeof(filehandle_view.volume_file_id.FileId))) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if (mount_filehandle.volume_file_id != filehandle_view.volume_file_id) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // not the mount directly
       }
 
-    auto file = mount_directory.by_id<FILE_READ_ATTRIBUTES>(filehandle_view.volume_file_id.FileId);
+    auto file = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES);
     if (!file.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    result.object_attributes = file_attr_from_object(file, filehandle_view.volume_file_id);
+    result.object_attributes = fresh_attributes(*file, filehandle_view.volume_file_id);
     if (result.object_attributes.empty()) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
+    // datagram clients neither receive nor send more than a datagram
+    result.read_max_size = result.read_preferred_size = fitting_transfer_size(read_max_size_m, max_reply_size);
+    result.write_max_size = result.write_preferred_size = fitting_transfer_size(write_max_size_m, max_reply_size);
     result.status = status_t::OK;
-    // TODO: query filesystem info of windows
+    // TODO: query filesystem info of the backend
 
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
 
     return result;
   }
 
   path_conf_result_t rpc_program::path_conf(const filehandle_t& filehandle)
   {
-    std::cout << "Path Conf..." << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Path Conf...";
 
     path_conf_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(filehandle);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if (mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if (mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // not the mount directly
       }
 
-    auto file = mount_directory.by_id(filehandle_view.volume_file_id.FileId);
+    auto file = cached_by_id(*mount_directory, filehandle_view);
     if (!file.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
@@ -1936,53 +1353,58 @@ namespace nfs3
 
     result.status = status_t::OK;
     // see defaults
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
 
     return result;
   }
 
   commit_result_t rpc_program::commit(const commit_args_t& commit)
   {
-    std::cout << "Commit... offset: " << commit.offset << " count: " << commit.count << std::endl;
+    LOG_AT(TRACE, "nfs3") << "Commit... offset: " << commit.offset << " count: " << commit.count;
     commit_result_t result;
 
     const auto& filehandle_view = mount_filehandle_t::view_binary(commit.file);
-    auto mount_pair = mount_cache_m.get(filehandle_view.mount_id);
-    auto mount_directory = mount_pair.first;
-    if ( !mount_directory.valid()) {
+    auto mount_view = watched_mount(filehandle_view.mount_id);
+    auto mount_directory = mount_view.directory;
+    if ( !mount_directory) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // invalid mount
       }
-    auto mount_filehandle = mount_filehandle_t::view_binary(mount_pair.second);
-    if (mount_filehandle.volume_file_id.VolumeSerialNumber != filehandle_view.volume_file_id.VolumeSerialNumber) {
+    const auto& mount_filehandle = *mount_view.filehandle;
+    if (mount_filehandle.volume_file_id.volume != filehandle_view.volume_file_id.volume) {
         result.status = status_t::ERR_BADHANDLE;
         return result; // not the mount directly
       }
 
-    auto file = mount_directory.by_id(filehandle_view.volume_file_id.FileId);
+    auto file = cached_by_id(*mount_directory, filehandle_view, fs::READ_ATTRIBUTES | fs::WRITE_DATA);
     if (!file.valid()) {
         result.status = status_t::ERR_ACCESS;
         return result;
       }
 
-    FILE_BASIC_INFO basic_info;
-    bool success = file.basic_info(basic_info);
+    fs::attributes_t attributes;
+    bool success = file->stat(attributes);
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
-    FILE_STANDARD_INFO standard_info;
-    success = file.standard_info(standard_info);
+
+    result.file_wcc.before.set(wcc_attr_from_attributes(attributes));
+    result.verifier = write_verifier_m;
+
+    // reports a failed background write of the file once
+    success = write_buffer_m.commit(filehandle_view.volume_file_id, commit.offset, commit.count)
+        && file->sync();
+
+    result.file_wcc.after = fresh_attributes(*file, filehandle_view.volume_file_id);
+
     if (!success) {
         result.status = status_t::ERR_IO;
         return result;
       }
 
-    result.file_wcc.before.set(wcc_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info));
-    result.file_wcc.after.set(file_attr_from_BASIC_and_STANDARD_INFO(basic_info, standard_info, filehandle_view.volume_file_id));
-
     result.status = status_t::OK;
-    std::wcout << "...success " << file.fullpath() << std::endl;
+    LOG_AT(TRACE, "nfs3") << "...success " << file->path();
 
     return result;
   }
@@ -2002,137 +1424,173 @@ namespace nfs3
         return result_t::respond({});
       };
     auto get_attr_rpc = [=](const args_t& args)->result_t {
-        auto reader = filehandle_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = get_attr(reader.read());
-        return result_t::respond(write_get_attr_result(result));
+        filehandle_t arguments;
+        if (!xdr::decode_with<xdr::filehandle_codec_t>(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = get_attr(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto set_attr_rpc = [=](const args_t& args)->result_t {
-        auto reader = set_attr_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = set_attr(reader.read());
-        return result_t::respond(write_set_attr_result(result));
+        set_attr_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = set_attr(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto lookup_rpc = [=](const args_t& args)->result_t {
-        auto reader = dir_op_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = lookup(reader.read());
-        return result_t::respond(write_lookup_result(result));
+        dir_op_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = lookup(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto access_rpc = [=](const args_t& args)->result_t {
-        auto reader = access_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = access(reader.read());
-        return result_t::respond(write_access_result(result));
+        access_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = access(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto readlink_rpc = [=](const args_t& args)->result_t {
-        auto reader = filehandle_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = readlink(reader.read());
-        return result_t::respond(write_readlink_result(result));
+        filehandle_t arguments;
+        if (!xdr::decode_with<xdr::filehandle_codec_t>(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = readlink(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto read_rpc = [=](const args_t& args)->result_t {
-        auto reader = read_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = read(reader.read());
-        return result_t::respond(write_read_result(result));
+        read_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = read(arguments, args.max_reply_size);
+        args.executed();
+        return result_t::respond_segmented(write_read_result(result));
       };
     auto write_rpc = [=](const args_t& args)->result_t {
-        auto reader = write_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = write(reader.read());
-        return result_t::respond(write_write_result(result));
+        write_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = write(std::move(arguments));
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto create_rpc = [=](const args_t& args)->result_t {
-        auto reader = create_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = create(reader.read());
-        return result_t::respond(write_create_result(result));
+        create_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = create(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto mkdir_rpc = [=](const args_t& args)->result_t {
-        auto reader = mkdir_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = mkdir(reader.read());
-        return result_t::respond(write_create_result(result));
+        mkdir_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = mkdir(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto remove_rpc = [=](const args_t& args)->result_t {
-        auto reader = dir_op_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = remove(reader.read());
-        return result_t::respond(write_remove_result(result));
+        dir_op_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = remove(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto rmdir_rpc = [=](const args_t& args)->result_t {
-        auto reader = dir_op_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = rmdir(reader.read());
-        return result_t::respond(write_remove_result(result));
+        dir_op_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = rmdir(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto rename_rpc = [=](const args_t& args)->result_t {
-        auto reader = rename_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = rename(reader.read());
-        return result_t::respond(write_rename_result(result));
+        rename_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = rename(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto read_dir_rpc = [=](const args_t& args)->result_t {
-        auto reader = read_dir_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = read_dir(reader.read());
-        return result_t::respond(write_read_dir_result(result));
+        read_dir_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = read_dir(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result, READ_DIR_RESULT_SIZE + result.reply.size() * READ_DIR_ENTRY_SIZE));
       };
     auto read_dir_plus_rpc = [=](const args_t& args)->result_t {
-        auto reader = read_dir_plus_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = read_dir_plus(reader.read());
-        return result_t::respond(write_read_dir_plus_result(result));
+        read_dir_plus_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = read_dir_plus(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result, READ_DIR_RESULT_SIZE + result.reply.size() * READ_DIR_PLUS_ENTRY_SIZE));
       };
     auto fs_stat_rpc = [=](const args_t& args)->result_t {
-        auto reader = filehandle_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = fs_stat(reader.read());
-        return result_t::respond(write_fs_stat_result(result));
+        filehandle_t arguments;
+        if (!xdr::decode_with<xdr::filehandle_codec_t>(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = fs_stat(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto fs_info_rpc = [=](const args_t& args)->result_t {
-        auto reader = filehandle_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = fs_info(reader.read());
-        return result_t::respond(write_fs_info_result(result));
+        filehandle_t arguments;
+        if (!xdr::decode_with<xdr::filehandle_codec_t>(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = fs_info(arguments, args.max_reply_size);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto path_conf_rpc = [=](const args_t& args)->result_t {
-        auto reader = filehandle_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = path_conf(reader.read());
-        return result_t::respond(write_path_conf_result(result));
+        filehandle_t arguments;
+        if (!xdr::decode_with<xdr::filehandle_codec_t>(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = path_conf(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
     auto commit_rpc = [=](const args_t& args)->result_t {
-        auto reader = commit_args_reader_t(args.parameter_reader);
-        if (!reader.valid()) return {};
-        auto result = commit(reader.read());
-        return result_t::respond(write_commit_result(result));
+        commit_args_t arguments;
+        if (!xdr::decode(args.parameter_reader, arguments)) return {};
+        args.decoded();
+        auto result = commit(arguments);
+        args.executed();
+        return result_t::respond(xdr::to_binary(result));
       };
 
     auto& calls = result.procedures;
-    calls.set( 0, { "NULL", null_rpc });
-    calls.set( 1, { "GETATTR", get_attr_rpc });
-    calls.set( 2, { "SETATTR", set_attr_rpc });
-    calls.set( 3, { "LOOKUP", lookup_rpc });
-    calls.set( 4, { "ACCESS", access_rpc });
-    calls.set( 5, { "READLINK", readlink_rpc });
-    calls.set( 6, { "READ", read_rpc });
-    calls.set( 7, { "WRITE", write_rpc });
-    calls.set( 8, { "CREATE", create_rpc });
-    calls.set( 9, { "MKDIR", mkdir_rpc });
-    calls.set(10, { "SYMLINK", {}/*symlink_rpc*/ });
-    calls.set(11, { "MKNOD", {}/*mk_node_rpc*/ });
-    calls.set(12, { "REMOVE", remove_rpc });
-    calls.set(13, { "RMDIR", rmdir_rpc });
-    calls.set(14, { "RENAME", rename_rpc });
-    calls.set(15, { "LINK", {}/*link_rpc*/ });
-    calls.set(16, { "READDIR", read_dir_rpc });
-    calls.set(17, { "READDIRPLUS", read_dir_plus_rpc });
-    calls.set(18, { "FSSTAT", fs_stat_rpc });
-    calls.set(19, { "FSINFO", fs_info_rpc });
-    calls.set(20, { "PATHCONF", path_conf_rpc });
-    calls.set(21, { "COMMIT", commit_rpc });
+    calls.set( 0, { "NULL", null_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set( 1, { "GETATTR", get_attr_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set( 2, { "SETATTR", set_attr_rpc, rpc_program_t::CACHE_REPLY });
+    calls.set( 3, { "LOOKUP", lookup_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set( 4, { "ACCESS", access_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set( 5, { "READLINK", readlink_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set( 6, { "READ", read_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set( 7, { "WRITE", write_rpc, rpc_program_t::CACHE_REPLY });
+    calls.set( 8, { "CREATE", create_rpc, rpc_program_t::CACHE_REPLY });
+    calls.set( 9, { "MKDIR", mkdir_rpc, rpc_program_t::CACHE_REPLY });
+    calls.set(10, { "SYMLINK", {}/*symlink_rpc*/, rpc_program_t::CACHE_REPLY });
+    calls.set(11, { "MKNOD", {}/*mk_node_rpc*/, rpc_program_t::CACHE_REPLY });
+    calls.set(12, { "REMOVE", remove_rpc, rpc_program_t::CACHE_REPLY });
+    calls.set(13, { "RMDIR", rmdir_rpc, rpc_program_t::CACHE_REPLY });
+    calls.set(14, { "RENAME", rename_rpc, rpc_program_t::CACHE_REPLY });
+    calls.set(15, { "LINK", {}/*link_rpc*/, rpc_program_t::CACHE_REPLY });
+    calls.set(16, { "READDIR", read_dir_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(17, { "READDIRPLUS", read_dir_plus_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(18, { "FSSTAT", fs_stat_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(19, { "FSINFO", fs_info_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(20, { "PATHCONF", path_conf_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(21, { "COMMIT", commit_rpc, rpc_program_t::NO_REPLY_CACHE });
 
     return result;
   }
@@ -0,0 +1 @@
+#include "nfs3_types.h"
@@ -0,0 +1 @@
+#include "nfs3_xdr.h"
@@ -0,0 +1,312 @@
+#pragma once
+
+#include "nfs3_types.h"
+
+#include "rpc/xdr_schema.h"
+
+/**
+ * @brief xdr schema of the nfs3 argument and result types
+ *
+ * the field lists follow the xdr definitions of RFC1813 section 3
+ */
+namespace xdr {
+
+  // ---- basic data types ----
+
+  using filehandle_codec_t = opaque_codec_t<nfs3::filehandle_t, nfs3::FILEHANDLE_SIZE>;
+
+  template<> struct schema_t<nfs3::time_t> {
+    static auto fields() {
+      // nfstime3 has 32 bit seconds
+      return xdr::fields(as<uint32_t>(&nfs3::time_t::seconds), &nfs3::time_t::nanoseconds);
+    }
+  };
+
+  template<> struct schema_t<nfs3::specdata_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&specdata_t::data1, &specdata_t::data2);
+    }
+  };
+
+  template<> struct schema_t<nfs3::file_attr_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&file_attr_t::type, &file_attr_t::mode, &file_attr_t::nlink,
+                         &file_attr_t::uid, &file_attr_t::gid, &file_attr_t::size, &file_attr_t::used,
+                         &file_attr_t::rdev, &file_attr_t::fsid, &file_attr_t::fileid,
+                         &file_attr_t::atime, &file_attr_t::mtime, &file_attr_t::ctime);
+    }
+  };
+
+  template<> struct schema_t<nfs3::wcc_attr_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&wcc_attr_t::size, &wcc_attr_t::mtime, &wcc_attr_t::ctime);
+    }
+  };
+
+  template<> struct schema_t<nfs3::wcc_data_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&wcc_data_t::before, &wcc_data_t::after);
+    }
+  };
+
+  template<> struct schema_t<nfs3::set_attr_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&set_attr_t::mode, &set_attr_t::uid, &set_attr_t::gid, &set_attr_t::size,
+                         discriminated(&set_attr_t::set_atime, when(time_how_t::SET_TO_CLIENT_TIME, &set_attr_t::atime)),
+                         discriminated(&set_attr_t::set_mtime, when(time_how_t::SET_TO_CLIENT_TIME, &set_attr_t::mtime)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::dir_op_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(opaque<FILEHANDLE_SIZE>(&dir_op_args_t::directory), &dir_op_args_t::name);
+    }
+  };
+
+  // ---- arguments ----
+
+  template<> struct schema_t<nfs3::set_attr_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(opaque<FILEHANDLE_SIZE>(&set_attr_args_t::filehandle), &set_attr_args_t::new_attributes,
+                         &set_attr_args_t::check_time);
+    }
+  };
+
+  template<> struct schema_t<nfs3::access_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(opaque<FILEHANDLE_SIZE>(&access_args_t::filehandle), &access_args_t::access);
+    }
+  };
+
+  template<> struct schema_t<nfs3::read_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(opaque<FILEHANDLE_SIZE>(&read_args_t::filehandle), &read_args_t::offset, &read_args_t::count);
+    }
+  };
+
+  template<> struct schema_t<nfs3::write_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(opaque<FILEHANDLE_SIZE>(&write_args_t::filehandle), &write_args_t::offset, &write_args_t::count,
+                         &write_args_t::stable, &write_args_t::data);
+    }
+  };
+
+  template<> struct schema_t<nfs3::create_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&create_args_t::where,
+                         discriminated(&create_args_t::how,
+                                       when(create_how_t::EXCLUSIVE, present(&create_args_t::verifier)),
+                                       otherwise<create_how_t>(present(&create_args_t::obj_attributes))));
+    }
+  };
+
+  template<> struct schema_t<nfs3::mkdir_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&mkdir_args_t::where, &mkdir_args_t::attributes);
+    }
+  };
+
+  template<> struct schema_t<nfs3::rename_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&rename_args_t::from, &rename_args_t::to);
+    }
+  };
+
+  template<> struct schema_t<nfs3::read_dir_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(opaque<FILEHANDLE_SIZE>(&read_dir_args_t::directory), &read_dir_args_t::cookie,
+                         &read_dir_args_t::cookie_verifier, &read_dir_args_t::count);
+    }
+  };
+
+  template<> struct schema_t<nfs3::read_dir_plus_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(opaque<FILEHANDLE_SIZE>(&read_dir_plus_args_t::directory), &read_dir_plus_args_t::cookie,
+                         &read_dir_plus_args_t::cookie_verifier, &read_dir_plus_args_t::dircount, &read_dir_plus_args_t::maxcount);
+    }
+  };
+
+  template<> struct schema_t<nfs3::commit_args_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(opaque<FILEHANDLE_SIZE>(&commit_args_t::file), &commit_args_t::offset, &commit_args_t::count);
+    }
+  };
+
+  // ---- results ----
+
+  template<> struct schema_t<nfs3::get_attr_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&get_attr_result_t::status, when(status_t::OK, &get_attr_result_t::attr)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::set_attr_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&set_attr_result_t::status, &set_attr_result_t::wcc_data);
+    }
+  };
+
+  template<> struct schema_t<nfs3::lookup_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&lookup_result_t::status,
+                                       when(status_t::OK, opaque<FILEHANDLE_SIZE>(&lookup_result_t::object_handle),
+                                            &lookup_result_t::object_attributes, &lookup_result_t::dir_attributes),
+                                       otherwise<status_t>(&lookup_result_t::dir_attributes)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::access_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&access_result_t::status,
+                                       when(status_t::OK, &access_result_t::obj_attributes, &access_result_t::access),
+                                       otherwise<status_t>(&access_result_t::obj_attributes)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::readlink_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&readlink_result_t::status,
+                                       when(status_t::OK, &readlink_result_t::symlink_attributes, &readlink_result_t::path),
+                                       otherwise<status_t>(&readlink_result_t::symlink_attributes)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::write_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&write_result_t::status,
+                                       when(status_t::OK, &write_result_t::file_wcc, &write_result_t::count,
+                                            &write_result_t::committed, &write_result_t::verifier),
+                                       otherwise<status_t>(&write_result_t::file_wcc)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::create_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&create_result_t::status,
+                                       when(status_t::OK, &create_result_t::object, &create_result_t::object_attributes,
+                                            &create_result_t::directory_wcc),
+                                       otherwise<status_t>(&create_result_t::directory_wcc)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::remove_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&remove_result_t::status, &remove_result_t::directory_wcc);
+    }
+  };
+
+  template<> struct schema_t<nfs3::rename_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&rename_result_t::status, &rename_result_t::from_directory_wcc, &rename_result_t::to_directory_wcc);
+    }
+  };
+
+  template<> struct schema_t<nfs3::read_dir_entry_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&read_dir_entry_t::file_id, &read_dir_entry_t::name, &read_dir_entry_t::cookie);
+    }
+  };
+
+  template<> struct schema_t<nfs3::read_dir_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&read_dir_result_t::status,
+                                       when(status_t::OK, &read_dir_result_t::directory_attributes, &read_dir_result_t::cookie_verifier,
+                                            list(&read_dir_result_t::reply), &read_dir_result_t::is_finished),
+                                       otherwise<status_t>(&read_dir_result_t::directory_attributes)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::read_dir_plus_entry_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(&read_dir_plus_entry_t::file_id, &read_dir_plus_entry_t::name, &read_dir_plus_entry_t::cookie,
+                         &read_dir_plus_entry_t::name_attributes, &read_dir_plus_entry_t::name_handle);
+    }
+  };
+
+  template<> struct schema_t<nfs3::read_dir_plus_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&read_dir_plus_result_t::status,
+                                       when(status_t::OK, &read_dir_plus_result_t::directory_attributes, &read_dir_plus_result_t::cookie_verifier,
+                                            list(&read_dir_plus_result_t::reply), &read_dir_plus_result_t::is_finished),
+                                       otherwise<status_t>(&read_dir_plus_result_t::directory_attributes)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::fs_stat_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      using result_t = fs_stat_result_t;
+      return xdr::fields(discriminated(&result_t::status,
+                                       when(status_t::OK, &result_t::object_attributes,
+                                            &result_t::total_bytes, &result_t::free_bytes, &result_t::available_bytes,
+                                            &result_t::total_files, &result_t::free_files, &result_t::available_files,
+                                            &result_t::invar_sec),
+                                       otherwise<status_t>(&result_t::object_attributes)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::fs_info_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      using result_t = fs_info_result_t;
+      return xdr::fields(discriminated(&result_t::status,
+                                       when(status_t::OK, &result_t::object_attributes,
+                                            &result_t::read_max_size, &result_t::read_preferred_size, &result_t::read_suggested_multiple,
+                                            &result_t::write_max_size, &result_t::write_preferred_size, &result_t::write_suggested_multiple,
+                                            &result_t::directory_preferred_size, &result_t::file_maximum_size,
+                                            &result_t::time_delta, &result_t::properties),
+                                       otherwise<status_t>(&result_t::object_attributes)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::path_conf_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      using result_t = path_conf_result_t;
+      return xdr::fields(discriminated(&result_t::status,
+                                       when(status_t::OK, &result_t::object_attributes,
+                                            &result_t::link_max, &result_t::name_max, &result_t::no_truncation,
+                                            &result_t::chown_restricted, &result_t::case_insensitive, &result_t::case_preserving),
+                                       otherwise<status_t>(&result_t::object_attributes)));
+    }
+  };
+
+  template<> struct schema_t<nfs3::commit_result_t> {
+    static auto fields() {
+      using namespace nfs3;
+      return xdr::fields(discriminated(&commit_result_t::status,
+                                       when(status_t::OK, &commit_result_t::file_wcc, &commit_result_t::verifier),
+                                       otherwise<status_t>(&commit_result_t::file_wcc)));
+    }
+  };
+
+} // namespace xdr
@@ -0,0 +1,114 @@
+#include "posix_file.h"
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace posixfs {
+
+  namespace {
+    const size_t max_vectors = 64; // below IOV_MAX
+
+    // skips the transferred bytes of the vectors - returns the first unfinished one
+    iovec* advance(iovec* begin, iovec* end, size_t bytes) {
+      for (; begin != end && bytes >= begin->iov_len; ++begin) bytes -= begin->iov_len;
+      if (begin != end) {
+          begin->iov_base = static_cast<uint8_t*>(begin->iov_base) + bytes;
+          begin->iov_len -= bytes;
+        }
+      return begin;
+    }
+  } // namespace
+
+  bool file_t::write_at(uint64_t offset, const uint8_t* data, size_t size)
+  {
+    size_t count = 0;
+    while (count < size) {
+        auto written = ::pwrite(fd_m, data + count, size - count, static_cast<off_t>(offset + count));
+        if (written < 0 && EINTR == errno) continue;
+        if (written <= 0) return false;
+        count += static_cast<size_t>(written);
+      }
+    return true;
+  }
+
+  bool file_t::read_at(uint64_t offset, uint8_t* data, size_t size, size_t& count)
+  {
+    count = 0;
+    while (count < size) {
+        auto read = ::pread(fd_m, data + count, size - count, static_cast<off_t>(offset + count));
+        if (read < 0 && EINTR == errno) continue;
+        if (read < 0) return false;
+        if (0 == read) break; // end of file
+        count += static_cast<size_t>(read);
+      }
+    return true;
+  }
+
+  bool file_t::write_at(uint64_t offset, const segmented_binary_t& binary)
+  {
+    auto& segments = binary.segments();
+    for (size_t first = 0; first < segments.size(); first += max_vectors) {
+        iovec vectors[max_vectors];
+        auto used = std::min(max_vectors, segments.size() - first);
+        for (size_t i = 0; i < used; ++i) {
+            vectors[i].iov_base = const_cast<uint8_t*>(segments[first + i].data());
+            vectors[i].iov_len = segments[first + i].size();
+          }
+        auto begin = vectors;
+        auto end = vectors + used;
+        while (begin != end) {
+            auto written = ::pwritev(fd_m, begin, static_cast<int>(end - begin), static_cast<off_t>(offset));
+            if (written < 0 && EINTR == errno) continue;
+            if (written <= 0) return false;
+            offset += static_cast<uint64_t>(written);
+            begin = advance(begin, end, static_cast<size_t>(written));
+          }
+      }
+    return true;
+  }
+
+  bool file_t::read_at(uint64_t offset, std::vector<binary_t>& binaries)
+  {
+    for (size_t first = 0; first < binaries.size(); first += max_vectors) {
+        iovec vectors[max_vectors];
+        auto used = std::min(max_vectors, binaries.size() - first);
+        for (size_t i = 0; i < used; ++i) {
+            vectors[i].iov_base = binaries[first + i].data();
+            vectors[i].iov_len = binaries[first + i].size();
+          }
+        auto begin = vectors;
+        auto end = vectors + used;
+        bool eof = false;
+        while (begin != end) {
+            auto read = ::preadv(fd_m, begin, static_cast<int>(end - begin), static_cast<off_t>(offset));
+            if (read < 0 && EINTR == errno) continue;
+            if (read < 0) return false;
+            if (0 == read) {
+                eof = true;
+                break;
+              }
+            offset += static_cast<uint64_t>(read);
+            begin = advance(begin, end, static_cast<size_t>(read));
+          }
+        if (eof) {
+            // the unfinished binary keeps what was read, all following are emptied
+            for (auto it = begin; it != end; ++it) {
+                auto& binary = binaries[first + (it - vectors)];
+                binary.resize(static_cast<uint8_t*>(it->iov_base) - binary.data());
+              }
+            for (auto i = first + used; i < binaries.size(); ++i) binaries[i].clear();
+            return true;
+          }
+      }
+    return true;
+  }
+
+  bool file_t::sync()
+  {
+    return 0 == ::fdatasync(fd_m);
+  }
+
+} // namespace posixfs
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "binary/binary.h"
+#include "binary/segmented_binary.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace posixfs {
+
+  /**
+   * @brief positional I/O of a file descriptor
+   *
+   * Like winfs::file_t the file does not own the descriptor.
+   * The file offset is never used, so all threads can share one descriptor.
+   */
+  struct file_t {
+    explicit file_t(int fd) : fd_m(fd) {}
+
+    int fd() const { return fd_m; }
+
+    // writes all bytes at the offset
+    bool write_at(uint64_t offset, const binary_t& binary) {
+      return write_at(offset, binary.data(), binary.size());
+    }
+    // writes the segments with one pwritev per batch of segments
+    bool write_at(uint64_t offset, const segmented_binary_t& binary);
+
+    // reads up to binary.size() bytes at the offset - the binary is shortened at the end of file
+    bool read_at(uint64_t offset, binary_t& binary) {
+      size_t count;
+      auto success = read_at(offset, binary.data(), binary.size(), count);
+      binary.resize(count);
+      return success;
+    }
+    // fills the binaries with preadv - all after the end of file are emptied
+    bool read_at(uint64_t offset, std::vector<binary_t>& binaries);
+
+    bool write_at(uint64_t offset, const uint8_t* data, size_t size);
+    bool read_at(uint64_t offset, uint8_t* data, size_t size, size_t& count);
+
+    // makes the written data durable
+    bool sync();
+
+  private:
+    int fd_m;
+  };
+
+} // namespace posixfs
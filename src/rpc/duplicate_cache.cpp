@@ -0,0 +1,116 @@
+#include "duplicate_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+  // FNV-1a
+  uint64_t checksum(const uint8_t* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+      }
+    return hash;
+  }
+} // namespace
+
+duplicate_cache_t::duplicate_cache_t()
+  : duplicate_cache_t(config_t())
+{}
+
+duplicate_cache_t::duplicate_cache_t(const config_t& config)
+  : config_m(config)
+  , shards_m(std::max<size_t>(1, config.shards))
+  , shard_budget_m(config.budget / shards_m.size())
+{}
+
+duplicate_cache_t::key_t duplicate_cache_t::key(const std::string& sender, uint32_t xid, uint32_t program, uint32_t version, uint32_t procedure,
+                                                const binary_reader_t& arguments)
+{
+  key_t result;
+  result.client = sender.substr(0, sender.rfind(':'));
+  result.xid = xid;
+  result.program = program;
+  result.version = version;
+  result.procedure = procedure;
+  // large WRITE arguments differ in their first bytes already - the offset is part of them
+  auto size = static_cast<uint64_t>(arguments.size());
+  result.checksum = checksum(arguments.data(), std::min<size_t>(arguments.size(), CHECKSUM_SIZE),
+                             checksum(reinterpret_cast<const uint8_t*>(&size), sizeof(size)));
+  return result;
+}
+
+duplicate_cache_t::status_t duplicate_cache_t::begin(const key_t& key, binary_t& reply)
+{
+  auto& shard = shard_for(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+      shard.index.emplace(key, shard.entries.end());
+      shard.bytes += ENTRY_OVERHEAD;
+      misses_m.fetch_add(1, std::memory_order_relaxed);
+      return NEW;
+    }
+  if (it->second == shard.entries.end()) {
+      in_progress_m.fetch_add(1, std::memory_order_relaxed);
+      return IN_PROGRESS;
+    }
+  shard.entries.splice(shard.entries.end(), shard.entries, it->second);
+  reply = it->second->reply;
+  hits_m.fetch_add(1, std::memory_order_relaxed);
+  return COMPLETED;
+}
+
+void duplicate_cache_t::complete(const key_t& key, binary_t reply)
+{
+  auto& shard = shard_for(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end() || it->second != shard.entries.end()) return;
+  shard.entries.push_back({ key, std::move(reply) });
+  it->second = std::prev(shard.entries.end());
+  shard.bytes += cost(shard.entries.back()) - ENTRY_OVERHEAD;
+  // calls in progress are never evicted - the newest reply is kept even above the budget
+  while (shard.bytes > shard_budget_m && shard.entries.size() > 1) {
+      auto& oldest = shard.entries.front();
+      shard.bytes -= cost(oldest);
+      shard.index.erase(oldest.key);
+      shard.entries.pop_front();
+      evictions_m.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+duplicate_cache_t::stats_t duplicate_cache_t::stats() const
+{
+  stats_t result;
+  result.hits = hits_m.load(std::memory_order_relaxed);
+  result.in_progress = in_progress_m.load(std::memory_order_relaxed);
+  result.misses = misses_m.load(std::memory_order_relaxed);
+  result.evictions = evictions_m.load(std::memory_order_relaxed);
+  for (auto& shard : shards_m) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      result.size += shard.entries.size();
+      result.bytes += shard.bytes;
+    }
+  return result;
+}
+
+size_t duplicate_cache_t::key_hash_t::operator() (const key_t& key) const
+{
+  auto hash = std::hash<std::string>()(key.client);
+  for (uint64_t value : { uint64_t(key.xid), uint64_t(key.program) << 32 | key.procedure, uint64_t(key.version), key.checksum }) {
+      hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+    }
+  return hash;
+}
+
+duplicate_cache_t::shard_t& duplicate_cache_t::shard_for(const key_t& key)
+{
+  uint64_t hash = key_hash_t()(key) * 0x9E3779B97F4A7C15ull;
+  return shards_m[(hash >> 32) % shards_m.size()];
+}
+
+size_t duplicate_cache_t::cost(const entry_t& entry)
+{
+  return ENTRY_OVERHEAD + entry.key.client.size() + entry.reply.size();
+}
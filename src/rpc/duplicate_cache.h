@@ -0,0 +1,116 @@
+#pragma once
+
+#include "binary/binary.h"
+#include "binary/binary_reader.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief replies of recent non idempotent calls for retransmissions
+ *
+ * Clients retransmit calls over udp and after tcp reconnects. A retransmission of a
+ * completed call is answered with the stored reply. A retransmission of a call that
+ * is still running is dropped - the client retransmits again later.
+ *
+ * Completed replies are kept in least recently used order per shard until the memory
+ * budget is exhausted. A budget of zero disables the cache.
+ */
+struct duplicate_cache_t {
+  enum : size_t {
+    CHECKSUM_SIZE = 256, // bytes of the arguments that are hashed
+    ENTRY_OVERHEAD = 128, // bytes counted per entry in addition to the reply
+  };
+
+  struct config_t {
+    size_t budget = 16 << 20; // bytes
+    size_t shards = 16;
+  };
+
+  // same caller, same call, same arguments
+  struct key_t {
+    std::string client; // address without the port - it changes with reconnects
+    uint32_t xid = 0;
+    uint32_t program = 0;
+    uint32_t version = 0;
+    uint32_t procedure = 0;
+    uint64_t checksum = 0;
+
+    bool operator== (const key_t& other) const {
+      return xid == other.xid && program == other.program && version == other.version
+          && procedure == other.procedure && checksum == other.checksum && client == other.client;
+    }
+  };
+
+  struct stats_t {
+    uint64_t hits = 0; // answered with a stored reply
+    uint64_t in_progress = 0; // dropped while the original call ran
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+    size_t bytes = 0;
+  };
+
+  enum status_t { NEW, IN_PROGRESS, COMPLETED };
+
+  duplicate_cache_t();
+  explicit duplicate_cache_t(const config_t&);
+
+  duplicate_cache_t(const duplicate_cache_t&) = delete;
+  duplicate_cache_t& operator= (const duplicate_cache_t&) = delete;
+
+  bool enabled() const { return config_m.budget > 0; }
+
+  // sender is "address:port", arguments are the encoded procedure parameters
+  static key_t key(const std::string& sender, uint32_t xid, uint32_t program, uint32_t version, uint32_t procedure,
+                   const binary_reader_t& arguments);
+
+  /**
+   * @brief registers a call
+   *
+   * NEW: the caller executes the call and has to complete() it
+   * COMPLETED: reply holds the stored reply
+   * IN_PROGRESS: the call is executed elsewhere
+   */
+  status_t begin(const key_t&, binary_t& reply);
+  void complete(const key_t&, binary_t reply);
+
+  stats_t stats() const;
+
+private:
+  struct key_hash_t {
+    size_t operator() (const key_t&) const;
+  };
+
+  struct entry_t {
+    key_t key;
+    binary_t reply;
+  };
+  using entries_t = std::list<entry_t>;
+
+  struct shard_t {
+    mutable std::mutex mutex;
+    entries_t entries; // completed - least recently used first
+    // end() of entries while the call is in progress
+    std::unordered_map<key_t, entries_t::iterator, key_hash_t> index;
+    size_t bytes = 0;
+  };
+
+  shard_t& shard_for(const key_t&);
+  static size_t cost(const entry_t&);
+
+private:
+  config_t config_m;
+  std::vector<shard_t> shards_m;
+  size_t shard_budget_m;
+  std::atomic<uint64_t> hits_m {0};
+  std::atomic<uint64_t> in_progress_m {0};
+  std::atomic<uint64_t> misses_m {0};
+  std::atomic<uint64_t> evictions_m {0};
+};
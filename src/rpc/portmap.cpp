@@ -4,9 +4,9 @@
 
 #include "binary/binary_builder.h"
 
-#include <algorithm>
+#include "logging/logger.h"
 
-#include <iostream>
+#include <algorithm>
 
 namespace portmap {
   namespace {
@@ -52,10 +52,10 @@ namespace portmap {
 
   uint32_t rpc_program::get_port(const mapping_t& mapping) const
   {
-    std::cout << "GetPort: program: " << mapping.program << " version: " << mapping.version << " prot: " << mapping.protocol << " for " << std::endl;
+    LOG_AT(INFO, "portmap") << "GetPort: program: " << mapping.program << " version: " << mapping.version << " prot: " << mapping.protocol;
     auto it = find(store_m, mapping);
     if (it == store_m.end()) return 0;
-    std::cout << "... Success port: " << it->port << std::endl;
+    LOG_AT(INFO, "portmap") << "... Success port: " << it->port;
     return it->port;
   }
 
@@ -77,34 +77,40 @@ namespace portmap {
         mapping_t mapping;
         if (!read_mapping(args.parameter_reader, mapping)) return {};
         if (mapping.port != protocol_t::TCP && mapping.port != protocol_t::UDP) return {};
+        args.decoded();
         auto result = set(mapping);
+        args.executed();
         binary_builder_t builder;
         builder.append32(result);
-        return result_t::respond(builder.build());
+        return result_t::respond(builder.release());
       };
     auto unset_rpc = [=](const args_t& args)->result_t {
         mapping_t mapping;
         if (!read_mapping(args.parameter_reader, mapping)) return {};
         if (mapping.port != protocol_t::TCP && mapping.port != protocol_t::UDP) return {};
+        args.decoded();
         auto result = unset(mapping);
+        args.executed();
         binary_builder_t builder;
         builder.append32(result);
-        return result_t::respond(builder.build());
+        return result_t::respond(builder.release());
       };
     auto get_port_rpc = [=](const args_t& args)->result_t {
         mapping_t mapping;
         if (!read_mapping(args.parameter_reader, mapping)) return {};
+        args.decoded();
         auto result = get_port(mapping);
+        args.executed();
         binary_builder_t builder;
         builder.append32(result);
-        return result_t::respond(builder.build());
+        return result_t::respond(builder.release());
       };
 
     auto& calls = result.procedures;
-    calls.set(0, { "NULL", null_rpc });
-    calls.set(1, { "SET", set_rpc });
-    calls.set(2, { "UNSET", unset_rpc });
-    calls.set(3, { "GETPORT", get_port_rpc });
+    calls.set(0, { "NULL", null_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(1, { "SET", set_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(2, { "UNSET", unset_rpc, rpc_program_t::NO_REPLY_CACHE });
+    calls.set(3, { "GETPORT", get_port_rpc, rpc_program_t::NO_REPLY_CACHE });
     //calls.set(4, { "DUMP", dump_rpc });
     //calls.set(5, { "CALLIT", callit_rpc });
 
@@ -0,0 +1,68 @@
+#include "record_marking.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace record_marking {
+
+  uint8_t* reassembler_t::prepare(size_t size)
+  {
+    if (buffer_m.size() - write_m < size) {
+        // move the incomplete tail down instead of erasing every consumed record
+        auto live = live_begin();
+        if (0 < live) {
+            auto bytes = write_m - live;
+            if (0 < bytes) std::memmove(buffer_m.data(), buffer_m.data() + live, bytes);
+            read_m -= live;
+            write_m = bytes;
+            if (in_record_m) {
+                record_begin_m -= live;
+                record_end_m -= live;
+              }
+          }
+        if (buffer_m.size() - write_m < size) {
+            buffer_m.resize(std::max(2 * buffer_m.size(), write_m + size));
+          }
+      }
+    return buffer_m.data() + write_m;
+  }
+
+  reassembler_t::status_t reassembler_t::next(binary_reader_t& record)
+  {
+    while (write_m - read_m >= HEADER_SIZE) {
+        auto begin = buffer_m.data();
+        auto header = binary_reader_t(begin + read_m, begin + write_m).get32(0);
+        size_t fragment_size = header & FRAGMENT_SIZE_MASK;
+        if ( !in_record_m) {
+            record_begin_m = record_end_m = read_m + HEADER_SIZE; // first fragment stays in place
+          }
+        if (max_record_size_m < (record_end_m - record_begin_m) + fragment_size) return INVALID;
+        if (write_m - read_m - HEADER_SIZE < fragment_size) return NEED_MORE;
+
+        auto payload = read_m + HEADER_SIZE;
+        if (record_end_m != payload && 0 < fragment_size) {
+            // join with the earlier fragments by overwriting the header in between
+            std::memmove(begin + record_end_m, begin + payload, fragment_size);
+          }
+        record_end_m += fragment_size;
+        read_m = payload + fragment_size;
+
+        if (0 == (header & LAST_FRAGMENT)) {
+            in_record_m = true;
+            continue;
+          }
+        in_record_m = false;
+        record = binary_reader_t(begin + record_begin_m, begin + record_end_m);
+        return RECORD;
+      }
+    return NEED_MORE;
+  }
+
+  void reassembler_t::clear()
+  {
+    read_m = write_m = 0;
+    in_record_m = false;
+    record_begin_m = record_end_m = 0;
+  }
+
+} // namespace record_marking
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "binary/binary.h"
+#include "binary/binary_reader.h"
+
+#include <cstdint>
+
+/**
+ * @brief record marking for rpc over tcp according to RFC1057 section 10
+ *
+ * Every record is sent as one or more fragments. Each fragment is prefixed
+ * with a 32 bit header: highest bit marks the last fragment, the rest is the length.
+ */
+namespace record_marking {
+
+  enum : uint32_t {
+    LAST_FRAGMENT = 0x80000000,
+    FRAGMENT_SIZE_MASK = 0x7FFFFFFF,
+    HEADER_SIZE = 4,
+  };
+
+  /**
+   * @brief reassembles records from a byte stream received in arbitrary chunks
+   *
+   * Received bytes are written directly into a reusable buffer (prepare + commit).
+   * Fragments of one record are joined in place. Consumed bytes are never erased
+   * from the front: only an incomplete tail is moved down when more room is needed.
+   *
+   * A record returned by next() stays valid until prepare() is called again.
+   */
+  struct reassembler_t {
+    enum status_t {
+      NEED_MORE, // no complete record available
+      RECORD, // record extracted
+      INVALID, // record exceeds max_record_size - the stream is unusable
+    };
+
+    explicit reassembler_t(size_t max_record_size = 0xFFFFF)
+      : max_record_size_m(max_record_size)
+    {}
+
+    size_t max_record_size() const { return max_record_size_m; }
+    size_t buffered() const { return write_m - live_begin(); }
+    size_t capacity() const { return buffer_m.size(); }
+
+    // returns a writable area of at least size bytes at the end of the received data
+    uint8_t* prepare(size_t size);
+    // marks size bytes of the prepared area as received
+    void commit(size_t size) { write_m += size; }
+
+    status_t next(binary_reader_t& record);
+
+    void clear();
+
+  private:
+    size_t live_begin() const { return in_record_m ? record_begin_m : read_m; }
+
+  private:
+    size_t max_record_size_m;
+    binary_t buffer_m;
+    size_t read_m = 0; // next fragment header
+    size_t write_m = 0; // end of received data
+    bool in_record_m = false; // earlier fragments of the current record were consumed
+    size_t record_begin_m = 0; // joined payload of the current record
+    size_t record_end_m = 0;
+  };
+
+  // the record mark for a reply sent as a single fragment
+  inline uint32_t single_fragment_header(size_t size) {
+    return LAST_FRAGMENT | static_cast<uint32_t>(size);
+  }
+
+} // namespace record_marking
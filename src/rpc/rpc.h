@@ -2,11 +2,13 @@
 
 #include "binary/binary_reader.h"
 #include "binary/binary_builder.h"
+#include "binary/segmented_binary.h"
 
 #include "meta/variant.h"
 #include "xdr.h"
 
 #include <limits>
+#include <utility>
 #include <cassert>
 
 /**
@@ -147,32 +149,33 @@ namespace rpc
   };
 
   struct auth_accepted_reply_builder_t {
-    binary_t success(const binary_t& binary) {
+    // the result segments are sent after the reply header without copying them
+    segmented_binary_t success(segmented_binary_t&& result) {
       builder_m.append32(accept_stat_t::SUCCESS);
-      builder_m.append_binary(binary);
-      return builder_m.build();
+      result.prepend(builder_m.release());
+      return std::move(result);
     }
 
     binary_t program_unavailable() {
       builder_m.append32(accept_stat_t::PROG_UNAVAIL);
-      return builder_m.build();
+      return builder_m.release();
     }
 
     binary_t program_mismatch(const mismatch_info_t& mismatch) {
       builder_m.append32(accept_stat_t::PROG_MISMATCH);
       builder_m.append32(mismatch.low);
       builder_m.append32(mismatch.high);
-      return builder_m.build();
+      return builder_m.release();
     }
 
     binary_t procedure_unavailable() {
       builder_m.append32(accept_stat_t::PROC_UNAVAIL);
-      return builder_m.build();
+      return builder_m.release();
     }
 
     binary_t garbage_args() {
       builder_m.append32(accept_stat_t::GARBAGE_ARGS);
-      return builder_m.build();
+      return builder_m.release();
     }
 
     binary_builder_t builder_m;
@@ -197,13 +200,13 @@ namespace rpc
       builder_m.append32(reject_stat_t::RPC_MISMATCH);
       builder_m.append32(mismatch.low);
       builder_m.append32(mismatch.high);
-      return builder_m.build();
+      return builder_m.release();
     }
 
     binary_t auth_error(auth_stat_t auth_stat) {
       builder_m.append32(reject_stat_t::AUTH_ERROR);
       builder_m.append32(auth_stat);
-      return builder_m.build();
+      return builder_m.release();
     }
 
     binary_builder_t builder_m;
@@ -223,13 +226,28 @@ namespace rpc
     binary_builder_t builder_m;
   };
 
+  struct call_body_builder_t {
+    // calls without credentials
+    binary_t null_auth(uint32_t program, uint32_t version, uint32_t procedure, const binary_t& parameters) {
+      builder_m.append32(VERSION);
+      builder_m.append32(program);
+      builder_m.append32(version);
+      builder_m.append32(procedure);
+      write_auth_null(builder_m); // credential
+      write_auth_null(builder_m); // verifier
+      builder_m.append_binary(parameters);
+      return builder_m.release();
+    }
+
+    binary_builder_t builder_m;
+  };
+
   struct message_builder_t {
-    // TODO
-    //		call_body_builder_t call(uint32_t xid) {
-    //			builder_m.append32(xid);
-    //			builder_m.append32(msg_type_t::REPLY);
-    //			return { builder_m };
-    //		}
+    call_body_builder_t call(uint32_t xid) {
+      builder_m.append32(xid);
+      builder_m.append32(msg_type_t::CALL);
+      return { builder_m };
+    }
 
     reply_body_builder_t reply(uint32_t xid) {
       builder_m.append32(xid);
@@ -2,36 +2,64 @@
 
 #include "binary/binary.h"
 #include "binary/binary_reader.h"
+#include "binary/segmented_binary.h"
 
 #include "container/range_map.h"
 
+#include <chrono>
 #include <functional>
 #include <string>
+#include <utility>
 
 struct rpc_program_t {
   struct procedure_result_t {
     enum status_t { INVALID_ARGUMENTS, RESPONDED };
 
-    static procedure_result_t respond(const binary_t& binary) {
+    static procedure_result_t respond(binary_t binary) {
       procedure_result_t result;
       result.status = RESPONDED;
-      result.response = binary;
+      result.response.append(std::move(binary));
+      return result;
+    }
+
+    // large payloads stay in their own segments up to the gather send
+    static procedure_result_t respond_segmented(segmented_binary_t&& segments) {
+      procedure_result_t result;
+      result.status = RESPONDED;
+      result.response = std::move(segments);
       return result;
     }
 
     status_t status = INVALID_ARGUMENTS;
-    binary_t response;
+    segmented_binary_t response;
+  };
+
+  // ends of the decode and execute phases of a call - unmarked phases count as execute
+  struct phases_t {
+    using clock_t = std::chrono::steady_clock;
+    clock_t::time_point decoded;
+    clock_t::time_point executed;
   };
 
   struct procedure_args_t {
     std::string sender;
     binary_reader_t parameter_reader;
+    phases_t* phases = nullptr;
+    size_t max_reply_size = 0; // of the transport - 0 if unbounded
+
+    // marked by the procedures after decoding the arguments and executing the call
+    void decoded() const { if (phases) phases->decoded = phases_t::clock_t::now(); }
+    void executed() const { if (phases) phases->executed = phases_t::clock_t::now(); }
   };
   using procedure_callback_t = std::function<procedure_result_t (procedure_args_t&)>;
 
+  // non idempotent procedures answer retransmissions from the duplicate request cache
+  enum reply_cache_t { NO_REPLY_CACHE, CACHE_REPLY };
+
   struct procedure_t {
     const char* name /*= nullptr*/; // defaulting would inhibit VS from creating default constructor
     procedure_callback_t callback;
+    reply_cache_t reply_cache; // not defaulted either - every procedure spells it out
   };
   using procedure_map_t = range_map_t<procedure_t>;
 
@@ -2,37 +2,49 @@
 
 #include "rpc.h"
 
-#define DEBUG_RPC_ROUTER
+#include "logging/logger.h"
 
-#ifdef DEBUG_RPC_ROUTER
-#include <iostream>
-#endif
+#include <string>
 
-binary_t rpc_router_t::handle(const router_args_t& server_args) const
+namespace {
+  std::string procedure_name(const rpc_program_t::procedure_t& procedure, uint32_t id) {
+    return procedure.name ? procedure.name : std::to_string(id);
+  }
+} // namespace
+
+segmented_binary_t rpc_router_t::handle(const router_args_t& server_args) const
 {
   using procedure_args_t = rpc_program_t::procedure_args_t;
   using procedure_result_t = rpc_program_t::procedure_result_t;
+  using timing_t = rpc_stats_t::timing_t;
+
+  timing_t timing;
+  timing.start = rpc_stats_t::clock_t::now();
 
   auto message_reader = rpc::message_reader(server_args.request_reader);
   if ( !message_reader.valid()) {
-      std::cout << "RPC_ROUTER invalid request" << std::endl;
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER invalid request";
+      stats_m.reject();
       return {}; // no message - no reply
     }
   auto message = message_reader.read();
   if ( !message.body_reader.is<rpc::call_body_reader_t>()) {
-      std::cout << "RPC_ROUTER invalid message" << std::endl;
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER invalid message";
+      stats_m.reject();
       return {}; // no call - no reply
     }
 
   auto call_body_reader = message.body_reader.get<rpc::call_body_reader_t>();
   if ( !call_body_reader.valid()) {
-      std::cout << "RPC_ROUTER invalid call body" << std::endl;
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER invalid call body";
+      stats_m.reject();
       return {}; // failed to read body - no reply
     }
   auto reply = rpc::message_builder().reply(message.xid);
   auto call_body = call_body_reader.read();
   if (call_body.rpc_version != rpc::VERSION) {
-      std::cout << "RPC_ROUTER invalid RPC version" << std::endl;
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER invalid RPC version";
+      stats_m.reject();
       return reply.reject().mismatch({ rpc::VERSION, rpc::VERSION });
     }
   auto accept_reply = reply.accept();
@@ -42,39 +54,78 @@ binary_t rpc_router_t::handle(const router_args_t& server_args) const
   // find the procedure to call
   auto program_it = program_map_m.find(call_body.program);
   if (program_it == program_map_m.end()) {
-      std::cout << "RPC_ROUTER unkown program: " << call_body.program << " v" << call_body.version << std::endl;
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER unkown program: " << call_body.program << " v" << call_body.version;
+      stats_m.reject();
       return auth_reply.program_unavailable();
     }
   auto& version_map = program_it->second;
   if (! version_map.contains(call_body.version)) {
-      std::cout << "RPC_ROUTER unkown program version: " << call_body.program << " v" << call_body.version << std::endl;
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER unkown program version: " << call_body.program << " v" << call_body.version;
+      stats_m.reject();
       return auth_reply.program_mismatch({version_map.range_start(), version_map.range_end() - 1});
     }
-  auto& procedure_map = version_map[call_body.version];
+  auto& version = version_map[call_body.version];
+  auto& procedure_map = version.procedures;
   if (! procedure_map.contains(call_body.procedure)) {
-      std::cout << "RPC_ROUTER unkown procedure in program: " << call_body.program << " v" << call_body.version << " procedure: " << call_body.procedure << std::endl;
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER unkown procedure in program: " << call_body.program << " v" << call_body.version << " procedure: " << call_body.procedure;
+      stats_m.reject();
       return auth_reply.procedure_unavailable();
     }
 
   auto& procedure = procedure_map[call_body.procedure];
   if (! procedure.callback || ! procedure.name) {
-      std::cout << "RPC_ROUTER unkown procedure in program: " << call_body.program << " v" << call_body.version << " procedure: ";
-      if (procedure.name) std::cout << procedure.name; else std::cout << call_body.procedure;
-      std::cout << std::endl;
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER unkown procedure in program: " << call_body.program << " v" << call_body.version
+                             << " procedure: " << procedure_name(procedure, call_body.procedure);
+      stats_m.reject();
       return auth_reply.procedure_unavailable();
     }
-  procedure_args_t procedure_args { server_args.sender, call_body.parameter_reader };
+
+  // retransmissions of non idempotent calls are not executed again
+  duplicate_cache_t::key_t duplicate_key;
+  auto cache_reply = procedure.reply_cache == rpc_program_t::CACHE_REPLY && duplicates_m.enabled();
+  if (cache_reply) {
+      duplicate_key = duplicate_cache_t::key(server_args.sender, message.xid, call_body.program, call_body.version,
+                                             call_body.procedure, call_body.parameter_reader);
+      binary_t cached;
+      switch (duplicates_m.begin(duplicate_key, cached)) {
+        case duplicate_cache_t::NEW: break;
+        case duplicate_cache_t::IN_PROGRESS: return {}; // the client retransmits again
+        case duplicate_cache_t::COMPLETED: return segmented_binary_t(std::move(cached));
+        }
+    }
+
+  auto slot = version.first_slot + (call_body.procedure - procedure_map.range_start());
+  stats_m.begin(slot);
+  rpc_program_t::phases_t phases;
+  procedure_args_t procedure_args { server_args.sender, call_body.parameter_reader, &phases, server_args.max_reply_size };
   auto procedure_result = procedure.callback(procedure_args);
-  if (procedure_result.status == procedure_result_t::INVALID_ARGUMENTS) {
-      std::cout << "RPC_ROUTER garbage args: " << call_body.program << " v" << call_body.version << " procedure: ";
-      if (procedure.name) std::cout << procedure.name; else std::cout << call_body.procedure;
-      std::cout << std::endl;
-      return auth_reply.garbage_args();
+  auto valid = procedure_result.status != procedure_result_t::INVALID_ARGUMENTS;
+  segmented_binary_t result;
+  if (valid) {
+      result = auth_reply.success(std::move(procedure_result.response));
+    }
+  else {
+      LOG_AT(WARNING, "rpc") << "RPC_ROUTER garbage args: " << call_body.program << " v" << call_body.version
+                             << " procedure: " << procedure_name(procedure, call_body.procedure);
+      result = auth_reply.garbage_args();
     }
-  return auth_reply.success(procedure_result.response);
+  // with marks the rpc header counts to decode and encode, without them to execute
+  timing.end = rpc_stats_t::clock_t::now();
+  timing.decoded = phases.decoded == rpc_stats_t::time_point_t() ? timing.start : phases.decoded;
+  timing.executed = phases.executed == rpc_stats_t::time_point_t() ? timing.end : phases.executed;
+  stats_m.end(slot, timing, server_args.request_reader.size(), result.size(), valid);
+  if (cache_reply) duplicates_m.complete(duplicate_key, result.flatten());
+  return result;
 }
 
 void rpc_router_t::add(const rpc_program_t &program)
 {
-  program_map_m[program.id].set(program.version, program.procedures);
+  version_t version;
+  version.procedures = program.procedures;
+  auto& procedures = version.procedures;
+  for (auto procedure = procedures.range_start(); procedure < procedures.range_end(); ++procedure) {
+      auto slot = stats_m.add(program.id, program.version, procedure, procedures[procedure].name);
+      if (procedure == procedures.range_start()) version.first_slot = slot;
+    }
+  program_map_m[program.id].set(program.version, version);
 }
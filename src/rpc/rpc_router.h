@@ -1,6 +1,8 @@
 #pragma once
 
 #include "rpc_program.h"
+#include "rpc_stats.h"
+#include "duplicate_cache.h"
 
 #include "container/range_map.h"
 
@@ -10,18 +12,33 @@ struct router_args_t
 {
   std::string sender;
   binary_reader_t request_reader;
+  size_t max_reply_size = 0; // a reply has to fit into one datagram - 0 for record transports
 };
 
 struct rpc_router_t
 {
-  binary_t handle(const router_args_t&) const;
+  explicit rpc_router_t(const duplicate_cache_t::config_t& duplicates = duplicate_cache_t::config_t())
+    : duplicates_m(duplicates)
+  {}
+
+  segmented_binary_t handle(const router_args_t&) const;
 
   void add(const rpc_program_t&);
 
+  rpc_stats_t::snapshot_t stats() const { return stats_m.snapshot(); }
+  duplicate_cache_t::stats_t duplicate_stats() const { return duplicates_m.stats(); }
+
 private:
   using procedure_map_t = rpc_program_t::procedure_map_t;
-  using version_map_t = range_map_t<procedure_map_t>;
+
+  struct version_t {
+    procedure_map_t procedures;
+    size_t first_slot = 0; // of the stats of the first procedure
+  };
+  using version_map_t = range_map_t<version_t>;
   using program_map_t = std::map<uint32_t, version_map_t>;
 
   program_map_t program_map_m;
+  mutable rpc_stats_t stats_m;
+  mutable duplicate_cache_t duplicates_m;
 };
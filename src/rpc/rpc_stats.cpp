@@ -0,0 +1,143 @@
+#include "rpc_stats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace {
+  // threads are numbered once and spread over the shards in order
+  size_t thread_shard() {
+    static std::atomic<size_t> next_thread {0};
+    thread_local size_t shard = next_thread.fetch_add(1, std::memory_order_relaxed) % rpc_stats_t::SHARDS;
+    return shard;
+  }
+
+  double microseconds(latency_histogram_t::duration_t duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  }
+
+  void write_percentiles(std::ostream& out, const char* phase, const latency_histogram_t& histogram) {
+    out << " " << phase << " p50: " << microseconds(histogram.percentile(50))
+        << " p99: " << microseconds(histogram.percentile(99))
+        << " p999: " << microseconds(histogram.percentile(99.9))
+        << " max: " << microseconds(histogram.max());
+  }
+} // namespace
+
+rpc_stats_t::shard_t::shard_t(size_t slot_count)
+  : slots(new slot_t[slot_count]())
+  , rejected(0)
+{}
+
+rpc_stats_t::~rpc_stats_t()
+{
+  for (auto& shard : shards_m) delete shard.load();
+}
+
+size_t rpc_stats_t::add(uint32_t program, uint32_t version, uint32_t procedure, const char* name)
+{
+  procedures_m.push_back({ program, version, procedure, name });
+  return procedures_m.size() - 1;
+}
+
+rpc_stats_t::shard_t& rpc_stats_t::shard()
+{
+  auto& entry = shards_m[thread_shard()];
+  auto shard = entry.load(std::memory_order_acquire);
+  if (shard) return *shard;
+  std::unique_ptr<shard_t> created(new shard_t(procedures_m.size()));
+  if (entry.compare_exchange_strong(shard, created.get(), std::memory_order_acq_rel)) return *created.release();
+  return *shard; // another thread of this shard was first
+}
+
+void rpc_stats_t::begin(size_t slot)
+{
+  shard().slots[slot].in_flight.fetch_add(1, std::memory_order_relaxed);
+}
+
+void rpc_stats_t::end(size_t slot, const timing_t& timing, size_t bytes_in, size_t bytes_out, bool valid)
+{
+  auto& stats = shard().slots[slot];
+  stats.in_flight.fetch_sub(1, std::memory_order_relaxed);
+  stats.calls.fetch_add(1, std::memory_order_relaxed);
+  if ( !valid) stats.errors.fetch_add(1, std::memory_order_relaxed);
+  stats.bytes_in.fetch_add(bytes_in, std::memory_order_relaxed);
+  stats.bytes_out.fetch_add(bytes_out, std::memory_order_relaxed);
+  record(stats.phases[TOTAL], timing.end - timing.start);
+  record(stats.phases[DECODE], timing.decoded - timing.start);
+  record(stats.phases[EXECUTE], timing.executed - timing.decoded);
+  record(stats.phases[ENCODE], timing.end - timing.executed);
+}
+
+void rpc_stats_t::reject()
+{
+  shard().rejected.fetch_add(1, std::memory_order_relaxed);
+}
+
+void rpc_stats_t::record(histogram_t& histogram, clock_t::duration duration)
+{
+  auto value = latency_histogram_t::value(std::chrono::duration_cast<latency_histogram_t::duration_t>(duration));
+  histogram.buckets[latency_histogram_t::bucket(value)].fetch_add(1, std::memory_order_relaxed);
+  auto max = histogram.max.load(std::memory_order_relaxed);
+  while (max < value && !histogram.max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+rpc_stats_t::snapshot_t rpc_stats_t::snapshot() const
+{
+  snapshot_t result;
+  std::vector<procedure_stats_t> procedures(procedures_m.size());
+  for (const auto& entry : shards_m) {
+      auto shard = entry.load(std::memory_order_acquire);
+      if ( !shard) continue;
+      result.rejected += shard->rejected.load(std::memory_order_relaxed);
+      for (size_t slot = 0; slot < procedures.size(); ++slot) {
+          auto& stats = shard->slots[slot];
+          auto& sum = procedures[slot];
+          sum.calls += stats.calls.load(std::memory_order_relaxed);
+          sum.errors += stats.errors.load(std::memory_order_relaxed);
+          sum.in_flight += stats.in_flight.load(std::memory_order_relaxed);
+          sum.bytes_in += stats.bytes_in.load(std::memory_order_relaxed);
+          sum.bytes_out += stats.bytes_out.load(std::memory_order_relaxed);
+          latency_histogram_t* histograms[PHASES] = { &sum.total, &sum.decode, &sum.execute, &sum.encode };
+          for (size_t phase = 0; phase < PHASES; ++phase) {
+              auto& histogram = stats.phases[phase];
+              for (size_t bucket = 0; bucket < histogram.buckets.size(); ++bucket) {
+                  histograms[phase]->add_bucket(bucket, histogram.buckets[bucket].load(std::memory_order_relaxed));
+                }
+              histograms[phase]->add_max(latency_histogram_t::duration_t(histogram.max.load(std::memory_order_relaxed)));
+            }
+        }
+    }
+  for (size_t slot = 0; slot < procedures.size(); ++slot) {
+      auto& procedure = procedures[slot];
+      if (0 == procedure.calls && 0 == procedure.in_flight) continue;
+      procedure.program = procedures_m[slot].program;
+      procedure.version = procedures_m[slot].version;
+      procedure.procedure = procedures_m[slot].procedure;
+      procedure.name = procedures_m[slot].name;
+      result.procedures.push_back(std::move(procedure));
+    }
+  return result;
+}
+
+void rpc_stats_t::write(std::ostream& out, const snapshot_t& snapshot)
+{
+  auto flags = out.flags();
+  auto precision = out.precision();
+  out << std::fixed << std::setprecision(1);
+  for (const auto& procedure : snapshot.procedures) {
+      out << procedure.program << " v" << procedure.version << " ";
+      if (procedure.name) out << procedure.name; else out << procedure.procedure;
+      out << " calls: " << procedure.calls << " errors: " << procedure.errors
+          << " in flight: " << procedure.in_flight
+          << " bytes in: " << procedure.bytes_in << " out: " << procedure.bytes_out;
+      write_percentiles(out, "total us", procedure.total);
+      write_percentiles(out, "decode", procedure.decode);
+      write_percentiles(out, "execute", procedure.execute);
+      write_percentiles(out, "encode", procedure.encode);
+      out << std::endl;
+    }
+  out << "rejected calls: " << snapshot.rejected << std::endl;
+  out.flags(flags);
+  out.precision(precision);
+}
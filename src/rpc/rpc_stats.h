@@ -0,0 +1,114 @@
+#pragma once
+
+#include "container/latency_histogram.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief counters and latency histograms per routed procedure
+ *
+ * Every thread records into its own shard with relaxed atomics, so recording never
+ * locks or shares cache lines with other threads. Shards are allocated on the first
+ * call of a thread. snapshot() adds up all shards - counters of calls still running
+ * may be missing from it.
+ *
+ * All procedures are added before the first call is recorded.
+ */
+struct rpc_stats_t {
+  using clock_t = std::chrono::steady_clock;
+  using time_point_t = clock_t::time_point;
+
+  enum : size_t { SHARDS = 16 };
+
+  // points in time of one call
+  struct timing_t {
+    time_point_t start;
+    time_point_t decoded;
+    time_point_t executed;
+    time_point_t end;
+  };
+
+  struct procedure_stats_t {
+    uint32_t program = 0;
+    uint32_t version = 0;
+    uint32_t procedure = 0;
+    const char* name = nullptr;
+
+    uint64_t calls = 0;
+    uint64_t errors = 0; // garbage arguments
+    int64_t in_flight = 0;
+    uint64_t bytes_in = 0; // whole rpc messages
+    uint64_t bytes_out = 0;
+
+    latency_histogram_t total;
+    latency_histogram_t decode;
+    latency_histogram_t execute;
+    latency_histogram_t encode;
+  };
+
+  struct snapshot_t {
+    std::vector<procedure_stats_t> procedures; // that were called
+    uint64_t rejected = 0; // invalid messages and unavailable programs or procedures
+  };
+
+  rpc_stats_t() = default;
+  rpc_stats_t(const rpc_stats_t&) = delete;
+  rpc_stats_t& operator= (const rpc_stats_t&) = delete;
+  ~rpc_stats_t();
+
+  // returns the slot of the procedure
+  size_t add(uint32_t program, uint32_t version, uint32_t procedure, const char* name);
+
+  void begin(size_t slot);
+  void end(size_t slot, const timing_t&, size_t bytes_in, size_t bytes_out, bool valid);
+  void reject();
+
+  snapshot_t snapshot() const;
+
+  // one line per procedure with the counters and latency percentiles in microseconds
+  static void write(std::ostream&, const snapshot_t&);
+
+private:
+  enum phase_t { TOTAL, DECODE, EXECUTE, ENCODE, PHASES };
+
+  struct histogram_t {
+    std::array<std::atomic<uint64_t>, latency_histogram_t::BUCKETS> buckets;
+    std::atomic<uint64_t> max;
+  };
+
+  struct slot_t {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> errors;
+    std::atomic<int64_t> in_flight;
+    std::atomic<uint64_t> bytes_in;
+    std::atomic<uint64_t> bytes_out;
+    std::array<histogram_t, PHASES> phases;
+  };
+
+  struct shard_t {
+    explicit shard_t(size_t slots);
+
+    std::unique_ptr<slot_t[]> slots;
+    std::atomic<uint64_t> rejected;
+  };
+
+  struct procedure_t {
+    uint32_t program;
+    uint32_t version;
+    uint32_t procedure;
+    const char* name;
+  };
+
+  shard_t& shard();
+  static void record(histogram_t&, clock_t::duration);
+
+private:
+  std::vector<procedure_t> procedures_m;
+  std::array<std::atomic<shard_t*>, SHARDS> shards_m = {};
+};
@@ -2,10 +2,12 @@
 
 #include "binary/binary_reader.h"
 #include "binary/binary_builder.h"
+#include "binary/segmented_binary.h"
 
 #include <limits>
 #include <cassert>
 #include <string>
+#include <utility>
 
 namespace xdr {
   using string_t = std::string;
@@ -55,11 +57,10 @@ namespace xdr {
   }
 
   inline void write_opaque(binary_builder_t& builder, const uint8_t* data, size_t size) {
+    static const uint8_t padding[4] = {};
     builder.append32(size);
     builder.append_binary(data, size);
-    for (; (size & 3) != 0; ++size) {
-        builder.append8(0); // align to 4 bytes
-      }
+    builder.append_binary(padding, (4 - (size & 3)) & 3); // align to 4 bytes
   }
 
   template<size_t max_size = std::numeric_limits<size_t>::max()>
@@ -69,6 +70,21 @@ namespace xdr {
     return (size <= max_size);
   }
 
+  /**
+   * @brief writes the opaque data as its own segment
+   *
+   * the builder content up to the length becomes the segment before the data,
+   * the builder is empty afterwards
+   */
+  inline void write_opaque_segment(segmented_binary_t& segments, binary_builder_t& builder, binary_t&& binary) {
+    static const uint8_t padding[4] = {};
+    auto size = binary.size();
+    builder.append32(size);
+    segments.append(builder.release());
+    segments.append(std::move(binary));
+    segments.append_borrowed(padding, (4 - (size & 3)) & 3); // align to 4 bytes
+  }
+
   template<size_t max_size = std::numeric_limits<size_t>::max()>
   bool write_opaque_string(binary_builder_t& builder, const std::string& str) {
     auto size = std::min(max_size, str.size());
@@ -0,0 +1,360 @@
+#pragma once
+
+#include "binary/binary.h"
+#include "binary/binary_reader.h"
+#include "binary/binary_builder.h"
+
+#include "meta/variant.h"
+
+#include <array>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <initializer_list>
+
+/**
+ * @brief compile time description of xdr types according to RFC1014
+ *
+ * A struct is described by specializing schema_t with a static fields() function
+ * that lists its members in wire order:
+ *
+ *   template<> struct schema_t<read_args_t> {
+ *     static auto fields() {
+ *       return xdr::fields(xdr::opaque<FILEHANDLE_SIZE>(&read_args_t::filehandle),
+ *                          &read_args_t::offset, &read_args_t::count);
+ *     }
+ *   };
+ *
+ * decode() and encode() walk the fields once from front to back.
+ * Decoding uses a bounds checked cursor and only allocates for the decoded values.
+ */
+namespace xdr {
+
+  template<typename value_t>
+  struct schema_t; // specialize for structs
+
+  template<typename value_t, typename = void>
+  struct codec_t; // specialize for wire types
+
+  template<typename value_t>
+  bool decode_value(binary_cursor_t& cursor, value_t& value) { return codec_t<value_t>::decode(cursor, value); }
+
+  template<typename value_t>
+  void encode_value(binary_builder_t& builder, const value_t& value) { codec_t<value_t>::encode(builder, value); }
+
+  // ---- wire types ----
+
+  template<>
+  struct codec_t<uint32_t> {
+    static bool decode(binary_cursor_t& cursor, uint32_t& value) { value = cursor.get32(); return cursor.valid(); }
+    static void encode(binary_builder_t& builder, uint32_t value) { builder.append32(value); }
+  };
+
+  template<>
+  struct codec_t<uint64_t> {
+    static bool decode(binary_cursor_t& cursor, uint64_t& value) { value = cursor.get64(); return cursor.valid(); }
+    static void encode(binary_builder_t& builder, uint64_t value) { builder.append64(value); }
+  };
+
+  template<>
+  struct codec_t<bool> {
+    static bool decode(binary_cursor_t& cursor, bool& value) { value = 0 != cursor.get32(); return cursor.valid(); }
+    static void encode(binary_builder_t& builder, bool value) { builder.append32(value ? 1u : 0u); }
+  };
+
+  // enums are 32 bit on the wire
+  template<typename enum_t>
+  struct codec_t<enum_t, typename std::enable_if<std::is_enum<enum_t>::value>::type> {
+    static bool decode(binary_cursor_t& cursor, enum_t& value) { value = static_cast<enum_t>(cursor.get32()); return cursor.valid(); }
+    static void encode(binary_builder_t& builder, enum_t value) { builder.append32(static_cast<uint32_t>(value)); }
+  };
+
+  // fixed size opaque
+  template<size_t size>
+  struct codec_t<std::array<uint8_t, size>> {
+    enum : size_t { PADDING = (4 - (size & 3)) & 3 };
+    static bool decode(binary_cursor_t& cursor, std::array<uint8_t, size>& value) {
+      return cursor.get_binary(value) && cursor.skip(PADDING);
+    }
+    static void encode(binary_builder_t& builder, const std::array<uint8_t, size>& value) {
+      static const uint8_t padding[4] = {};
+      builder.append_binary(value);
+      builder.append_binary(padding, PADDING);
+    }
+  };
+
+  // variable size opaque or string with a maximum size
+  template<typename value_t, size_t max_size>
+  struct opaque_codec_t {
+    static bool decode(binary_cursor_t& cursor, value_t& value) {
+      auto size = cursor.get32();
+      if ( !cursor.valid() || size > max_size) return false;
+      auto data = cursor.get_reader(size);
+      if ( !cursor.valid() || !cursor.align4()) return false;
+      auto begin = reinterpret_cast<const typename value_t::value_type*>(data.data());
+      value.assign(begin, begin + size);
+      return true;
+    }
+    static void encode(binary_builder_t& builder, const value_t& value) {
+      static const uint8_t padding[4] = {};
+      auto size = value.size() < max_size ? value.size() : max_size;
+      builder.append32(static_cast<uint32_t>(size));
+      if (size > 0) builder.append_binary(reinterpret_cast<const uint8_t*>(&value[0]), size);
+      builder.append_binary(padding, (4 - (size & 3)) & 3);
+    }
+  };
+
+  template<>
+  struct codec_t<binary_t> : opaque_codec_t<binary_t, std::numeric_limits<uint32_t>::max()> {};
+
+  template<>
+  struct codec_t<std::string> : opaque_codec_t<std::string, std::numeric_limits<uint32_t>::max()> {};
+
+  // optional data is a union with a bool discriminant
+  template<typename value_t>
+  struct codec_t<meta::optional_t<value_t>> {
+    static bool decode(binary_cursor_t& cursor, meta::optional_t<value_t>& value) {
+      bool present;
+      if ( !decode_value(cursor, present)) return false;
+      if ( !present) {
+          value = meta::optional_t<value_t>();
+          return true;
+        }
+      value_t present_value;
+      if ( !codec_t<value_t>::decode(cursor, present_value)) return false;
+      value.set(std::move(present_value));
+      return true;
+    }
+    static void encode(binary_builder_t& builder, const meta::optional_t<value_t>& value) {
+      auto present = value.template is<value_t>();
+      encode_value(builder, present);
+      if (present) codec_t<value_t>::encode(builder, value.template get<value_t>());
+    }
+  };
+
+  // linked list (the *next pointer style used by READDIR) stored as vector
+  template<typename value_t, typename element_codec_t = codec_t<value_t>>
+  struct list_codec_t {
+    static bool decode(binary_cursor_t& cursor, std::vector<value_t>& list) {
+      list.clear();
+      while (true) {
+          bool next;
+          if ( !decode_value(cursor, next)) return false;
+          if ( !next) return true;
+          list.emplace_back();
+          if ( !element_codec_t::decode(cursor, list.back())) return false;
+        }
+    }
+    static void encode(binary_builder_t& builder, const std::vector<value_t>& list) {
+      for (const auto& value : list) {
+          builder.append32(1u);
+          element_codec_t::encode(builder, value);
+        }
+      builder.append32(0u);
+    }
+  };
+
+  // ---- struct fields ----
+
+  // member encoded with a codec
+  template<typename object_t, typename member_t, typename member_codec_t = codec_t<member_t>>
+  struct field_t {
+    member_t object_t::* member;
+
+    bool decode(binary_cursor_t& cursor, object_t& object) const { return member_codec_t::decode(cursor, object.*member); }
+    void encode(binary_builder_t& builder, const object_t& object) const { member_codec_t::encode(builder, object.*member); }
+  };
+
+  // member stored wider than on the wire (e.g. 64 bit seconds sent as 32 bit)
+  template<typename wire_t, typename object_t, typename member_t>
+  struct as_field_t {
+    member_t object_t::* member;
+
+    bool decode(binary_cursor_t& cursor, object_t& object) const {
+      wire_t value;
+      if ( !decode_value(cursor, value)) return false;
+      object.*member = static_cast<member_t>(value);
+      return true;
+    }
+    void encode(binary_builder_t& builder, const object_t& object) const { encode_value(builder, static_cast<wire_t>(object.*member)); }
+  };
+
+  // optional member that is always present in the selected union arm
+  template<typename object_t, typename value_t>
+  struct present_field_t {
+    meta::optional_t<value_t> object_t::* member;
+
+    bool decode(binary_cursor_t& cursor, object_t& object) const {
+      value_t value;
+      if ( !codec_t<value_t>::decode(cursor, value)) return false;
+      (object.*member).set(std::move(value));
+      return true;
+    }
+    void encode(binary_builder_t& builder, const object_t& object) const {
+      const auto& member_value = object.*member;
+      codec_t<value_t>::encode(builder, member_value.template is<value_t>() ? member_value.template get<value_t>() : value_t());
+    }
+  };
+
+  namespace details {
+    template<typename object_t, typename fields_t, size_t... index>
+    bool decode_fields(binary_cursor_t& cursor, object_t& object, const fields_t& fields, std::index_sequence<index...>) {
+      bool valid = true;
+      (void)std::initializer_list<int>{ (valid = valid && std::get<index>(fields).decode(cursor, object), 0)... };
+      return valid;
+    }
+
+    template<typename object_t, typename fields_t, size_t... index>
+    void encode_fields(binary_builder_t& builder, const object_t& object, const fields_t& fields, std::index_sequence<index...>) {
+      (void)std::initializer_list<int>{ (std::get<index>(fields).encode(builder, object), 0)... };
+    }
+
+    template<typename object_t, typename... field_t>
+    bool decode_fields(binary_cursor_t& cursor, object_t& object, const std::tuple<field_t...>& fields) {
+      return decode_fields(cursor, object, fields, std::index_sequence_for<field_t...>());
+    }
+
+    template<typename object_t, typename... field_t>
+    void encode_fields(binary_builder_t& builder, const object_t& object, const std::tuple<field_t...>& fields) {
+      encode_fields(builder, object, fields, std::index_sequence_for<field_t...>());
+    }
+
+    // plain member pointers become fields with the default codec
+    template<typename object_t, typename member_t>
+    field_t<object_t, member_t> as_field(member_t object_t::* member) { return { member }; }
+
+    template<typename field_t>
+    field_t as_field(const field_t& field) { return field; }
+  } // namespace details
+
+  template<typename... field_t>
+  auto fields(const field_t&... field) {
+    return std::make_tuple(details::as_field(field)...);
+  }
+
+  template<size_t max_size, typename object_t, typename member_t>
+  field_t<object_t, member_t, opaque_codec_t<member_t, max_size>> opaque(member_t object_t::* member) { return { member }; }
+
+  template<typename object_t, typename value_t>
+  field_t<object_t, std::vector<value_t>, list_codec_t<value_t>> list(std::vector<value_t> object_t::* member) { return { member }; }
+
+  template<typename wire_t, typename object_t, typename member_t>
+  as_field_t<wire_t, object_t, member_t> as(member_t object_t::* member) { return { member }; }
+
+  template<typename object_t, typename value_t>
+  present_field_t<object_t, value_t> present(meta::optional_t<value_t> object_t::* member) { return { member }; }
+
+  // ---- discriminated unions ----
+
+  // union arm with the fields sent for one discriminant value
+  template<typename discriminant_t, typename fields_t>
+  struct arm_t {
+    bool is_default;
+    discriminant_t value;
+    fields_t fields;
+
+    bool matches(discriminant_t discriminant) const { return is_default || value == discriminant; }
+  };
+
+  template<typename discriminant_t, typename... field_t>
+  auto when(discriminant_t value, const field_t&... field) {
+    auto arm_fields = fields(field...);
+    return arm_t<discriminant_t, decltype(arm_fields)>{ false, value, arm_fields };
+  }
+
+  // arm for all other discriminant values - has to be the last arm
+  template<typename discriminant_t, typename... field_t>
+  auto otherwise(const field_t&... field) {
+    auto arm_fields = fields(field...);
+    return arm_t<discriminant_t, decltype(arm_fields)>{ true, discriminant_t(), arm_fields };
+  }
+
+  template<typename object_t, typename discriminant_t, typename... arm_t>
+  struct union_field_t {
+    discriminant_t object_t::* discriminant;
+    std::tuple<arm_t...> arms;
+
+    bool decode(binary_cursor_t& cursor, object_t& object) const {
+      if ( !decode_value(cursor, object.*discriminant)) return false;
+      return decode_arm(cursor, object, std::index_sequence_for<arm_t...>());
+    }
+    void encode(binary_builder_t& builder, const object_t& object) const {
+      encode_value(builder, object.*discriminant);
+      encode_arm(builder, object, std::index_sequence_for<arm_t...>());
+    }
+
+  private:
+    // the first matching arm is used, no matching arm means void
+    template<size_t... index>
+    bool decode_arm(binary_cursor_t& cursor, object_t& object, std::index_sequence<index...>) const {
+      auto value = object.*discriminant;
+      bool done = false, valid = true;
+      (void)std::initializer_list<int>{ (!done && std::get<index>(arms).matches(value)
+          ? (done = true, valid = details::decode_fields(cursor, object, std::get<index>(arms).fields), 0) : 0)... };
+      return valid;
+    }
+    template<size_t... index>
+    void encode_arm(binary_builder_t& builder, const object_t& object, std::index_sequence<index...>) const {
+      auto value = object.*discriminant;
+      bool done = false;
+      (void)std::initializer_list<int>{ (!done && std::get<index>(arms).matches(value)
+          ? (done = true, details::encode_fields(builder, object, std::get<index>(arms).fields), 0) : 0)... };
+    }
+  };
+
+  template<typename object_t, typename discriminant_t, typename... arm_t>
+  union_field_t<object_t, discriminant_t, arm_t...> discriminated(discriminant_t object_t::* discriminant, const arm_t&... arm) {
+    return { discriminant, std::make_tuple(arm...) };
+  }
+
+  // structs described by schema_t
+  template<typename value_t, typename>
+  struct codec_t {
+    static bool decode(binary_cursor_t& cursor, value_t& value) {
+      return details::decode_fields(cursor, value, schema_t<value_t>::fields());
+    }
+    static void encode(binary_builder_t& builder, const value_t& value) {
+      details::encode_fields(builder, value, schema_t<value_t>::fields());
+    }
+  };
+
+  // ---- entry points ----
+
+  // single pass decode of the whole value, false if the data is truncated or invalid
+  template<typename value_t>
+  bool decode(const binary_reader_t& reader, value_t& value) {
+    binary_cursor_t cursor(reader);
+    return decode_value(cursor, value);
+  }
+
+  // decode with an explicit codec (e.g. an opaque with a maximum size)
+  template<typename value_codec_t, typename value_t>
+  bool decode_with(const binary_reader_t& reader, value_t& value) {
+    binary_cursor_t cursor(reader);
+    return value_codec_t::decode(cursor, value);
+  }
+
+  template<typename value_t>
+  void encode(binary_builder_t& builder, const value_t& value) {
+    encode_value(builder, value);
+  }
+
+  template<typename value_t>
+  binary_t to_binary(const value_t& value, size_t reserve = 0) {
+    binary_builder_t builder;
+    builder.reserve(reserve);
+    encode_value(builder, value);
+    return builder.release();
+  }
+
+  template<typename value_codec_t, typename value_t>
+  binary_t to_binary_with(const value_t& value) {
+    binary_builder_t builder;
+    value_codec_t::encode(builder, value);
+    return builder.release();
+  }
+
+} // namespace xdr
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+struct connection_stats_t {
+  size_t connections = 0;
+  size_t hosts = 0;
+  size_t max_per_host = 0;
+  size_t memory = 0; // bytes of all connections
+  size_t max_memory = 0; // of one connection
+  uint64_t accepted = 0;
+  uint64_t replaced = 0; // the sender reconnected
+  uint64_t reaped = 0; // were idle
+};
+
+/**
+ * @brief accepted connections of a server
+ *
+ * Any number of connections per host - clients mounting with nconnect or several mounts
+ * open one connection each. Only a connection from the same address and port replaces
+ * an older one, which can no longer be alive.
+ *
+ * All methods are thread safe. connection_t provides:
+ *   const std::string& sender() const; // address:port
+ *   const std::string& host() const;
+ *   bool idle_since(clock_t::time_point) const; // no call was received, running or sent after
+ *   size_t memory() const; // buffered bytes
+ *   void shutdown(); // safe from any thread - the owner closes and removes the connection
+ */
+template<typename connection_t>
+struct connection_table_t {
+  using connection_ptr_t = std::shared_ptr<connection_t>;
+  using clock_t = std::chrono::steady_clock;
+
+  using stats_t = connection_stats_t;
+
+  // returns the replaced connection of the same sender - to be shut down by the caller
+  connection_ptr_t insert(const connection_ptr_t& connection) {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    ++accepted_m;
+    connection_ptr_t replaced;
+    auto& sender = senders_m[connection->sender()];
+    if (sender) {
+        auto it = connections_m.find(sender);
+        if (it != connections_m.end()) replaced = it->second;
+        ++replaced_m;
+      }
+    sender = connection.get();
+    connections_m[connection.get()] = connection;
+    ++hosts_m[connection->host()];
+    return replaced;
+  }
+
+  void remove(const connection_t* connection) {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    auto it = connections_m.find(connection);
+    if (it == connections_m.end()) return;
+    connections_m.erase(it);
+    auto sender = senders_m.find(connection->sender());
+    if (sender != senders_m.end() && sender->second == connection) senders_m.erase(sender);
+    auto host = hosts_m.find(connection->host());
+    if (host != hosts_m.end() && 0 == --host->second) hosts_m.erase(host);
+  }
+
+  // shuts down the connections idle since before now - timeout, returns their count
+  size_t reap(clock_t::time_point now, clock_t::duration timeout) {
+    std::vector<connection_ptr_t> idle;
+    {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      for (auto& entry : connections_m) {
+          if (entry.second->idle_since(now - timeout)) idle.push_back(entry.second);
+        }
+      reaped_m += idle.size();
+    }
+    for (auto& connection : idle) connection->shutdown();
+    return idle.size();
+  }
+
+  // the connections are only dropped - their owners still close them
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    connections_m.clear();
+    senders_m.clear();
+    hosts_m.clear();
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_m);
+    return connections_m.size();
+  }
+
+  stats_t stats() const {
+    stats_t result;
+    std::lock_guard<std::mutex> lock(mutex_m);
+    result.connections = connections_m.size();
+    result.hosts = hosts_m.size();
+    for (auto& host : hosts_m) result.max_per_host = std::max(result.max_per_host, host.second);
+    for (auto& entry : connections_m) {
+        auto memory = entry.second->memory();
+        result.memory += memory;
+        result.max_memory = std::max(result.max_memory, memory);
+      }
+    result.accepted = accepted_m;
+    result.replaced = replaced_m;
+    result.reaped = reaped_m;
+    return result;
+  }
+
+private:
+  mutable std::mutex mutex_m;
+  std::unordered_map<const connection_t*, connection_ptr_t> connections_m;
+  std::unordered_map<std::string, const connection_t*> senders_m; // latest connection of each sender
+  std::unordered_map<std::string, size_t> hosts_m; // connections per host
+  uint64_t accepted_m = 0;
+  uint64_t replaced_m = 0;
+  uint64_t reaped_m = 0;
+};
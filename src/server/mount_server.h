@@ -5,19 +5,24 @@
 #include "nfs/mount.h"
 
 struct mount_server_t {
-  mount_server_t()
-    : rpc_server_m(mount::PORT)
+  explicit mount_server_t(fs::backend_t& backend = fs::default_backend(), int port = mount::PORT)
+    : program_m(backend)
+    , rpc_server_m(port)
   {}
 
   const mount_cache_t& cache() const { return program_m.cache(); }
   mount_aliases_t& aliases() { return program_m.aliases(); }
   void restore(const binary_t& binary) { program_m.restore(binary); }
+  bool persist(const mount_journal_t::config_t& config) { return program_m.persist(config); }
+  bool checkpoint() { return program_m.checkpoint(); }
 
   void start() {
     rpc_server_m.add(program_m.describe());
     rpc_server_m.start();
   }
 
+  rpc_stats_t::snapshot_t rpc_stats() const { return rpc_server_m.stats(); }
+
 private:
   mount::rpc_program program_m;
   rpc_server_t rpc_server_m;
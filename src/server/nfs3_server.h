@@ -5,16 +5,33 @@
 #include "nfs/nfs3.h"
 
 struct nfs3_server_t {
-  nfs3_server_t(const mount_cache_t& mount_cache)
-    : program_m(mount_cache)
-    , rpc_server_m(nfs3::PORT)
-  {}
+  enum : size_t { CALL_OVERHEAD = 0x1000 }; // rpc header, credentials and WRITE arguments besides the data
+
+  nfs3_server_t(const mount_cache_t& mount_cache, const nfs3::rpc_program::config_t& config = {}, int port = nfs3::PORT,
+                worker_pool_t* workers = nullptr, size_t socket_threads = 1)
+    : program_m(mount_cache, config)
+    , rpc_server_m(port, socket_threads, workers)
+  {
+    rpc_server_m.set_max_record_size(program_m.write_max_size() + CALL_OVERHEAD);
+  }
 
   void start() {
     rpc_server_m.add(program_m.describe());
     rpc_server_m.start();
   }
 
+  // before start()
+  void set_idle_timeout(std::chrono::milliseconds timeout) { rpc_server_m.set_idle_timeout(timeout); }
+
+  rpc_stats_t::snapshot_t rpc_stats() const { return rpc_server_m.stats(); }
+  connection_stats_t connection_stats() const { return rpc_server_m.connection_stats(); }
+  duplicate_cache_t::stats_t duplicate_cache_stats() const { return rpc_server_m.duplicate_stats(); }
+
+  nfs3::object_cache_t::stats_t object_cache_stats() const { return program_m.object_cache_stats(); }
+  nfs3::attribute_cache_t::stats_t attribute_cache_stats() const { return program_m.attribute_cache_stats(); }
+  nfs3::directory_listings_t::stats_t directory_listings_stats() const { return program_m.directory_listings_stats(); }
+  nfs3::write_buffer_t::stats_t write_buffer_stats() const { return program_m.write_buffer_stats(); }
+
 private:
   nfs3::rpc_program program_m;
   rpc_server_t rpc_server_m;
@@ -5,8 +5,8 @@
 #include "rpc/portmap.h"
 
 struct portmap_server_t {
-  portmap_server_t()
-    : rpc_server_m(portmap::PORT)
+  explicit portmap_server_t(int port = portmap::PORT)
+    : rpc_server_m(port)
   {}
 
   void add(int program, int version, int port) {
@@ -25,6 +25,8 @@ struct portmap_server_t {
     rpc_server_m.start();
   }
 
+  rpc_stats_t::snapshot_t rpc_stats() const { return rpc_server_m.stats(); }
+
 private:
   portmap::rpc_program program_m;
   rpc_server_t rpc_server_m;
@@ -1,71 +1,342 @@
 #include "rpc_server.h"
+#include "worker_pool.h"
 
 #include "binary/binary.h"
 #include "binary/binary_reader.h"
 #include "binary/binary_builder.h"
+#include "binary/buffer_pool.h"
 
 #include "network/tcp.h"
 #include "network/udp.h"
+#include "network/event_loop.h"
 
 #include "rpc/rpc_router.h"
+#include "rpc/record_marking.h"
 
-#include <thread>
-#include <iostream>
+#include "logging/logger.h"
 
 #include <string>
-#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 
-template<typename socket_t>
-struct socket_thread_t {
-  socket_thread_t() = default;
+namespace {
+  /**
+   * @brief runs the calls on the workers - without workers on the receiving thread
+   *
+   * Queued calls own a pooled copy of their request. Replies are handed to the callback on the
+   * thread that ran the call, so replies of one connection may leave out of order.
+   */
+  struct dispatcher_t {
+    using reply_callback_t = std::function<void (segmented_binary_t&&)>;
 
-  socket_thread_t(const socket_thread_t&) = delete;
-  socket_thread_t& operator= (const socket_thread_t&) = delete;
+    dispatcher_t(const rpc_router_t& router, worker_pool_t* workers)
+      : router_m(router)
+      , workers_m(workers)
+    {}
 
-  socket_thread_t(socket_thread_t&& other) = default;
-  socket_thread_t& operator= (socket_thread_t&& other) = default;
+    ~dispatcher_t() {
+      wait();
+    }
 
-  ~socket_thread_t() { stop(); }
+    // run_when_busy: a full pool runs the call on this thread, otherwise it is dropped
+    void dispatch(const router_args_t& args, reply_callback_t&& reply, bool run_when_busy) {
+      if (workers_m) {
+          {
+            std::lock_guard<std::mutex> lock(pending_mutex_m);
+            ++pending_m;
+          }
+          const uint8_t* data = args.request_reader.data();
+          auto request = buffer_pool_t::shared().acquire(args.request_reader.size());
+          request.assign(data, data + args.request_reader.size());
+          auto queued = workers_m->submit([this, sender = args.sender, request = std::move(request),
+                                           max_reply_size = args.max_reply_size, reply]() mutable {
+              reply(router_m.handle({ sender, binary_reader_t::binary(request), max_reply_size }));
+              buffer_pool_t::shared().release(std::move(request));
+              done();
+            });
+          if (queued) return;
+          buffer_pool_t::shared().release(std::move(request));
+          done();
+          if ( !run_when_busy) return; // udp clients retransmit
+        }
+      reply(router_m.handle(args));
+    }
 
-  static socket_thread_t with_socket(socket_t&& socket) {
-    socket_thread_t result;
-    result.socket = std::move(socket);
-    return result;
-  }
+    // false if the calls reply on the dispatching thread
+    bool queues() const { return nullptr != workers_m; }
 
-  template<typename callback_t>
-  void start(callback_t&& callback) {
-    if (!socket.valid()) socket = socket_t::create();
-    thread = std::thread(std::forward<callback_t>(callback));
-  }
+    // until all queued calls have replied
+    void wait() {
+      std::unique_lock<std::mutex> lock(pending_mutex_m);
+      idle_m.wait(lock, [this] { return 0 == pending_m; });
+    }
 
-  void stop() {
-    if (socket.valid()) socket.close();
-    if (thread.joinable()) thread.join();
-  }
+  private:
+    void done() {
+      std::lock_guard<std::mutex> lock(pending_mutex_m);
+      if (0 == --pending_m) idle_m.notify_all();
+    }
 
-  socket_t socket;
-  std::thread thread;
-};
-using udp_socket_thread_t = socket_thread_t<udp_socket_t>;
-using tcp_socket_thread_t = socket_thread_t<tcp_socket_t>;
+  private:
+    const rpc_router_t& router_m;
+    worker_pool_t* workers_m;
+
+    std::mutex pending_mutex_m;
+    std::condition_variable idle_m;
+    size_t pending_m = 0;
+  };
+
+  /**
+   * @brief state of one accepted tcp connection
+   *
+   * Receiving and closing run on the thread of the owning reactor. Replies are sent
+   * from the threads that ran the calls - the send queue and the socket are guarded by
+   * the send mutex.
+   */
+  struct tcp_connection_t : std::enable_shared_from_this<tcp_connection_t> {
+    enum : size_t { MIN_RECEIVE_SIZE = 0x10000 };
+    using close_callback_t = std::function<void (tcp_connection_t*)>;
+    using clock_t = std::chrono::steady_clock;
+
+    tcp_connection_t(tcp_socket_t&& socket, const inet_addr_t& remoteaddr, reactor_t& reactor, size_t max_record_size)
+      : socket_m(std::move(socket))
+      , sender_m(remoteaddr.name())
+      , host_m(remoteaddr.ip())
+      , reactor_m(reactor)
+      , reassembler_m(max_record_size)
+    {
+      touch();
+    }
+
+    const std::string& sender() const { return sender_m; }
+    const std::string& host() const { return host_m; }
+
+    bool idle_since(clock_t::time_point time) const {
+      return 0 == calls_m.load(std::memory_order_relaxed)
+          && active_m.load(std::memory_order_relaxed) < time.time_since_epoch().count();
+    }
+
+    // receive buffer, unsent replies and requests of running calls
+    size_t memory() const {
+      return receive_memory_m.load(std::memory_order_relaxed) + send_memory_m.load(std::memory_order_relaxed)
+          + call_memory_m.load(std::memory_order_relaxed);
+    }
+
+    bool start(dispatcher_t& dispatcher, close_callback_t&& on_close) {
+      on_close_m = std::move(on_close);
+      auto self = shared_from_this();
+      return reactor_m.add(socket_m.handle(), reactor_t::READABLE, [self, &dispatcher](uint32_t events) {
+          if (events & reactor_t::WRITABLE) {
+              if ( !self->flush()) return self->close();
+            }
+          if (events & (reactor_t::READABLE | reactor_t::CLOSED)) {
+              if ( !self->receive(dispatcher)) return self->close();
+            }
+        });
+    }
+
+    // safe to call from any thread - the owning reactor will close the connection
+    void shutdown() {
+      std::lock_guard<std::mutex> lock(send_mutex_m);
+      if (socket_m.valid()) socket_m.shutdown();
+    }
+
+    void close() {
+      {
+        std::lock_guard<std::mutex> lock(send_mutex_m);
+        if ( !socket_m.valid()) return;
+        reactor_m.remove(socket_m.handle());
+        socket_m.close();
+      }
+      if (on_close_m) on_close_m(this);
+    }
+
+  private:
+    // read everything available and handle all complete records
+    bool receive(dispatcher_t& dispatcher) {
+      while (true) {
+          auto size = std::max<size_t>(MIN_RECEIVE_SIZE, socket_m.available());
+          auto bytes = socket_m.receive(reassembler_m.prepare(size), size);
+          if (0 == bytes) return false; // orderly shutdown
+          if (0 > bytes) return socket_would_block();
+          reassembler_m.commit(bytes);
+          receive_memory_m.store(reassembler_m.capacity(), std::memory_order_relaxed);
+          touch();
+          if ( !handle_records(dispatcher)) return false;
+        }
+    }
+
+    bool handle_records(dispatcher_t& dispatcher) {
+      auto self = shared_from_this();
+      while (true) {
+          router_args_t args;
+          switch (reassembler_m.next(args.request_reader)) {
+            case record_marking::reassembler_t::NEED_MORE: return true;
+            case record_marking::reassembler_t::INVALID: return false; // above the max record size
+            case record_marking::reassembler_t::RECORD: break;
+            }
+          args.sender = sender_m;
+          auto size = args.request_reader.size();
+          calls_m.fetch_add(1, std::memory_order_relaxed);
+          call_memory_m.fetch_add(size, std::memory_order_relaxed);
+          dispatcher.dispatch(args, [self, size](segmented_binary_t&& result) {
+              self->reply(std::move(result));
+              self->call_memory_m.fetch_sub(size, std::memory_order_relaxed);
+              self->touch();
+              self->calls_m.fetch_sub(1, std::memory_order_relaxed);
+            }, true);
+        }
+    }
+
+    // called from any thread - a failed send closes the connection on the owning reactor
+    void reply(segmented_binary_t&& result) {
+      if (result.empty()) return;
+      binary_builder_t builder;
+      builder.append32(record_marking::single_fragment_header(result.size()));
+      result.prepend(builder.release());
+      {
+        std::lock_guard<std::mutex> lock(send_mutex_m);
+        if ( !socket_m.valid()) return;
+        if ( !send(result)) socket_m.shutdown();
+        send_memory_m.store(send_buffer_m.capacity(), std::memory_order_relaxed);
+      }
+      buffer_pool_t::shared().release(std::move(result)); // sent or copied
+    }
+
+    void touch() {
+      active_m.store(clock_t::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    // gather send of the segments - only bytes the socket did not take are copied
+    bool send(const segmented_binary_t& segments) {
+      if (send_buffer_m.empty()) {
+          auto sent = socket_m.send(segments);
+          if (sent == (int)segments.size()) return true;
+          if (0 > sent && !socket_would_block()) return false;
+          segments.copy_to(send_buffer_m, std::max(0, sent));
+          return reactor_m.modify(socket_m.handle(), reactor_t::READABLE | reactor_t::WRITABLE);
+        }
+      segments.copy_to(send_buffer_m);
+      return true;
+    }
+
+    // continue a partial send once the socket is writable again
+    bool flush() {
+      std::lock_guard<std::mutex> lock(send_mutex_m);
+      while (send_offset_m < send_buffer_m.size()) {
+          auto sent = socket_m.send(&send_buffer_m[send_offset_m], send_buffer_m.size() - send_offset_m);
+          if (0 > sent) return socket_would_block();
+          send_offset_m += sent;
+        }
+      send_buffer_m.clear();
+      send_offset_m = 0;
+      if (send_buffer_m.capacity() > MIN_RECEIVE_SIZE) binary_t().swap(send_buffer_m); // large replies are rare
+      send_memory_m.store(send_buffer_m.capacity(), std::memory_order_relaxed);
+      return reactor_m.modify(socket_m.handle(), reactor_t::READABLE);
+    }
+
+  private:
+    tcp_socket_t socket_m;
+    std::string sender_m;
+    std::string host_m;
+    reactor_t& reactor_m;
+    close_callback_t on_close_m;
 
-using tcp_session_map_t = std::map<std::string, tcp_socket_thread_t>;
+    record_marking::reassembler_t reassembler_m;
+
+    std::mutex send_mutex_m;
+    binary_t send_buffer_m;
+    size_t send_offset_m = 0;
+
+    std::atomic<clock_t::rep> active_m {0}; // last call received or replied
+    std::atomic<size_t> calls_m {0}; // running
+    std::atomic<size_t> receive_memory_m {0};
+    std::atomic<size_t> send_memory_m {0};
+    std::atomic<size_t> call_memory_m {0};
+  };
+  using tcp_connection_ptr = std::shared_ptr<tcp_connection_t>;
+  using tcp_connection_table_t = connection_table_t<tcp_connection_t>;
+
+} // namespace
 
 struct rpc_server_t::impl {
   int port_m;
   rpc_router_t router_m;
+  dispatcher_t dispatcher_m;
+
+  event_loop_t event_loop_m;
+
+  /**
+   * @brief one socket per reactor where the port can be shared, the kernel spreads the datagrams
+   *
+   * Workers queue their replies and make the reactor wait for a writable socket. The
+   * reactor sends them together with the replies of calls it ran itself - one sendmmsg
+   * per wakeup instead of one send per reply.
+   */
+  struct udp_receiver_t {
+    udp_socket_t socket;
+    udp_batch_t batch; // used by the reactor only
+    reactor_t* reactor = nullptr;
 
-  udp_socket_thread_t udp_socket_thread_m;
-  tcp_socket_thread_t tcp_accept_socket_thread_m;
+    // called by the workers
+    void queue_reply(segmented_binary_t&& result, const inet_addr_t& to) {
+      std::lock_guard<std::mutex> lock(replies_mutex);
+      replies.push_back({ std::move(result), to });
+      if (writable_wanted) return; // the reactor sends this one as well
+      writable_wanted = true;
+      reactor->modify(socket.handle(), reactor_t::READABLE | reactor_t::WRITABLE);
+    }
 
-  tcp_session_map_t tcp_session_map_m;
+    // called by the reactor - the interest changes under the mutex, so no queued reply is missed
+    size_t send() {
+      {
+        std::lock_guard<std::mutex> lock(replies_mutex);
+        if (writable_wanted) {
+            writable_wanted = false;
+            reactor->modify(socket.handle(), reactor_t::READABLE);
+          }
+        batch.queue_replies(replies);
+      }
+      return batch.send(socket);
+    }
+
+  private:
+    std::mutex replies_mutex;
+    std::vector<udp_batch_t::reply_t> replies; // of the workers
+    bool writable_wanted = false;
+  };
+  std::vector<std::unique_ptr<udp_receiver_t>> udp_receivers_m;
+  tcp_socket_t tcp_accept_socket_m;
+
+  tcp_connection_table_t connections_m;
+  size_t max_record_size_m = record_marking::reassembler_t().max_record_size();
+
+  std::chrono::milliseconds idle_timeout_m = std::chrono::minutes(5);
+  std::mutex reaper_mutex_m;
+  std::condition_variable reaper_wake_m;
+  bool stopping_m = false;
+  std::thread reaper_m;
 
 public:
-  impl(int port)
+  impl(int port, size_t loop_threads, worker_pool_t* workers)
     : port_m(port)
+    , dispatcher_m(router_m, workers)
+    , event_loop_m(loop_threads)
   {}
 
+  ~impl() {
+    stop_reaper();
+    event_loop_m.stop();
+    dispatcher_m.wait();
+    connections_m.clear();
+  }
+
   void add(const rpc_program_t &program) {
     router_m.add(program);
   }
@@ -73,81 +344,120 @@ public:
   void start() {
     start_udp();
     start_tcp();
+    event_loop_m.start();
+    start_reaper();
+  }
+
+  // shuts down idle tcp connections - clients reconnect when they need them again
+  void start_reaper() {
+    if (idle_timeout_m <= std::chrono::milliseconds::zero()) return;
+    auto interval = std::min<std::chrono::milliseconds>(idle_timeout_m / 4 + std::chrono::milliseconds(1), std::chrono::seconds(10));
+    reaper_m = std::thread([=] {
+        std::unique_lock<std::mutex> lock(reaper_mutex_m);
+        while ( !reaper_wake_m.wait_for(lock, interval, [this] { return stopping_m; })) {
+            auto reaped = connections_m.reap(tcp_connection_t::clock_t::now(), idle_timeout_m);
+            if (0 < reaped) LOG_AT(INFO, "rpc") << "closing " << reaped << " idle connections of port " << port_m;
+          }
+      });
+  }
+
+  void stop_reaper() {
+    {
+      std::lock_guard<std::mutex> lock(reaper_mutex_m);
+      stopping_m = true;
+    }
+    reaper_wake_m.notify_all();
+    if (reaper_m.joinable()) reaper_m.join();
   }
 
   void start_udp() {
-    udp_socket_thread_m.start([=] {
-        udp_receive::config_t config;
-        config.port = port_m;
-        auto success = udp_receive::loop(udp_socket_thread_m.socket, config, [=](binary_t& binary, const inet_addr_t& remoteaddr) {
+    auto count = event_loop_m.size();
+    for (size_t index = 0; index < count; ++index) {
+        std::unique_ptr<udp_receiver_t> receiver(new udp_receiver_t);
+        auto& socket = receiver->socket;
+        socket = udp_socket_t::create();
+        if ( !socket.valid()) break;
+        if (1 < count && !socket_set_reuse_port(socket.handle())) count = 1;
+        if (SOCKET_ERROR == socket.bind_all(port_m) || !socket.set_non_blocking()) break;
+        auto& added = *receiver;
+        added.reactor = &event_loop_m.reactor(index);
+        udp_receivers_m.push_back(std::move(receiver));
+        added.reactor->add(added.socket.handle(), reactor_t::READABLE, [this, &added](uint32_t events) {
+            if (events & (reactor_t::READABLE | reactor_t::CLOSED)) receive_udp(added);
+            if (events & reactor_t::WRITABLE) added.send(); // replies of the workers
+          });
+      }
+    if (udp_receivers_m.empty()) LOG_AT(FAILURE, "rpc") << "udp socket error " << socket_last_error();
+  }
+
+  // replies are sent a batch at a time - with those the workers queued meanwhile
+  void receive_udp(udp_receiver_t& receiver) {
+    auto& batch = receiver.batch;
+    while (0 < batch.receive(receiver.socket)) {
+        for (size_t index = 0; index < batch.size(); ++index) {
             router_args_t args;
-            args.request_reader = binary_reader_t::binary(binary);
+            args.request_reader = batch.datagram(index);
+            auto remoteaddr = batch.sender(index);
             args.sender = remoteaddr.name();
-            auto result = router_m.handle(args);
-            if ( !result.empty()) {
-                udp_socket_thread_m.socket.send_to(result, remoteaddr);
+            args.max_reply_size = udp_batch_t::MAX_REPLY;
+            if (dispatcher_m.queues()) {
+                dispatcher_m.dispatch(args, [&receiver, remoteaddr](segmented_binary_t&& result) {
+                    if ( !result.empty()) receiver.queue_reply(std::move(result), remoteaddr);
+                  }, false);
+              }
+            else {
+                dispatcher_m.dispatch(args, [&batch, remoteaddr](segmented_binary_t&& result) {
+                    if ( !result.empty()) batch.queue_reply(std::move(result), remoteaddr);
+                  }, false);
               }
-          });
-        if ( !success) {
-            std::cout << "udp socket error " << WSAGetLastError() << std::endl;
-            return;
           }
-      });
+        receiver.send();
+      }
   }
 
   void start_tcp() {
-    tcp_accept_socket_thread_m.start([=] {
-        tcp_accept::config_t config;
-        config.backlog = 32;
-        config.port = port_m;
-        tcp_accept::loop(tcp_accept_socket_thread_m.socket, config, [=](tcp_socket_t&& socket, const inet_addr_t& remoteaddr) {
-            start_tcp_session(std::move(socket), remoteaddr);
-          });
+    tcp_accept_socket_m = tcp_socket_t::create();
+    if ( !tcp_accept_socket_m.valid()) return;
+    socket_set_reuse_address(tcp_accept_socket_m.handle());
+    if (SOCKET_ERROR == tcp_accept_socket_m.bind_all(port_m)
+        || SOCKET_ERROR == tcp_accept_socket_m.listen(128)
+        || !tcp_accept_socket_m.set_non_blocking()) {
+        LOG_AT(FAILURE, "rpc") << "tcp socket error " << socket_last_error();
+        return;
+      }
+    event_loop_m.reactor(0).add(tcp_accept_socket_m.handle(), reactor_t::READABLE, [=](uint32_t) {
+        accept_tcp();
       });
   }
 
-  void start_tcp_session(tcp_socket_t&& socket, const inet_addr_t& remoteaddr) {
-    auto sender = remoteaddr.name();
-    auto it = tcp_session_map_m.find(sender);
-    if (it != tcp_session_map_m.end()) {
-        it->second.stop();
-        it->second.socket = std::move(socket);
-      }
-    else {
-        auto result = tcp_session_map_m.emplace(sender, tcp_socket_thread_t::with_socket(std::move(socket)));
-        if (result.second) {
-            it = result.first;
-          }
-        else return; // failed to insert
+  void accept_tcp() {
+    while (true) {
+        inet_addr_t remoteaddr;
+        auto socket = tcp_accept_socket_m.accept(remoteaddr);
+        if ( !socket.valid()) return; // would block or error
+        start_tcp_session(std::move(socket), remoteaddr);
       }
-    it->second.start([=] {
-        tcp_receive::loop(it->second.socket, [=](binary_t& binary) {
-            auto reader = binary_reader_t::binary(binary);
-            auto message_size = reader.get32(0);
-            if (0 == (message_size & 0x80000000)) return false; // drop connection
-            message_size &= 0x7FFFFFFF;
-            if (0xFFFFF < message_size) return false; // no single message should be >1MB
-            if (binary.size() < 4 + message_size) return true; // need more data
-            router_args_t args;
-            args.request_reader = reader.get_reader(4, message_size);
-            args.sender = it->first;
-            auto result = router_m.handle(args);
-            if ( !result.empty()) {
-                binary_builder_t builder;
-                builder.append32(0x80000000 | result.size());
-                builder.append_binary(result);
-                it->second.socket.send(builder.build());
-              }
-            binary.erase(binary.begin(), binary.begin() + 4 + message_size);
-            return true; // keep connection
-          });
+  }
+
+  void start_tcp_session(tcp_socket_t&& socket, const inet_addr_t& remoteaddr) {
+    if ( !socket.set_non_blocking()) return;
+    socket.set_no_delay();
+    auto connection = std::make_shared<tcp_connection_t>(std::move(socket), remoteaddr, event_loop_m.next_reactor(),
+                                                         max_record_size_m);
+
+    auto previous = connections_m.insert(connection);
+    if (previous) previous->shutdown(); // same sender reconnected
+
+    auto started = connection->start(dispatcher_m, [=](tcp_connection_t* closed) {
+        connections_m.remove(closed);
       });
+    if ( !started) connection->close();
   }
 
 };
 
-rpc_server_t::rpc_server_t(int port)
-  : p(new impl(port))
+rpc_server_t::rpc_server_t(int port, size_t loop_threads, worker_pool_t* workers)
+  : p(new impl(port, loop_threads, workers))
 {}
 
 rpc_server_t::~rpc_server_t()
@@ -162,3 +472,28 @@ void rpc_server_t::start()
 {
   p->start();
 }
+
+rpc_stats_t::snapshot_t rpc_server_t::stats() const
+{
+  return p->router_m.stats();
+}
+
+duplicate_cache_t::stats_t rpc_server_t::duplicate_stats() const
+{
+  return p->router_m.duplicate_stats();
+}
+
+void rpc_server_t::set_idle_timeout(std::chrono::milliseconds timeout)
+{
+  p->idle_timeout_m = timeout;
+}
+
+void rpc_server_t::set_max_record_size(size_t size)
+{
+  p->max_record_size_m = size;
+}
+
+connection_stats_t rpc_server_t::connection_stats() const
+{
+  return p->connections_m.stats();
+}
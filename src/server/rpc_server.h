@@ -1,17 +1,39 @@
 #pragma once
 
 #include "rpc/rpc_program.h"
+#include "rpc/rpc_stats.h"
+#include "rpc/duplicate_cache.h"
+#include "connection_table.h"
 
+#include <chrono>
 #include <memory>
 
+struct worker_pool_t;
+
+/**
+ * @brief udp and tcp server of the added programs on one port
+ *
+ * Every loop thread receives udp datagrams on its own socket where the port can be
+ * shared, otherwise the first one receives all. The calls run on the given workers,
+ * without workers on the socket threads. The workers have to outlive the server.
+ */
 struct rpc_server_t {
-  rpc_server_t(int port);
+  rpc_server_t(int port, size_t loop_threads = 1, worker_pool_t* workers = nullptr);
   ~rpc_server_t();
 
   void add(const rpc_program_t&);
 
+  // tcp connections without calls for this long are closed, zero keeps them - set before start()
+  void set_idle_timeout(std::chrono::milliseconds);
+  // tcp connections sending larger calls are closed - set before start()
+  void set_max_record_size(size_t);
+
   void start();
 
+  rpc_stats_t::snapshot_t stats() const;
+  duplicate_cache_t::stats_t duplicate_stats() const;
+  connection_stats_t connection_stats() const;
+
 private:
   struct impl;
   std::unique_ptr<impl> p;
@@ -0,0 +1,130 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+
+namespace {
+  // the pool and queue of the worker running on this thread
+  thread_local const worker_pool_t* current_pool = nullptr;
+  thread_local size_t current_index = 0;
+} // namespace
+
+worker_pool_t::worker_pool_t()
+  : worker_pool_t(config_t())
+{}
+
+worker_pool_t::worker_pool_t(const config_t& config)
+  : config_m(config)
+{
+  auto threads = std::max<size_t>(1, config.threads);
+  workers_m.reserve(threads);
+  for (auto i = 0u; i < threads; ++i) {
+      workers_m.emplace_back(new worker_t());
+    }
+}
+
+worker_pool_t::~worker_pool_t()
+{
+  stop();
+}
+
+void worker_pool_t::start()
+{
+  if (running_m.exchange(true)) return; // already running
+  for (size_t index = 0; index < workers_m.size(); ++index) {
+      workers_m[index]->thread = std::thread([=] { run(index); });
+    }
+}
+
+void worker_pool_t::stop()
+{
+  if ( !running_m.exchange(false)) return; // not running
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_m);
+  }
+  wake_m.notify_all();
+  for (auto& worker : workers_m) {
+      if (worker->thread.joinable()) worker->thread.join();
+    }
+  // submitted while the workers were leaving - no task is queued after this
+  task_t task;
+  while (take(0, task)) {
+      task();
+      task = nullptr;
+      executed_m.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool worker_pool_t::submit(task_t&& task)
+{
+  if (queued_m.fetch_add(1) >= config_m.queue_depth) {
+      queued_m.fetch_sub(1);
+      rejected_m.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  auto index = current_pool == this ? current_index : next_m.fetch_add(1, std::memory_order_relaxed) % workers_m.size();
+  auto& worker = *workers_m[index];
+  {
+    // checked with the queue locked - stop() takes every task queued while running
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if ( !running_m) {
+        queued_m.fetch_sub(1);
+        rejected_m.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    worker.tasks.push_back(std::move(task));
+  }
+  // a worker that saw no task is waiting or sees the increment above
+  if (sleeping_m.load() > 0) {
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex_m);
+      }
+      wake_m.notify_one();
+    }
+  return true;
+}
+
+worker_pool_t::stats_t worker_pool_t::stats() const
+{
+  stats_t result;
+  result.executed = executed_m.load(std::memory_order_relaxed);
+  result.stolen = stolen_m.load(std::memory_order_relaxed);
+  result.rejected = rejected_m.load(std::memory_order_relaxed);
+  result.queued = queued_m.load(std::memory_order_relaxed);
+  return result;
+}
+
+void worker_pool_t::run(size_t index)
+{
+  current_pool = this;
+  current_index = index;
+  task_t task;
+  while (true) {
+      if (take(index, task)) {
+          task();
+          task = nullptr;
+          executed_m.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+      std::unique_lock<std::mutex> lock(wake_mutex_m);
+      if ( !running_m && 0 == queued_m) break; // queued tasks are run before stopping
+      sleeping_m.fetch_add(1);
+      wake_m.wait(lock, [this] { return 0 < queued_m || !running_m; });
+      sleeping_m.fetch_sub(1);
+    }
+  current_pool = nullptr;
+}
+
+bool worker_pool_t::take(size_t index, task_t& task)
+{
+  for (size_t offset = 0; offset < workers_m.size(); ++offset) {
+      auto& worker = *workers_m[(index + offset) % workers_m.size()];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      if (worker.tasks.empty()) continue;
+      task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      queued_m.fetch_sub(1);
+      if (0 != offset) stolen_m.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  return false;
+}
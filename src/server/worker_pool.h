@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief threads that execute the procedures apart from the socket threads
+ *
+ * Every worker owns a queue. Tasks submitted by a worker go to its own queue, others
+ * are spread round robin. A worker takes its oldest task first and steals the oldest
+ * task of another worker when its own queue is empty, so no request waits behind a
+ * slow one while a worker is idle.
+ *
+ * At most queue_depth tasks are queued - submit() fails above that and the caller
+ * decides to drop or to run the task itself.
+ */
+struct worker_pool_t {
+  using task_t = std::function<void ()>;
+
+  struct config_t {
+    size_t threads = 4;
+    size_t queue_depth = 1024;
+  };
+
+  struct stats_t {
+    uint64_t executed = 0;
+    uint64_t stolen = 0; // executed by another worker than the one they were queued for
+    uint64_t rejected = 0; // queue was full
+    size_t queued = 0;
+  };
+
+  worker_pool_t();
+  explicit worker_pool_t(const config_t&);
+  ~worker_pool_t();
+
+  worker_pool_t(const worker_pool_t&) = delete;
+  worker_pool_t& operator= (const worker_pool_t&) = delete;
+
+  size_t size() const { return workers_m.size(); }
+
+  void start();
+  // runs the queued tasks and joins the workers - a concurrent submit() runs or fails
+  void stop();
+
+  // false if the pool is full or not running
+  bool submit(task_t&&);
+
+  stats_t stats() const;
+
+private:
+  struct worker_t {
+    std::mutex mutex;
+    std::deque<task_t> tasks;
+    std::thread thread;
+  };
+  using worker_ptr = std::unique_ptr<worker_t>;
+
+  void run(size_t index);
+  bool take(size_t index, task_t&);
+
+private:
+  config_t config_m;
+  std::vector<worker_ptr> workers_m;
+  std::atomic<bool> running_m {false};
+  std::atomic<size_t> next_m {0};
+  std::atomic<size_t> queued_m {0};
+
+  std::mutex wake_mutex_m;
+  std::condition_variable wake_m;
+  std::atomic<size_t> sleeping_m {0};
+
+  std::atomic<uint64_t> executed_m {0};
+  std::atomic<uint64_t> stolen_m {0};
+  std::atomic<uint64_t> rejected_m {0};
+};
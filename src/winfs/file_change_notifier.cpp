@@ -3,8 +3,26 @@
 #include "file_change_notifier.h"
 
 #include <algorithm>
+#include <vector>
 #include <Windows.h>
 
+namespace {
+    DWORD notify_filter(file_change_notifier::change_event events) {
+        DWORD dwNotifyFiler = 0;
+        if(events & file_change_notifier::change_event::file_attributes){
+            dwNotifyFiler |= FILE_NOTIFY_CHANGE_LAST_WRITE;
+            dwNotifyFiler |= FILE_NOTIFY_CHANGE_SECURITY;
+            dwNotifyFiler |= FILE_NOTIFY_CHANGE_ATTRIBUTES;
+        } if(events & file_change_notifier::change_event::file_name) {
+            dwNotifyFiler |= FILE_NOTIFY_CHANGE_FILE_NAME;
+            dwNotifyFiler |= FILE_NOTIFY_CHANGE_DIR_NAME;
+        } if(events & file_change_notifier::change_event::file_size) {
+            dwNotifyFiler |= FILE_NOTIFY_CHANGE_SIZE;
+        }
+        return dwNotifyFiler;
+    }
+} // namespace
+
 file_change_notifier::
 file_change_notifier(full_path_t file_path,
                      change_event events,
@@ -14,20 +32,27 @@ file_change_notifier(full_path_t file_path,
 {
     split_path(file_path,this->directory_path_,this->file_name_);
 
-    DWORD dwNotifyFiler = 0;
-    if(events_ & change_event::file_attributes){
-        dwNotifyFiler |= FILE_NOTIFY_CHANGE_LAST_WRITE;
-        dwNotifyFiler |= FILE_NOTIFY_CHANGE_SECURITY;
-        dwNotifyFiler |= FILE_NOTIFY_CHANGE_ATTRIBUTES;
-    } if(events_ & change_event::file_name) {
-        dwNotifyFiler |= FILE_NOTIFY_CHANGE_FILE_NAME;
-    } if(events_ & change_event::file_size) {
-        dwNotifyFiler |= FILE_NOTIFY_CHANGE_SIZE;
+    this->notification_handle_ = FindFirstChangeNotification(this->directory_path_.c_str(),false,notify_filter(events_));
+    if (notification_handle_ == INVALID_HANDLE_VALUE) {
+        throw win32_exception("FindFirstChangeNotification failed", GetLastError());
     }
+}
 
-    this->notification_handle_ = FindFirstChangeNotification(this->directory_path_.c_str(),false,dwNotifyFiler);
+file_change_notifier::
+file_change_notifier(directory_path_t directory_path,
+                     subtree_t,
+                     std::function<void(full_path_t)> callback
+                     ) :
+    directory_path_(directory_path),
+    callback_(std::bind(callback,std::placeholders::_1)), events_(change_event::all), subtree_(true),
+    notification_handle_(INVALID_HANDLE_VALUE), continue_waiting_(false)
+{
+    this->notification_handle_ = CreateFileW(this->directory_path_.c_str(), FILE_LIST_DIRECTORY,
+                                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                             NULL, OPEN_EXISTING,
+                                             FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
     if (notification_handle_ == INVALID_HANDLE_VALUE) {
-        throw win32_exception("FindFirstChangeNotification failed", GetLastError());
+        throw win32_exception("CreateFileW of the watched directory failed", GetLastError());
     }
 }
 
@@ -39,7 +64,8 @@ file_change_notifier::~file_change_notifier()  {
     try{
         this->waiting_future.get();}
     catch (...) {}
-    FindCloseChangeNotification(this->notification_handle_);
+    if (this->subtree_) CloseHandle(this->notification_handle_);
+    else FindCloseChangeNotification(this->notification_handle_);
 }
 
 void file_change_notifier::split_path(full_path_t full_path,
@@ -72,7 +98,10 @@ void file_change_notifier::start_watching(){
         return;
     }
     this->continue_waiting_ = true;
-    this->waiting_future = std::async(std::launch::async,&file_change_notifier::waiting_function,this);
+    this->waiting_future = std::async(std::launch::async,
+                                      this->subtree_ ? &file_change_notifier::subtree_waiting_function
+                                                     : &file_change_notifier::waiting_function,
+                                      this);
 
 }
 
@@ -96,6 +125,59 @@ void file_change_notifier::waiting_function(){
     }
 }
 
+void file_change_notifier::subtree_waiting_function(){
+    auto directory_path = this->directory_path_;
+    if (!directory_path.empty() && directory_path.back() != L'\\') directory_path += L'\\';
+
+    std::vector<DWORD> buffer(16 * 1024); // DWORD aligned as required
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (overlapped.hEvent == NULL) {
+        throw win32_exception("CreateEventW failed", GetLastError());
+    }
+    bool pending = false;
+    while (this->continue_waiting_){
+        if (!pending) {
+            if (!ReadDirectoryChangesW(this->notification_handle_, buffer.data(), buffer.size() * sizeof(DWORD),
+                                       TRUE, notify_filter(this->events_), NULL, &overlapped, NULL)) {
+                auto error = GetLastError();
+                CloseHandle(overlapped.hEvent);
+                throw win32_exception("ReadDirectoryChangesW failed", error);
+            }
+            pending = true;
+        }
+        DWORD wait_return = WaitForSingleObject(overlapped.hEvent,1000);
+        if (wait_return == WAIT_TIMEOUT) continue;
+        pending = false;
+        DWORD bytes = 0;
+        if (wait_return != WAIT_OBJECT_0 || !GetOverlappedResult(this->notification_handle_, &overlapped, &bytes, FALSE)) {
+            auto error = GetLastError();
+            CloseHandle(overlapped.hEvent);
+            throw win32_exception("Waiting for directory changes failed", error);
+        }
+        ResetEvent(overlapped.hEvent);
+        if (bytes == 0) {
+            // the buffer overflowed - the changes are lost
+            this->callback_(this->directory_path_, this->events_);
+            continue;
+        }
+        auto it = reinterpret_cast<const uint8_t*>(buffer.data());
+        while (true) {
+            auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(it);
+            this->callback_(directory_path + std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)),
+                            this->events_);
+            if (info->NextEntryOffset == 0) break;
+            it += info->NextEntryOffset;
+        }
+    }
+    if (pending) {
+        CancelIoEx(this->notification_handle_, &overlapped);
+        DWORD bytes;
+        GetOverlappedResult(this->notification_handle_, &overlapped, &bytes, TRUE);
+    }
+    CloseHandle(overlapped.hEvent);
+}
+
 file_change_notifier::win32_exception::win32_exception(std::string msg, std::uint32_t get_last_error_code) :
     std::runtime_error(""), final_msg(msg), error_code(get_last_error_code)
 {
@@ -36,6 +36,9 @@ public:
         all = UINT_MAX,
     };
 
+    /*! @brief Tag to select watching a whole directory tree */
+    enum subtree_t { subtree };
+
     file_change_notifier() = delete;
 
     /*! @brief Creates a new notifier which will, after being started, call the supplied
@@ -68,6 +71,17 @@ public:
                          std::function<void(full_path_t, change_event)> callback
                          );
 
+    /*! @brief Creates a new notifier which will, after being started, call the supplied
+     * callback for every changed file or directory below the directory
+     * @param directory_path Full path to the to be watched directory
+     * @param callback Callback which will be called with the full path of the changed entry.
+     * It is called with directory_path itself, when changes were lost.
+     * @attention Renames report the old and the new name
+    */
+    file_change_notifier(directory_path_t directory_path,
+                         subtree_t,
+                         std::function<void(full_path_t)> callback);
+
     /*! @brief Exception class for the windows API aka WIN32 functions which are using GetLastError*/
     class win32_exception : public std::runtime_error{
     public:
@@ -96,6 +110,7 @@ private:
     internal_path_t file_name_;
     std::function<void(full_path_t, change_event)> callback_;
     change_event events_;
+    bool subtree_ = false;
     void* notification_handle_;
     std::atomic<bool> continue_waiting_;
     std::future<void> waiting_future;
@@ -104,6 +119,7 @@ private:
                     internal_path_t& directory_path,
                     internal_path_t& file_name);
     void waiting_function();
+    void subtree_waiting_function();
 
 };
 
@@ -20,8 +20,11 @@ namespace winfs {
     }
 
     std::wstring filename() const {
-      return std::wstring(info_m->FileName, info_m->FileNameLength >> 1);
+      return std::wstring(filename_data(), filename_size());
     }
+    // the name without a copy - not null terminated
+    const wchar_t* filename_data() const { return info_m->FileName; }
+    size_t filename_size() const { return info_m->FileNameLength >> 1; }
     bool relative() const {
       auto fileName = info_m->FileName;
       return fileName[0] == '.' && (fileName[1] == 0 || (fileName[1] == '.' && fileName[2] == 0));
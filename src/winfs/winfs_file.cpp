@@ -1,5 +1,100 @@
 #include "winfs_file.h"
 
+#include <algorithm>
+
 namespace winfs {
 
+  namespace {
+    // every thread waits for its own requests - the handle is signaled by all of them
+    struct io_event_t {
+      io_event_t() : handle(::CreateEventW(nullptr, TRUE, FALSE, nullptr)) {}
+      ~io_event_t() { if (handle) ::CloseHandle(handle); }
+
+      HANDLE handle;
+    };
+    thread_local io_event_t io_event;
+
+    OVERLAPPED overlapped_at(uint64_t offset) {
+      OVERLAPPED overlapped = {};
+      overlapped.Offset = static_cast<DWORD>(offset);
+      overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+      overlapped.hEvent = io_event.handle;
+      return overlapped;
+    }
+
+    // waits if the handle was opened with FILE_FLAG_OVERLAPPED
+    bool complete(HANDLE handle, OVERLAPPED& overlapped, BOOL success, DWORD& bytes) {
+      if (!success && ERROR_IO_PENDING == ::GetLastError()) {
+          success = ::GetOverlappedResult(handle, &overlapped, &bytes, TRUE);
+        }
+      return success;
+    }
+
+    const size_t max_transfer = 1u << 30; // DWORD sizes
+  } // namespace
+
+  bool file_t::write_at(uint64_t offset, const uint8_t* data, size_t size)
+  {
+    size_t count = 0;
+    while (count < size) {
+        auto overlapped = overlapped_at(offset + count);
+        DWORD written_bytes = 0;
+        auto success = ::WriteFile(
+              handle_m, // hFile
+              data + count, static_cast<DWORD>(std::min(size - count, max_transfer)), // Buffer
+              &written_bytes, // NumberOfBytesWritten
+              &overlapped // Overlapped
+              );
+        if (!complete(handle_m, overlapped, success, written_bytes) || 0 == written_bytes) return false;
+        count += written_bytes;
+      }
+    return true;
+  }
+
+  bool file_t::read_at(uint64_t offset, uint8_t* data, size_t size, size_t& count)
+  {
+    count = 0;
+    while (count < size) {
+        auto overlapped = overlapped_at(offset + count);
+        DWORD read_bytes = 0;
+        auto success = ::ReadFile(
+              handle_m, // hFile
+              data + count, static_cast<DWORD>(std::min(size - count, max_transfer)), // Buffer
+              &read_bytes, // NumberOfBytesRead
+              &overlapped // Overlapped
+              );
+        if (!complete(handle_m, overlapped, success, read_bytes)) {
+            return ERROR_HANDLE_EOF == ::GetLastError();
+          }
+        if (0 == read_bytes) break; // end of file
+        count += read_bytes;
+      }
+    return true;
+  }
+
+  // ReadFileScatter and WriteFileGather need unbuffered page aligned I/O - one request per segment
+  bool file_t::write_at(uint64_t offset, const segmented_binary_t& binary)
+  {
+    for (auto& segment : binary.segments()) {
+        if (!write_at(offset, segment.data(), segment.size())) return false;
+        offset += segment.size();
+      }
+    return true;
+  }
+
+  bool file_t::read_at(uint64_t offset, std::vector<binary_t>& binaries)
+  {
+    auto it = binaries.begin();
+    for (; it != binaries.end(); ++it) {
+        auto size = it->size();
+        if (!read_at(offset, *it)) return false;
+        offset += it->size();
+        if (it->size() < size) break; // end of file
+      }
+    if (it != binaries.end()) {
+        for (++it; it != binaries.end(); ++it) it->clear();
+      }
+    return true;
+  }
+
 } // namespace winfs
@@ -3,12 +3,14 @@
 #include "winfs.h"
 
 #include "binary/binary.h"
+#include "binary/segmented_binary.h"
 
 #include <windows.h>
 #undef max
 #undef min
 
 #include <string>
+#include <vector>
 #include <cstdint>
 
 namespace winfs {
@@ -54,6 +56,34 @@ namespace winfs {
       return success;
     }
 
+    // positional I/O does not use the file pointer - concurrent calls of one handle do not interfere
+    // with FILE_FLAG_OVERLAPPED they also run in parallel, a synchronous handle serializes them
+
+    // writes all bytes at the offset
+    bool write_at(uint64_t offset, const binary_t& binary) {
+      return write_at(offset, binary.data(), binary.size());
+    }
+    // writes the segments one after another (gathered)
+    bool write_at(uint64_t offset, const segmented_binary_t& binary);
+
+    // reads up to binary.size() bytes at the offset - the binary is shortened at the end of file
+    bool read_at(uint64_t offset, binary_t& binary) {
+      size_t count;
+      auto success = read_at(offset, binary.data(), binary.size(), count);
+      binary.resize(count);
+      return success;
+    }
+    // fills the binaries one after another (scattered) - all after the end of file are emptied
+    bool read_at(uint64_t offset, std::vector<binary_t>& binaries);
+
+    bool write_at(uint64_t offset, const uint8_t* data, size_t size);
+    bool read_at(uint64_t offset, uint8_t* data, size_t size, size_t& count);
+
+    // makes the written data durable
+    bool sync() {
+      return ::FlushFileBuffers(handle_m);
+    }
+
     bool read(binary_t& binary) {
       if (binary.empty()) return true;
       DWORD readBytes;
@@ -25,6 +25,7 @@ namespace winfs {
 
   template<uint32_t desiredAccess = 0, uint32_t flags = FILE_FLAG_OPEN_REPARSE_POINT | FILE_FLAG_BACKUP_SEMANTICS>
   unique_object_t open_path(const std::wstring& path);
+  unique_object_t open_path(const std::wstring& path, uint32_t desiredAccess, uint32_t flags);
 
   template<uint32_t desiredAccess = 0, uint32_t flags = FILE_ATTRIBUTE_NORMAL>
   unique_object_t create_file(const std::wstring& path);
@@ -36,6 +37,10 @@ namespace winfs {
              uint32_t flags = FILE_FLAG_OPEN_REPARSE_POINT | FILE_FLAG_BACKUP_SEMANTICS,
              uint32_t shareMode = FILE_SHARE_ALL>
     unique_object_t by_id(const file_id_t& id) const {
+      return by_id(id, desiredAccess, flags, shareMode);
+    }
+
+    unique_object_t by_id(const file_id_t& id, uint32_t desiredAccess, uint32_t flags, uint32_t shareMode = FILE_SHARE_ALL) const {
       unique_object_t result;
       FILE_ID_DESCRIPTOR descriptor;
       descriptor.dwSize = sizeof(descriptor);
@@ -198,8 +203,7 @@ namespace winfs {
   private:
     friend std::wstring resolve_symlink(const std::wstring&);
 
-    template<uint32_t, uint32_t>
-    friend unique_object_t open_path(const std::wstring&);
+    friend unique_object_t open_path(const std::wstring&, uint32_t, uint32_t);
 
     template<uint32_t, uint32_t>
     friend unique_object_t create_file(const std::wstring&);
@@ -207,6 +211,10 @@ namespace winfs {
 
   template<uint32_t desiredAccess, uint32_t flags>
   inline unique_object_t open_path(const std::wstring& path) {
+    return open_path(path, desiredAccess, flags);
+  }
+
+  inline unique_object_t open_path(const std::wstring& path, uint32_t desiredAccess, uint32_t flags) {
     unique_object_t result;
     result.handle_m = ::CreateFileW(
           path.c_str(), // FileName
@@ -0,0 +1 @@
+#include "unix_time.h"
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+namespace wintime {
+
+  struct unix_time_t {
+    uint64_t seconds;
+    uint32_t nanoseconds;
+
+    bool operator == (const unix_time_t& other) const {
+      return seconds == other.seconds
+          && nanoseconds == other.nanoseconds;
+    }
+    bool operator != (const unix_time_t& other) const {
+      return !((*this) == other);
+    }
+  };
+
+} // namespace wintime
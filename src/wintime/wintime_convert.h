@@ -1,5 +1,7 @@
 #pragma once
 
+#include "unix_time.h"
+
 #include <Windows.h>
 #include <time.h>
 #include <utility>
@@ -7,19 +9,6 @@
 
 namespace wintime {
 
-  struct unix_time_t {
-    uint64_t seconds;
-    uint32_t nanoseconds;
-
-    bool operator == (const unix_time_t& other) const {
-      return seconds == other.seconds
-          && nanoseconds == other.nanoseconds;
-    }
-    bool operator != (const unix_time_t& other) const {
-      return !((*this) == other);
-    }
-  };
-
   const uint64_t filetime_Jan1970 = 116444736000000000u; // '100 nanosecons since 1601
   const uint64_t filetime_Second  =           10000000u;
   const uint64_t nanosecond_Filetime = 100u; // filetime stores 100 nanoseconds
@@ -0,0 +1,249 @@
+#include "binary/binary_builder.h"
+#include "binary/binary_reader.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Encoding and decoding of nfs3 attributes and READDIRPLUS entries.
+ * The legacy types are the previous byte at a time implementation for comparison.
+ * The structures mirror nfs3::file_attr_t and nfs3::read_dir_plus_entry_t in a plain
+ * form, so both builders encode the same data without the xdr schema of the nfs types.
+ */
+namespace {
+  struct legacy_builder_t {
+    binary_t build() const { return binary_m; }
+    void clear() { binary_m.clear(); offset_m = 0; }
+
+    void append8(uint8_t value) {
+      if (offset_m >= binary_m.size()) binary_m.push_back(value);
+      else binary_m[offset_m] = value;
+      ++offset_m;
+    }
+    void append32(uint32_t value) {
+      for (auto n = sizeof(value); n--;) append8((value >> (n*8)) & 255);
+    }
+    void append64(uint64_t value) {
+      for (auto n = sizeof(value); n--;) append8((value >> (n*8)) & 255);
+    }
+    void append_binary(const uint8_t* binary, size_t size) {
+      auto binary_size = binary_m.size();
+      while (offset_m < binary_size && size > 0) {
+          binary_m[offset_m] = *binary;
+          ++offset_m; ++binary; --size;
+        }
+      if (size > 0) {
+          binary_m.insert(binary_m.end(), binary, binary + size);
+          offset_m += size;
+        }
+    }
+
+    size_t offset_m = 0;
+    binary_t binary_m;
+  };
+
+  struct legacy_reader_t {
+    explicit legacy_reader_t(const binary_t& binary) : binary_m(binary) {}
+
+    uint8_t get8(size_t offset) const { return binary_m[offset]; }
+    uint32_t get32(size_t offset) const {
+      uint32_t result = 0;
+      for (auto i = 0u; i < sizeof(result); ++i) result = (result << 8) + get8(offset + i);
+      return result;
+    }
+    uint64_t get64(size_t offset) const {
+      uint64_t result = 0;
+      for (auto i = 0u; i < sizeof(result); ++i) result = (result << 8) + get8(offset + i);
+      return result;
+    }
+    void get_binary(size_t offset, uint8_t* data, size_t size) const {
+      for (auto i = 0u; i < size; ++i) data[i] = get8(offset + i);
+    }
+
+    const binary_t& binary_m;
+  };
+
+  struct time_t { uint32_t seconds; uint32_t nanoseconds; };
+  struct file_attr_t {
+    uint32_t type, mode, nlink, uid, gid;
+    uint64_t size, used;
+    uint32_t rdev1, rdev2;
+    uint64_t fsid, fileid;
+    time_t atime, mtime, ctime;
+  };
+  struct read_dir_plus_entry_t {
+    uint64_t file_id;
+    std::string name;
+    uint64_t cookie;
+    file_attr_t attributes;
+    binary_t handle;
+  };
+
+  enum { FILE_ATTR_SIZE = 84 };
+
+  file_attr_t sample_attr(uint64_t id) {
+    return { 1, 0777, 1, 0, 0, 4096 * id, 4096 * id, 0, 0, 42, id, {1, 2}, {3, 4}, {5, 6} };
+  }
+
+  std::vector<read_dir_plus_entry_t> sample_entries(size_t count) {
+    std::vector<read_dir_plus_entry_t> result;
+    for (auto i = 0u; i < count; ++i) {
+        result.push_back({ i, "file_" + std::to_string(i) + ".txt", i + 1, sample_attr(i), binary_t(32, 7) });
+      }
+    return result;
+  }
+
+  template<typename builder_t>
+  void write_time(builder_t& builder, const time_t& time) {
+    builder.append32(time.seconds);
+    builder.append32(time.nanoseconds);
+  }
+
+  template<typename builder_t>
+  void write_file_attr(builder_t& builder, const file_attr_t& attr) {
+    builder.append32(attr.type);
+    builder.append32(attr.mode);
+    builder.append32(attr.nlink);
+    builder.append32(attr.uid);
+    builder.append32(attr.gid);
+    builder.append64(attr.size);
+    builder.append64(attr.used);
+    builder.append32(attr.rdev1);
+    builder.append32(attr.rdev2);
+    builder.append64(attr.fsid);
+    builder.append64(attr.fileid);
+    write_time(builder, attr.atime);
+    write_time(builder, attr.mtime);
+    write_time(builder, attr.ctime);
+  }
+
+  template<typename builder_t>
+  void write_opaque(builder_t& builder, const uint8_t* data, size_t size) {
+    builder.append32(size);
+    builder.append_binary(data, size);
+    for (; (size & 3) != 0; ++size) builder.append8(0);
+  }
+
+  template<typename builder_t>
+  void write_entries(builder_t& builder, const std::vector<read_dir_plus_entry_t>& entries) {
+    for (const auto& entry : entries) {
+        builder.append32(1);
+        builder.append64(entry.file_id);
+        write_opaque(builder, (const uint8_t*)entry.name.data(), entry.name.size());
+        builder.append64(entry.cookie);
+        builder.append32(1);
+        write_file_attr(builder, entry.attributes);
+        builder.append32(1);
+        write_opaque(builder, entry.handle.data(), entry.handle.size());
+      }
+    builder.append32(0);
+  }
+
+  template<typename reader_t>
+  uint64_t read_file_attr(const reader_t& reader, size_t offset) {
+    uint64_t sum = 0;
+    for (auto i = 0; i < 5; ++i) sum += reader.get32(offset + 4 * i);
+    sum += reader.get64(offset + 20) + reader.get64(offset + 28);
+    sum += reader.get32(offset + 36) + reader.get32(offset + 40);
+    sum += reader.get64(offset + 44) + reader.get64(offset + 52);
+    for (auto i = 0; i < 6; ++i) sum += reader.get32(offset + 60 + 4 * i);
+    return sum;
+  }
+
+  // walks all entries like a client decoding the reply
+  template<typename reader_t>
+  uint64_t read_entries(const reader_t& reader) {
+    uint64_t sum = 0;
+    uint8_t name[256];
+    size_t offset = 0;
+    while (reader.get32(offset)) {
+        sum += reader.get64(offset + 4);
+        auto name_size = reader.get32(offset + 12);
+        reader.get_binary(offset + 16, name, name_size);
+        offset += 16 + ((name_size + 3) & ~3u);
+        sum += name[0] + reader.get64(offset);
+        sum += read_file_attr(reader, offset + 12);
+        offset += 12 + FILE_ATTR_SIZE;
+        auto handle_size = reader.get32(offset + 4);
+        offset += 8 + ((handle_size + 3) & ~3u);
+      }
+    return sum;
+  }
+} // namespace
+
+template<typename builder_t>
+static void BM_encode_file_attr(benchmark::State& state) {
+  auto attr = sample_attr(1);
+  builder_t builder;
+  for (auto _ : state) {
+      builder.clear();
+      for (auto i = 0; i < 64; ++i) write_file_attr(builder, attr);
+      benchmark::DoNotOptimize(builder.build());
+    }
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK_TEMPLATE(BM_encode_file_attr, legacy_builder_t);
+BENCHMARK_TEMPLATE(BM_encode_file_attr, binary_builder_t);
+
+template<typename builder_t>
+static void BM_encode_read_dir_plus(benchmark::State& state) {
+  auto entries = sample_entries(state.range(0));
+  for (auto _ : state) {
+      builder_t builder;
+      write_entries(builder, entries);
+      benchmark::DoNotOptimize(builder.build());
+    }
+  state.SetItemsProcessed(state.iterations() * entries.size());
+}
+BENCHMARK_TEMPLATE(BM_encode_read_dir_plus, legacy_builder_t)->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(BM_encode_read_dir_plus, binary_builder_t)->Arg(16)->Arg(256);
+
+static void BM_decode_file_attr_legacy(benchmark::State& state) {
+  binary_builder_t builder;
+  write_file_attr(builder, sample_attr(1));
+  auto binary = builder.build();
+  legacy_reader_t reader(binary);
+  for (auto _ : state) {
+      benchmark::DoNotOptimize(read_file_attr(reader, 0));
+    }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_decode_file_attr_legacy);
+
+static void BM_decode_file_attr(benchmark::State& state) {
+  binary_builder_t builder;
+  write_file_attr(builder, sample_attr(1));
+  auto binary = builder.build();
+  auto reader = binary_reader_t::binary(binary);
+  for (auto _ : state) {
+      benchmark::DoNotOptimize(read_file_attr(reader, 0));
+    }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_decode_file_attr);
+
+static void BM_decode_read_dir_plus_legacy(benchmark::State& state) {
+  binary_builder_t builder;
+  write_entries(builder, sample_entries(state.range(0)));
+  auto binary = builder.build();
+  legacy_reader_t reader(binary);
+  for (auto _ : state) {
+      benchmark::DoNotOptimize(read_entries(reader));
+    }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_decode_read_dir_plus_legacy)->Arg(16)->Arg(256);
+
+static void BM_decode_read_dir_plus(benchmark::State& state) {
+  binary_builder_t builder;
+  write_entries(builder, sample_entries(state.range(0)));
+  auto binary = builder.build();
+  auto reader = binary_reader_t::binary(binary);
+  for (auto _ : state) {
+      benchmark::DoNotOptimize(read_entries(reader));
+    }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_decode_read_dir_plus)->Arg(16)->Arg(256);
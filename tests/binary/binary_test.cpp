@@ -0,0 +1,186 @@
+#include "binary/segmented_binary.h"
+#include "binary/binary_builder.h"
+#include "binary/binary_reader.h"
+#include "binary/buffer_pool.h"
+#include "binary/crc32.h"
+#include "rpc/xdr.h"
+
+#include <gtest/gtest.h>
+
+TEST(segmented_binary, append_and_flatten) {
+  static const uint8_t borrowed[] = { 4, 5 };
+  segmented_binary_t segments(binary_t{ 2, 3 });
+  segments.append_borrowed(borrowed, sizeof(borrowed));
+  segments.append(binary_t{ 6 });
+  segments.append(binary_t{}); // empty segments are skipped
+  segments.prepend(binary_t{ 1 });
+
+  EXPECT_EQ(4u, segments.segments().size());
+  EXPECT_EQ(6u, segments.size());
+  EXPECT_EQ((binary_t{ 1, 2, 3, 4, 5, 6 }), segments.flatten());
+}
+
+TEST(segmented_binary, owned_segment_is_moved) {
+  binary_t payload(4096, 7);
+  auto data = payload.data();
+  segmented_binary_t segments;
+  segments.append(std::move(payload));
+  EXPECT_EQ(data, segments.segments().front().data());
+}
+
+TEST(segmented_binary, copy_from_offset) {
+  segmented_binary_t segments(binary_t{ 1, 2, 3 });
+  segments.append(binary_t{ 4, 5 });
+  for (size_t offset = 0; offset <= segments.size(); ++offset) {
+      binary_t copy = { 0 };
+      segments.copy_to(copy, offset);
+      binary_t expected = { 0 };
+      for (auto value = offset + 1; value <= 5; ++value) expected.push_back(static_cast<uint8_t>(value));
+      EXPECT_EQ(expected, copy) << "offset " << offset;
+    }
+}
+
+// replies appended behind a slow socket must not copy the pending buffer each time
+TEST(segmented_binary, copy_to_grows_the_target_geometrically) {
+  segmented_binary_t reply(binary_t(1000, 7));
+  binary_t pending;
+  size_t reallocations = 0;
+  for (auto i = 0; i < 1000; ++i) {
+      auto data = pending.data();
+      reply.copy_to(pending);
+      if (data != pending.data()) ++reallocations;
+    }
+  EXPECT_EQ(1000u * 1000u, pending.size());
+  EXPECT_GT(20u, reallocations);
+}
+
+TEST(segmented_binary, xdr_opaque_segment_matches_opaque) {
+  for (size_t size = 0; size < 9; ++size) {
+      binary_t data(size, 0xAB);
+
+      binary_builder_t expected;
+      expected.append32(42);
+      xdr::write_opaque_binary(expected, data);
+
+      segmented_binary_t segments;
+      binary_builder_t builder;
+      builder.append32(42);
+      xdr::write_opaque_segment(segments, builder, std::move(data));
+
+      EXPECT_EQ(expected.build(), segments.flatten()) << "size " << size;
+      EXPECT_EQ(0u, builder.size());
+    }
+}
+
+TEST(binary_builder, big_endian_words) {
+  binary_builder_t builder;
+  builder.append8(0x01);
+  builder.append32(0x02030405u);
+  builder.append64(0x060708090A0B0C0Dull);
+  EXPECT_EQ((binary_t{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 }), builder.build());
+}
+
+TEST(binary_builder, overwrite_after_seek) {
+  binary_builder_t builder;
+  builder.append32(0);
+  builder.append32(0x0A0B0C0Du);
+  builder.seek_to(2);
+  builder.append32(0x01020304u); // overwrites two bytes and appends two
+  EXPECT_EQ((binary_t{ 0, 0, 1, 2, 3, 4, 0x0C, 0x0D }), builder.build());
+  builder.seek_end();
+  builder.append8(5);
+  EXPECT_EQ(9u, builder.size());
+}
+
+TEST(binary_reader, big_endian_words) {
+  binary_t binary = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+  auto reader = binary_reader_t::binary(binary);
+  EXPECT_EQ(0x01020304u, reader.get32(0));
+  EXPECT_EQ(0x05060708090A0B0Cull, reader.get64(4));
+  EXPECT_EQ((binary_t{ 3, 4, 5 }), reader.get_binary(2, 3));
+}
+
+TEST(binary_cursor, sequential_reads) {
+  binary_builder_t builder;
+  builder.append32(7u);
+  builder.append64(0x0102030405060708ull);
+  builder.append32(3u);
+  builder.append_binary(binary_t{ 'a', 'b', 'c', 0 });
+  auto binary = builder.build();
+
+  binary_cursor_t cursor(binary_reader_t::binary(binary));
+  EXPECT_EQ(7u, cursor.get32());
+  EXPECT_EQ(0x0102030405060708ull, cursor.get64());
+  auto size = cursor.get32();
+  auto text = cursor.get_reader(size);
+  EXPECT_EQ("abc", text.get_string(0, text.size()));
+  EXPECT_TRUE(cursor.align4());
+  EXPECT_TRUE(cursor.valid());
+  EXPECT_EQ(0u, cursor.remaining());
+}
+
+TEST(binary_cursor, out_of_bounds_invalidates) {
+  binary_t binary = { 0, 0, 0, 1, 2 };
+  binary_cursor_t cursor(binary_reader_t::binary(binary));
+  EXPECT_EQ(1u, cursor.get32());
+  EXPECT_EQ(0u, cursor.get32()); // only one byte left
+  EXPECT_FALSE(cursor.valid());
+  EXPECT_EQ(0u, cursor.get64());
+  EXPECT_TRUE(cursor.get_reader(0).empty());
+  EXPECT_EQ(0u, cursor.remaining());
+}
+
+// a length field larger than the data must not allocate
+TEST(binary_cursor, strings_are_length_checked) {
+  binary_t binary = { 'a', 'b', 'c' };
+  binary_cursor_t cursor(binary_reader_t::binary(binary));
+  EXPECT_EQ("ab", cursor.get_string(2));
+  EXPECT_EQ(std::wstring(), cursor.get_wstring(0x40000000));
+  EXPECT_FALSE(cursor.valid());
+  EXPECT_EQ("", cursor.get_string(1));
+}
+
+TEST(crc32, check_values) {
+  const std::string check = "123456789";
+  auto data = reinterpret_cast<const uint8_t*>(check.data());
+  EXPECT_EQ(0xCBF43926u, crc32(data, check.size()));
+  EXPECT_EQ(0u, crc32(data, 0));
+  EXPECT_EQ(crc32(data, 9), crc32(data + 4, 5, crc32(data, 4)));
+}
+
+TEST(buffer_pool, reuses_released_buffers) {
+  buffer_pool_t pool;
+  auto buffer = pool.acquire(0x100000 + 100);
+  EXPECT_LE(0x100000u + 100, buffer.capacity());
+  auto data = buffer.data();
+  buffer.resize(50);
+  pool.release(std::move(buffer));
+  EXPECT_EQ(1u, pool.stats().buffers);
+
+  auto reused = pool.acquire(0x100000 + 1); // same class
+  EXPECT_EQ(data, reused.data());
+  EXPECT_TRUE(reused.empty());
+  auto stats = pool.stats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(0u, stats.buffers);
+}
+
+TEST(buffer_pool, keeps_only_large_buffers_within_the_budget) {
+  buffer_pool_t::config_t config;
+  config.budget = 3 * buffer_pool_t::GRANULE;
+  buffer_pool_t pool(config);
+  pool.release(binary_t(100)); // small
+  pool.release(binary_t(2 * buffer_pool_t::MAX_BUFFER)); // huge
+  pool.release(binary_t(2 * buffer_pool_t::GRANULE));
+  pool.release(binary_t(2 * buffer_pool_t::GRANULE)); // above the budget
+  auto stats = pool.stats();
+  EXPECT_EQ(1u, stats.buffers);
+  EXPECT_EQ(size_t(2 * buffer_pool_t::GRANULE), stats.bytes);
+
+  segmented_binary_t reply(binary_t{ 1, 2, 3 });
+  reply.append(binary_t(buffer_pool_t::GRANULE));
+  pool.release(std::move(reply));
+  EXPECT_TRUE(reply.empty());
+  EXPECT_EQ(2u, pool.stats().buffers);
+}
@@ -0,0 +1,90 @@
+#include "container/handle_cache.h"
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/*
+ * Open file per request compared to the shared handle cache.
+ * The files are opened by path, the closest POSIX equivalent of OpenFileById.
+ */
+namespace {
+  struct fd_handle_t {
+    fd_handle_t() = default;
+    explicit fd_handle_t(int fd) : fd_m(fd) {}
+    ~fd_handle_t() { if (valid()) ::close(fd_m); }
+
+    fd_handle_t(const fd_handle_t&) = delete;
+    fd_handle_t& operator= (const fd_handle_t&) = delete;
+    fd_handle_t(fd_handle_t&& other) : fd_m(other.fd_m) { other.fd_m = -1; }
+
+    bool valid() const { return 0 <= fd_m; }
+    int fd() const { return fd_m; }
+
+  private:
+    int fd_m = -1;
+  };
+
+  using cache_t = handle_cache_t<int, fd_handle_t>;
+
+  enum { FILE_COUNT = 64 };
+
+  // the files of the working set
+  const std::vector<std::string>& paths() {
+    static auto result = [] {
+        std::vector<std::string> result;
+        char directory[] = "/tmp/handle_cache_benchXXXXXX";
+        if (nullptr == ::mkdtemp(directory)) return result;
+        for (auto i = 0; i < FILE_COUNT; ++i) {
+            result.push_back(std::string(directory) + "/file" + std::to_string(i));
+            auto fd = ::open(result.back().c_str(), O_CREAT | O_WRONLY, 0644);
+            if (0 <= fd) ::close(fd);
+          }
+        return result;
+      }();
+    return result;
+  }
+
+  // threads start at different files
+  size_t first_index() {
+    static std::atomic<size_t> next {0};
+    return 7 * next++;
+  }
+
+  // one attribute request: open, stat, close
+  void BM_open_per_request(benchmark::State& state) {
+    const auto& files = paths();
+    size_t index = first_index();
+    while (state.KeepRunning()) {
+        fd_handle_t handle(::open(files[index++ % FILE_COUNT].c_str(), O_RDONLY));
+        struct stat info;
+        benchmark::DoNotOptimize(::fstat(handle.fd(), &info));
+      }
+  }
+  BENCHMARK(BM_open_per_request)->Threads(1)->Threads(4);
+
+  cache_t& shared_cache() {
+    static cache_t cache;
+    return cache;
+  }
+
+  void BM_handle_cache(benchmark::State& state) {
+    const auto& files = paths();
+    auto& cache = shared_cache();
+    size_t index = first_index();
+    while (state.KeepRunning()) {
+        auto key = static_cast<int>(index++ % FILE_COUNT);
+        auto handle = cache.get(key, [&] { return fd_handle_t(::open(files[key].c_str(), O_RDONLY)); });
+        struct stat info;
+        benchmark::DoNotOptimize(::fstat(handle->fd(), &info));
+      }
+    state.counters["hit_rate"] = benchmark::Counter(cache.stats().hit_rate(), benchmark::Counter::kAvgThreads);
+  }
+  BENCHMARK(BM_handle_cache)->Threads(1)->Threads(4);
+} // namespace
@@ -0,0 +1,180 @@
+#include "container/handle_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+  // POSIX file descriptor as cached handle
+  struct fd_handle_t {
+    fd_handle_t() = default;
+    explicit fd_handle_t(int fd) : fd_m(fd) {}
+    ~fd_handle_t() {
+      if (valid()) {
+          ::close(fd_m);
+          ++closed;
+        }
+    }
+
+    fd_handle_t(const fd_handle_t&) = delete;
+    fd_handle_t& operator= (const fd_handle_t&) = delete;
+    fd_handle_t(fd_handle_t&& other) : fd_m(other.fd_m) { other.fd_m = -1; }
+
+    bool valid() const { return 0 <= fd_m; }
+    int fd() const { return fd_m; }
+
+    static std::atomic<int> closed;
+
+  private:
+    int fd_m = -1;
+  };
+  std::atomic<int> fd_handle_t::closed {0};
+
+  // time only advances when the test says so
+  struct manual_clock_t {
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<manual_clock_t>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() { return time_point(duration(current)); }
+    static rep current;
+  };
+  manual_clock_t::rep manual_clock_t::current = 0;
+
+  using cache_t = handle_cache_t<int, fd_handle_t, std::hash<int>, manual_clock_t>;
+
+  struct handle_cache_test : ::testing::Test {
+    void SetUp() override {
+      fd_handle_t::closed = 0;
+      manual_clock_t::current = 0;
+    }
+
+    // opens /dev/null and counts the opens
+    auto opener() {
+      return [this] {
+          ++opened;
+          return fd_handle_t(::open("/dev/null", O_RDONLY));
+        };
+    }
+
+    cache_t::config_t config(size_t capacity, size_t shards = 1) {
+      cache_t::config_t result;
+      result.capacity = capacity;
+      result.shards = shards;
+      result.idle_timeout = std::chrono::seconds(10);
+      return result;
+    }
+
+    std::atomic<int> opened {0};
+  };
+} // namespace
+
+TEST_F(handle_cache_test, shares_open_handles) {
+  cache_t cache(config(4));
+  auto first = cache.get(1, opener());
+  auto second = cache.get(1, opener());
+  ASSERT_TRUE(first->valid());
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(1, opened);
+
+  auto stats = cache.stats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.size);
+  EXPECT_DOUBLE_EQ(0.5, stats.hit_rate());
+}
+
+TEST_F(handle_cache_test, invalid_handles_are_not_cached) {
+  cache_t cache(config(4));
+  auto failed = cache.get(1, [] { return fd_handle_t(); });
+  EXPECT_FALSE(failed->valid());
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_TRUE(cache.get(1, opener())->valid());
+}
+
+TEST_F(handle_cache_test, evicts_least_recently_used) {
+  cache_t cache(config(2));
+  cache.get(1, opener());
+  cache.get(2, opener());
+  cache.get(1, opener()); // 2 is now the oldest
+  cache.get(3, opener());
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(1, fd_handle_t::closed);
+  EXPECT_EQ(1u, cache.stats().evictions);
+
+  cache.get(1, opener());
+  EXPECT_EQ(3, opened);
+  cache.get(2, opener());
+  EXPECT_EQ(4, opened);
+}
+
+TEST_F(handle_cache_test, evicted_handle_stays_open_while_used) {
+  cache_t cache(config(1));
+  auto in_use = cache.get(1, opener());
+  cache.get(2, opener());
+  EXPECT_EQ(0, fd_handle_t::closed);
+  EXPECT_NE(-1, ::fcntl(in_use->fd(), F_GETFD));
+  in_use.reset();
+  EXPECT_EQ(1, fd_handle_t::closed);
+}
+
+TEST_F(handle_cache_test, invalidate) {
+  cache_t cache(config(16, 4));
+  for (auto key = 0; key < 10; ++key) cache.get(key, opener());
+
+  EXPECT_TRUE(cache.invalidate(3));
+  EXPECT_FALSE(cache.invalidate(3));
+  EXPECT_EQ(1, fd_handle_t::closed);
+
+  EXPECT_EQ(5u, cache.invalidate_if([](int key) { return 0 == key % 2; }));
+  EXPECT_EQ(4u, cache.size());
+  EXPECT_EQ(6u, cache.stats().invalidations);
+
+  cache.get(3, opener());
+  EXPECT_EQ(11, opened);
+}
+
+TEST_F(handle_cache_test, evicts_idle_handles) {
+  cache_t cache(config(16, 4));
+  cache.get(1, opener());
+  auto in_use = cache.get(2, opener());
+  manual_clock_t::current = 5000;
+  cache.get(3, opener());
+
+  manual_clock_t::current = 11000;
+  EXPECT_EQ(1u, cache.evict_idle()); // 2 is still in use, 3 is recent
+  EXPECT_EQ(2u, cache.size());
+
+  in_use.reset();
+  manual_clock_t::current = 16000;
+  cache.get(4, opener()); // sweeps during get
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ(3u, cache.stats().evictions);
+}
+
+TEST_F(handle_cache_test, concurrent_users_share_handles) {
+  cache_t cache(config(256, 8));
+  std::vector<std::thread> threads;
+  for (auto thread = 0; thread < 8; ++thread) {
+      threads.emplace_back([&] {
+          for (auto i = 0; i < 10000; ++i) {
+              auto handle = cache.get(i % 32, opener());
+              ASSERT_TRUE(handle->valid());
+            }
+        });
+    }
+  for (auto& thread : threads) thread.join();
+
+  auto stats = cache.stats();
+  EXPECT_EQ(80000u, stats.hits + stats.misses);
+  EXPECT_EQ(32u, stats.size);
+  EXPECT_EQ(0u, stats.evictions);
+  EXPECT_EQ(opened, fd_handle_t::closed + 32); // concurrent opens of one key are closed again
+}
@@ -0,0 +1,63 @@
+#include "container/id_table.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(id_table, finds_inserted_ids) {
+  id_table_t<int> table;
+  int a = 1, b = 2;
+  EXPECT_TRUE(table.insert(7, &a));
+  EXPECT_TRUE(table.insert(0, &b));
+  EXPECT_FALSE(table.insert(7, &b)); // stored already
+  EXPECT_FALSE(table.insert(8, nullptr));
+  EXPECT_EQ(2u, table.size());
+
+  EXPECT_EQ(&a, table.find(7));
+  EXPECT_EQ(&b, table.find(0));
+  EXPECT_EQ(nullptr, table.find(8));
+}
+
+TEST(id_table, keeps_ids_when_growing) {
+  id_table_t<size_t> table(1);
+  std::vector<size_t> values(10000);
+  for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = i;
+      ASSERT_TRUE(table.insert(i * 4096, &values[i])); // ids that share low bits
+    }
+  for (size_t i = 0; i < values.size(); ++i) EXPECT_EQ(&values[i], table.find(i * 4096));
+  EXPECT_EQ(nullptr, table.find(1));
+
+  table.reserve(100000);
+  EXPECT_EQ(&values.back(), table.find((values.size() - 1) * 4096));
+}
+
+// readers never see a missing id that was inserted before they looked
+TEST(id_table, readers_run_while_the_writer_grows) {
+  id_table_t<size_t> table(1);
+  std::vector<size_t> values(20000);
+  std::atomic<size_t> inserted {0};
+  std::atomic<bool> failed {false};
+
+  std::vector<std::thread> readers;
+  for (auto r = 0; r < 4; ++r) {
+      readers.emplace_back([&] {
+          while (inserted.load() < values.size()) {
+              auto count = inserted.load();
+              for (size_t i = count > 64 ? count - 64 : 0; i < count; ++i) {
+                  auto value = table.find(i + 1);
+                  if ( !value || *value != i) failed = true;
+                }
+            }
+        });
+    }
+  for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = i;
+      table.insert(i + 1, &values[i]);
+      inserted.store(i + 1);
+    }
+  for (auto& reader : readers) reader.join();
+  EXPECT_FALSE(failed);
+}
@@ -0,0 +1,65 @@
+#include "container/latency_histogram.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+  using ns = std::chrono::nanoseconds;
+
+  // percentiles are bucket bounds - within 1/SUB_BUCKETS above the value
+  void expect_near(uint64_t expected, ns actual) {
+    EXPECT_LE(expected, static_cast<uint64_t>(actual.count()));
+    EXPECT_GE(expected + expected / latency_histogram_t::SUB_BUCKETS, static_cast<uint64_t>(actual.count()));
+  }
+} // namespace
+
+TEST(latency_histogram, small_values_are_exact) {
+  latency_histogram_t histogram;
+  for (auto i = 0; i < 10; ++i) histogram.record(ns(i));
+  EXPECT_EQ(10u, histogram.count());
+  EXPECT_EQ(ns(4), histogram.percentile(50));
+  EXPECT_EQ(ns(9), histogram.percentile(100));
+  EXPECT_EQ(ns(9), histogram.max());
+}
+
+TEST(latency_histogram, percentiles_have_bounded_error) {
+  latency_histogram_t histogram;
+  for (uint64_t i = 1; i <= 100000; ++i) histogram.record(ns(i * 1000));
+  expect_near(50000000, histogram.percentile(50));
+  expect_near(99000000, histogram.percentile(99));
+  expect_near(99900000, histogram.percentile(99.9));
+  EXPECT_EQ(ns(100000000), histogram.max());
+}
+
+TEST(latency_histogram, buckets_cover_their_values) {
+  for (uint64_t value = 1; value < (uint64_t(1) << latency_histogram_t::VALUE_BITS); value = value * 3 + 1) {
+      auto bucket = latency_histogram_t::bucket(value);
+      ASSERT_LT(bucket, size_t(latency_histogram_t::BUCKETS));
+      EXPECT_LE(value, latency_histogram_t::upper_bound(bucket));
+      if (bucket > 0) {
+          EXPECT_GT(value, latency_histogram_t::upper_bound(bucket - 1));
+        }
+    }
+}
+
+TEST(latency_histogram, clamps_large_values) {
+  latency_histogram_t histogram;
+  histogram.record(std::chrono::hours(1));
+  histogram.record(ns(-5));
+  EXPECT_EQ(2u, histogram.count());
+  EXPECT_EQ(ns((int64_t(1) << latency_histogram_t::VALUE_BITS) - 1), histogram.max());
+  EXPECT_EQ(ns(0), histogram.percentile(50));
+}
+
+TEST(latency_histogram, merges_buckets) {
+  latency_histogram_t a, b, c;
+  a.record(ns(100));
+  b.record(ns(100000));
+  a.merge(b);
+  EXPECT_EQ(2u, a.count());
+  EXPECT_EQ(ns(100000), a.max());
+
+  c.add_bucket(latency_histogram_t::bucket(100), 3);
+  c.add_max(ns(100));
+  EXPECT_EQ(3u, c.count());
+  EXPECT_EQ(ns(100), c.percentile(99));
+}
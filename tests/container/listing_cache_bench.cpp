@@ -0,0 +1,132 @@
+#include "container/listing_cache.h"
+
+#include <benchmark/benchmark.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Listing a large directory in READDIR sized chunks.
+ * Restarting the enumeration for every chunk compared to continuing in a cached listing.
+ */
+namespace {
+  enum : size_t {
+    ENTRY_COUNT = 100000,
+    REPLY_SIZE = 8192,
+    ENTRY_SIZE = 4 + 8 + 4 + 12 + 8, // marker, file id, name, cookie
+    CHUNK_ENTRIES = REPLY_SIZE / ENTRY_SIZE,
+  };
+
+  struct entry_t {
+    uint64_t file_id;
+    std::string name;
+  };
+
+  using cache_t = listing_cache_t<std::string, entry_t>;
+
+  const std::string& directory() {
+    static auto result = [] {
+        char directory[] = "/tmp/listing_cache_benchXXXXXX";
+        if (nullptr == ::mkdtemp(directory)) return std::string();
+        for (size_t i = 0; i < ENTRY_COUNT; ++i) {
+            auto path = std::string(directory) + "/file" + std::to_string(i);
+            auto fd = ::open(path.c_str(), O_CREAT | O_WRONLY, 0644);
+            if (0 <= fd) ::close(fd);
+          }
+        return std::string(directory);
+      }();
+    return result;
+  }
+
+  // the directory version used as cookie verifier
+  uint64_t version(const std::string& path) {
+    struct stat info;
+    if (0 != ::stat(path.c_str(), &info)) return 0;
+    return static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000u + info.st_mtim.tv_nsec;
+  }
+
+  template<typename callback_t> // bool (const dirent&)
+  void enumerate(const std::string& path, const callback_t& callback) {
+    auto dir = ::opendir(path.c_str());
+    if (nullptr == dir) return;
+    while (auto entry = ::readdir(dir)) {
+        if ( !callback(*entry)) break;
+      }
+    ::closedir(dir);
+  }
+
+  // one READDIR call as implemented before: restart and skip up to the cookie
+  size_t read_dir_restart(const std::string& path, uint64_t cookie, std::vector<entry_t>& reply) {
+    version(path);
+    uint64_t file_cookie = 0;
+    enumerate(path, [&](const dirent& entry) {
+        ++file_cookie;
+        if (file_cookie <= cookie) return true;
+        if (reply.size() == CHUNK_ENTRIES) return false;
+        reply.push_back({ entry.d_ino, entry.d_name });
+        return true;
+      });
+    return reply.size();
+  }
+
+  // one READDIR call with the listing cache
+  size_t read_dir_cached(cache_t& cache, const std::string& path, uint64_t cookie, std::vector<entry_t>& reply) {
+    auto directory_version = version(path);
+    auto listing = 0 == cookie ? nullptr : cache.get(path, directory_version);
+    if ( !listing) {
+        std::vector<entry_t> entries;
+        enumerate(path, [&](const dirent& entry) {
+            entries.push_back({ entry.d_ino, entry.d_name });
+            return true;
+          });
+        listing = cache.put(path, directory_version, std::move(entries));
+      }
+    for (auto index = cookie; index < listing->entries.size() && reply.size() < CHUNK_ENTRIES; ++index) {
+        reply.push_back(listing->entries[index]);
+      }
+    return reply.size();
+  }
+
+  template<typename read_dir_t>
+  void list_directory(benchmark::State& state, const read_dir_t& read_dir) {
+    const auto& path = directory();
+    if (path.empty()) {
+        state.SkipWithError("no directory");
+        return;
+      }
+    size_t calls = 0;
+    for (auto _ : state) {
+        uint64_t cookie = 0;
+        std::vector<entry_t> reply;
+        while (true) {
+            reply.clear();
+            auto count = read_dir(path, cookie, reply);
+            ++calls;
+            if (0 == count) break;
+            cookie += count;
+          }
+        benchmark::DoNotOptimize(cookie);
+      }
+    state.counters["calls"] = benchmark::Counter(calls, benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * ENTRY_COUNT);
+  }
+
+  void BM_list_restart(benchmark::State& state) {
+    list_directory(state, &read_dir_restart);
+  }
+
+  void BM_list_cached(benchmark::State& state) {
+    cache_t cache;
+    list_directory(state, [&](const std::string& path, uint64_t cookie, std::vector<entry_t>& reply) {
+        return read_dir_cached(cache, path, cookie, reply);
+      });
+  }
+} // namespace
+
+BENCHMARK(BM_list_restart)->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK(BM_list_cached)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,87 @@
+#include "container/listing_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+  using cache_t = listing_cache_t<int, std::string>;
+
+  cache_t::config_t config(size_t capacity, size_t listings = 64) {
+    cache_t::config_t result;
+    result.capacity = capacity;
+    result.listings = listings;
+    return result;
+  }
+
+  std::vector<std::string> entries(size_t count) {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < count; ++i) result.push_back(std::to_string(i));
+    return result;
+  }
+} // namespace
+
+TEST(listing_cache, continues_same_version) {
+  cache_t cache(config(100));
+  EXPECT_FALSE(cache.get(1, 7));
+  auto stored = cache.put(1, 7, entries(10));
+  auto listing = cache.get(1, 7);
+  ASSERT_TRUE(listing);
+  EXPECT_EQ(stored, listing);
+  EXPECT_EQ(10u, listing->entries.size());
+  EXPECT_EQ("3", listing->entries[3]);
+
+  auto stats = cache.stats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(10u, stats.size);
+}
+
+TEST(listing_cache, other_version_is_replaced) {
+  cache_t cache(config(100));
+  auto old_listing = cache.put(1, 7, entries(10));
+  EXPECT_FALSE(cache.get(1, 8));
+  cache.put(1, 8, entries(5));
+  EXPECT_FALSE(cache.get(1, 7));
+  EXPECT_EQ(5u, cache.stats().size);
+  EXPECT_EQ(10u, old_listing->entries.size()); // still usable by a running reply
+}
+
+TEST(listing_cache, bounded_by_entries) {
+  cache_t cache(config(25));
+  cache.put(1, 1, entries(10));
+  cache.put(2, 1, entries(10));
+  EXPECT_TRUE(cache.get(1, 1)); // 2 is now the oldest
+  cache.put(3, 1, entries(10));
+  EXPECT_FALSE(cache.get(2, 1));
+  EXPECT_TRUE(cache.get(1, 1));
+  EXPECT_TRUE(cache.get(3, 1));
+
+  auto huge = cache.put(4, 1, entries(30));
+  EXPECT_EQ(30u, huge->entries.size());
+  EXPECT_FALSE(cache.get(4, 1));
+
+  auto stats = cache.stats();
+  EXPECT_EQ(20u, stats.size);
+  EXPECT_EQ(1u, stats.evictions);
+}
+
+TEST(listing_cache, bounded_by_listings) {
+  cache_t cache(config(100, 2));
+  cache.put(1, 1, entries(1));
+  cache.put(2, 1, entries(1));
+  cache.put(3, 1, entries(1));
+  EXPECT_FALSE(cache.get(1, 1));
+  EXPECT_EQ(2u, cache.stats().listings);
+}
+
+TEST(listing_cache, invalidate) {
+  cache_t cache(config(100));
+  cache.put(1, 1, entries(10));
+  EXPECT_TRUE(cache.invalidate(1));
+  EXPECT_FALSE(cache.invalidate(1));
+  cache.put(2, 1, entries(10));
+  cache.clear();
+  EXPECT_FALSE(cache.get(2, 1));
+  EXPECT_EQ(0u, cache.stats().size);
+}
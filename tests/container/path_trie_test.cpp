@@ -0,0 +1,96 @@
+#include "container/path_trie.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+  using trie_t = path_trie_t<int>;
+
+  trie_t::value_ptr_t value(int v) { return std::make_shared<const int>(v); }
+
+  // the matched value and prefix - -1 if nothing matched
+  std::pair<int, size_t> match(const trie_t& trie, const std::string& path) {
+    auto result = trie.longest_prefix(path);
+    return { result.value ? *result.value : -1, result.length };
+  }
+
+  std::vector<std::string> paths(const trie_t& trie) {
+    std::vector<std::string> result;
+    trie.for_each([&](const std::string& path, int) { result.push_back(path); });
+    return result;
+  }
+} // namespace
+
+TEST(path_trie, longest_prefix_of_full_components) {
+  trie_t trie;
+  EXPECT_TRUE(trie.insert("/a", value(1)));
+  EXPECT_TRUE(trie.insert("/a/b/c", value(3)));
+  EXPECT_TRUE(trie.insert("/", value(0)));
+  EXPECT_FALSE(trie.insert("a", value(9)));
+  EXPECT_EQ(3u, trie.size());
+
+  EXPECT_EQ(std::make_pair(1, size_t(2)), match(trie, "/a"));
+  EXPECT_EQ(std::make_pair(1, size_t(2)), match(trie, "/a/b"));
+  EXPECT_EQ(std::make_pair(3, size_t(6)), match(trie, "/a/b/c/d/e"));
+  EXPECT_EQ(std::make_pair(1, size_t(2)), match(trie, "/a/b/cd"));
+  EXPECT_EQ(std::make_pair(-1, size_t(0)), match(trie, "/ab"));
+  EXPECT_EQ(std::make_pair(0, size_t(1)), match(trie, "/"));
+  EXPECT_EQ(std::make_pair(-1, size_t(0)), match(trie, "/x")); // "/" matches itself only
+  EXPECT_EQ(std::make_pair(-1, size_t(0)), match(trie, ""));
+  EXPECT_EQ(std::make_pair(-1, size_t(0)), match(trie, "a/b"));
+
+  EXPECT_EQ(3, *trie.find("/a/b/c"));
+  EXPECT_EQ(nullptr, trie.find("/a/b"));
+  EXPECT_EQ(nullptr, trie.find("/a/b/c/d"));
+}
+
+// a trailing slash is an empty last component
+TEST(path_trie, trailing_slash) {
+  trie_t trie;
+  trie.insert("/a/", value(1));
+  EXPECT_EQ(std::make_pair(1, size_t(3)), match(trie, "/a/"));
+  EXPECT_EQ(std::make_pair(1, size_t(3)), match(trie, "/a//b"));
+  EXPECT_EQ(std::make_pair(-1, size_t(0)), match(trie, "/a/b"));
+  EXPECT_EQ(std::make_pair(-1, size_t(0)), match(trie, "/a"));
+}
+
+TEST(path_trie, erase_prunes_empty_nodes) {
+  trie_t trie;
+  trie.insert("/a/b", value(1));
+  trie.insert("/a/c", value(2));
+  trie.insert("/d", value(3));
+  EXPECT_FALSE(trie.erase("/a"));
+  EXPECT_TRUE(trie.erase("/a/b"));
+  EXPECT_FALSE(trie.erase("/a/b"));
+  EXPECT_EQ(std::vector<std::string>({ "/a/c", "/d" }), paths(trie));
+
+  EXPECT_EQ(1u, trie.erase_if([](int v) { return v == 2; }));
+  EXPECT_EQ(std::vector<std::string>({ "/d" }), paths(trie));
+  EXPECT_EQ(std::make_pair(-1, size_t(0)), match(trie, "/a/c"));
+  EXPECT_EQ(1u, trie.size());
+}
+
+TEST(path_trie, copies_do_not_change) {
+  trie_t published;
+  for (auto i = 0; i < 100; ++i) published.insert("/projects/p" + std::to_string(i), value(i));
+
+  auto copy = published;
+  copy.insert("/projects/p5", value(500));
+  copy.insert("/projects/new", value(1000));
+  copy.erase("/projects/p7");
+  copy.erase_if([](int v) { return v < 5; });
+
+  EXPECT_EQ(100u, published.size());
+  EXPECT_EQ(5, *published.find("/projects/p5"));
+  EXPECT_EQ(7, *published.find("/projects/p7"));
+  EXPECT_EQ(nullptr, published.find("/projects/new"));
+  EXPECT_EQ(3, *published.longest_prefix("/projects/p3/src").value);
+
+  EXPECT_EQ(95u, copy.size());
+  EXPECT_EQ(500, *copy.find("/projects/p5"));
+  EXPECT_EQ(nullptr, copy.find("/projects/p7"));
+  EXPECT_EQ(nullptr, copy.find("/projects/p3"));
+  EXPECT_EQ(1000, *copy.find("/projects/new"));
+}
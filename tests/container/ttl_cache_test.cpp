@@ -0,0 +1,104 @@
+#include "container/ttl_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+  // time only advances when the test says so
+  struct manual_clock_t {
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<manual_clock_t>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() { return time_point(duration(current)); }
+    static rep current;
+  };
+  manual_clock_t::rep manual_clock_t::current = 0;
+
+  using cache_t = ttl_cache_t<int, std::string, std::hash<int>, std::equal_to<int>, manual_clock_t>;
+
+  cache_t::config_t config(size_t capacity, size_t shards = 1, int time_to_live_ms = 1000) {
+    cache_t::config_t result;
+    result.capacity = capacity;
+    result.shards = shards;
+    result.time_to_live = std::chrono::milliseconds(time_to_live_ms);
+    return result;
+  }
+} // namespace
+
+TEST(ttl_cache, get_and_put) {
+  manual_clock_t::current = 0;
+  cache_t cache(config(16, 4));
+  std::string value;
+  EXPECT_FALSE(cache.get(1, value));
+  cache.put(1, "one");
+  cache.put(2, "two");
+  ASSERT_TRUE(cache.get(1, value));
+  EXPECT_EQ("one", value);
+  cache.put(1, "uno");
+  ASSERT_TRUE(cache.get(1, value));
+  EXPECT_EQ("uno", value);
+
+  auto stats = cache.stats();
+  EXPECT_EQ(2u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(2u, stats.size);
+}
+
+TEST(ttl_cache, values_expire) {
+  manual_clock_t::current = 0;
+  cache_t cache(config(16));
+  cache.put(1, "one");
+  cache.put(2, "two");
+  manual_clock_t::current = 500;
+  cache.put(1, "one again"); // stored later - expires later
+
+  std::string value;
+  manual_clock_t::current = 1000;
+  EXPECT_TRUE(cache.get(1, value));
+  EXPECT_FALSE(cache.get(2, value));
+  manual_clock_t::current = 1500;
+  EXPECT_FALSE(cache.get(1, value));
+
+  cache.put(3, "three"); // drops the expired entries
+  EXPECT_EQ(1u, cache.size());
+}
+
+TEST(ttl_cache, capacity_drops_oldest) {
+  manual_clock_t::current = 0;
+  cache_t cache(config(3));
+  for (auto key = 0; key < 5; ++key) cache.put(key, std::to_string(key));
+  EXPECT_EQ(3u, cache.size());
+  std::string value;
+  EXPECT_FALSE(cache.get(0, value));
+  EXPECT_FALSE(cache.get(1, value));
+  EXPECT_TRUE(cache.get(4, value));
+}
+
+TEST(ttl_cache, invalidate) {
+  manual_clock_t::current = 0;
+  cache_t cache(config(16, 4));
+  cache.put(1, "one");
+  cache.put(2, "two");
+  EXPECT_TRUE(cache.invalidate(1));
+  EXPECT_FALSE(cache.invalidate(1));
+  std::string value;
+  EXPECT_FALSE(cache.get(1, value));
+  EXPECT_TRUE(cache.get(2, value));
+
+  cache.clear();
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(2u, cache.stats().invalidations);
+}
+
+TEST(ttl_cache, zero_time_to_live_disables) {
+  cache_t cache(config(16, 1, 0));
+  EXPECT_FALSE(cache.enabled());
+  cache.put(1, "one");
+  std::string value;
+  EXPECT_FALSE(cache.get(1, value));
+  EXPECT_EQ(0u, cache.size());
+}
@@ -0,0 +1,135 @@
+#include "container/string_convert.h"
+
+#include <benchmark/benchmark.h>
+
+#include <clocale>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+/*
+ * Conversion of directory listings: every name of a corpus is converted like READDIR
+ * does. The wcsrtombs variants are the former two pass conversion - length first, then
+ * the conversion into a string of that length - in a utf8 locale.
+ */
+namespace {
+  enum corpus_t { ASCII, LATIN, CJK, EMOJI };
+
+  const char* corpus_name(int corpus) {
+    switch (corpus) {
+      case ASCII: return "ascii";
+      case LATIN: return "latin";
+      case CJK: return "cjk";
+      default: return "emoji";
+      }
+  }
+
+  // 1000 utf8 names of the corpus
+  std::vector<std::string> names(int corpus) {
+    static const char* ascii[] = { "main.cpp", "CMakeLists.txt", "libstdc++.so.6.0.28", "node_modules",
+                                   "IMG_20190612_184233.jpg", "report-final-v2.docx", ".gitignore" };
+    static const char* latin[] = { "R\xC3\xA9sum\xC3\xA9.pdf", "\xC3\x9C" "bersicht_2024.xlsx", "Fa\xC3\xA7" "ade.png",
+                                   "Stra\xC3\x9F" "enplan K\xC3\xB6ln.pdf", "notes.txt", "ma\xC3\xB1" "ana.md" };
+    static const char* cjk[] = { "\xE9\xA0\x85\xE7\x9B\xAE\xE8\xA8\x88\xE7\x94\xBB\xE6\x9B\xB8_\xE7\xAC\xAC" "3\xE7\x89\x88.xlsx",
+                                 "\xE5\x86\x99\xE7\x9C\x9F.jpg", "\xE3\x83\x86\xE3\x82\xB9\xE3\x83\x88.txt",
+                                 "\xEC\x82\xAC\xEC\xA7\x84 2019.png" };
+    static const char* emoji[] = { "\xF0\x9F\x93\xB7 IMG_2041.jpg", "party \xF0\x9F\x8E\x89\xF0\x9F\x8E\x89.mov",
+                                   "todo \xE2\x9C\x85.md", "plain.txt" };
+    std::vector<const char*> samples;
+    switch (corpus) {
+      case ASCII: samples.assign(std::begin(ascii), std::end(ascii)); break;
+      case LATIN: samples.assign(std::begin(latin), std::end(latin)); break;
+      case CJK: samples.assign(std::begin(cjk), std::end(cjk)); break;
+      default: samples.assign(std::begin(emoji), std::end(emoji)); break;
+      }
+    std::vector<std::string> result;
+    for (size_t i = 0; i < 1000; ++i) result.push_back(samples[i % samples.size()] + std::to_string(i));
+    return result;
+  }
+
+  std::vector<std::wstring> wide_names(int corpus) {
+    std::vector<std::wstring> result;
+    for (auto& name : names(corpus)) result.push_back(convert::to_wstring(name));
+    return result;
+  }
+
+  bool utf8_locale() {
+    return nullptr != std::setlocale(LC_ALL, "C.UTF-8") || nullptr != std::setlocale(LC_ALL, "en_US.UTF-8");
+  }
+
+  std::string wcsrtombs_two_pass(const std::wstring& src) {
+    std::mbstate_t state {};
+    auto cstr = src.c_str();
+    auto length = std::wcsrtombs(nullptr, &cstr, 0, &state);
+    if (static_cast<size_t>(-1) == length) return {};
+    std::string result(length, '\0');
+    cstr = src.c_str();
+    std::wcsrtombs(&result[0], &cstr, length, &state);
+    return result;
+  }
+
+  std::wstring mbsrtowcs_two_pass(const std::string& src) {
+    std::mbstate_t state {};
+    auto cstr = src.c_str();
+    auto length = std::mbsrtowcs(nullptr, &cstr, 0, &state);
+    if (static_cast<size_t>(-1) == length) return {};
+    std::wstring result(length, L'\0');
+    cstr = src.c_str();
+    std::mbsrtowcs(&result[0], &cstr, length, &state);
+    return result;
+  }
+
+  template<typename names_t>
+  void set_counters(benchmark::State& state, const names_t& names) {
+    state.SetLabel(corpus_name(static_cast<int>(state.range(0))));
+    state.SetItemsProcessed(state.iterations() * names.size());
+  }
+} // namespace
+
+static void BM_to_utf8(benchmark::State& state) {
+  auto names = wide_names(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+      for (auto& name : names) benchmark::DoNotOptimize(convert::to_string(name));
+    }
+  set_counters(state, names);
+}
+BENCHMARK(BM_to_utf8)->DenseRange(ASCII, EMOJI);
+
+static void BM_to_utf8_wcsrtombs(benchmark::State& state) {
+  if ( !utf8_locale()) return state.SkipWithError("no utf8 locale");
+  auto names = wide_names(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+      for (auto& name : names) benchmark::DoNotOptimize(wcsrtombs_two_pass(name));
+    }
+  set_counters(state, names);
+}
+BENCHMARK(BM_to_utf8_wcsrtombs)->DenseRange(ASCII, EMOJI);
+
+static void BM_from_utf8(benchmark::State& state) {
+  auto names = ::names(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+      for (auto& name : names) benchmark::DoNotOptimize(convert::to_wstring(name));
+    }
+  set_counters(state, names);
+}
+BENCHMARK(BM_from_utf8)->DenseRange(ASCII, EMOJI);
+
+static void BM_from_utf8_mbsrtowcs(benchmark::State& state) {
+  if ( !utf8_locale()) return state.SkipWithError("no utf8 locale");
+  auto names = ::names(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+      for (auto& name : names) benchmark::DoNotOptimize(mbsrtowcs_two_pass(name));
+    }
+  set_counters(state, names);
+}
+BENCHMARK(BM_from_utf8_mbsrtowcs)->DenseRange(ASCII, EMOJI);
+
+// long ascii paths take the vector path
+static void BM_to_utf8_long_path(benchmark::State& state) {
+  std::wstring path;
+  while (path.size() < 240) path += L"\\\\?\\C:\\Users\\build\\projects\\winnfsd\\src";
+  for (auto _ : state) benchmark::DoNotOptimize(convert::to_string(path));
+  state.SetBytesProcessed(state.iterations() * path.size());
+}
+BENCHMARK(BM_to_utf8_long_path);
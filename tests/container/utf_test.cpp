@@ -0,0 +1,125 @@
+#include "container/utf.h"
+#include "container/string_convert.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+  template<typename unit_t>
+  std::string utf8(const std::basic_string<unit_t>& src) {
+    std::string result;
+    if ( !utf::append_utf8(result, src.data(), src.size())) return "<invalid>";
+    return result;
+  }
+
+  template<typename unit_t>
+  std::basic_string<unit_t> from_utf8(const std::string& src) {
+    std::basic_string<unit_t> result;
+    utf::append_from_utf8(result, src.data(), src.size());
+    return result;
+  }
+
+  template<typename unit_t>
+  bool valid_utf8(const std::string& src) {
+    std::basic_string<unit_t> result;
+    return utf::append_from_utf8(result, src.data(), src.size());
+  }
+
+  // "Grüße 日本 😀" - two, three and four byte sequences
+  const std::string MIXED_UTF8 = "Gr\xC3\xBC\xC3\x9F" "e \xE6\x97\xA5\xE6\x9C\xAC \xF0\x9F\x98\x80";
+  const std::u16string MIXED_UTF16 = { u'G', u'r', 0xFC, 0xDF, u'e', u' ', 0x65E5, 0x672C, u' ', 0xD83D, 0xDE00 };
+  const std::u32string MIXED_UTF32 = { U'G', U'r', 0xFC, 0xDF, U'e', U' ', 0x65E5, 0x672C, U' ', 0x1F600 };
+} // namespace
+
+TEST(utf, mixed_text_in_every_width) {
+  EXPECT_EQ(MIXED_UTF8, utf8(MIXED_UTF16));
+  EXPECT_EQ(MIXED_UTF8, utf8(MIXED_UTF32));
+  EXPECT_EQ(MIXED_UTF16, from_utf8<char16_t>(MIXED_UTF8));
+  EXPECT_EQ(MIXED_UTF32, from_utf8<char32_t>(MIXED_UTF8));
+  EXPECT_EQ(MIXED_UTF8, utf8(from_utf8<wchar_t>(MIXED_UTF8)));
+}
+
+// the vector paths end at every position of the text
+TEST(utf, ascii_runs_of_every_length) {
+  for (size_t length = 0; length < 100; ++length) {
+      std::string ascii;
+      for (size_t i = 0; i < length; ++i) ascii += static_cast<char>('!' + i % 90);
+      EXPECT_EQ(ascii, utf8(from_utf8<char16_t>(ascii))) << length;
+      EXPECT_EQ(ascii, utf8(from_utf8<char32_t>(ascii))) << length;
+      EXPECT_EQ(length, from_utf8<char16_t>(ascii).size());
+
+      auto text = ascii + MIXED_UTF8 + ascii;
+      EXPECT_EQ(text, utf8(from_utf8<char16_t>(text))) << length;
+      EXPECT_EQ(text, utf8(from_utf8<char32_t>(text))) << length;
+    }
+}
+
+// a surrogate pair may straddle the end of a block
+TEST(utf, surrogate_pairs_at_every_offset) {
+  for (size_t offset = 0; offset < 40; ++offset) {
+      std::u16string text(offset, u'a');
+      text += { 0xD83D, 0xDE00, u'b' };
+      auto encoded = utf8(text);
+      EXPECT_EQ(std::string(offset, 'a') + "\xF0\x9F\x98\x80" "b", encoded) << offset;
+      EXPECT_EQ(text, from_utf8<char16_t>(encoded)) << offset;
+    }
+  EXPECT_EQ("\xF4\x8F\xBF\xBF", utf8(std::u16string{ 0xDBFF, 0xDFFF })); // U+10FFFF
+}
+
+TEST(utf, unpaired_surrogates_are_invalid) {
+  EXPECT_EQ("<invalid>", utf8(std::u16string{ u'a', 0xD83D }));
+  EXPECT_EQ("<invalid>", utf8(std::u16string{ 0xD83D, u'a' }));
+  EXPECT_EQ("<invalid>", utf8(std::u16string{ 0xDE00, 0xD83D }));
+  EXPECT_EQ("<invalid>", utf8(std::u32string{ 0xD800 }));
+  EXPECT_EQ("<invalid>", utf8(std::u32string{ 0x110000 }));
+}
+
+TEST(utf, malformed_utf8_is_invalid) {
+  EXPECT_TRUE(valid_utf8<char16_t>("\x7F\xC2\x80\xEF\xBF\xBF\xF4\x8F\xBF\xBF"));
+  EXPECT_FALSE(valid_utf8<char16_t>("\xC0\x80")); // overlong
+  EXPECT_FALSE(valid_utf8<char16_t>("\xE0\x9F\xBF")); // overlong
+  EXPECT_FALSE(valid_utf8<char16_t>("\xED\xA0\x80")); // encoded surrogate
+  EXPECT_FALSE(valid_utf8<char16_t>("\xF4\x90\x80\x80")); // above U+10FFFF
+  EXPECT_FALSE(valid_utf8<char32_t>("abc\xE6\x97")); // truncated
+  EXPECT_FALSE(valid_utf8<char32_t>("\x80"));
+  EXPECT_FALSE(valid_utf8<char32_t>("\xE6\x41\x41"));
+  EXPECT_FALSE(valid_utf8<char32_t>("\xFF"));
+}
+
+TEST(utf, failed_append_keeps_the_destination) {
+  std::string narrow = "kept";
+  EXPECT_FALSE(utf::append_utf8(narrow, u"\xD800", 1));
+  EXPECT_EQ("kept", narrow);
+  std::u16string wide = u"kept";
+  EXPECT_FALSE(utf::append_from_utf8(wide, "ok\xC0", 3));
+  EXPECT_EQ(u"kept", wide);
+}
+
+TEST(string_convert, ignores_the_locale) {
+  auto wide = convert::to_wstring(MIXED_UTF8);
+  EXPECT_EQ(MIXED_UTF8, convert::to_string(wide));
+  EXPECT_EQ(std::string(MIXED_UTF8, 2), convert::to_string_with_offset(wide, 2));
+  EXPECT_EQ(std::wstring(), convert::to_wstring("\xC0\x80"));
+}
+
+// names of clients are raw bytes - a name that does not convert must not leave the
+// bare directory path behind
+TEST(string_convert, invalid_name_does_not_extend_a_path) {
+  std::wstring path = L"C:\\export\\";
+  EXPECT_FALSE(convert::append_wstring(path, "bad\xFF"));
+  EXPECT_FALSE(convert::append_wstring(path, "\xED\xA0\x80")); // encoded surrogate
+  EXPECT_EQ(L"C:\\export\\", path);
+  EXPECT_TRUE(convert::append_wstring(path, "ok"));
+  EXPECT_EQ(L"C:\\export\\ok", path);
+}
+
+// directory entries with an unpaired surrogate - legal on NTFS - have no utf8 name
+TEST(string_convert, unpaired_surrogate_names_are_empty) {
+  std::wstring name = L"a";
+  name += static_cast<wchar_t>(0xD800);
+  EXPECT_EQ(std::string(), convert::to_string(name.data(), name.size()));
+  std::string listed = "kept";
+  EXPECT_FALSE(convert::append_string(listed, name));
+  EXPECT_EQ("kept", listed);
+}
@@ -0,0 +1,92 @@
+#include "container/write_behind.h"
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+/*
+ * Uploading a file with WRITE requests followed by a COMMIT.
+ * Synchronous writes per request compared to buffering them behind the reply.
+ * The ack counter is the time until a WRITE could be answered.
+ */
+namespace {
+  enum : size_t {
+    FILE_SIZE = 16 << 20,
+    WRITE_SIZE = 64 << 10,
+  };
+
+  using clock_source_t = std::chrono::steady_clock;
+
+  struct temp_file_t {
+    temp_file_t() {
+      char path[] = "/tmp/write_behind_benchXXXXXX";
+      fd = ::mkstemp(path);
+      ::unlink(path);
+    }
+    ~temp_file_t() { if (0 <= fd) ::close(fd); }
+
+    bool write_at(uint64_t offset, const binary_t& data) {
+      return static_cast<ssize_t>(data.size()) == ::pwrite(fd, data.data(), data.size(), offset);
+    }
+
+    int fd = -1;
+  };
+
+  template<typename write_t, typename commit_t>
+  void upload(benchmark::State& state, temp_file_t& file, const write_t& write, const commit_t& commit) {
+    if (file.fd < 0) {
+        state.SkipWithError("no file");
+        return;
+      }
+    double ack_seconds = 0;
+    for (auto _ : state) {
+        for (size_t offset = 0; offset < FILE_SIZE; offset += WRITE_SIZE) {
+            binary_t data(WRITE_SIZE, static_cast<uint8_t>(offset >> 16));
+            auto start = clock_source_t::now();
+            write(offset, std::move(data));
+            ack_seconds += std::chrono::duration<double>(clock_source_t::now() - start).count();
+          }
+        commit();
+      }
+    state.counters["ack"] = benchmark::Counter(ack_seconds / (FILE_SIZE / WRITE_SIZE), benchmark::Counter::kAvgIterations);
+    state.SetBytesProcessed(state.iterations() * FILE_SIZE);
+  }
+
+  // FILE_SYNC - every write is durable before the reply
+  void BM_upload_file_sync(benchmark::State& state) {
+    temp_file_t file;
+    upload(state, file, [&](uint64_t offset, binary_t&& data) {
+        file.write_at(offset, data);
+        ::fdatasync(file.fd);
+      }, [] {});
+  }
+
+  // UNSTABLE written before the reply
+  void BM_upload_write_through(benchmark::State& state) {
+    temp_file_t file;
+    upload(state, file, [&](uint64_t offset, binary_t&& data) {
+        file.write_at(offset, data);
+      }, [&] { ::fdatasync(file.fd); });
+  }
+
+  // UNSTABLE buffered and written in the background
+  void BM_upload_write_behind(benchmark::State& state) {
+    temp_file_t file;
+    write_behind_t<int> buffer;
+    auto writer = [&](uint64_t offset, const binary_t& data) { return file.write_at(offset, data); };
+    upload(state, file, [&](uint64_t offset, binary_t&& data) {
+        buffer.write(1, offset, std::move(data), writer);
+      }, [&] {
+        buffer.commit(1);
+        ::fdatasync(file.fd);
+      });
+  }
+} // namespace
+
+BENCHMARK(BM_upload_file_sync)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_upload_write_through)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_upload_write_behind)->Unit(benchmark::kMillisecond);
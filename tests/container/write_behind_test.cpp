@@ -0,0 +1,193 @@
+#include "container/write_behind.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+  // file contents in memory
+  struct memory_file_t {
+    bool write(uint64_t offset, const binary_t& data) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (fail) return false;
+      if (content.size() < offset + data.size()) content.resize(offset + data.size());
+      std::copy(data.begin(), data.end(), content.begin() + offset);
+      ++writes;
+      return true;
+    }
+
+    binary_t read() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return content;
+    }
+
+    write_behind_t<int>::writer_t writer() {
+      return [this](uint64_t offset, const binary_t& data) { return write(offset, data); };
+    }
+
+    std::mutex mutex;
+    binary_t content;
+    int writes = 0;
+    std::atomic<bool> fail {false};
+  };
+
+  using buffer_t = write_behind_t<int>;
+
+  buffer_t::config_t config(size_t memory_limit = 1 << 20) {
+    buffer_t::config_t result;
+    result.memory_limit = memory_limit;
+    result.flush_delay = std::chrono::hours(1); // only explicit flushes
+    return result;
+  }
+
+  binary_t bytes(size_t size, uint8_t value) { return binary_t(size, value); }
+} // namespace
+
+TEST(write_behind, buffers_until_flushed) {
+  memory_file_t file;
+  buffer_t buffer(config());
+  EXPECT_TRUE(buffer.write(1, 0, bytes(4, 1), file.writer()));
+  EXPECT_TRUE(buffer.dirty(1));
+  EXPECT_TRUE(file.read().empty());
+
+  EXPECT_TRUE(buffer.flush(1));
+  EXPECT_FALSE(buffer.dirty(1));
+  EXPECT_EQ(bytes(4, 1), file.read());
+  EXPECT_EQ(0u, buffer.stats().dirty_files);
+}
+
+// attributes of the file are not complete before the data is written
+TEST(write_behind, dirty_while_writing) {
+  memory_file_t file;
+  buffer_t buffer(config());
+  uint64_t end = 0;
+  EXPECT_FALSE(buffer.buffered_end(1, end));
+  EXPECT_TRUE(buffer.write(1, 10, bytes(4, 1), file.writer()));
+  EXPECT_TRUE(buffer.write(1, 0, bytes(2, 2), file.writer()));
+  ASSERT_TRUE(buffer.buffered_end(1, end));
+  EXPECT_EQ(14u, end);
+
+  bool dirty_in_writer = false;
+  uint64_t end_in_writer = 0;
+  EXPECT_TRUE(buffer.write(2, 0, bytes(4, 3), [&](uint64_t, const binary_t&) {
+      dirty_in_writer = buffer.buffered_end(2, end_in_writer);
+      return true;
+    }));
+  EXPECT_TRUE(buffer.flush(2));
+  EXPECT_TRUE(dirty_in_writer);
+  EXPECT_EQ(4u, end_in_writer);
+  EXPECT_FALSE(buffer.dirty(2));
+}
+
+TEST(write_behind, writes_in_offset_order) {
+  memory_file_t file;
+  buffer_t buffer(config());
+  for (auto i = 15; i >= 0; --i) buffer.write(1, i * 1024, bytes(1024, i), file.writer());
+  EXPECT_EQ(16u * 1024, buffer.stats().dirty_bytes);
+  buffer.commit(1);
+  EXPECT_EQ(16, file.writes);
+  auto content = file.read();
+  ASSERT_EQ(16u * 1024, content.size());
+  EXPECT_EQ(15, content[15 * 1024]);
+}
+
+TEST(write_behind, overlapping_writes_are_merged) {
+  memory_file_t file;
+  buffer_t buffer(config());
+  buffer.write(1, 10, bytes(10, 1), file.writer());
+  buffer.write(1, 30, bytes(10, 3), file.writer());
+  buffer.write(1, 15, bytes(20, 2), file.writer()); // covers the end of the first and the start of the second
+  EXPECT_EQ(30u, buffer.stats().dirty_bytes);
+  buffer.commit(1);
+  EXPECT_EQ(1, file.writes);
+
+  auto content = file.read();
+  ASSERT_EQ(40u, content.size());
+  EXPECT_EQ(1, content[14]);
+  EXPECT_EQ(2, content[15]);
+  EXPECT_EQ(2, content[34]);
+  EXPECT_EQ(3, content[35]);
+}
+
+TEST(write_behind, flush_range) {
+  memory_file_t file;
+  buffer_t buffer(config());
+  buffer.write(1, 0, bytes(10, 1), file.writer());
+  buffer.write(1, 100, bytes(10, 2), file.writer());
+  buffer.flush(1, 95, 10);
+  EXPECT_EQ(110u, file.read().size());
+  EXPECT_EQ(10u, buffer.stats().dirty_bytes);
+}
+
+TEST(write_behind, memory_limit_writes_oldest) {
+  memory_file_t first, second;
+  buffer_t buffer(config(100));
+  buffer.write(1, 0, bytes(40, 1), first.writer());
+  std::this_thread::sleep_for(std::chrono::milliseconds(1)); // 1 is older
+  buffer.write(2, 0, bytes(70, 2), second.writer());
+  // written before the write returned - the background flusher may write the other
+  EXPECT_EQ(40u, first.read().size());
+  EXPECT_LE(buffer.stats().dirty_bytes, 100u);
+  EXPECT_LE(1u, buffer.stats().forced_flushes);
+}
+
+TEST(write_behind, failure_is_reported_until_commit) {
+  memory_file_t file;
+  buffer_t buffer(config());
+  buffer.write(1, 0, bytes(10, 1), file.writer());
+  file.fail = true;
+  EXPECT_FALSE(buffer.flush(1));
+  EXPECT_FALSE(buffer.write(1, 10, bytes(10, 1), file.writer()));
+  EXPECT_FALSE(buffer.commit(1));
+  file.fail = false;
+  EXPECT_TRUE(buffer.write(1, 0, bytes(10, 1), file.writer()));
+  EXPECT_TRUE(buffer.commit(1));
+  EXPECT_EQ(1u, buffer.stats().failures);
+}
+
+TEST(write_behind, discard) {
+  memory_file_t file;
+  buffer_t buffer(config());
+  buffer.write(1, 0, bytes(10, 1), file.writer());
+  buffer.discard(1);
+  EXPECT_TRUE(buffer.commit(1));
+  EXPECT_TRUE(file.read().empty());
+}
+
+TEST(write_behind, background_flush) {
+  memory_file_t file;
+  auto background = config();
+  background.flush_delay = std::chrono::milliseconds(5);
+  buffer_t buffer(background);
+  buffer.write(1, 0, bytes(10, 1), file.writer());
+  for (auto i = 0; i < 200 && file.read().empty(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  EXPECT_EQ(bytes(10, 1), file.read());
+}
+
+TEST(write_behind, concurrent_writers) {
+  memory_file_t file;
+  auto background = config(4096);
+  background.flush_delay = std::chrono::milliseconds(1);
+  buffer_t buffer(background);
+  std::vector<std::thread> threads;
+  for (auto thread = 0; thread < 4; ++thread) {
+      threads.emplace_back([&, thread] {
+          for (auto i = 0; i < 256; ++i) {
+              buffer.write(1, (i * 4 + thread) * 64, bytes(64, thread + 1), file.writer());
+            }
+        });
+    }
+  for (auto& thread : threads) thread.join();
+  EXPECT_TRUE(buffer.commit(1));
+
+  auto content = file.read();
+  ASSERT_EQ(4u * 256 * 64, content.size());
+  for (size_t block = 0; block < content.size() / 64; ++block) {
+      EXPECT_EQ(block % 4 + 1, content[block * 64]);
+    }
+}
@@ -0,0 +1,162 @@
+#include "fs/memory_backend.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <set>
+#include <string>
+
+namespace {
+  struct memory_backend_test : ::testing::Test {
+    void SetUp() override {
+      root = backend.make_directories(L"/export/data");
+      ASSERT_TRUE(root);
+      ASSERT_TRUE(root->id(root_id));
+    }
+
+    binary_t pattern(size_t size, uint8_t seed) {
+      binary_t result(size);
+      for (size_t i = 0; i < size; ++i) result[i] = static_cast<uint8_t>(seed + i);
+      return result;
+    }
+
+    std::set<std::string> names(const fs::object_t& directory) {
+      std::set<std::string> result;
+      directory.enumerate([&](const fs::entry_t& entry) {
+          result.insert(entry.name);
+          return true;
+        });
+      return result;
+    }
+
+    fs::memory_backend_t backend;
+    fs::object_ptr_t root;
+    fs::volume_file_id_t root_id;
+  };
+} // namespace
+
+TEST_F(memory_backend_test, opens_paths) {
+  EXPECT_EQ(L"/export/data", root->path());
+  auto same = backend.open_path(L"\\export\\data");
+  ASSERT_TRUE(same);
+  fs::volume_file_id_t same_id;
+  ASSERT_TRUE(same->id(same_id));
+  EXPECT_EQ(root_id, same_id);
+  EXPECT_FALSE(backend.open_path(L"/export/missing"));
+
+  fs::attributes_t attributes;
+  ASSERT_TRUE(root->stat(attributes));
+  EXPECT_EQ(fs::type_t::DIRECTORY, attributes.type);
+  EXPECT_EQ(2u, attributes.nlink);
+}
+
+TEST_F(memory_backend_test, reads_and_writes_pages) {
+  auto file = root->create_file("data");
+  ASSERT_TRUE(file);
+  EXPECT_FALSE(root->create_file("data"));
+
+  // spans three pages and leaves a hole in front
+  auto data = pattern(2 * fs::memory_backend_t::PAGE_SIZE, 3);
+  auto offset = fs::memory_backend_t::PAGE_SIZE + 100;
+  ASSERT_TRUE(file->write_at(offset, data));
+
+  fs::attributes_t attributes;
+  ASSERT_TRUE(file->stat(attributes));
+  EXPECT_EQ(offset + data.size(), attributes.size);
+  EXPECT_EQ(3 * fs::memory_backend_t::PAGE_SIZE, attributes.allocated_size);
+  EXPECT_EQ(3u, backend.stats().pages);
+
+  binary_t read(data.size());
+  ASSERT_TRUE(file->read_at(offset, read));
+  EXPECT_EQ(data, read);
+
+  binary_t hole(16, 0xFF);
+  ASSERT_TRUE(file->read_at(0, hole));
+  EXPECT_EQ(binary_t(16, 0), hole);
+
+  binary_t tail(100);
+  ASSERT_TRUE(file->read_at(attributes.size - 10, tail));
+  EXPECT_EQ(10u, tail.size());
+}
+
+TEST_F(memory_backend_test, set_size_drops_pages) {
+  auto file = root->create_file("data");
+  ASSERT_TRUE(file);
+  ASSERT_TRUE(file->write_at(0, pattern(3 * fs::memory_backend_t::PAGE_SIZE, 1)));
+  ASSERT_TRUE(file->set_size(100));
+  EXPECT_EQ(1u, backend.stats().pages);
+
+  // growing again reads zeros after the old end
+  ASSERT_TRUE(file->set_size(200));
+  binary_t read(200);
+  ASSERT_TRUE(file->read_at(0, read));
+  ASSERT_EQ(200u, read.size());
+  EXPECT_EQ(0, read[150]);
+
+  file.reset();
+  ASSERT_TRUE(root->remove("data"));
+  EXPECT_EQ(0u, backend.stats().pages);
+}
+
+TEST_F(memory_backend_test, ids_stay_valid_across_renames) {
+  auto directory = root->create_directory("sub");
+  ASSERT_TRUE(directory);
+  auto file = directory->create_file("data");
+  ASSERT_TRUE(file);
+  fs::volume_file_id_t id;
+  ASSERT_TRUE(file->id(id));
+
+  ASSERT_TRUE(root->rename("sub", *root, "moved"));
+  EXPECT_FALSE(directory->rename("data", *file, "x")); // not a directory
+  EXPECT_FALSE(root->rename("moved", *directory, "inside")); // below itself
+
+  auto by_id = backend.open_by_id(*root, id);
+  ASSERT_TRUE(by_id);
+  EXPECT_EQ(L"/export/data/moved/data", by_id->path());
+
+  ASSERT_TRUE(directory->remove("data"));
+  EXPECT_FALSE(backend.open_by_id(*root, id));
+}
+
+TEST_F(memory_backend_test, enumerates_entries) {
+  ASSERT_TRUE(root->create_file("a"));
+  ASSERT_TRUE(root->create_directory("b"));
+  EXPECT_EQ((std::set<std::string>{ ".", "..", "a", "b" }), names(*root));
+
+  fs::attributes_t attributes;
+  ASSERT_TRUE(root->stat(attributes));
+  EXPECT_EQ(3u, attributes.nlink);
+
+  auto parent = root->lookup("..");
+  ASSERT_TRUE(parent);
+  EXPECT_EQ(L"/export", parent->path());
+
+  EXPECT_FALSE(root->remove("b")); // a directory
+  EXPECT_FALSE(root->remove_directory("missing"));
+  ASSERT_TRUE(root->remove_directory("b"));
+  EXPECT_EQ((std::set<std::string>{ ".", "..", "a" }), names(*root));
+}
+
+TEST_F(memory_backend_test, changes_advance_the_directory_time) {
+  fs::attributes_t before;
+  ASSERT_TRUE(root->stat(before));
+  ASSERT_TRUE(root->create_file("a"));
+  ASSERT_TRUE(root->remove("a"));
+
+  fs::attributes_t after;
+  ASSERT_TRUE(root->stat(after));
+  EXPECT_NE(before.mtime, after.mtime);
+}
+
+TEST(memory_backend, waits_for_the_latency) {
+  fs::memory_backend_t::config_t config;
+  config.latency = std::chrono::milliseconds(5);
+  fs::memory_backend_t backend(config);
+  auto root = backend.open_path(L"/");
+  ASSERT_TRUE(root);
+
+  auto start = std::chrono::steady_clock::now();
+  fs::attributes_t attributes;
+  ASSERT_TRUE(root->stat(attributes));
+  EXPECT_LE(std::chrono::milliseconds(5), std::chrono::steady_clock::now() - start);
+}
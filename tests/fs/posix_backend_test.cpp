@@ -0,0 +1,149 @@
+#include "fs/posix_backend.h"
+
+#include "container/string_convert.h"
+
+#include <gtest/gtest.h>
+
+#include <ftw.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+namespace {
+  int remove_entry(const char* path, const struct stat*, int, struct FTW*) {
+    return ::remove(path);
+  }
+
+  struct posix_backend_test : ::testing::Test {
+    void SetUp() override {
+      char name[] = "/tmp/posix_backend_testXXXXXX";
+      ASSERT_NE(nullptr, ::mkdtemp(name));
+      root_path = name;
+      root = backend.open_path(convert::to_wstring(root_path));
+      ASSERT_TRUE(root);
+      ASSERT_TRUE(root->id(root_id));
+    }
+    void TearDown() override {
+      root.reset();
+      ::nftw(root_path.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    binary_t pattern(size_t size, uint8_t seed) {
+      binary_t result(size);
+      for (size_t i = 0; i < size; ++i) result[i] = static_cast<uint8_t>(seed + i);
+      return result;
+    }
+
+    fs::posix_backend_t backend;
+    std::string root_path;
+    fs::object_ptr_t root;
+    fs::volume_file_id_t root_id;
+  };
+} // namespace
+
+TEST_F(posix_backend_test, opens_paths) {
+  fs::attributes_t attributes;
+  ASSERT_TRUE(root->stat(attributes));
+  EXPECT_EQ(fs::type_t::DIRECTORY, attributes.type);
+  EXPECT_EQ(convert::to_wstring(root_path), root->path());
+  EXPECT_FALSE(backend.open_path(convert::to_wstring(root_path + "/missing")));
+
+  fs::space_t space;
+  ASSERT_TRUE(root->space(space));
+  EXPECT_LT(0u, space.total_bytes);
+}
+
+TEST_F(posix_backend_test, creates_writes_and_reads_files) {
+  auto file = root->create_file("data");
+  ASSERT_TRUE(file);
+  EXPECT_FALSE(root->create_file("data")); // exists
+
+  ASSERT_TRUE(file->write_at(10, pattern(20, 3)));
+  ASSERT_TRUE(file->sync());
+  fs::attributes_t attributes;
+  ASSERT_TRUE(file->stat(attributes));
+  EXPECT_EQ(fs::type_t::REGULAR_FILE, attributes.type);
+  EXPECT_EQ(30u, attributes.size);
+
+  auto reader = root->lookup("data", fs::READ_ATTRIBUTES | fs::READ_DATA);
+  ASSERT_TRUE(reader);
+  binary_t data(64);
+  ASSERT_TRUE(reader->read_at(10, data));
+  EXPECT_EQ(pattern(20, 3), data);
+
+  ASSERT_TRUE(file->set_size(5));
+  ASSERT_TRUE(reader->stat(attributes));
+  EXPECT_EQ(5u, attributes.size);
+}
+
+TEST_F(posix_backend_test, enumerates_entries) {
+  ASSERT_TRUE(root->create_file("a"));
+  ASSERT_TRUE(root->create_directory("b"));
+
+  auto directory = backend.open_by_id(*root, root_id, fs::READ_ATTRIBUTES | fs::LIST_DIRECTORY);
+  ASSERT_TRUE(directory);
+  std::set<std::string> names;
+  bool b_is_directory = false;
+  ASSERT_TRUE(directory->enumerate([&](const fs::entry_t& entry) {
+      names.insert(entry.name);
+      if ("b" == entry.name) b_is_directory = entry.attributes.type == fs::type_t::DIRECTORY;
+      return true;
+    }));
+  EXPECT_EQ((std::set<std::string>{ ".", "..", "a", "b" }), names);
+  EXPECT_TRUE(b_is_directory);
+}
+
+TEST_F(posix_backend_test, opens_listed_ids) {
+  ASSERT_TRUE(root->create_file("listed"));
+  auto directory = root->lookup(".", fs::LIST_DIRECTORY);
+  ASSERT_TRUE(directory);
+
+  fs::volume_file_id_t id = root_id;
+  directory->enumerate([&](const fs::entry_t& entry) {
+      if ("listed" == entry.name) memcpy(id.file, entry.file, sizeof(id.file));
+      return true;
+    });
+  ASSERT_NE(root_id, id);
+
+  auto file = backend.open_by_id(*root, id);
+  ASSERT_TRUE(file);
+  fs::volume_file_id_t opened_id;
+  ASSERT_TRUE(file->id(opened_id));
+  EXPECT_EQ(id, opened_id);
+
+  fs::volume_file_id_t unknown = id;
+  unknown.file[15] ^= 1;
+  EXPECT_FALSE(backend.open_by_id(*root, unknown));
+}
+
+TEST_F(posix_backend_test, renamed_ids_stay_resolvable) {
+  auto directory = root->create_directory("before");
+  ASSERT_TRUE(directory);
+  auto file = directory->create_file("file");
+  ASSERT_TRUE(file);
+  fs::volume_file_id_t id;
+  ASSERT_TRUE(file->id(id));
+  file.reset();
+
+  ASSERT_TRUE(root->rename("before", *root, "after"));
+  EXPECT_FALSE(root->lookup("before"));
+
+  auto moved = backend.open_by_id(*root, id, fs::READ_ATTRIBUTES | fs::READ_DATA);
+  ASSERT_TRUE(moved);
+  EXPECT_EQ(convert::to_wstring(root_path + "/after/file"), moved->path());
+}
+
+TEST_F(posix_backend_test, removes_entries) {
+  ASSERT_TRUE(root->create_file("file"));
+  ASSERT_TRUE(root->create_directory("directory"));
+  EXPECT_FALSE(root->remove("directory"));
+  EXPECT_FALSE(root->remove_directory("file"));
+
+  EXPECT_TRUE(root->remove("file"));
+  EXPECT_TRUE(root->remove_directory("directory"));
+  EXPECT_FALSE(root->lookup("file"));
+  EXPECT_FALSE(root->lookup("directory"));
+}
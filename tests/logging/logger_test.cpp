@@ -0,0 +1,169 @@
+#include "logging/logger.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+  struct capture_sink_t : logging::sink_t {
+    void write(const logging::record_t& record) override {
+      std::unique_lock<std::mutex> lock(mutex_m);
+      ++writes_m;
+      changed_m.notify_all();
+      changed_m.wait(lock, [this] { return !blocked_m; });
+      records_m.push_back(record);
+    }
+
+    std::vector<logging::record_t> records() {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      return records_m;
+    }
+
+    // the writer waits in the next write until released
+    void block() {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      blocked_m = true;
+    }
+    void wait_for_writes(size_t count) {
+      std::unique_lock<std::mutex> lock(mutex_m);
+      changed_m.wait(lock, [&] { return writes_m >= count; });
+    }
+    void release() {
+      std::lock_guard<std::mutex> lock(mutex_m);
+      blocked_m = false;
+      changed_m.notify_all();
+    }
+
+  private:
+    std::mutex mutex_m;
+    std::condition_variable changed_m;
+    std::vector<logging::record_t> records_m;
+    size_t writes_m = 0;
+    bool blocked_m = false;
+  };
+
+  struct logger_test : ::testing::Test {
+    void SetUp() override {
+      logging::flush();
+      logging::set_sink(sink);
+    }
+    void TearDown() override {
+      logging::set_sink(std::make_shared<logging::stream_sink_t>(std::clog));
+    }
+
+    std::shared_ptr<capture_sink_t> sink = std::make_shared<capture_sink_t>();
+    logging::scoped_level_t level {logging::level_t::INFO};
+  };
+} // namespace
+
+TEST_F(logger_test, filters_levels_without_evaluating) {
+  logging::set_level(logging::level_t::WARNING);
+  auto evaluated = 0;
+  auto argument = [&] { return ++evaluated; };
+  LOG_AT(TRACE, "test") << argument();
+  LOG_AT(INFO, "test") << argument();
+  EXPECT_EQ(0, evaluated);
+  LOG_AT(WARNING, "test") << "value " << argument();
+  LOG_AT(FAILURE, "test") << "value " << argument();
+  EXPECT_EQ(2, evaluated);
+
+  logging::set_level(logging::level_t::OFF);
+  LOG_AT(FAILURE, "test") << argument();
+  EXPECT_EQ(2, evaluated);
+
+  logging::flush();
+  auto records = sink->records();
+  ASSERT_EQ(2u, records.size());
+  EXPECT_EQ(logging::level_t::WARNING, records[0].level);
+  EXPECT_EQ("value 1", records[0].message);
+  EXPECT_EQ(logging::level_t::FAILURE, records[1].level);
+  EXPECT_STREQ("test", records[1].component);
+  EXPECT_EQ(std::this_thread::get_id(), records[1].thread);
+}
+
+TEST_F(logger_test, converts_wide_strings) {
+  std::wstring path = L"/export/dir";
+  LOG_AT(INFO, "test") << path << " " << L"done";
+  logging::flush();
+  auto records = sink->records();
+  ASSERT_EQ(1u, records.size());
+  EXPECT_EQ("/export/dir done", records[0].message);
+}
+
+TEST_F(logger_test, resets_the_format_between_lines) {
+  LOG_AT(INFO, "test") << std::hex << 255;
+  LOG_AT(INFO, "test") << 255;
+  logging::flush();
+  auto records = sink->records();
+  ASSERT_EQ(2u, records.size());
+  EXPECT_EQ("ff", records[0].message);
+  EXPECT_EQ("255", records[1].message);
+}
+
+TEST_F(logger_test, writes_threads_in_time_order) {
+  enum { THREADS = 4, LINES = 100 };
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < THREADS; ++i) {
+      threads.emplace_back([i] {
+          for (auto line = 0; line < LINES; ++line) LOG_AT(INFO, "test") << i << ":" << line;
+        });
+    }
+  for (auto& thread : threads) thread.join();
+  logging::flush();
+
+  auto records = sink->records();
+  ASSERT_EQ(size_t(THREADS * LINES), records.size());
+  for (size_t i = 1; i < records.size(); ++i) EXPECT_LE(records[i - 1].time, records[i].time);
+}
+
+TEST_F(logger_test, counts_dropped_records) {
+  enum { LINES = 5000 };
+  auto before = logging::stats();
+  sink->block();
+  LOG_AT(INFO, "test") << "first";
+  sink->wait_for_writes(1); // the writer is stuck - nothing is drained
+  for (auto line = 0; line < LINES; ++line) LOG_AT(INFO, "test") << line;
+  sink->release();
+  logging::flush();
+
+  auto after = logging::stats();
+  auto dropped = after.dropped - before.dropped;
+  EXPECT_EQ(uint64_t(LINES + 1), after.records - before.records + dropped);
+  EXPECT_LT(0u, dropped);
+  auto records = sink->records();
+  auto report = std::find_if(records.begin(), records.end(), [](const logging::record_t& record) {
+      return logging::level_t::WARNING == record.level;
+    });
+  ASSERT_NE(records.end(), report);
+  EXPECT_EQ(std::to_string(dropped) + " records dropped", report->message);
+}
+
+TEST(logging, writes_lines_to_streams) {
+  std::ostringstream out;
+  logging::stream_sink_t sink(out);
+  logging::record_t record;
+  record.level = logging::level_t::WARNING;
+  record.time = logging::record_t::clock_t::now();
+  record.component = "nfs3";
+  record.message = "message";
+  sink.write(record);
+  auto line = out.str();
+  EXPECT_EQ("W ", line.substr(0, 2));
+  EXPECT_NE(std::string::npos, line.find(" nfs3] message\n"));
+}
+
+TEST(logging, parses_levels) {
+  logging::level_t level = logging::level_t::OFF;
+  EXPECT_TRUE(logging::parse_level("trace", level));
+  EXPECT_EQ(logging::level_t::TRACE, level);
+  EXPECT_TRUE(logging::parse_level("failure", level));
+  EXPECT_EQ(logging::level_t::FAILURE, level);
+  EXPECT_FALSE(logging::parse_level("debug", level));
+  EXPECT_EQ(logging::level_t::FAILURE, level);
+}
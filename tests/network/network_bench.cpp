@@ -0,0 +1,242 @@
+#include "server/rpc_server.h"
+#include "server/worker_pool.h"
+#include "network/tcp.h"
+#include "network/udp.h"
+#include "binary/binary_builder.h"
+#include "binary/binary_reader.h"
+#include "rpc/xdr.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
+/*
+ * Loopback benchmark of the tcp server core.
+ * Every iteration sends one NULL call on each of N connections and waits for all replies.
+ * The "threads" counter shows that the server does not grow with the connection count.
+ * The udp benchmarks send one datagram per client socket and count packets per second.
+ * Labeled "workers" they run the calls on a worker pool like the nfs server does.
+ */
+namespace {
+  enum {
+    BENCH_PORT = 20111,
+    WORKERS_PORT = 20112, // of the server with a worker pool
+    BENCH_PROGRAM = 200000,
+    BENCH_VERSION = 1,
+  };
+
+  rpc_server_t& bench_server(bool workers = false) {
+    static std::unique_ptr<worker_pool_t> pool; // destroyed after the servers
+    static std::unique_ptr<rpc_server_t> servers[2];
+    auto& server = servers[workers ? 1 : 0];
+    if (!server) {
+        if (workers && !pool) {
+            pool.reset(new worker_pool_t());
+            pool->start();
+          }
+        server.reset(new rpc_server_t(workers ? WORKERS_PORT : BENCH_PORT, 2, workers ? pool.get() : nullptr));
+        rpc_program_t program;
+        program.id = BENCH_PROGRAM;
+        program.version = BENCH_VERSION;
+        program.procedures.set(0, { "NULL", [](rpc_program_t::procedure_args_t&) {
+            return rpc_program_t::procedure_result_t::respond({});
+          }, rpc_program_t::NO_REPLY_CACHE });
+        program.procedures.set(1, { "READ", [](rpc_program_t::procedure_args_t& args) {
+            // payload size as argument - the payload is sent as its own segment like nfs READ data
+            auto size = args.parameter_reader.has_size(4) ? args.parameter_reader.get32(0) : 0;
+            segmented_binary_t segments;
+            binary_builder_t builder;
+            xdr::write_opaque_segment(segments, builder, binary_t(size, 0x55));
+            return rpc_program_t::procedure_result_t::respond_segmented(std::move(segments));
+          }, rpc_program_t::NO_REPLY_CACHE });
+        server->add(program);
+        server->start();
+      }
+    return *server;
+  }
+
+  binary_t call_record(uint32_t xid, uint32_t procedure, const binary_t& parameters) {
+    binary_builder_t builder;
+    builder.append32(0x80000000u | (40 + parameters.size()));
+    builder.append32(xid);
+    builder.append32(0); // CALL
+    builder.append32(2); // rpc version
+    builder.append32(BENCH_PROGRAM);
+    builder.append32(BENCH_VERSION);
+    builder.append32(procedure);
+    builder.append32(0); builder.append32(0); // credential
+    builder.append32(0); builder.append32(0); // verifier
+    builder.append_binary(parameters);
+    return builder.build();
+  }
+
+  binary_t null_call_record(uint32_t xid) {
+    return call_record(xid, 0, {});
+  }
+
+  // calls as datagrams - without the record mark
+  binary_t call_datagram(uint32_t xid, uint32_t procedure, const binary_t& parameters) {
+    auto record = call_record(xid, procedure, parameters);
+    return binary_t(record.begin() + 4, record.end());
+  }
+
+  udp_socket_t udp_client() {
+    auto client = udp_socket_t::create();
+    if ( !client.valid() || !socket_set_receive_timeout(client.handle(), 1000)) return {};
+    return client;
+  }
+
+  tcp_socket_t connect_client() {
+    auto client = tcp_socket_t::create();
+    if (SOCKET_ERROR == client.connect(inet_addr_t::loopback(BENCH_PORT))) return {};
+    client.set_no_delay();
+    return client;
+  }
+
+  bool receive_record(const tcp_socket_t& socket, binary_t& buffer) {
+    buffer.clear();
+    while (true) {
+        if (buffer.size() >= 4) {
+            auto size = binary_reader_t::binary(buffer).get32(0) & 0x7FFFFFFF;
+            if (buffer.size() >= 4 + size) return true;
+          }
+        auto offset = buffer.size();
+        buffer.resize(offset + 0x10000);
+        auto bytes = socket.receive(&buffer[offset], 0x10000);
+        buffer.resize(offset + std::max(0, bytes));
+        if (0 >= bytes) return false;
+      }
+  }
+
+  int process_thread_count() {
+    int result = 0;
+#ifndef _WIN32
+    auto dir = ::opendir("/proc/self/task");
+    if (!dir) return 0;
+    while (auto entry = ::readdir(dir)) {
+        if (entry->d_name[0] != '.') ++result;
+      }
+    ::closedir(dir);
+#endif
+    return result;
+  }
+} // namespace
+
+static void BM_tcp_null_calls(benchmark::State& state) {
+  bench_server();
+  auto connection_count = state.range(0);
+
+  std::vector<tcp_socket_t> clients;
+  for (auto i = 0; i < connection_count; ++i) {
+      auto client = connect_client();
+      if ( !client.valid()) {
+          state.SkipWithError("connect failed");
+          return;
+        }
+      clients.push_back(std::move(client));
+    }
+
+  auto request = null_call_record(1);
+  binary_t reply;
+  for (auto _ : state) {
+      for (const auto& client : clients) client.send(request);
+      for (const auto& client : clients) {
+          if (!receive_record(client, reply)) {
+              state.SkipWithError("connection lost");
+              return;
+            }
+        }
+    }
+  state.SetItemsProcessed(state.iterations() * connection_count);
+  state.counters["threads"] = process_thread_count();
+}
+BENCHMARK(BM_tcp_null_calls)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+
+// large replies like sequential nfs READs - the payload is sent with a gather send
+static void BM_tcp_read_replies(benchmark::State& state) {
+  bench_server();
+  auto client = connect_client();
+  if ( !client.valid()) {
+      state.SkipWithError("connect failed");
+      return;
+    }
+  binary_builder_t parameters;
+  parameters.append32(state.range(0));
+  auto request = call_record(1, 1, parameters.build());
+  binary_t reply;
+  for (auto _ : state) {
+      client.send(request);
+      if (!receive_record(client, reply)) {
+          state.SkipWithError("connection lost");
+          return;
+        }
+    }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_tcp_read_replies)->RangeMultiplier(4)->Range(4096, 1 << 20)->UseRealTime();
+
+static void BM_udp_null_calls(benchmark::State& state) {
+  bench_server(state.range(1));
+  auto client_count = state.range(0);
+
+  std::vector<udp_socket_t> clients;
+  for (auto i = 0; i < client_count; ++i) {
+      auto client = udp_client();
+      if ( !client.valid()) {
+          state.SkipWithError("socket failed");
+          return;
+        }
+      clients.push_back(std::move(client));
+    }
+
+  auto server = inet_addr_t::loopback(state.range(1) ? WORKERS_PORT : BENCH_PORT);
+  auto request = call_datagram(1, 0, {});
+  binary_t reply;
+  reply.reserve(udp_batch_t::MAX_DATAGRAM);
+  for (auto _ : state) {
+      for (const auto& client : clients) client.send_to(request, server);
+      for (const auto& client : clients) {
+          inet_addr_t sender;
+          if (0 >= client.receive_from(reply, sender)) {
+              state.SkipWithError("datagram lost");
+              return;
+            }
+        }
+    }
+  state.SetItemsProcessed(state.iterations() * client_count);
+  if (state.range(1)) state.SetLabel("workers");
+}
+BENCHMARK(BM_udp_null_calls)->RangeMultiplier(4)->Ranges({{1, 64}, {0, 1}})->UseRealTime();
+
+// replies up to the largest datagram
+static void BM_udp_read_replies(benchmark::State& state) {
+  bench_server(state.range(1));
+  auto client = udp_client();
+  if ( !client.valid()) {
+      state.SkipWithError("socket failed");
+      return;
+    }
+  binary_builder_t parameters;
+  parameters.append32(state.range(0));
+  auto server = inet_addr_t::loopback(state.range(1) ? WORKERS_PORT : BENCH_PORT);
+  auto request = call_datagram(1, 1, parameters.build());
+  binary_t reply;
+  reply.reserve(udp_batch_t::MAX_DATAGRAM);
+  for (auto _ : state) {
+      client.send_to(request, server);
+      inet_addr_t sender;
+      if (0 >= client.receive_from(reply, sender)) {
+          state.SkipWithError("datagram lost");
+          return;
+        }
+    }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  if (state.range(1)) state.SetLabel("workers");
+}
+BENCHMARK(BM_udp_read_replies)->RangeMultiplier(4)->Ranges({{1024, 32768}, {0, 1}})->UseRealTime();
@@ -0,0 +1,134 @@
+#include "nfs/mount_aliases.h"
+#include "fs/memory_backend.h"
+#include "logging/logger.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Resolving mount paths against many per project aliases of a path file.
+ * The legacy store is the previous linear scan under a shared lock for comparison.
+ */
+namespace {
+  const size_t ALIASES = 10000;
+
+  struct legacy_store_t {
+    struct entry_t {
+      std::string alias_path;
+      std::wstring windows_path;
+    };
+
+    void add(const std::wstring& windows_path, const std::string& alias_path) {
+      std::unique_lock<std::shared_timed_mutex> lock(mutex_m);
+      if (std::any_of(entries_m.begin(), entries_m.end(), [&](const entry_t& entry) {
+          return entry.alias_path == alias_path;
+        })) return;
+      entries_m.push_back({ alias_path, windows_path });
+    }
+
+    std::wstring resolve(const std::string& alias_path) const {
+      std::shared_lock<std::shared_timed_mutex> lock(mutex_m);
+      auto best_it = entries_m.end();
+      size_t best_length = 0;
+      for (auto it = entries_m.begin(); it != entries_m.end(); ++it) {
+          auto length = it->alias_path.length();
+          if (length > alias_path.length() || length < best_length) continue;
+          if (0 != alias_path.compare(0, length, it->alias_path)) continue;
+          if (length < alias_path.length() && alias_path[length] != '/') continue;
+          best_it = it;
+          best_length = length;
+        }
+      if (best_it == entries_m.end()) return {};
+      return best_it->windows_path + mount_aliases_t::alias_subpath_to_windows(alias_path.substr(best_length));
+    }
+
+  private:
+    mutable std::shared_timed_mutex mutex_m;
+    std::vector<entry_t> entries_m;
+  };
+
+  std::string project_alias(size_t i) { return "/ci/projects/project-" + std::to_string(i); }
+  std::wstring project_path(size_t i) { return L"/export/project-" + std::to_wstring(i); }
+
+  // a mount storm - every project mounts a sub directory
+  std::vector<std::string> mount_paths() {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < ALIASES; ++i) result.push_back(project_alias((i * 7919) % ALIASES) + "/workspace");
+    return result;
+  }
+
+  struct aliases_t {
+    aliases_t()
+      : aliases(backend)
+    {
+      logging::scoped_level_t quiet(logging::level_t::OFF);
+      mount_aliases_t::alias_vector_t vector;
+      for (size_t i = 0; i < ALIASES; ++i) {
+          backend.make_directories(project_path(i));
+          vector.emplace_back(project_path(i), project_alias(i));
+        }
+      aliases.set(aliases.create_source(), vector);
+    }
+
+    fs::memory_backend_t backend;
+    mount_aliases_t aliases;
+  };
+
+  aliases_t& shared_aliases() {
+    static aliases_t aliases;
+    return aliases;
+  }
+
+  legacy_store_t& shared_legacy_store() {
+    static legacy_store_t* store = [] {
+        auto result = new legacy_store_t();
+        for (size_t i = 0; i < ALIASES; ++i) result->add(project_path(i), project_alias(i));
+        return result;
+      }();
+    return *store;
+  }
+} // namespace
+
+static void BM_resolve_aliases(benchmark::State& state) {
+  auto& aliases = shared_aliases().aliases;
+  auto paths = mount_paths();
+  size_t i = 0;
+  for (auto _ : state) {
+      benchmark::DoNotOptimize(aliases.resolve(paths[i++ % paths.size()]));
+    }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_resolve_aliases)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_resolve_aliases_legacy(benchmark::State& state) {
+  auto& store = shared_legacy_store();
+  auto paths = mount_paths();
+  size_t i = 0;
+  for (auto _ : state) {
+      benchmark::DoNotOptimize(store.resolve(paths[i++ % paths.size()]));
+    }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_resolve_aliases_legacy)->ThreadRange(1, 8)->UseRealTime();
+
+// the path file is synced while mounts resolve
+static void BM_set_aliases(benchmark::State& state) {
+  fs::memory_backend_t backend;
+  mount_aliases_t::alias_vector_t vector;
+  for (size_t i = 0; i < ALIASES; ++i) {
+      backend.make_directories(project_path(i));
+      vector.emplace_back(project_path(i), project_alias(i));
+    }
+  logging::scoped_level_t quiet(logging::level_t::OFF);
+  mount_aliases_t aliases(backend);
+  auto source = aliases.create_source();
+  for (auto _ : state) aliases.set(source, vector);
+  state.SetItemsProcessed(state.iterations() * ALIASES);
+}
+BENCHMARK(BM_set_aliases)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,87 @@
+#include "nfs/mount_aliases.h"
+#include "fs/memory_backend.h"
+#include "logging/logger.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace {
+  struct mount_aliases_test : ::testing::Test {
+    mount_aliases_test()
+      : quiet(logging::level_t::OFF)
+      , aliases(backend)
+    {
+      backend.make_directories(L"/export/data/sub");
+      backend.make_directories(L"/export/other");
+      backend.make_directories(L"/projects");
+    }
+
+    logging::scoped_level_t quiet; // aliases are logged
+    fs::memory_backend_t backend;
+    mount_aliases_t aliases;
+  };
+} // namespace
+
+TEST_F(mount_aliases_test, resolves_the_longest_alias) {
+  auto source = aliases.create_source();
+  EXPECT_TRUE(aliases.add(source, L"/export", "/e"));
+  EXPECT_TRUE(aliases.add(source, L"/export/data", "/e/data"));
+  EXPECT_TRUE(aliases.add(source, L"/export/other"));
+
+  EXPECT_EQ(L"/export", aliases.resolve("/e"));
+  EXPECT_EQ(L"/export/data\\sub\\file", aliases.resolve("/e/data/sub/file"));
+  EXPECT_EQ(L"/export\\database", aliases.resolve("/e/database"));
+  EXPECT_EQ(L"/export/other\\x", aliases.resolve("/export/other/x"));
+  EXPECT_EQ(L"", aliases.resolve("/elsewhere"));
+  EXPECT_EQ(L"", aliases.resolve("/export"));
+}
+
+TEST_F(mount_aliases_test, rejects_duplicates_and_missing_directories) {
+  auto source = aliases.create_source();
+  EXPECT_TRUE(aliases.add(source, L"/export/data", "/data"));
+  EXPECT_FALSE(aliases.add(source, L"/export/other", "/data"));
+  EXPECT_FALSE(aliases.add(source, L"/missing", "/missing"));
+  EXPECT_TRUE(aliases.add(source, L"/export/other"));
+  EXPECT_FALSE(aliases.add(source, L"/export/other")); // the derived alias is taken
+  EXPECT_EQ(2u, aliases.size());
+  EXPECT_EQ(L"/export/data", aliases.resolve("/data"));
+}
+
+TEST_F(mount_aliases_test, set_replaces_the_aliases_of_the_source) {
+  auto file = aliases.create_source();
+  auto manual = aliases.create_source();
+  aliases.add(manual, L"/export", "/manual");
+  aliases.set(file, { { L"/export/data", "/a" }, { L"/export/other", "/b" } });
+  EXPECT_EQ(3u, aliases.size());
+
+  aliases.set(file, { { L"/export/other", "/a" } });
+  EXPECT_EQ(L"/export/other", aliases.resolve("/a"));
+  EXPECT_EQ(L"", aliases.resolve("/b"));
+
+  aliases.clear(file);
+  EXPECT_EQ(1u, aliases.size());
+  EXPECT_EQ(L"/export\\data", aliases.resolve("/manual/data"));
+}
+
+// readers see either the old or the new aliases while the path file is synced
+TEST_F(mount_aliases_test, resolves_while_aliases_change) {
+  auto source = aliases.create_source();
+  aliases.add(aliases.create_source(), L"/export/data", "/stable");
+  std::atomic<bool> done {false};
+  std::thread writer([&] {
+      for (auto i = 0; i < 200; ++i) {
+          aliases.set(source, { { L"/projects", "/p" + std::to_string(i % 10) } });
+        }
+      done = true;
+    });
+  size_t failures = 0;
+  while ( !done) {
+      if (L"/export/data\\x" != aliases.resolve("/stable/x")) ++failures;
+    }
+  writer.join();
+  EXPECT_EQ(0u, failures);
+  EXPECT_EQ(L"/projects", aliases.resolve("/p9"));
+  EXPECT_EQ(2u, aliases.size());
+}
@@ -0,0 +1,162 @@
+#include "nfs/mount_cache.h"
+#include "fs/memory_backend.h"
+#include "logging/logger.h"
+#include "binary/binary_builder.h"
+
+#include <benchmark/benchmark.h>
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <string>
+
+/*
+ * Startup of the mount cache with many persisted mounts. Every mount is three journal
+ * records - the mount, its query path and the client. The former format is the plain
+ * file that was only written at a clean shutdown. It has no directory ids, so its
+ * mounts are opened at startup - restored mounts are opened on first use otherwise.
+ */
+namespace {
+  const size_t MOUNTS = 100000;
+
+  struct persisted_t {
+    persisted_t() {
+      char directory[] = "/tmp/mount_cache_benchXXXXXX";
+      if (nullptr == ::mkdtemp(directory)) return;
+      logging::scoped_level_t quiet(logging::level_t::OFF);
+      for (size_t i = 0; i < MOUNTS; ++i) backend.make_directories(path(i));
+
+      journal.path = std::string(directory) + "/journal";
+      journal.checkpoint_interval = std::chrono::hours(1);
+      journal.checkpoint_records = SIZE_MAX;
+      snapshot = journal;
+      snapshot.path = std::string(directory) + "/snapshot";
+      former = journal;
+      former.path = std::string(directory) + "/former";
+
+      mount_cache_t cache(backend);
+      cache.persist(journal);
+      for (size_t i = 0; i < MOUNTS; ++i) {
+          cache.mount_session([&](const mount_cache_t::mount_session_t& session) {
+              session.mount("client" + std::to_string(i % 64), "/mounts/" + std::to_string(i), path(i));
+            });
+        }
+      auto former_file = former_format();
+      std::ofstream(former.path, std::ios_base::binary).write(reinterpret_cast<const char*>(former_file.data()), former_file.size());
+
+      // the snapshot holds all mounts and an empty journal follows
+      for (auto file : { "", ".0" }) {
+          std::ifstream ifs(journal.path + file, std::ios_base::binary);
+          std::ofstream(snapshot.path + file, std::ios_base::binary) << ifs.rdbuf();
+        }
+      mount_cache_t compacted(backend);
+      compacted.persist(snapshot);
+      compacted.checkpoint();
+    }
+
+    static std::wstring path(size_t i) { return L"/export/project" + std::to_wstring(i); }
+
+    // mount i + 1 is at path(i) for client i % 64
+    static binary_t former_format() {
+      binary_builder_t builder;
+      builder.append32(MOUNTS);
+      for (size_t i = 0; i < MOUNTS; ++i) {
+          builder.append64(i + 1);
+          builder.append32(path(i).size());
+          builder.append_binary(path(i));
+        }
+      builder.append32(MOUNTS);
+      for (size_t i = 0; i < MOUNTS; ++i) {
+          auto query = "/mounts/" + std::to_string(i);
+          builder.append32(query.size());
+          builder.append_binary(query);
+          builder.append64(i + 1);
+        }
+      builder.append32(64);
+      for (size_t client = 0; client < 64; ++client) {
+          auto name = "client" + std::to_string(client);
+          builder.append32(name.size());
+          builder.append_binary(name);
+          builder.append32((MOUNTS - client + 63) / 64);
+          for (auto i = client; i < MOUNTS; i += 64) builder.append64(i + 1);
+        }
+      return builder.release();
+    }
+
+    fs::memory_backend_t backend;
+    mount_journal_t::config_t journal;
+    mount_journal_t::config_t snapshot;
+    mount_journal_t::config_t former;
+  };
+
+  persisted_t& persisted() {
+    static persisted_t result;
+    return result;
+  }
+
+  // every restart appends a new journal - the copy keeps the measured files unchanged
+  mount_journal_t::config_t copy_of(const mount_journal_t::config_t& config) {
+    auto result = config;
+    result.path += ".run";
+    for (auto file : { "", ".0", ".1", ".2" }) {
+        std::remove((result.path + file).c_str());
+        std::ifstream ifs(config.path + file, std::ios_base::binary);
+        if (ifs) std::ofstream(result.path + file, std::ios_base::binary) << ifs.rdbuf();
+      }
+    return result;
+  }
+
+  // until the first request is served
+  void restart(benchmark::State& state, const mount_journal_t::config_t& config) {
+    auto& files = persisted();
+    logging::scoped_level_t quiet(logging::level_t::OFF);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto copy = copy_of(config);
+        state.ResumeTiming();
+        mount_cache_t cache(files.backend);
+        cache.persist(copy);
+        benchmark::DoNotOptimize(cache.get(MOUNTS / 2).directory);
+      }
+    state.SetItemsProcessed(state.iterations() * MOUNTS);
+  }
+} // namespace
+
+static void BM_restart_from_journal(benchmark::State& state) {
+  restart(state, persisted().journal);
+}
+BENCHMARK(BM_restart_from_journal)->Unit(benchmark::kMillisecond);
+
+static void BM_restart_from_snapshot(benchmark::State& state) {
+  restart(state, persisted().snapshot);
+}
+BENCHMARK(BM_restart_from_snapshot)->Unit(benchmark::kMillisecond);
+
+static void BM_restart_from_former_format(benchmark::State& state) {
+  restart(state, persisted().former);
+}
+BENCHMARK(BM_restart_from_former_format)->Unit(benchmark::kMillisecond);
+
+// the journal costs of a mount storm
+static void BM_journaled_mounts(benchmark::State& state) {
+  auto& files = persisted();
+  logging::scoped_level_t quiet(logging::level_t::OFF);
+  auto config = files.journal;
+  config.path += ".storm";
+  size_t i = 0;
+  for (auto _ : state) {
+      state.PauseTiming();
+      for (auto file : { "", ".0", ".1" }) std::remove((config.path + file).c_str());
+      mount_cache_t cache(files.backend);
+      if (state.range(0)) cache.persist(config);
+      state.ResumeTiming();
+      for (auto n = 0; n < 1000; ++n, ++i) {
+          cache.mount_session([&](const mount_cache_t::mount_session_t& session) {
+              session.mount("client", "/storm/" + std::to_string(i), persisted_t::path(i % MOUNTS));
+            });
+        }
+    }
+  state.SetItemsProcessed(state.iterations() * 1000);
+  state.SetLabel(state.range(0) ? "journaled" : "in memory");
+}
+BENCHMARK(BM_journaled_mounts)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,293 @@
+#include "nfs/mount_cache.h"
+#include "fs/memory_backend.h"
+#include "logging/logger.h"
+#include "binary/binary_builder.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace {
+  struct mount_cache_test : ::testing::Test {
+    mount_cache_test()
+      : quiet(logging::level_t::OFF)
+    {
+      backend.make_directories(L"/export/a");
+      backend.make_directories(L"/export/b");
+      backend.make_directories(L"/export/c");
+      config.path = ::testing::TempDir() + "mount_cache_test_"
+                    + ::testing::UnitTest::GetInstance()->current_test_info()->name();
+      config.checkpoint_interval = std::chrono::hours(1);
+      remove_files();
+    }
+    ~mount_cache_test() override { remove_files(); }
+
+    void remove_files() {
+      for (auto suffix : { "", ".tmp", ".corrupt", ".0", ".1", ".2", ".3" }) std::remove((config.path + suffix).c_str());
+    }
+
+    uint64_t mount(mount_cache_t& cache, const std::string& client, const std::string& query, const std::wstring& path) {
+      uint64_t result = 0;
+      cache.mount_session([&](const mount_cache_t::mount_session_t& session) {
+          auto it = session.find_query(query);
+          if (it != session.end()) session.mount_sender(client, it);
+          else it = session.mount(client, query, path);
+          if (it != session.end()) result = it->first;
+        });
+      return result;
+    }
+
+    bool mounted(mount_cache_t& cache, uint64_t mount_id, const std::string& query) {
+      bool found = false;
+      cache.mount_session([&](const mount_cache_t::mount_session_t& session) {
+          auto it = session.find_query(query);
+          found = it != session.end() && it->first == mount_id;
+        });
+      return found && nullptr != cache.get(mount_id).directory;
+    }
+
+    binary_t read(const std::string& path) {
+      std::ifstream ifs(path, std::ios_base::binary);
+      return binary_t(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+
+    void write(const std::string& path, const binary_t& binary) {
+      std::ofstream ofs(path, std::ios_base::binary | std::ios_base::trunc);
+      ofs.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+    }
+
+    logging::scoped_level_t quiet; // corrupt files are logged
+    fs::memory_backend_t backend;
+    mount_journal_t::config_t config;
+  };
+} // namespace
+
+// a crash loses no mount - nothing is written at shutdown
+TEST_F(mount_cache_test, journal_restores_mounts) {
+  uint64_t a, b;
+  {
+    mount_cache_t cache(backend);
+    ASSERT_TRUE(cache.persist(config));
+    a = mount(cache, "client1", "/a", L"/export/a");
+    b = mount(cache, "client1", "/b", L"/export/b");
+    EXPECT_EQ(a, mount(cache, "client2", "/a", L"/export/a"));
+    EXPECT_EQ(7u, cache.journal_stats().records); // 2 mounts, 2 queries, 3 clients
+  }
+  mount_cache_t cache(backend);
+  ASSERT_TRUE(cache.persist(config));
+  EXPECT_EQ(7u, cache.journal_stats().replayed);
+  EXPECT_TRUE(mounted(cache, a, "/a"));
+  EXPECT_TRUE(mounted(cache, b, "/b"));
+  EXPECT_EQ(b + 1, mount(cache, "client1", "/c", L"/export/c"));
+}
+
+TEST_F(mount_cache_test, torn_record_ends_the_journal) {
+  uint64_t a, b;
+  size_t size_after_a;
+  {
+    mount_cache_t cache(backend);
+    cache.persist(config);
+    a = mount(cache, "client", "/a", L"/export/a");
+    size_after_a = read(config.path + ".0").size();
+    b = mount(cache, "client", "/b", L"/export/b");
+  }
+  auto journal = read(config.path + ".0");
+  journal.resize(size_after_a + 10); // the mount record of b is torn
+  write(config.path + ".0", journal);
+
+  uint64_t c;
+  {
+    mount_cache_t cache(backend);
+    ASSERT_TRUE(cache.persist(config));
+    EXPECT_EQ(1u, cache.journal_stats().torn);
+    EXPECT_TRUE(mounted(cache, a, "/a"));
+    EXPECT_FALSE(mounted(cache, b, "/b"));
+    c = mount(cache, "client", "/c", L"/export/c");
+  }
+  // later changes are in the next journal - behind the torn one
+  mount_cache_t cache(backend);
+  ASSERT_TRUE(cache.persist(config));
+  EXPECT_TRUE(mounted(cache, a, "/a"));
+  EXPECT_TRUE(mounted(cache, c, "/c"));
+}
+
+TEST_F(mount_cache_test, corrupt_record_ends_the_journal) {
+  uint64_t a;
+  size_t size_after_a;
+  {
+    mount_cache_t cache(backend);
+    cache.persist(config);
+    a = mount(cache, "client", "/a", L"/export/a");
+    size_after_a = read(config.path + ".0").size();
+    mount(cache, "client", "/b", L"/export/b");
+    mount(cache, "client", "/c", L"/export/c");
+  }
+  auto journal = read(config.path + ".0");
+  journal[size_after_a + 12] ^= 0x40; // in the mount record of b
+  write(config.path + ".0", journal);
+
+  mount_cache_t cache(backend);
+  ASSERT_TRUE(cache.persist(config));
+  EXPECT_EQ(3u, cache.journal_stats().replayed);
+  EXPECT_TRUE(mounted(cache, a, "/a"));
+  EXPECT_EQ(nullptr, cache.get(a + 1).directory);
+  EXPECT_EQ(nullptr, cache.get(a + 2).directory);
+}
+
+TEST_F(mount_cache_test, checkpoint_compacts_the_journals) {
+  uint64_t a, b;
+  {
+    mount_cache_t cache(backend);
+    cache.persist(config);
+    a = mount(cache, "client", "/a", L"/export/a");
+    ASSERT_TRUE(cache.checkpoint());
+    EXPECT_TRUE(read(config.path + ".0").empty()); // deleted
+    EXPECT_EQ(1u, cache.journal_stats().generation);
+    b = mount(cache, "client", "/b", L"/export/b");
+  }
+  mount_cache_t cache(backend);
+  ASSERT_TRUE(cache.persist(config));
+  EXPECT_EQ(3u, cache.journal_stats().replayed); // only b
+  EXPECT_TRUE(mounted(cache, a, "/a"));
+  EXPECT_TRUE(mounted(cache, b, "/b"));
+}
+
+TEST_F(mount_cache_test, corrupt_snapshot_is_rejected) {
+  {
+    mount_cache_t cache(backend);
+    cache.persist(config);
+    mount(cache, "client", "/a", L"/export/a");
+    cache.checkpoint();
+  }
+  auto snapshot = read(config.path);
+  snapshot.back() ^= 1;
+  write(config.path, snapshot);
+
+  mount_cache_t cache(backend);
+  EXPECT_FALSE(cache.persist(config));
+  EXPECT_EQ(nullptr, cache.get(1).directory);
+  EXPECT_FALSE(read(config.path + ".corrupt").empty());
+}
+
+TEST_F(mount_cache_test, restores_the_former_format) {
+  // the file written at shutdown - mount 7 of "/export/a" at "/a" for "client"
+  binary_builder_t builder;
+  builder.append32(1);
+  builder.append64(7);
+  builder.append32(std::wstring(L"/export/a").size());
+  builder.append_binary(std::wstring(L"/export/a"));
+  builder.append32(1);
+  builder.append32(2);
+  builder.append_binary(std::string("/a"));
+  builder.append64(7);
+  builder.append32(1);
+  builder.append32(6);
+  builder.append_binary(std::string("client"));
+  builder.append32(1);
+  builder.append64(7);
+  write(config.path, builder.build());
+
+  mount_cache_t cache(backend);
+  ASSERT_TRUE(cache.persist(config));
+  EXPECT_EQ(0u, cache.unopened()); // the id of the directory is not known
+  EXPECT_TRUE(mounted(cache, 7, "/a"));
+  EXPECT_EQ(8u, mount(cache, "client", "/b", L"/export/b"));
+
+  // lengths beyond the data are rejected
+  mount_cache_t truncated(backend);
+  auto binary = cache.save();
+  binary.resize(binary.size() - 3);
+  EXPECT_FALSE(truncated.restore(binary));
+}
+
+TEST_F(mount_cache_test, restored_mounts_open_on_first_use) {
+  uint64_t a, b;
+  {
+    mount_cache_t cache(backend);
+    cache.persist(config);
+    a = mount(cache, "client", "/a", L"/export/a");
+    cache.checkpoint();
+    b = mount(cache, "client", "/b", L"/export/b");
+  }
+  mount_cache_t cache(backend);
+  ASSERT_TRUE(cache.persist(config));
+  EXPECT_EQ(2u, cache.unopened()); // from the snapshot and the journal
+
+  // concurrent requests share one open
+  std::vector<const fs::object_t*> directories(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < directories.size(); ++i) {
+      threads.emplace_back([&, i] { directories[i] = cache.get(a).directory; });
+    }
+  for (auto& thread : threads) thread.join();
+  ASSERT_NE(nullptr, directories[0]);
+  EXPECT_EQ(std::vector<const fs::object_t*>(directories.size(), directories[0]), directories);
+  EXPECT_EQ(L"/export/a", directories[0]->path());
+  EXPECT_EQ(1u, cache.unopened());
+
+  auto mount_b = cache.get(b);
+  ASSERT_NE(nullptr, mount_b.directory);
+  fs::volume_file_id_t id;
+  ASSERT_TRUE(mount_b.directory->id(id));
+  EXPECT_EQ(id, mount_b.filehandle->volume_file_id);
+}
+
+// a filehandle must not reach another directory of the same path
+TEST_F(mount_cache_test, replaced_directory_is_not_served) {
+  uint64_t a;
+  {
+    mount_cache_t cache(backend);
+    cache.persist(config);
+    a = mount(cache, "client", "/a", L"/export/a");
+  }
+  ASSERT_TRUE(backend.open_path(L"/export")->remove_directory("a"));
+  backend.make_directories(L"/export/a");
+
+  mount_cache_t cache(backend);
+  ASSERT_TRUE(cache.persist(config));
+  auto mount_a = cache.get(a);
+  EXPECT_EQ(nullptr, mount_a.directory);
+  EXPECT_EQ(nullptr, mount_a.filehandle);
+  EXPECT_EQ(1u, cache.unopened());
+}
+
+TEST_F(mount_cache_test, checkpoints_in_the_background) {
+  config.checkpoint_records = 3;
+  mount_cache_t cache(backend);
+  cache.persist(config);
+  mount(cache, "client", "/a", L"/export/a");
+  for (auto i = 0; i < 500 && 0 == cache.journal_stats().checkpoints; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  EXPECT_EQ(1u, cache.journal_stats().checkpoints);
+  EXPECT_FALSE(read(config.path).empty());
+}
+
+// requests look up their mount without the lock of the mounts
+TEST_F(mount_cache_test, get_runs_while_mounting) {
+  mount_cache_t cache(backend);
+  auto a = mount(cache, "client", "/a", L"/export/a");
+  for (auto i = 0; i < 200; ++i) backend.make_directories(L"/export/m" + std::to_wstring(i));
+
+  std::atomic<bool> done {false};
+  std::atomic<bool> failed {false};
+  std::thread reader([&] {
+      while ( !done) {
+          auto view = cache.get(a);
+          if ( !view || a != view.filehandle->mount_id) failed = true;
+        }
+    });
+  uint64_t last = 0;
+  for (auto i = 0; i < 200; ++i) last = mount(cache, "client", "/m" + std::to_string(i), L"/export/m" + std::to_wstring(i));
+  done = true;
+  reader.join();
+  EXPECT_FALSE(failed);
+  ASSERT_TRUE(cache.get(last));
+  EXPECT_EQ(L"/export/m199", cache.get(last).directory->path());
+}
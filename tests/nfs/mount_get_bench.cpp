@@ -0,0 +1,114 @@
+#include "nfs/mount_cache.h"
+#include "fs/memory_backend.h"
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Every nfs3 request starts with the lookup of its mount. The threads hammer get on
+ * a few hundred mounts. In the contended variants every 64th lookup of the first
+ * thread is a mount instead - it opens the directory under the exclusive lock. The
+ * legacy cache is the former get with a shared lock and a copy of the filehandle.
+ */
+namespace {
+  const size_t MOUNTS = 256;
+  const size_t STORM = 4096; // directories mounted in the contended variants
+
+  std::wstring path(size_t i) { return L"/export/project" + std::to_wstring(i); }
+
+  struct legacy_cache_t {
+    std::pair<const fs::object_t*, binary_t> get(uint64_t mount_id) const {
+      std::pair<const fs::object_t*, binary_t> result;
+      std::shared_lock<std::shared_timed_mutex> lock(mutex_m);
+      auto it = mount_map_m.find(mount_id);
+      if (it == mount_map_m.end()) return result;
+      result.first = it->second.first.get();
+      result.second = it->second.second;
+      return result;
+    }
+
+    void mount(uint64_t mount_id, fs::backend_t& backend, const std::wstring& windows_path) {
+      std::unique_lock<std::shared_timed_mutex> lock(mutex_m);
+      auto& entry = mount_map_m[mount_id];
+      entry.first = backend.open_path(windows_path);
+      auto& filehandle = mount_filehandle_t::create_in_binary(entry.second);
+      filehandle.mount_id = mount_id;
+      entry.first->id(filehandle.volume_file_id);
+    }
+
+  private:
+    mutable std::shared_timed_mutex mutex_m;
+    std::unordered_map<uint64_t, std::pair<fs::object_ptr_t, binary_t>> mount_map_m;
+  };
+
+  struct mounts_t {
+    mounts_t()
+      : cache(backend)
+    {
+      for (size_t i = 0; i < MOUNTS + STORM; ++i) backend.make_directories(path(i));
+      for (size_t i = 0; i < MOUNTS; ++i) {
+          mount(i);
+          legacy.mount(i + 1, backend, path(i));
+        }
+    }
+
+    void mount(size_t i) {
+      cache.mount_session([&](const mount_cache_t::mount_session_t& session) {
+          session.mount("client", "/mounts/" + std::to_string(i), path(i));
+        });
+    }
+
+    fs::memory_backend_t backend;
+    mount_cache_t cache;
+    legacy_cache_t legacy;
+    size_t stormed = 0; // by the first thread
+  };
+
+  mounts_t& mounts() {
+    static mounts_t result;
+    return result;
+  }
+
+  bool storms(benchmark::State& state, size_t iteration) {
+    return state.range(0) && 0 == state.thread_index() && 0 == iteration % 64;
+  }
+
+  void set_counters(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations());
+    if (state.range(0)) state.SetLabel("with mounts");
+  }
+} // namespace
+
+static void BM_get(benchmark::State& state) {
+  auto& m = mounts();
+  uint64_t id = state.thread_index();
+  size_t iteration = 0;
+  for (auto _ : state) {
+      if (storms(state, iteration++)) m.mount(MOUNTS + m.stormed++ % STORM);
+      else benchmark::DoNotOptimize(m.cache.get(1 + id++ % MOUNTS).filehandle->volume_file_id);
+    }
+  set_counters(state);
+}
+BENCHMARK(BM_get)->Arg(0)->Arg(1)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+static void BM_get_legacy(benchmark::State& state) {
+  auto& m = mounts();
+  uint64_t id = state.thread_index();
+  size_t iteration = 0;
+  for (auto _ : state) {
+      if (storms(state, iteration++)) {
+          auto i = MOUNTS + m.stormed++ % STORM;
+          m.legacy.mount(i + 1, m.backend, path(i));
+        }
+      else {
+          auto mount = m.legacy.get(1 + id++ % MOUNTS);
+          benchmark::DoNotOptimize(mount_filehandle_t::view_binary(mount.second).volume_file_id);
+        }
+    }
+  set_counters(state);
+}
+BENCHMARK(BM_get_legacy)->Arg(0)->Arg(1)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
@@ -0,0 +1,67 @@
+#include "fs/memory_backend.h"
+#include "nfs/mount.h"
+#include "nfs/nfs3.h"
+#include "logging/logger.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+  using namespace nfs3;
+
+  struct nfs3_test : ::testing::Test {
+    nfs3_test()
+      : mount_program(backend)
+      , nfs_program(mount_program.cache(), rpc_program::config_t())
+    {
+      logging::scoped_level_t quiet(logging::level_t::OFF);
+      backend.make_directories(L"/export");
+      auto& aliases = mount_program.aliases();
+      aliases.add(aliases.create_source(), L"/export", "/export");
+      root = mount_program.mount("client", "/export").filehandle;
+    }
+
+    filehandle_t create(const std::string& name) {
+      create_args_t args;
+      args.where = { root, name };
+      args.how = create_how_t::UNCHECKED;
+      args.obj_attributes.set(set_attr_t());
+      auto result = nfs_program.create(args);
+      return result.object.is<filehandle_t>() ? result.object.get<filehandle_t>() : filehandle_t();
+    }
+
+    write_result_t write(const filehandle_t& filehandle, uint64_t offset, size_t size, stable_how_t stable) {
+      write_args_t args;
+      args.filehandle = filehandle;
+      args.offset = offset;
+      args.count = static_cast<count_t>(size);
+      args.stable = stable;
+      args.data = binary_t(size, 0x55);
+      return nfs_program.write(std::move(args));
+    }
+
+    fs::memory_backend_t backend;
+    mount::rpc_program mount_program;
+    rpc_program nfs_program;
+    filehandle_t root;
+  };
+} // namespace
+
+// attributes cached before the write must not hide the buffered data
+TEST_F(nfs3_test, unstable_write_then_lookup_then_get_attr_reports_the_new_size) {
+  auto file = create("file");
+  ASSERT_FALSE(file.empty());
+  auto before = nfs_program.get_attr(file);
+  ASSERT_EQ(status_t::OK, before.status);
+  EXPECT_EQ(0u, before.attr.size);
+
+  ASSERT_EQ(status_t::OK, write(file, 0, 1000, stable_how_t::UNSTABLE).status);
+
+  auto looked_up = nfs_program.lookup({ root, "file" });
+  ASSERT_EQ(status_t::OK, looked_up.status);
+  ASSERT_TRUE(looked_up.object_attributes.is<file_attr_t>());
+  EXPECT_EQ(1000u, looked_up.object_attributes.get<file_attr_t>().size);
+
+  auto after = nfs_program.get_attr(file);
+  ASSERT_EQ(status_t::OK, after.status);
+  EXPECT_EQ(1000u, after.attr.size);
+}
@@ -0,0 +1,242 @@
+#include "nfs/nfs3_xdr.h"
+#include "rpc/xdr.h"
+
+#include <benchmark/benchmark.h>
+
+/*
+ * Decoding of nfs3 arguments with the xdr schema.
+ * The legacy readers are the previous offset recomputing implementation for comparison
+ * (with the optional attributes gated on their own flags).
+ */
+namespace {
+  using namespace nfs3;
+
+  struct legacy_filehandle_reader_t {
+    legacy_filehandle_reader_t(const binary_reader_t& reader)
+      : filehandle_m(xdr::opaque_reader<FILEHANDLE_SIZE>(reader, 0))
+    {}
+
+    size_t size() const { return filehandle_m.read_size(); }
+    bool valid() const { return filehandle_m.valid(); }
+    filehandle_t read() const { return filehandle_m.to_binary(); }
+
+  private:
+    xdr::opaque_reader_t filehandle_m;
+  };
+
+  struct legacy_set_attr_reader_t {
+    legacy_set_attr_reader_t(const binary_reader_t& reader)
+      : reader_m(reader)
+    {}
+    size_t size() const { return mtime_size(); }
+    bool valid() const { return reader_m.has_size(size()); }
+
+    bool has_mode() const { return reader_m.has_size(4) && reader_m.get32(0); }
+    meta::optional_t<mode_t> mode() const {
+      meta::optional_t<mode_t> result;
+      if (has_mode()) result.set(reader_m.get32<mode_t>(4));
+      return result;
+    }
+    uint32_t mode_size() const { return 4 + (has_mode() ? 4 : 0); }
+
+    bool has_uid() const { return reader_m.has_size(mode_size() + 4) && reader_m.get32(mode_size()); }
+    meta::optional_t<uid_t> uid() const {
+      meta::optional_t<uid_t> result;
+      if (has_uid()) result.set(reader_m.get32<uid_t>(4 + mode_size()));
+      return result;
+    }
+    uint32_t uid_size() const { return mode_size() + 4 + (has_uid() ? 4 : 0); }
+
+    bool has_gid() const { return reader_m.has_size(uid_size() + 4) && reader_m.get32(uid_size()); }
+    meta::optional_t<gid_t> gid() const {
+      meta::optional_t<gid_t> result;
+      if (has_gid()) result.set(reader_m.get32<gid_t>(4 + uid_size()));
+      return result;
+    }
+    uint32_t gid_size() const { return uid_size() + 4 + (has_gid() ? 4 : 0); }
+
+    bool has_fsize() const { return reader_m.has_size(gid_size() + 4) && reader_m.get32(gid_size()); }
+    meta::optional_t<nfs3::size_t> fsize() const {
+      meta::optional_t<nfs3::size_t> result;
+      if (has_fsize()) result.set(reader_m.get64(4 + gid_size()));
+      return result;
+    }
+    uint32_t fsize_size() const { return gid_size() + 4 + (has_fsize() ? 8 : 0); }
+
+    time_how_t atime_how() const { return reader_m.has_size(fsize_size() + 4) ? reader_m.get32<time_how_t>(fsize_size()) : time_how_t::DONT_CHANGE; }
+    nfs3::time_t atime() const {
+      nfs3::time_t result;
+      result.seconds = reader_m.get32(4 + fsize_size());
+      result.nanoseconds = reader_m.get32(8 + fsize_size());
+      return result;
+    }
+    uint32_t atime_size() const { return fsize_size() + 4 + (atime_how() == time_how_t::SET_TO_CLIENT_TIME ? 8 : 0); }
+
+    time_how_t mtime_how() const { return reader_m.has_size(atime_size() + 4) ? reader_m.get32<time_how_t>(atime_size()) : time_how_t::DONT_CHANGE; }
+    nfs3::time_t mtime() const {
+      nfs3::time_t result;
+      result.seconds = reader_m.get32(4 + atime_size());
+      result.nanoseconds = reader_m.get32(8 + atime_size());
+      return result;
+    }
+    uint32_t mtime_size() const { return atime_size() + 4 + (mtime_how() == time_how_t::SET_TO_CLIENT_TIME ? 8 : 0); }
+
+    set_attr_t read() const {
+      set_attr_t result;
+      result.mode = mode();
+      result.uid = uid();
+      result.gid = gid();
+      result.size = fsize();
+      result.set_atime = atime_how();
+      if (result.set_atime == time_how_t::SET_TO_CLIENT_TIME) result.atime = atime();
+      result.set_mtime = mtime_how();
+      if (result.set_mtime == time_how_t::SET_TO_CLIENT_TIME) result.mtime = mtime();
+      return result;
+    }
+
+  private:
+    const binary_reader_t reader_m;
+  };
+
+  struct legacy_set_attr_args_reader_t {
+    legacy_set_attr_args_reader_t(const binary_reader_t& reader)
+      : reader_m(reader)
+      , directory_handle_m(reader)
+      , set_attr_reader_m(reader.get_reader(directory_handle_m.size()))
+    {}
+    size_t size() const { return directory_handle_m.size() + set_attr_reader_m.size() + 4 + (has_time() ? 8 : 0); }
+    bool valid() const { return directory_handle_m.valid() && set_attr_reader_m.valid() && reader_m.has_size(size()); }
+
+    bool has_time() const {
+      return reader_m.has_size(directory_handle_m.size() + set_attr_reader_m.size() + 4)
+          && reader_m.get32(directory_handle_m.size() + set_attr_reader_m.size());
+    }
+    nfs3::time_t check_time() const {
+      nfs3::time_t result;
+      result.seconds = reader_m.get32(directory_handle_m.size() + set_attr_reader_m.size() + 4);
+      result.nanoseconds = reader_m.get32(directory_handle_m.size() + set_attr_reader_m.size() + 8);
+      return result;
+    }
+
+    set_attr_args_t read() const {
+      set_attr_args_t result;
+      result.filehandle = directory_handle_m.read();
+      result.new_attributes = set_attr_reader_m.read();
+      if (has_time()) result.check_time.set(check_time());
+      return result;
+    }
+
+  private:
+    binary_reader_t reader_m;
+    legacy_filehandle_reader_t directory_handle_m;
+    legacy_set_attr_reader_t set_attr_reader_m;
+  };
+
+  struct legacy_read_dir_plus_args_reader_t {
+    legacy_read_dir_plus_args_reader_t(const binary_reader_t& reader)
+      : reader_m(reader)
+      , directory_handle_m(reader)
+    {}
+    size_t size() const { return 16 + directory_handle_m.size() + sizeof(cookie_verifier_t); }
+    bool valid() const { return directory_handle_m.valid() && reader_m.has_size(size()); }
+
+    read_dir_plus_args_t read() const {
+      read_dir_plus_args_t result;
+      result.directory = directory_handle_m.read();
+      result.cookie = reader_m.get64(directory_handle_m.size());
+      reader_m.get_binary(8 + directory_handle_m.size(), result.cookie_verifier);
+      result.dircount = reader_m.get32(8 + directory_handle_m.size() + sizeof(cookie_verifier_t));
+      result.maxcount = reader_m.get32(12 + directory_handle_m.size() + sizeof(cookie_verifier_t));
+      return result;
+    }
+
+  private:
+    binary_reader_t reader_m;
+    legacy_filehandle_reader_t directory_handle_m;
+  };
+
+  // all optional attributes present - the worst case for the legacy reader
+  binary_t make_set_attr_args() {
+    set_attr_args_t arguments;
+    arguments.filehandle = binary_t(32, 1);
+    arguments.new_attributes.mode.set(0644u);
+    arguments.new_attributes.uid.set(1000u);
+    arguments.new_attributes.gid.set(1000u);
+    arguments.new_attributes.size.set(nfs3::size_t(1) << 20);
+    arguments.new_attributes.set_atime = time_how_t::SET_TO_CLIENT_TIME;
+    arguments.new_attributes.atime = { 1500000000, 1 };
+    arguments.new_attributes.set_mtime = time_how_t::SET_TO_CLIENT_TIME;
+    arguments.new_attributes.mtime = { 1500000000, 2 };
+    arguments.check_time.set(nfs3::time_t{ 1500000000, 3 });
+    return xdr::to_binary(arguments);
+  }
+
+  binary_t make_read_dir_plus_args() {
+    return xdr::to_binary(read_dir_plus_args_t{ binary_t(32, 1), 1234, {{ 1, 2, 3, 4, 5, 6, 7, 8 }}, 8192, 32768 });
+  }
+
+  void BM_set_attr_args_legacy(benchmark::State& state) {
+    auto binary = make_set_attr_args();
+    auto reader = binary_reader_t::binary(binary);
+    while (state.KeepRunning()) {
+        legacy_set_attr_args_reader_t args_reader(reader);
+        if ( !args_reader.valid()) state.SkipWithError("invalid");
+        auto arguments = args_reader.read();
+        benchmark::DoNotOptimize(arguments);
+      }
+  }
+  BENCHMARK(BM_set_attr_args_legacy);
+
+  void BM_set_attr_args_schema(benchmark::State& state) {
+    auto binary = make_set_attr_args();
+    auto reader = binary_reader_t::binary(binary);
+    while (state.KeepRunning()) {
+        set_attr_args_t arguments;
+        if ( !xdr::decode(reader, arguments)) state.SkipWithError("invalid");
+        benchmark::DoNotOptimize(arguments);
+      }
+  }
+  BENCHMARK(BM_set_attr_args_schema);
+
+  void BM_read_dir_plus_args_legacy(benchmark::State& state) {
+    auto binary = make_read_dir_plus_args();
+    auto reader = binary_reader_t::binary(binary);
+    while (state.KeepRunning()) {
+        legacy_read_dir_plus_args_reader_t args_reader(reader);
+        if ( !args_reader.valid()) state.SkipWithError("invalid");
+        auto arguments = args_reader.read();
+        benchmark::DoNotOptimize(arguments);
+      }
+  }
+  BENCHMARK(BM_read_dir_plus_args_legacy);
+
+  void BM_read_dir_plus_args_schema(benchmark::State& state) {
+    auto binary = make_read_dir_plus_args();
+    auto reader = binary_reader_t::binary(binary);
+    while (state.KeepRunning()) {
+        read_dir_plus_args_t arguments;
+        if ( !xdr::decode(reader, arguments)) state.SkipWithError("invalid");
+        benchmark::DoNotOptimize(arguments);
+      }
+  }
+  BENCHMARK(BM_read_dir_plus_args_schema);
+
+  void BM_read_dir_plus_result_encode(benchmark::State& state) {
+    read_dir_plus_result_t result;
+    result.status = status_t::OK;
+    result.reply.resize(state.range(0));
+    auto cookie = cookie_t();
+    for (auto& entry : result.reply) {
+        entry.file_id = entry.cookie = ++cookie;
+        entry.name = "file_" + std::to_string(cookie) + ".txt";
+        entry.name_attributes.set(file_attr_t{});
+        entry.name_handle.set(binary_t(32, 1));
+      }
+    while (state.KeepRunning()) {
+        auto binary = xdr::to_binary(result, 256 + result.reply.size() * 256);
+        benchmark::DoNotOptimize(binary.data());
+      }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_read_dir_plus_result_encode)->Arg(100)->Arg(1000);
+} // namespace
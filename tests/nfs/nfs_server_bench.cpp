@@ -0,0 +1,199 @@
+#include "fs/memory_backend.h"
+#include "nfs/mount.h"
+#include "nfs/mount_xdr.h"
+#include "nfs/nfs3.h"
+#include "nfs/nfs3_xdr.h"
+#include "rpc/rpc.h"
+#include "rpc/rpc_router.h"
+#include "logging/logger.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+/*
+ * Server overhead per nfs3 operation on the in-memory backend.
+ * Encoded calls are routed like the servers route received records - without sockets.
+ */
+namespace {
+  using namespace nfs3;
+
+  enum {
+    FILE_SIZE = 1 << 20,
+    LISTING_SIZE = 100,
+    REPLY_HEADER_SIZE = 24, // xid, type, accepted, null verifier, success
+  };
+
+  // the programs log mounts and failures - that is not measured
+  using quiet_t = logging::scoped_level_t;
+
+  struct server_t {
+    server_t()
+      : mount_program_m(backend_m)
+      , nfs_program_m(mount_program_m.cache(), nfs3::rpc_program::config_t())
+    {
+      quiet_t quiet(logging::level_t::OFF);
+      backend_m.make_directories(L"/bench/listing");
+      auto& aliases = mount_program_m.aliases();
+      aliases.add(aliases.create_source(), L"/bench", "/bench");
+      router_m.add(mount_program_m.describe());
+      router_m.add(nfs_program_m.describe());
+
+      mount::mount_result_t mounted;
+      xdr::decode(result_reader(call(mount::PROGRAM, mount::VERSION, 1, xdr::to_binary_with<xdr::directory_path_codec_t>(std::string("/bench")))), mounted);
+      root = mounted.filehandle;
+
+      file = create(root, "file");
+      written = create(root, "written");
+      write(file, binary_t(FILE_SIZE, 0x55));
+      listing = lookup(root, "listing");
+      for (auto i = 0; i < LISTING_SIZE; ++i) create(listing, "entry" + std::to_string(i));
+    }
+
+    binary_t call(uint32_t program, uint32_t version, uint32_t procedure, const binary_t& parameters) {
+      auto request = rpc::message_builder().call(++xid_m).null_auth(program, version, procedure, parameters);
+      router_args_t args { "bench", binary_reader_t::binary(request) };
+      return router_m.handle(args).flatten();
+    }
+
+    template<typename args_t>
+    binary_t call(uint32_t procedure, const args_t& args) {
+      return call(nfs3::PROGRAM, nfs3::VERSION, procedure, xdr::to_binary(args));
+    }
+
+    static binary_reader_t result_reader(const binary_t& reply) {
+      return binary_reader_t::binary(reply).get_reader(REPLY_HEADER_SIZE);
+    }
+
+    // the nfs status leads every result
+    static bool ok(const binary_t& reply) {
+      return reply.size() > REPLY_HEADER_SIZE
+          && status_t::OK == static_cast<status_t>(result_reader(reply).get32(0));
+    }
+
+    filehandle_t lookup(const filehandle_t& directory, const std::string& name) {
+      lookup_result_t result;
+      xdr::decode(result_reader(call(3, dir_op_args_t { directory, name })), result);
+      return result.object_handle;
+    }
+
+    filehandle_t create(const filehandle_t& directory, const std::string& name) {
+      create_args_t args;
+      args.where = { directory, name };
+      args.how = create_how_t::UNCHECKED;
+      args.obj_attributes.set(set_attr_t());
+      create_result_t result;
+      xdr::decode(result_reader(call(8, args)), result);
+      return result.object.is<filehandle_t>() ? result.object.get<filehandle_t>() : filehandle_t();
+    }
+
+    void write(const filehandle_t& filehandle, const binary_t& data) {
+      write_args_t args;
+      args.filehandle = filehandle;
+      args.offset = 0;
+      args.count = static_cast<count_t>(data.size());
+      args.stable = stable_how_t::FILE_SYNC;
+      args.data = data;
+      call(7, args);
+    }
+
+    filehandle_t root;
+    filehandle_t file;
+    filehandle_t written;
+    filehandle_t listing;
+
+  private:
+    fs::memory_backend_t backend_m;
+    mount::rpc_program mount_program_m;
+    nfs3::rpc_program nfs_program_m;
+    rpc_router_t router_m;
+    uint32_t xid_m = 0;
+  };
+
+  server_t& server() {
+    static server_t result;
+    return result;
+  }
+
+  // runs the call until the benchmark stops - every call is checked
+  void run(benchmark::State& state, uint32_t procedure, const binary_t& parameters, size_t bytes = 0) {
+    auto& bench_server = server();
+    quiet_t quiet(logging::level_t::OFF);
+    while (state.KeepRunning()) {
+        auto reply = bench_server.call(nfs3::PROGRAM, nfs3::VERSION, procedure, parameters);
+        if ( !server_t::ok(reply) && 0 != procedure) {
+            state.SkipWithError("call failed");
+            break;
+          }
+      }
+    state.SetItemsProcessed(state.iterations());
+    if (0 != bytes) state.SetBytesProcessed(state.iterations() * bytes);
+  }
+
+  void BM_null(benchmark::State& state) {
+    run(state, 0, {});
+  }
+  BENCHMARK(BM_null);
+
+  void BM_get_attr(benchmark::State& state) {
+    run(state, 1, xdr::to_binary_with<xdr::filehandle_codec_t>(server().file));
+  }
+  BENCHMARK(BM_get_attr);
+
+  void BM_lookup(benchmark::State& state) {
+    run(state, 3, xdr::to_binary(dir_op_args_t { server().root, "file" }));
+  }
+  BENCHMARK(BM_lookup);
+
+  void BM_read(benchmark::State& state) {
+    read_args_t args;
+    args.filehandle = server().file;
+    args.offset = 0;
+    args.count = static_cast<count_t>(state.range(0));
+    run(state, 6, xdr::to_binary(args), args.count);
+  }
+  BENCHMARK(BM_read)->Arg(4096)->Arg(65536);
+
+  void BM_write(benchmark::State& state) {
+    write_args_t args;
+    args.filehandle = server().written;
+    args.offset = 0;
+    args.count = static_cast<count_t>(state.range(0));
+    args.stable = stable_how_t::FILE_SYNC;
+    args.data = binary_t(args.count, 0xAA);
+    run(state, 7, xdr::to_binary(args), args.count);
+  }
+  BENCHMARK(BM_write)->Arg(4096)->Arg(65536);
+
+  void BM_read_dir_plus(benchmark::State& state) {
+    read_dir_plus_args_t args;
+    args.directory = server().listing;
+    args.cookie = 0;
+    args.cookie_verifier = {};
+    args.dircount = 0x10000;
+    args.maxcount = 0x40000;
+    run(state, 17, xdr::to_binary(args));
+  }
+  BENCHMARK(BM_read_dir_plus);
+
+  // two calls per iteration
+  void BM_create_remove(benchmark::State& state) {
+    auto& bench_server = server();
+    quiet_t quiet(logging::level_t::OFF);
+    create_args_t create;
+    create.where = { bench_server.root, "created" };
+    create.how = create_how_t::UNCHECKED;
+    create.obj_attributes.set(set_attr_t());
+    auto create_parameters = xdr::to_binary(create);
+    auto remove_parameters = xdr::to_binary(create.where);
+    while (state.KeepRunning()) {
+        if ( !server_t::ok(bench_server.call(nfs3::PROGRAM, nfs3::VERSION, 8, create_parameters))
+             || !server_t::ok(bench_server.call(nfs3::PROGRAM, nfs3::VERSION, 12, remove_parameters))) {
+            state.SkipWithError("call failed");
+            break;
+          }
+      }
+    state.SetItemsProcessed(2 * state.iterations());
+  }
+  BENCHMARK(BM_create_remove);
+} // namespace
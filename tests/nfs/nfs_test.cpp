@@ -0,0 +1,229 @@
+#include "nfs/nfs3_xdr.h"
+#include "nfs/mount_xdr.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace {
+  nfs3::file_attr_t make_file_attr(uint32_t seed) {
+    nfs3::file_attr_t result;
+    result.type = nfs3::filetype_t::REGULAR_FILE;
+    result.mode = 0644;
+    result.nlink = 1;
+    result.uid = seed;
+    result.gid = seed + 1;
+    result.size = 1000ull * seed;
+    result.used = 4096;
+    result.rdev = { 0, 0 };
+    result.fsid = 7;
+    result.fileid = 0x100000000ull + seed;
+    result.atime = { 1500000000, 1 };
+    result.mtime = { 1500000001, 2 };
+    result.ctime = { 1500000002, 3 };
+    return result;
+  }
+
+  nfs3::post_op_attr_t make_post_op_attr(uint32_t seed) {
+    nfs3::post_op_attr_t result;
+    result.set(make_file_attr(seed));
+    return result;
+  }
+
+  // encode -> decode -> encode has to reproduce the same bytes
+  template<typename value_t>
+  void expect_round_trip(const value_t& value) {
+    auto encoded = xdr::to_binary(value);
+    value_t decoded;
+    ASSERT_TRUE(xdr::decode(binary_reader_t::binary(encoded), decoded));
+    EXPECT_EQ(encoded, xdr::to_binary(decoded));
+
+    // every truncation is rejected
+    for (auto size = 0u; size < encoded.size(); ++size) {
+        value_t truncated;
+        EXPECT_FALSE(xdr::decode(binary_reader_t(encoded.data(), encoded.data() + size), truncated)) << size;
+      }
+  }
+
+  // random input must never crash, whatever decodes encodes to a stable form
+  template<typename value_t>
+  void fuzz_decode(std::mt19937& random, const binary_t& prefix = {}) {
+    for (auto i = 0; i < 2000; ++i) {
+        binary_builder_t input;
+        input.append_binary(prefix);
+        auto words = random() % 64;
+        for (auto n = 0u; n < words; ++n) {
+            // small words make present optionals, short opaques and longer lists likely
+            input.append32(0 == random() % 4 ? static_cast<uint32_t>(random()) : static_cast<uint32_t>(random() % 3));
+          }
+        if (0 == random() % 2) input.append8(static_cast<uint8_t>(random())); // unaligned end
+        value_t decoded;
+        if ( !xdr::decode(binary_reader_t::binary(input.build()), decoded)) continue;
+        auto encoded = xdr::to_binary(decoded);
+        value_t again;
+        ASSERT_TRUE(xdr::decode(binary_reader_t::binary(encoded), again));
+        EXPECT_EQ(encoded, xdr::to_binary(again));
+      }
+  }
+} // namespace
+
+TEST(nfs3_xdr, set_attr_args_without_mode) {
+  nfs3::set_attr_args_t arguments;
+  arguments.filehandle = binary_t(24, 3);
+  arguments.new_attributes.uid.set(1000u);
+  arguments.new_attributes.size.set(uint64_t(42));
+  arguments.new_attributes.set_atime = nfs3::time_how_t::SET_TO_SERVER_TIME;
+  arguments.new_attributes.set_mtime = nfs3::time_how_t::SET_TO_CLIENT_TIME;
+  arguments.new_attributes.mtime = { 12, 34 };
+  expect_round_trip(arguments);
+
+  nfs3::set_attr_args_t decoded;
+  ASSERT_TRUE(xdr::decode(binary_reader_t::binary(xdr::to_binary(arguments)), decoded));
+  EXPECT_EQ(binary_t(24, 3), decoded.filehandle);
+  EXPECT_FALSE(decoded.new_attributes.mode.is<nfs3::mode_t>());
+  ASSERT_TRUE(decoded.new_attributes.uid.is<nfs3::uid_t>());
+  EXPECT_EQ(1000u, decoded.new_attributes.uid.get<nfs3::uid_t>());
+  ASSERT_TRUE(decoded.new_attributes.size.is<nfs3::size_t>());
+  EXPECT_EQ(42u, decoded.new_attributes.size.get<nfs3::size_t>());
+  EXPECT_EQ(12u, decoded.new_attributes.mtime.seconds);
+  EXPECT_EQ(34u, decoded.new_attributes.mtime.nanoseconds);
+  EXPECT_FALSE(decoded.check_time.is<nfs3::time_t>());
+}
+
+TEST(nfs3_xdr, arguments_round_trip) {
+  const nfs3::dir_op_args_t dir_op{ binary_t(16, 1), "name.txt" };
+  expect_round_trip(dir_op);
+
+  expect_round_trip(nfs3::access_args_t{ binary_t(16, 1), nfs3::ACCESS_READ | nfs3::ACCESS_LOOKUP });
+  expect_round_trip(nfs3::read_args_t{ binary_t(64, 2), 1ull << 40, 65536 });
+  expect_round_trip(nfs3::write_args_t{ binary_t(8, 3), 4096, 5, nfs3::stable_how_t::FILE_SYNC, binary_t(5, 9) });
+  expect_round_trip(nfs3::rename_args_t{ dir_op, { binary_t(16, 2), "other" } });
+  expect_round_trip(nfs3::read_dir_args_t{ binary_t(16, 1), 77, {{ 1, 2, 3, 4, 5, 6, 7, 8 }}, 4096 });
+  expect_round_trip(nfs3::read_dir_plus_args_t{ binary_t(16, 1), 77, {}, 4096, 32768 });
+  expect_round_trip(nfs3::commit_args_t{ binary_t(16, 1), 0, 0 });
+
+  nfs3::create_args_t create;
+  create.where = dir_op;
+  create.how = nfs3::create_how_t::GUARDED;
+  nfs3::set_attr_t attributes{};
+  attributes.mode.set(0755u);
+  attributes.set_atime = nfs3::time_how_t::SET_TO_CLIENT_TIME;
+  attributes.atime = { 5, 6 };
+  create.obj_attributes.set(attributes);
+  expect_round_trip(create);
+
+  create.how = nfs3::create_how_t::EXCLUSIVE;
+  create.obj_attributes = {};
+  create.verifier.set(nfs3::create_verifier_t{{ 8, 7, 6, 5, 4, 3, 2, 1 }});
+  expect_round_trip(create);
+
+  expect_round_trip(nfs3::mkdir_args_t{ dir_op, attributes });
+}
+
+TEST(nfs3_xdr, results_round_trip) {
+  const auto attributes = make_post_op_attr(1);
+  nfs3::wcc_data_t wcc;
+  wcc.before.set(nfs3::wcc_attr_t{ 10, { 1, 2 }, { 3, 4 } });
+  wcc.after = attributes;
+
+  expect_round_trip(nfs3::get_attr_result_t{ nfs3::status_t::OK, make_file_attr(2) });
+  expect_round_trip(nfs3::get_attr_result_t{ nfs3::status_t::ERR_STALE, {} });
+  expect_round_trip(nfs3::set_attr_result_t{ nfs3::status_t::OK, wcc });
+  expect_round_trip(nfs3::lookup_result_t{ nfs3::status_t::OK, binary_t(32, 5), attributes, attributes });
+  expect_round_trip(nfs3::lookup_result_t{ nfs3::status_t::ERR_NO_ENTRY, {}, {}, attributes });
+  expect_round_trip(nfs3::access_result_t{ nfs3::status_t::OK, attributes, nfs3::ACCESS_READ });
+  expect_round_trip(nfs3::readlink_result_t{ nfs3::status_t::OK, attributes, "../target" });
+  expect_round_trip(nfs3::write_result_t{ nfs3::status_t::OK, wcc, 100, nfs3::stable_how_t::UNSTABLE, {{ 1, 2, 3, 4, 5, 6, 7, 8 }} });
+  expect_round_trip(nfs3::remove_result_t{ nfs3::status_t::ERR_NOTEMPTY, wcc });
+  expect_round_trip(nfs3::rename_result_t{ nfs3::status_t::OK, wcc, {} });
+  expect_round_trip(nfs3::commit_result_t{ nfs3::status_t::OK, wcc, {} });
+
+  nfs3::create_result_t create;
+  create.status = nfs3::status_t::OK;
+  create.object.set(binary_t(20, 4));
+  create.object_attributes = attributes;
+  create.directory_wcc = wcc;
+  expect_round_trip(create);
+
+  nfs3::read_dir_result_t read_dir;
+  read_dir.status = nfs3::status_t::OK;
+  read_dir.directory_attributes = attributes;
+  read_dir.reply = { { 1, ".", 1 }, { 2, "..", 2 }, { 3, "file", 3 } };
+  read_dir.is_finished = false;
+  expect_round_trip(read_dir);
+
+  nfs3::read_dir_plus_result_t read_dir_plus;
+  read_dir_plus.status = nfs3::status_t::OK;
+  read_dir_plus.reply.resize(3);
+  read_dir_plus.reply[1].name = "with attributes";
+  read_dir_plus.reply[1].name_attributes = attributes;
+  read_dir_plus.reply[1].name_handle.set(binary_t(24, 6));
+  expect_round_trip(read_dir_plus);
+
+  nfs3::fs_stat_result_t fs_stat;
+  fs_stat.status = nfs3::status_t::OK;
+  fs_stat.total_bytes = 1ull << 40;
+  expect_round_trip(fs_stat);
+  expect_round_trip(nfs3::fs_info_result_t{});
+
+  nfs3::fs_info_result_t fs_info;
+  fs_info.status = nfs3::status_t::OK;
+  expect_round_trip(fs_info);
+
+  nfs3::path_conf_result_t path_conf;
+  path_conf.status = nfs3::status_t::OK;
+  expect_round_trip(path_conf);
+}
+
+TEST(nfs3_xdr, oversized_opaque_is_rejected) {
+  binary_builder_t builder;
+  builder.append32(nfs3::FILEHANDLE_SIZE + 4);
+  builder.append_binary(binary_t(nfs3::FILEHANDLE_SIZE + 4, 1));
+  builder.append64(0);
+  builder.append32(100);
+  nfs3::read_args_t arguments;
+  EXPECT_FALSE(xdr::decode(binary_reader_t::binary(builder.build()), arguments));
+
+  nfs3::filehandle_t filehandle;
+  EXPECT_FALSE(xdr::decode_with<xdr::filehandle_codec_t>(binary_reader_t::binary(builder.build()), filehandle));
+}
+
+TEST(nfs3_xdr, random_input) {
+  std::mt19937 random(1813);
+  fuzz_decode<nfs3::set_attr_args_t>(random);
+  fuzz_decode<nfs3::create_args_t>(random);
+  fuzz_decode<nfs3::mkdir_args_t>(random);
+  fuzz_decode<nfs3::rename_args_t>(random);
+  fuzz_decode<nfs3::write_args_t>(random);
+  fuzz_decode<nfs3::read_dir_plus_args_t>(random);
+  fuzz_decode<nfs3::read_dir_result_t>(random, { 0, 0, 0, 0 });
+  fuzz_decode<nfs3::read_dir_plus_result_t>(random, { 0, 0, 0, 0 });
+  fuzz_decode<nfs3::lookup_result_t>(random, { 0, 0, 0, 0 });
+  fuzz_decode<nfs3::write_result_t>(random, { 0, 0, 0, 0 });
+}
+
+TEST(mount_xdr, mount_result) {
+  mount::mount_result_t result;
+  result.status = mount::OK;
+  result.filehandle = binary_t(40, 7);
+  result.auth_flavors = binary_t(3, 1);
+  expect_round_trip(result);
+
+  mount::mount_result_t failed;
+  failed.filehandle = binary_t(40, 7);
+  EXPECT_EQ(4u, xdr::to_binary(failed).size());
+}
+
+TEST(mount_xdr, directory_path) {
+  mount::directory_path_t path = "/c/export";
+  binary_builder_t builder;
+  xdr::directory_path_codec_t::encode(builder, path);
+  mount::directory_path_t decoded;
+  ASSERT_TRUE(xdr::decode_with<xdr::directory_path_codec_t>(binary_reader_t::binary(builder.build()), decoded));
+  EXPECT_EQ(path, decoded);
+
+  binary_builder_t too_long;
+  too_long.append32(mount::DIRECTORY_PATH_LEN + 1);
+  too_long.append_binary(binary_t(mount::DIRECTORY_PATH_LEN + 4, 'a'));
+  EXPECT_FALSE(xdr::decode_with<xdr::directory_path_codec_t>(binary_reader_t::binary(too_long.build()), decoded));
+}
@@ -0,0 +1,80 @@
+#include "posixfs/posix_file.h"
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <mutex>
+
+namespace {
+  const size_t block_size = 64 * 1024; // a typical NFS read
+  const size_t file_size = 64 << 20; // stays in the page cache
+
+  // one file shared by all benchmark threads like a cached handle
+  struct shared_file_t {
+    shared_file_t() {
+      char name[] = "/tmp/posix_file_benchXXXXXX";
+      fd = ::mkstemp(name);
+      ::unlink(name);
+      posixfs::file_t file(fd);
+      binary_t block(block_size, 0x5A);
+      for (size_t offset = 0; offset < file_size; offset += block_size) file.write_at(offset, block);
+    }
+    ~shared_file_t() { ::close(fd); }
+
+    int fd;
+    std::mutex mutex; // for the file offset
+  };
+
+  shared_file_t& shared_file() {
+    static shared_file_t file;
+    return file;
+  }
+
+  uint64_t block_offset(uint64_t& state) {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return ((state >> 33) % (file_size / block_size)) * block_size;
+  }
+} // namespace
+
+// the previous READ path: the file offset is shared, so seek and read need a lock
+void seek_and_read_shared_file(benchmark::State& state) {
+  auto& file = shared_file();
+  binary_t data(block_size);
+  uint64_t random = reinterpret_cast<uintptr_t>(&data); // differs per thread
+  for (auto _ : state) {
+      std::lock_guard<std::mutex> lock(file.mutex);
+      ::lseek(file.fd, static_cast<off_t>(block_offset(random)), SEEK_SET);
+      benchmark::DoNotOptimize(::read(file.fd, data.data(), data.size()));
+    }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * block_size));
+}
+BENCHMARK(seek_and_read_shared_file)->ThreadRange(1, 8)->UseRealTime();
+
+// positional reads proceed in parallel
+void read_at_shared_file(benchmark::State& state) {
+  posixfs::file_t file(shared_file().fd);
+  binary_t data(block_size);
+  uint64_t random = reinterpret_cast<uintptr_t>(&data); // differs per thread
+  for (auto _ : state) {
+      data.resize(block_size);
+      benchmark::DoNotOptimize(file.read_at(block_offset(random), data));
+    }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * block_size));
+}
+BENCHMARK(read_at_shared_file)->ThreadRange(1, 8)->UseRealTime();
+
+// scattered into the fragments of a reply
+void vectored_read_at_shared_file(benchmark::State& state) {
+  posixfs::file_t file(shared_file().fd);
+  std::vector<binary_t> data(16);
+  uint64_t random = reinterpret_cast<uintptr_t>(&data); // differs per thread
+  for (auto _ : state) {
+      for (auto& binary : data) binary.resize(block_size / 16);
+      benchmark::DoNotOptimize(file.read_at(block_offset(random), data));
+    }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * block_size));
+}
+BENCHMARK(vectored_read_at_shared_file)->ThreadRange(1, 8)->UseRealTime();
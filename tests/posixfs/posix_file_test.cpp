@@ -0,0 +1,101 @@
+#include "posixfs/posix_file.h"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+  struct posix_file_test : ::testing::Test {
+    void SetUp() override {
+      char name[] = "/tmp/posix_file_testXXXXXX";
+      fd = ::mkstemp(name);
+      ASSERT_LE(0, fd);
+      ::unlink(name);
+    }
+    void TearDown() override {
+      ::close(fd);
+    }
+
+    binary_t pattern(size_t size, uint8_t seed) {
+      binary_t result(size);
+      for (size_t i = 0; i < size; ++i) result[i] = static_cast<uint8_t>(seed + i);
+      return result;
+    }
+
+    int fd = -1;
+  };
+} // namespace
+
+TEST_F(posix_file_test, write_and_read_at_offsets) {
+  posixfs::file_t file(fd);
+  ASSERT_TRUE(file.write_at(100, pattern(50, 1)));
+  auto front = pattern(100, 7);
+  ASSERT_TRUE(file.write_at(0, front));
+
+  binary_t data(50);
+  ASSERT_TRUE(file.read_at(100, data));
+  EXPECT_EQ(pattern(50, 1), data);
+  ASSERT_TRUE(file.read_at(0, data));
+  EXPECT_EQ(binary_t(front.begin(), front.begin() + 50), data);
+  EXPECT_EQ(0, ::lseek(fd, 0, SEEK_CUR)); // file offset is not used
+}
+
+TEST_F(posix_file_test, read_is_shortened_at_end_of_file) {
+  posixfs::file_t file(fd);
+  ASSERT_TRUE(file.write_at(0, pattern(10, 0)));
+
+  binary_t data(64);
+  ASSERT_TRUE(file.read_at(4, data));
+  EXPECT_EQ(6u, data.size());
+  data.resize(64);
+  ASSERT_TRUE(file.read_at(10, data));
+  EXPECT_TRUE(data.empty());
+}
+
+TEST_F(posix_file_test, vectored_write_and_read) {
+  posixfs::file_t file(fd);
+  auto first = pattern(30, 1);
+  auto second = pattern(20, 9);
+  segmented_binary_t segmented;
+  segmented.append(binary_t(first));
+  segmented.append_borrowed(second.data(), second.size());
+  ASSERT_TRUE(file.write_at(5, segmented));
+
+  std::vector<binary_t> binaries { binary_t(5), binary_t(40), binary_t(20), binary_t(8) };
+  ASSERT_TRUE(file.read_at(0, binaries));
+  EXPECT_EQ(5u, binaries[0].size());
+  EXPECT_EQ(40u, binaries[1].size());
+  EXPECT_EQ(first, binary_t(binaries[1].begin(), binaries[1].begin() + 30));
+  EXPECT_EQ(10u, binaries[2].size()); // end of file
+  EXPECT_TRUE(binaries[3].empty());
+
+  binary_t all;
+  for (auto& binary : binaries) all.insert(all.end(), binary.begin(), binary.end());
+  EXPECT_EQ(second, binary_t(all.begin() + 35, all.end()));
+}
+
+TEST_F(posix_file_test, concurrent_reads_of_one_descriptor) {
+  posixfs::file_t file(fd);
+  const size_t block = 4096;
+  const size_t blocks = 64;
+  for (size_t i = 0; i < blocks; ++i) ASSERT_TRUE(file.write_at(i * block, pattern(block, i)));
+
+  std::vector<std::thread> threads;
+  for (auto thread = 0; thread < 8; ++thread) {
+      threads.emplace_back([&, thread] {
+          binary_t data(block);
+          for (size_t i = 0; i < 1000; ++i) {
+              auto index = (i * 7 + thread) % blocks;
+              data.resize(block);
+              ASSERT_TRUE(file.read_at(index * block, data));
+              ASSERT_EQ(pattern(block, index), data);
+            }
+        });
+    }
+  for (auto& thread : threads) thread.join();
+}
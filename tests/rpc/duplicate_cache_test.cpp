@@ -0,0 +1,171 @@
+#include "rpc/duplicate_cache.h"
+#include "rpc/rpc_router.h"
+#include "rpc/rpc.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+  enum : uint32_t { PROGRAM = 400000, VERSION = 3, CREATE = 1, GET = 2, BLOCKING = 3 };
+
+  struct duplicate_cache_test : ::testing::Test {
+    using args_t = rpc_program_t::procedure_args_t;
+    using result_t = rpc_program_t::procedure_result_t;
+
+    void SetUp() override {
+      rpc_program_t program;
+      program.id = PROGRAM;
+      program.version = VERSION;
+      // replies with the number of executions - retransmissions must not change it
+      auto count = [this](const args_t&)->result_t {
+          binary_builder_t builder;
+          builder.append32(++executions);
+          return result_t::respond(builder.build());
+        };
+      program.procedures.set(CREATE, { "CREATE", count, rpc_program_t::CACHE_REPLY });
+      program.procedures.set(GET, { "GET", count, rpc_program_t::NO_REPLY_CACHE });
+      program.procedures.set(BLOCKING, { "BLOCKING", [this](const args_t&)->result_t {
+          std::unique_lock<std::mutex> lock(mutex);
+          ++executions;
+          running = true;
+          changed.notify_all();
+          changed.wait(lock, [this] { return released; });
+          return result_t::respond({});
+        }, rpc_program_t::CACHE_REPLY });
+      router.add(program);
+    }
+
+    binary_t call(uint32_t xid, uint32_t procedure, const std::string& sender = "10.0.0.1:900", uint32_t argument = 0) {
+      binary_builder_t builder;
+      builder.append32(argument);
+      auto request = rpc::message_builder().call(xid).null_auth(PROGRAM, VERSION, procedure, builder.build());
+      return router.handle({ sender, binary_reader_t::binary(request) }).flatten();
+    }
+
+    rpc_router_t router;
+    std::atomic<uint32_t> executions {0};
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool running = false;
+    bool released = false;
+  };
+
+  duplicate_cache_t::key_t key(uint32_t xid) {
+    binary_t arguments(4, 0);
+    return duplicate_cache_t::key("10.0.0.1:900", xid, PROGRAM, VERSION, CREATE, binary_reader_t::binary(arguments));
+  }
+} // namespace
+
+TEST_F(duplicate_cache_test, answers_retransmissions_with_the_stored_reply) {
+  auto reply = call(1, CREATE);
+  auto retransmitted = call(1, CREATE);
+  EXPECT_EQ(1u, executions);
+  EXPECT_EQ(reply, retransmitted);
+
+  auto stats = router.duplicate_stats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.size);
+}
+
+TEST_F(duplicate_cache_test, executes_different_calls) {
+  call(1, CREATE);
+  call(2, CREATE); // next xid
+  call(1, CREATE, "10.0.0.2:900"); // other client
+  call(1, CREATE, "10.0.0.1:900", 7); // other arguments
+  EXPECT_EQ(4u, executions);
+
+  call(1, CREATE, "10.0.0.1:901"); // reconnected from another port
+  EXPECT_EQ(4u, executions);
+  EXPECT_EQ(1u, router.duplicate_stats().hits);
+}
+
+TEST_F(duplicate_cache_test, executes_idempotent_calls_again) {
+  call(1, GET);
+  call(1, GET);
+  EXPECT_EQ(2u, executions);
+  EXPECT_EQ(0u, router.duplicate_stats().misses);
+}
+
+TEST_F(duplicate_cache_test, drops_retransmissions_in_progress) {
+  std::thread original([this] { call(1, BLOCKING); });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return running; });
+  }
+  EXPECT_TRUE(call(1, BLOCKING).empty());
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    released = true;
+  }
+  changed.notify_all();
+  original.join();
+
+  EXPECT_FALSE(call(1, BLOCKING).empty());
+  EXPECT_EQ(1u, executions);
+  auto stats = router.duplicate_stats();
+  EXPECT_EQ(1u, stats.in_progress);
+  EXPECT_EQ(1u, stats.hits);
+}
+
+TEST(duplicate_cache, evicts_least_recently_used_replies) {
+  duplicate_cache_t::config_t config;
+  config.shards = 1;
+  config.budget = 3 * (duplicate_cache_t::ENTRY_OVERHEAD + 100);
+  duplicate_cache_t cache(config);
+
+  binary_t reply;
+  for (uint32_t xid = 1; xid <= 3; ++xid) {
+      ASSERT_EQ(duplicate_cache_t::NEW, cache.begin(key(xid), reply));
+      cache.complete(key(xid), binary_t(64, static_cast<uint8_t>(xid)));
+    }
+  ASSERT_EQ(duplicate_cache_t::COMPLETED, cache.begin(key(1), reply)); // 1 is used again
+  EXPECT_EQ(binary_t(64, 1), reply);
+
+  ASSERT_EQ(duplicate_cache_t::NEW, cache.begin(key(4), reply));
+  cache.complete(key(4), binary_t(64, 4));
+  auto stats = cache.stats();
+  EXPECT_EQ(1u, stats.evictions);
+  EXPECT_GE(config.budget, stats.bytes);
+
+  EXPECT_EQ(duplicate_cache_t::COMPLETED, cache.begin(key(1), reply));
+  EXPECT_EQ(duplicate_cache_t::NEW, cache.begin(key(2), reply)); // evicted
+}
+
+TEST(duplicate_cache, checksums_the_arguments) {
+  binary_t arguments(1000, 0);
+  auto original = duplicate_cache_t::key("host:1", 1, PROGRAM, VERSION, CREATE, binary_reader_t::binary(arguments));
+  arguments[0] = 1;
+  auto changed = duplicate_cache_t::key("host:2", 1, PROGRAM, VERSION, CREATE, binary_reader_t::binary(arguments));
+  EXPECT_EQ("host", changed.client);
+  EXPECT_FALSE(original == changed);
+
+  arguments[0] = 0;
+  arguments.push_back(0); // only the size differs
+  EXPECT_FALSE(original == duplicate_cache_t::key("host:1", 1, PROGRAM, VERSION, CREATE, binary_reader_t::binary(arguments)));
+}
+
+TEST(duplicate_cache, budget_of_zero_disables_the_router_cache) {
+  duplicate_cache_t::config_t config;
+  config.budget = 0;
+  rpc_router_t router(config);
+  rpc_program_t program;
+  program.id = PROGRAM;
+  program.version = VERSION;
+  uint32_t executions = 0;
+  program.procedures.set(CREATE, { "CREATE", [&](const rpc_program_t::procedure_args_t&) {
+      ++executions;
+      return rpc_program_t::procedure_result_t::respond({});
+    }, rpc_program_t::CACHE_REPLY });
+  router.add(program);
+
+  auto request = rpc::message_builder().call(1).null_auth(PROGRAM, VERSION, CREATE, {});
+  router.handle({ "host:1", binary_reader_t::binary(request) });
+  router.handle({ "host:1", binary_reader_t::binary(request) });
+  EXPECT_EQ(2u, executions);
+}
@@ -0,0 +1,80 @@
+#include "rpc/record_marking.h"
+#include "binary/binary_builder.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <algorithm>
+
+/*
+ * Throughput of tcp record reassembly for a client pipelining many WRITE sized records.
+ * The stream is fed in receive sized chunks, so every chunk holds several records.
+ */
+namespace {
+  enum {
+    RECORD_COUNT = 256,
+    RECEIVE_SIZE = 0x10000,
+  };
+
+  binary_t make_stream(size_t record_size) {
+    binary_builder_t builder;
+    binary_t record(record_size, 0x55);
+    for (auto i = 0; i < RECORD_COUNT; ++i) {
+        builder.append32(record_marking::single_fragment_header(record_size));
+        builder.append_binary(record);
+      }
+    return builder.build();
+  }
+
+  // the previous approach: grow by the received bytes and erase every record at the front
+  size_t legacy_reassemble(binary_t& buffer, const binary_t& stream) {
+    size_t bytes = 0;
+    for (size_t offset = 0; offset < stream.size(); offset += RECEIVE_SIZE) {
+        auto size = std::min<size_t>(RECEIVE_SIZE, stream.size() - offset);
+        buffer.insert(buffer.end(), stream.begin() + offset, stream.begin() + offset + size);
+        while (buffer.size() >= 4) {
+            auto record_size = binary_reader_t::binary(buffer).get32(0) & record_marking::FRAGMENT_SIZE_MASK;
+            if (buffer.size() < 4 + record_size) break;
+            bytes += record_size;
+            buffer.erase(buffer.begin(), buffer.begin() + 4 + record_size);
+          }
+      }
+    return bytes;
+  }
+
+  size_t reassemble(record_marking::reassembler_t& reassembler, const binary_t& stream) {
+    size_t bytes = 0;
+    for (size_t offset = 0; offset < stream.size(); offset += RECEIVE_SIZE) {
+        auto size = std::min<size_t>(RECEIVE_SIZE, stream.size() - offset);
+        std::memcpy(reassembler.prepare(size), &stream[offset], size);
+        reassembler.commit(size);
+        binary_reader_t record;
+        while (record_marking::reassembler_t::RECORD == reassembler.next(record)) {
+            bytes += record.size();
+          }
+      }
+    return bytes;
+  }
+} // namespace
+
+static void BM_legacy_erase(benchmark::State& state) {
+  auto stream = make_stream(state.range(0));
+  binary_t buffer;
+  while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(legacy_reassemble(buffer, stream));
+    }
+  state.SetBytesProcessed(state.iterations() * stream.size());
+  state.SetItemsProcessed(state.iterations() * RECORD_COUNT);
+}
+BENCHMARK(BM_legacy_erase)->Arg(128)->Arg(4096)->Arg(32768);
+
+static void BM_reassembler(benchmark::State& state) {
+  auto stream = make_stream(state.range(0));
+  record_marking::reassembler_t reassembler;
+  while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(reassemble(reassembler, stream));
+    }
+  state.SetBytesProcessed(state.iterations() * stream.size());
+  state.SetItemsProcessed(state.iterations() * RECORD_COUNT);
+}
+BENCHMARK(BM_reassembler)->Arg(128)->Arg(4096)->Arg(32768);
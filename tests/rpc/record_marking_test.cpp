@@ -0,0 +1,128 @@
+#include "rpc/record_marking.h"
+#include "binary/binary_builder.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+  using records_t = std::vector<binary_t>;
+
+  binary_t make_record(size_t size, uint8_t seed) {
+    binary_t result(size);
+    for (auto i = 0u; i < size; ++i) result[i] = static_cast<uint8_t>(seed + i);
+    return result;
+  }
+
+  // encodes the record as fragments of at most fragment_size bytes
+  void append_record(binary_builder_t& builder, const binary_t& record, size_t fragment_size) {
+    size_t offset = 0;
+    do {
+      auto size = std::min(fragment_size, record.size() - offset);
+      auto last = offset + size == record.size();
+      builder.append32((last ? record_marking::LAST_FRAGMENT : 0u) | static_cast<uint32_t>(size));
+      builder.append_binary(record.data() + offset, size);
+      offset += size;
+    } while (offset < record.size());
+  }
+
+  binary_t make_stream(const records_t& records, size_t fragment_size) {
+    binary_builder_t builder;
+    for (const auto& record : records) append_record(builder, record, fragment_size);
+    return builder.build();
+  }
+
+  // feeds the stream in chunks of chunk_size bytes and collects all records
+  bool reassemble(record_marking::reassembler_t& reassembler, const binary_t& stream, size_t chunk_size, records_t& records) {
+    for (size_t offset = 0; offset < stream.size(); offset += chunk_size) {
+        auto size = std::min(chunk_size, stream.size() - offset);
+        std::memcpy(reassembler.prepare(size), &stream[offset], size);
+        reassembler.commit(size);
+        binary_reader_t record;
+        while (true) {
+            auto status = reassembler.next(record);
+            if (status == record_marking::reassembler_t::INVALID) return false;
+            if (status == record_marking::reassembler_t::NEED_MORE) break;
+            records.push_back(record.get_binary(0, record.size()));
+          }
+      }
+    return true;
+  }
+
+  records_t sample_records() {
+    return { make_record(40, 1), make_record(0, 2), make_record(1000, 3), make_record(7, 4), make_record(4096, 5) };
+  }
+} // namespace
+
+TEST(record_marking, single_fragments_in_one_chunk) {
+  auto records = sample_records();
+  auto stream = make_stream(records, 0x7FFFFFFF);
+  record_marking::reassembler_t reassembler;
+  records_t result;
+  ASSERT_TRUE(reassemble(reassembler, stream, stream.size(), result));
+  EXPECT_EQ(records, result);
+  EXPECT_EQ(0u, reassembler.buffered());
+}
+
+TEST(record_marking, arbitrary_chunk_boundaries) {
+  auto records = sample_records();
+  for (size_t fragment_size : { 1u, 3u, 64u, 1000u, 0x7FFFFFFFu }) {
+      auto stream = make_stream(records, fragment_size);
+      for (size_t chunk_size : { 1u, 2u, 3u, 5u, 17u, 1500u, 4099u }) {
+          record_marking::reassembler_t reassembler;
+          records_t result;
+          ASSERT_TRUE(reassemble(reassembler, stream, chunk_size, result));
+          EXPECT_EQ(records, result) << "fragment " << fragment_size << " chunk " << chunk_size;
+          EXPECT_EQ(0u, reassembler.buffered());
+        }
+    }
+}
+
+TEST(record_marking, partial_record_is_kept) {
+  auto stream = make_stream({ make_record(100, 1) }, 30);
+  record_marking::reassembler_t reassembler;
+  std::memcpy(reassembler.prepare(stream.size() - 1), &stream[0], stream.size() - 1);
+  reassembler.commit(stream.size() - 1);
+  binary_reader_t record;
+  EXPECT_EQ(record_marking::reassembler_t::NEED_MORE, reassembler.next(record));
+
+  std::memcpy(reassembler.prepare(1), &stream.back(), 1);
+  reassembler.commit(1);
+  ASSERT_EQ(record_marking::reassembler_t::RECORD, reassembler.next(record));
+  EXPECT_EQ(make_record(100, 1), record.get_binary(0, record.size()));
+}
+
+TEST(record_marking, buffer_is_reused) {
+  auto stream = make_stream({ make_record(1000, 1) }, 0x7FFFFFFF);
+  record_marking::reassembler_t reassembler;
+  records_t result;
+  for (auto i = 0; i < 1000; ++i) {
+      ASSERT_TRUE(reassemble(reassembler, stream, 333, result));
+    }
+  EXPECT_EQ(1000u, result.size());
+  EXPECT_GE(2 * stream.size(), reassembler.capacity());
+}
+
+TEST(record_marking, oversized_record_is_invalid) {
+  record_marking::reassembler_t reassembler(100);
+  records_t result;
+  EXPECT_TRUE(reassemble(reassembler, make_stream({ make_record(100, 1) }, 0x7FFFFFFF), 7, result));
+  EXPECT_FALSE(reassemble(reassembler, make_stream({ make_record(101, 1) }, 0x7FFFFFFF), 7, result));
+}
+
+TEST(record_marking, oversized_fragments_are_invalid) {
+  record_marking::reassembler_t reassembler(100);
+  records_t result;
+  EXPECT_FALSE(reassemble(reassembler, make_stream({ make_record(101, 1) }, 20), 7, result));
+}
+
+TEST(record_marking, large_records_in_many_fragments) {
+  auto records = records_t{ make_record(0x100000, 1), make_record(40, 2), make_record(0x100000, 3) };
+  auto stream = make_stream(records, 0x10000);
+  record_marking::reassembler_t reassembler(0x100000 + 0x1000);
+  records_t result;
+  ASSERT_TRUE(reassemble(reassembler, stream, 0x10000, result));
+  EXPECT_EQ(records, result);
+}
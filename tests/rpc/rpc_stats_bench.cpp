@@ -0,0 +1,53 @@
+#include "rpc/rpc_stats.h"
+
+#include <benchmark/benchmark.h>
+
+/*
+ * Cost of recording one call in the always-on router statistics.
+ * Threads record into their own shards, so the time per call should not grow with threads.
+ */
+namespace {
+  enum { PROCEDURES = 22 };
+
+  rpc_stats_t& stats() {
+    static rpc_stats_t result;
+    static bool added = [] {
+        for (uint32_t procedure = 0; procedure < PROCEDURES; ++procedure) result.add(100003, 3, procedure, "BENCH");
+        return true;
+      }();
+    (void)added;
+    return result;
+  }
+} // namespace
+
+static void BM_record_call(benchmark::State& state) {
+  auto& recorder = stats();
+  rpc_stats_t::timing_t timing;
+  timing.start = rpc_stats_t::clock_t::now();
+  timing.decoded = timing.start + std::chrono::microseconds(1);
+  timing.executed = timing.start + std::chrono::microseconds(20);
+  timing.end = timing.start + std::chrono::microseconds(22);
+  size_t slot = 0;
+  while (state.KeepRunning()) {
+      recorder.begin(slot);
+      recorder.end(slot, timing, 128, 256, true);
+      slot = (slot + 1) % PROCEDURES;
+    }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_record_call)->ThreadRange(1, 4);
+
+static void BM_timed_call(benchmark::State& state) {
+  auto& recorder = stats();
+  while (state.KeepRunning()) {
+      rpc_stats_t::timing_t timing;
+      timing.start = rpc_stats_t::clock_t::now();
+      timing.decoded = rpc_stats_t::clock_t::now();
+      timing.executed = rpc_stats_t::clock_t::now();
+      recorder.begin(1);
+      timing.end = rpc_stats_t::clock_t::now();
+      recorder.end(1, timing, 128, 256, true);
+    }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_timed_call);
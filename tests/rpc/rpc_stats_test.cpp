@@ -0,0 +1,145 @@
+#include "rpc/rpc_router.h"
+#include "rpc/rpc.h"
+#include "logging/logger.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+  enum : uint32_t { PROGRAM = 400000, VERSION = 2 };
+
+  struct rpc_stats_test : ::testing::Test {
+    using args_t = rpc_program_t::procedure_args_t;
+    using result_t = rpc_program_t::procedure_result_t;
+
+    void SetUp() override {
+      rpc_program_t program;
+      program.id = PROGRAM;
+      program.version = VERSION;
+      // echoes 4 bytes after sleeping for the given milliseconds
+      program.procedures.set(1, { "SLEEP", [](const args_t& args)->result_t {
+          if ( !args.parameter_reader.has_size(4)) return {};
+          auto milliseconds = args.parameter_reader.get32(0);
+          args.decoded();
+          std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+          args.executed();
+          return result_t::respond(args.parameter_reader.get_binary(0, 4));
+        }, rpc_program_t::NO_REPLY_CACHE });
+      program.procedures.set(3, { "UNMARKED", [](const args_t&)->result_t {
+          return result_t::respond({});
+        }, rpc_program_t::NO_REPLY_CACHE });
+      router.add(program);
+    }
+
+    segmented_binary_t call(uint32_t procedure, uint32_t milliseconds, uint32_t program = PROGRAM) {
+      binary_builder_t builder;
+      builder.append32(milliseconds);
+      auto request = rpc::message_builder().call(++xid).null_auth(program, VERSION, procedure, builder.build());
+      return router.handle({ "test", binary_reader_t::binary(request) });
+    }
+
+    segmented_binary_t call_garbage() {
+      auto request = rpc::message_builder().call(++xid).null_auth(PROGRAM, VERSION, 1, {});
+      return router.handle({ "test", binary_reader_t::binary(request) });
+    }
+
+    const rpc_stats_t::procedure_stats_t* find(const rpc_stats_t::snapshot_t& snapshot, uint32_t procedure) {
+      for (const auto& stats : snapshot.procedures) {
+          if (stats.procedure == procedure) return &stats;
+        }
+      return nullptr;
+    }
+
+    rpc_router_t router;
+    uint32_t xid = 0;
+  };
+} // namespace
+
+TEST_F(rpc_stats_test, counts_calls_and_bytes) {
+  EXPECT_TRUE(router.stats().procedures.empty());
+
+  auto reply = call(1, 0);
+  call(1, 0);
+  auto snapshot = router.stats();
+  ASSERT_EQ(1u, snapshot.procedures.size());
+  auto& stats = snapshot.procedures[0];
+  EXPECT_EQ(uint32_t(PROGRAM), stats.program);
+  EXPECT_EQ(uint32_t(VERSION), stats.version);
+  EXPECT_EQ(1u, stats.procedure);
+  EXPECT_STREQ("SLEEP", stats.name);
+  EXPECT_EQ(2u, stats.calls);
+  EXPECT_EQ(0u, stats.errors);
+  EXPECT_EQ(0, stats.in_flight);
+  EXPECT_EQ(2 * reply.size(), stats.bytes_out);
+  EXPECT_EQ(2u, stats.total.count());
+  EXPECT_EQ(2u, stats.encode.count());
+}
+
+TEST_F(rpc_stats_test, splits_the_phases) {
+  call(1, 20);
+  auto snapshot = router.stats();
+  auto stats = find(snapshot, 1);
+  ASSERT_TRUE(stats);
+  EXPECT_LE(std::chrono::milliseconds(20), stats->execute.max());
+  EXPECT_GT(std::chrono::milliseconds(20), stats->decode.max());
+  EXPECT_GT(std::chrono::milliseconds(20), stats->encode.max());
+  EXPECT_LE(stats->execute.max(), stats->total.max());
+}
+
+TEST_F(rpc_stats_test, counts_errors_and_rejects) {
+  logging::scoped_level_t quiet(logging::level_t::OFF); // the router logs errors - that is not tested
+  call_garbage();
+  call(2, 0); // a gap in the procedures
+  call(1, 0, PROGRAM + 1);
+
+  auto snapshot = router.stats();
+  auto stats = find(snapshot, 1);
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(1u, stats->calls);
+  EXPECT_EQ(1u, stats->errors);
+  EXPECT_EQ(2u, snapshot.rejected);
+}
+
+TEST_F(rpc_stats_test, unmarked_phases_count_as_execute) {
+  call(3, 0);
+  auto snapshot = router.stats();
+  auto stats = find(snapshot, 3);
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(1u, stats->execute.count());
+  EXPECT_EQ(1u, stats->decode.count());
+}
+
+TEST_F(rpc_stats_test, adds_up_the_threads) {
+  enum { THREADS = 4, CALLS = 1000 };
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < THREADS; ++i) {
+      threads.emplace_back([this] {
+          uint32_t id = 0;
+          for (auto call = 0; call < CALLS; ++call) {
+              auto request = rpc::message_builder().call(++id).null_auth(PROGRAM, VERSION, 3, {});
+              router.handle({ "thread", binary_reader_t::binary(request) });
+            }
+        });
+    }
+  for (auto& thread : threads) thread.join();
+
+  auto snapshot = router.stats();
+  auto stats = find(snapshot, 3);
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(uint64_t(THREADS * CALLS), stats->calls);
+  EXPECT_EQ(uint64_t(THREADS * CALLS), stats->total.count());
+}
+
+TEST_F(rpc_stats_test, writes_a_line_per_procedure) {
+  call(1, 0);
+  call(3, 0);
+  std::ostringstream out;
+  rpc_stats_t::write(out, router.stats());
+  auto text = out.str();
+  EXPECT_NE(std::string::npos, text.find("SLEEP calls: 1"));
+  EXPECT_NE(std::string::npos, text.find("UNMARKED calls: 1"));
+  EXPECT_NE(std::string::npos, text.find("rejected calls: 0"));
+}
@@ -0,0 +1,85 @@
+#include "server/connection_table.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+  using clock_source_t = std::chrono::steady_clock;
+
+  struct fake_connection_t {
+    fake_connection_t(const std::string& host, int port)
+      : sender_m(host + ":" + std::to_string(port))
+      , host_m(host)
+    {}
+
+    const std::string& sender() const { return sender_m; }
+    const std::string& host() const { return host_m; }
+    bool idle_since(clock_source_t::time_point time) const { return active <= time; }
+    size_t memory() const { return bytes; }
+    void shutdown() { closed = true; }
+
+    clock_source_t::time_point active = clock_source_t::now();
+    size_t bytes = 100;
+    bool closed = false;
+
+  private:
+    std::string sender_m;
+    std::string host_m;
+  };
+  using connection_ptr_t = std::shared_ptr<fake_connection_t>;
+  using table_t = connection_table_t<fake_connection_t>;
+} // namespace
+
+TEST(connection_table, keeps_connections_of_one_host_apart) {
+  table_t table;
+  std::vector<connection_ptr_t> connections;
+  for (auto port = 900; port < 908; ++port) {
+      connections.push_back(std::make_shared<fake_connection_t>("10.0.0.1", port));
+      EXPECT_FALSE(table.insert(connections.back()));
+    }
+  connections.push_back(std::make_shared<fake_connection_t>("10.0.0.2", 900));
+  table.insert(connections.back());
+
+  auto stats = table.stats();
+  EXPECT_EQ(9u, stats.connections);
+  EXPECT_EQ(2u, stats.hosts);
+  EXPECT_EQ(8u, stats.max_per_host);
+  EXPECT_EQ(900u, stats.memory);
+  EXPECT_EQ(100u, stats.max_memory);
+
+  for (auto& connection : connections) table.remove(connection.get());
+  stats = table.stats();
+  EXPECT_EQ(0u, stats.connections);
+  EXPECT_EQ(0u, stats.hosts);
+  EXPECT_EQ(9u, stats.accepted);
+}
+
+TEST(connection_table, replaces_a_reconnected_sender) {
+  table_t table;
+  auto stale = std::make_shared<fake_connection_t>("10.0.0.1", 900);
+  auto reconnected = std::make_shared<fake_connection_t>("10.0.0.1", 900);
+  table.insert(stale);
+  EXPECT_EQ(stale, table.insert(reconnected));
+
+  // the stale connection closes later - the new one stays
+  table.remove(stale.get());
+  EXPECT_EQ(1u, table.size());
+  EXPECT_EQ(1u, table.stats().replaced);
+  auto newer = std::make_shared<fake_connection_t>("10.0.0.1", 900);
+  EXPECT_EQ(reconnected, table.insert(newer));
+}
+
+TEST(connection_table, shuts_down_idle_connections) {
+  table_t table;
+  auto now = clock_source_t::now();
+  auto idle = std::make_shared<fake_connection_t>("10.0.0.1", 900);
+  auto active = std::make_shared<fake_connection_t>("10.0.0.1", 901);
+  idle->active = now - std::chrono::seconds(10);
+  active->active = now;
+  table.insert(idle);
+  table.insert(active);
+
+  EXPECT_EQ(1u, table.reap(now, std::chrono::seconds(5)));
+  EXPECT_TRUE(idle->closed);
+  EXPECT_FALSE(active->closed);
+  EXPECT_EQ(1u, table.stats().reaped);
+}
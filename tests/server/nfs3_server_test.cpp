@@ -0,0 +1,114 @@
+#include "server/nfs3_server.h"
+#include "server/worker_pool.h"
+#include "fs/memory_backend.h"
+#include "network/udp.h"
+#include "nfs/mount.h"
+#include "nfs/nfs3_xdr.h"
+#include "rpc/rpc.h"
+#include "binary/binary_reader.h"
+#include "logging/logger.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace {
+  using namespace nfs3;
+
+  enum : uint32_t {
+    PORT = 20213,
+    READ = 6,
+    FSINFO = 19,
+    FILE_SIZE = 0x40000,
+    REPLY_HEADER_SIZE = 24, // xid, type, accepted, null verifier, success
+    READ_COUNT_OFFSET = 4 + 4 + 84, // status and file attributes before the count
+  };
+
+  // serves a file larger than a datagram from memory over loopback
+  struct nfs3_server_test : ::testing::Test {
+    void SetUp() override {
+      logging::scoped_level_t quiet(logging::level_t::OFF);
+      mount_program.reset(new mount::rpc_program(backend));
+      backend.make_directories(L"/export");
+      auto& aliases = mount_program->aliases();
+      aliases.add(aliases.create_source(), L"/export", "/export");
+      root = mount_program->mount("client", "/export").filehandle;
+
+      rpc_program writer(mount_program->cache(), rpc_program::config_t());
+      create_args_t create;
+      create.where = { root, "file" };
+      create.how = create_how_t::UNCHECKED;
+      create.obj_attributes.set(set_attr_t());
+      auto created = writer.create(create);
+      ASSERT_TRUE(created.object.is<filehandle_t>());
+      file = created.object.get<filehandle_t>();
+      write_args_t write;
+      write.filehandle = file;
+      write.offset = 0;
+      write.count = FILE_SIZE;
+      write.stable = stable_how_t::FILE_SYNC;
+      write.data = binary_t(FILE_SIZE, 0x55);
+      ASSERT_EQ(status_t::OK, writer.write(std::move(write)).status);
+
+      worker_pool_t::config_t config;
+      config.threads = 2;
+      workers.reset(new worker_pool_t(config));
+      workers->start();
+      server.reset(new nfs3_server_t(mount_program->cache(), rpc_program::config_t(), PORT, workers.get()));
+      server->start();
+
+      client = udp_socket_t::create();
+      ASSERT_TRUE(client.valid() && socket_set_receive_timeout(client.handle(), 10000));
+    }
+
+    void TearDown() override {
+      server.reset();
+      workers.reset();
+    }
+
+    // the result behind the rpc header - empty if no reply arrived
+    binary_t call(uint32_t procedure, const binary_t& parameters) {
+      auto datagram = rpc::message_builder().call(++xid).null_auth(PROGRAM, VERSION, procedure, parameters);
+      if (int(datagram.size()) != client.send_to(datagram, inet_addr_t::loopback(PORT))) return {};
+      binary_t reply;
+      reply.reserve(udp_batch_t::MAX_DATAGRAM);
+      inet_addr_t sender;
+      if (int(REPLY_HEADER_SIZE) >= client.receive_from(reply, sender)) return {};
+      return binary_t(reply.begin() + REPLY_HEADER_SIZE, reply.end());
+    }
+
+    fs::memory_backend_t backend;
+    std::unique_ptr<mount::rpc_program> mount_program;
+    std::unique_ptr<worker_pool_t> workers;
+    std::unique_ptr<nfs3_server_t> server;
+    udp_socket_t client;
+    filehandle_t root;
+    filehandle_t file;
+    uint32_t xid = 0;
+  };
+} // namespace
+
+// a datagram holds no more than 64 KB - larger replies could never be sent
+TEST_F(nfs3_server_test, udp_read_above_a_datagram_is_shortened) {
+  read_args_t args;
+  args.filehandle = file;
+  args.offset = 0;
+  args.count = FILE_SIZE;
+  auto result = call(READ, xdr::to_binary(args));
+  ASSERT_LT(size_t(READ_COUNT_OFFSET + 4), result.size());
+  auto reader = binary_reader_t::binary(result);
+  EXPECT_EQ(uint32_t(status_t::OK), reader.get32(0));
+  auto count = reader.get32(READ_COUNT_OFFSET);
+  EXPECT_LE(uint32_t(MIN_TRANSFER_SIZE), count);
+  EXPECT_GT(uint32_t(udp_batch_t::MAX_REPLY), count);
+  EXPECT_EQ(0u, count % MIN_TRANSFER_SIZE);
+}
+
+TEST_F(nfs3_server_test, udp_fs_info_offers_transfers_that_fit_a_datagram) {
+  fs_info_result_t result;
+  ASSERT_TRUE(xdr::decode(binary_reader_t::binary(call(FSINFO, xdr::to_binary_with<xdr::filehandle_codec_t>(root))), result));
+  ASSERT_EQ(status_t::OK, result.status);
+  EXPECT_GT(uint32_t(udp_batch_t::MAX_REPLY), result.read_max_size);
+  EXPECT_GE(result.read_max_size, result.read_preferred_size);
+  EXPECT_GT(uint32_t(udp_batch_t::MAX_REPLY), result.write_max_size);
+}
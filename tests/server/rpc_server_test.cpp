@@ -0,0 +1,228 @@
+#include "server/rpc_server.h"
+#include "server/worker_pool.h"
+#include "network/tcp.h"
+#include "network/udp.h"
+#include "rpc/rpc.h"
+#include "binary/binary_builder.h"
+#include "binary/binary_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+  enum : uint32_t { PORT = 20211, PROGRAM = 200001, VERSION = 1, SLOW = 1, FAST = 2 };
+
+  struct rpc_server_test : ::testing::Test {
+    void SetUp() override {
+      worker_pool_t::config_t config;
+      config.threads = 2;
+      workers.reset(new worker_pool_t(config));
+      workers->start();
+    }
+
+    void TearDown() override {
+      release();
+      server.reset();
+      workers.reset();
+    }
+
+    void start(std::chrono::milliseconds idle_timeout = std::chrono::milliseconds::zero()) {
+      server.reset(new rpc_server_t(PORT, 2, workers.get()));
+      server->set_idle_timeout(idle_timeout);
+      rpc_program_t program;
+      program.id = PROGRAM;
+      program.version = VERSION;
+      program.procedures.set(SLOW, { "SLOW", [this](rpc_program_t::procedure_args_t&) {
+          std::unique_lock<std::mutex> lock(mutex);
+          changed.wait(lock, [this] { return released; });
+          return rpc_program_t::procedure_result_t::respond({});
+        }, rpc_program_t::NO_REPLY_CACHE });
+      program.procedures.set(FAST, { "FAST", [](rpc_program_t::procedure_args_t&) {
+          return rpc_program_t::procedure_result_t::respond({});
+        }, rpc_program_t::NO_REPLY_CACHE });
+      server->add(program);
+      server->start();
+    }
+
+    void release() {
+      std::lock_guard<std::mutex> lock(mutex);
+      released = true;
+      changed.notify_all();
+    }
+
+    // polls the connection stats until they match or 10 seconds passed
+    template<typename predicate_t>
+    bool wait_for(predicate_t&& predicate) {
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+      while ( !predicate(server->connection_stats())) {
+          if (std::chrono::steady_clock::now() > deadline) return false;
+          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+      return true;
+    }
+
+    std::unique_ptr<worker_pool_t> workers;
+    std::unique_ptr<rpc_server_t> server;
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool released = false;
+  };
+
+  binary_t call_record(uint32_t xid, uint32_t procedure) {
+    auto call = rpc::message_builder().call(xid).null_auth(PROGRAM, VERSION, procedure, {});
+    binary_builder_t builder;
+    builder.append32(0x80000000u | call.size());
+    builder.append_binary(call);
+    return builder.build();
+  }
+
+  udp_socket_t udp_client() {
+    auto client = udp_socket_t::create();
+    if ( !client.valid() || !socket_set_receive_timeout(client.handle(), 10000)) return {};
+    return client;
+  }
+
+  tcp_socket_t connect_client() {
+    auto client = tcp_socket_t::create();
+    if (SOCKET_ERROR == client.connect(inet_addr_t::loopback(PORT))) return {};
+    return client;
+  }
+
+  // xid of the next reply
+  bool receive_xid(const tcp_socket_t& socket, uint32_t& xid) {
+    binary_t buffer;
+    while (true) {
+        if (buffer.size() >= 8) {
+            auto size = binary_reader_t::binary(buffer).get32(0) & 0x7FFFFFFF;
+            if (buffer.size() >= 4 + size) {
+                xid = binary_reader_t::binary(buffer).get32(4);
+                return true;
+              }
+          }
+        if (0 >= socket.receive(buffer)) return false;
+      }
+  }
+} // namespace
+
+TEST_F(rpc_server_test, replies_fast_calls_behind_a_slow_one) {
+  start();
+  auto client = connect_client();
+  ASSERT_TRUE(client.valid());
+  client.send(call_record(1, SLOW));
+  client.send(call_record(2, FAST));
+
+  uint32_t xid = 0;
+  ASSERT_TRUE(receive_xid(client, xid));
+  EXPECT_EQ(2u, xid);
+  release();
+  ASSERT_TRUE(receive_xid(client, xid));
+  EXPECT_EQ(1u, xid);
+}
+
+TEST_F(rpc_server_test, serves_many_connections_of_one_host) {
+  enum { CONNECTIONS = 48 };
+  start();
+  std::vector<tcp_socket_t> clients;
+  for (auto i = 0; i < CONNECTIONS; ++i) {
+      clients.push_back(connect_client());
+      ASSERT_TRUE(clients.back().valid());
+    }
+  // all connections are open at once
+  uint32_t xid = 0;
+  for (auto& client : clients) client.send(call_record(++xid, FAST));
+  for (auto& client : clients) {
+      uint32_t reply = 0;
+      ASSERT_TRUE(receive_xid(client, reply));
+    }
+
+  ASSERT_TRUE(wait_for([](const connection_stats_t& stats) { return CONNECTIONS == stats.connections; }));
+  auto stats = server->connection_stats();
+  EXPECT_EQ(1u, stats.hosts);
+  EXPECT_EQ(size_t(CONNECTIONS), stats.max_per_host);
+  EXPECT_EQ(uint64_t(CONNECTIONS), stats.accepted);
+  EXPECT_EQ(0u, stats.replaced);
+  EXPECT_LT(0u, stats.memory);
+
+  clients.clear();
+  EXPECT_TRUE(wait_for([](const connection_stats_t& stats) { return 0 == stats.connections && 0 == stats.hosts; }));
+}
+
+TEST_F(rpc_server_test, closes_idle_connections) {
+  start(std::chrono::milliseconds(100));
+  auto idle = connect_client();
+  auto busy = connect_client();
+  ASSERT_TRUE(idle.valid() && busy.valid());
+  busy.send(call_record(1, SLOW));
+
+  binary_t buffer;
+  EXPECT_GE(0, idle.receive(buffer)); // closed by the server
+  ASSERT_TRUE(wait_for([](const connection_stats_t& stats) { return 1 == stats.connections; }));
+  EXPECT_LE(1u, server->connection_stats().reaped);
+
+  // a running call keeps its connection
+  release();
+  uint32_t xid = 0;
+  ASSERT_TRUE(receive_xid(busy, xid));
+  EXPECT_EQ(1u, xid);
+}
+
+TEST_F(rpc_server_test, answers_large_datagrams_of_many_clients) {
+  enum { CLIENTS = 8, CALLS = 4 };
+  start();
+  auto server_addr = inet_addr_t::loopback(PORT);
+  binary_t parameters(20000, 0x55); // larger than a single ethernet frame
+  std::vector<udp_socket_t> clients;
+  for (auto i = 0; i < CLIENTS; ++i) {
+      clients.push_back(udp_client());
+      ASSERT_TRUE(clients.back().valid());
+    }
+  // replies of one client may arrive in any order - the workers run its calls concurrently
+  uint32_t xid = 0;
+  for (auto& client : clients) {
+      std::vector<uint32_t> expected, received;
+      for (auto call = 0; call < CALLS; ++call) {
+          expected.push_back(++xid);
+          auto datagram = rpc::message_builder().call(xid).null_auth(PROGRAM, VERSION, FAST, parameters);
+          ASSERT_EQ(int(datagram.size()), client.send_to(datagram, server_addr));
+        }
+      for (auto call = 0; call < CALLS; ++call) {
+          binary_t reply;
+          reply.reserve(udp_batch_t::MAX_DATAGRAM);
+          inet_addr_t sender;
+          ASSERT_LT(8, client.receive_from(reply, sender));
+          received.push_back(binary_reader_t::binary(reply).get32(0));
+        }
+      std::sort(received.begin(), received.end());
+      EXPECT_EQ(expected, received);
+    }
+}
+
+// a reply that cannot be sent - broadcasts are not allowed - drops no other reply
+TEST_F(rpc_server_test, failed_reply_keeps_the_rest_of_the_batch) {
+  auto receiver = udp_client();
+  auto sender = udp_client();
+  ASSERT_TRUE(receiver.valid() && sender.valid());
+  ASSERT_NE(SOCKET_ERROR, receiver.bind_all(PORT + 1));
+  auto broadcast = inet_addr_t::loopback(PORT + 1);
+  broadcast.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+
+  udp_batch_t batch;
+  batch.queue_reply(segmented_binary_t(binary_t{ 1 }), inet_addr_t::loopback(PORT + 1));
+  batch.queue_reply(segmented_binary_t(binary_t{ 2 }), broadcast);
+  batch.queue_reply(segmented_binary_t(binary_t{ 3 }), inet_addr_t::loopback(PORT + 1));
+  EXPECT_EQ(2u, batch.send(sender));
+
+  for (uint8_t expected : { 1, 3 }) {
+      binary_t reply;
+      reply.reserve(16);
+      inet_addr_t from;
+      ASSERT_EQ(1, receiver.receive_from(reply, from));
+      EXPECT_EQ(expected, reply[0]);
+    }
+}
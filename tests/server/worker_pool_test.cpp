@@ -0,0 +1,117 @@
+#include "server/worker_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+  // blocks the tasks that wait on it until opened
+  struct gate_t {
+    void wait() {
+      std::unique_lock<std::mutex> lock(mutex);
+      ++waiting;
+      changed.notify_all();
+      changed.wait(lock, [this] { return open; });
+    }
+    void wait_for_waiting(int count) {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&] { return waiting >= count; });
+    }
+    void release() {
+      std::lock_guard<std::mutex> lock(mutex);
+      open = true;
+      changed.notify_all();
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    int waiting = 0;
+    bool open = false;
+  };
+} // namespace
+
+TEST(worker_pool, runs_all_tasks_before_stopping) {
+  enum { TASKS = 10000 };
+  worker_pool_t::config_t config;
+  config.threads = 4;
+  config.queue_depth = TASKS;
+  worker_pool_t pool(config);
+  pool.start();
+  std::atomic<int> executed {0};
+  for (auto i = 0; i < TASKS; ++i) {
+      ASSERT_TRUE(pool.submit([&] { ++executed; }));
+    }
+  pool.stop();
+  EXPECT_EQ(int(TASKS), executed);
+  EXPECT_EQ(uint64_t(TASKS), pool.stats().executed);
+  EXPECT_EQ(0u, pool.stats().queued);
+}
+
+TEST(worker_pool, idle_workers_take_tasks_behind_a_slow_one) {
+  worker_pool_t::config_t config;
+  config.threads = 2;
+  worker_pool_t pool(config);
+  pool.start();
+
+  gate_t gate;
+  std::atomic<int> fast {0};
+  // tasks of a worker go to its own queue - all of them queue behind the slow one
+  pool.submit([&] {
+      pool.submit([&] { ++fast; });
+      pool.submit([&] { ++fast; });
+      gate.wait();
+    });
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (fast < 2 && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+  EXPECT_EQ(2, fast);
+  EXPECT_LE(2u, pool.stats().stolen);
+  gate.release();
+}
+
+TEST(worker_pool, rejects_tasks_above_the_queue_depth) {
+  worker_pool_t::config_t config;
+  config.threads = 1;
+  config.queue_depth = 2;
+  worker_pool_t pool(config);
+  EXPECT_FALSE(pool.submit([] {})); // not started
+
+  pool.start();
+  gate_t gate;
+  ASSERT_TRUE(pool.submit([&] { gate.wait(); }));
+  gate.wait_for_waiting(1); // taken - no longer queued
+  EXPECT_TRUE(pool.submit([] {}));
+  EXPECT_TRUE(pool.submit([] {}));
+  EXPECT_FALSE(pool.submit([] {}));
+  EXPECT_EQ(2u, pool.stats().rejected);
+  gate.release();
+  pool.stop();
+  EXPECT_EQ(3u, pool.stats().executed);
+}
+
+// every task submit() accepted runs - even when stop() races with it
+TEST(worker_pool, runs_tasks_submitted_while_stopping) {
+  for (auto round = 0; round < 2000; ++round) {
+      worker_pool_t::config_t config;
+      config.threads = 2;
+      worker_pool_t pool(config);
+      pool.start();
+      std::atomic<int> accepted {0};
+      std::atomic<int> executed {0};
+      std::vector<std::thread> submitters;
+      for (auto s = 0; s < 4; ++s) {
+          submitters.emplace_back([&] {
+              for (auto i = 0; i < 100; ++i) {
+                  if (pool.submit([&] { ++executed; })) ++accepted;
+                }
+            });
+        }
+      pool.stop();
+      for (auto& submitter : submitters) submitter.join();
+      ASSERT_EQ(accepted.load(), executed.load());
+    }
+}